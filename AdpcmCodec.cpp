@@ -0,0 +1,191 @@
+#include "AdpcmCodec.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static const int indexTable[16] =
+{
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int stepTable[89] =
+{
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/*apply one nibble to predictor and step index, shared by encoder and decoder*/
+static inline void step(int nibble, int& predictor, int& index)
+{
+    int s = stepTable[index];
+    int delta = s >> 3;
+
+    if (nibble & 4) delta += s;
+    if (nibble & 2) delta += s >> 1;
+    if (nibble & 1) delta += s >> 2;
+
+    predictor += (nibble & 8) ? -delta : delta;
+    predictor = std::clamp(predictor, -32768, 32767);
+
+    index = std::clamp(index + indexTable[nibble], 0, 88);
+}
+
+size_t AdpcmCodec::BlockBytes(int channels)
+{
+    return channels * (ADPCM_HEADER_BYTES + ADPCM_BLOCK_FRAMES / 2);
+}
+
+size_t AdpcmCodec::BlockCount(size_t frames)
+{
+    return (frames + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+}
+
+/*encode one channel of a block*/
+static void encodeChannel(const int16_t* samples, size_t count, int stride, int& index, uint8_t* nibbles)
+{
+    int predictor = samples[0];
+
+    for (size_t i = 1; i < count; i++)
+    {
+        int diff = samples[i * stride] - predictor;
+        int s = stepTable[index];
+        int nibble = 0;
+
+        if (diff < 0)
+        {
+            nibble = 8;
+            diff = -diff;
+        }
+
+        if (diff >= s) { nibble |= 4; diff -= s; }
+        s >>= 1;
+        if (diff >= s) { nibble |= 2; diff -= s; }
+        s >>= 1;
+        if (diff >= s) { nibble |= 1; }
+
+        step(nibble, predictor, index);
+
+        nibbles[(i - 1) / 2] |= static_cast<uint8_t>(nibble << (((i - 1) & 1) * 4));
+    }
+}
+
+bool AdpcmCodec::Encode(const int16_t* samples, size_t frames, int channels, std::vector<uint8_t>& out)
+{
+    if (channels < 1 || channels > ADPCM_MAX_CHANNELS)
+        return false;
+
+    const size_t blockBytes = BlockBytes(channels);
+    const size_t first = out.size();
+
+    out.resize(first + BlockCount(frames) * blockBytes, 0);
+
+    /*the step index carries over between blocks, the predictor restarts at the exact sample*/
+    int index[ADPCM_MAX_CHANNELS] = {};
+
+    for (size_t b = 0; b < BlockCount(frames); b++)
+    {
+        uint8_t* block = &out[first + b * blockBytes];
+        size_t start = b * ADPCM_BLOCK_FRAMES;
+        size_t count = std::min<size_t>(ADPCM_BLOCK_FRAMES, frames - start);
+
+        for (int c = 0; c < channels; c++)
+        {
+            const int16_t* src = samples + start * channels + c;
+
+            uint8_t* header = block + c * ADPCM_HEADER_BYTES;
+            int16_t p16 = src[0];
+            memcpy(header, &p16, sizeof(p16));
+            header[2] = static_cast<uint8_t>(index[c]);
+            header[3] = 0;
+
+            encodeChannel(src, count, channels, index[c], block + channels * ADPCM_HEADER_BYTES + c * (ADPCM_BLOCK_FRAMES / 2));
+        }
+    }
+
+    return true;
+}
+
+bool AdpcmCodec::DecodeBlock(const uint8_t* block, int channels, size_t frames, float* out)
+{
+    if (channels < 1 || channels > ADPCM_MAX_CHANNELS || frames > ADPCM_BLOCK_FRAMES)
+        return false;
+
+    for (int c = 0; c < channels; c++)
+    {
+        const uint8_t* header = block + c * ADPCM_HEADER_BYTES;
+        const uint8_t* nibbles = block + channels * ADPCM_HEADER_BYTES + c * (ADPCM_BLOCK_FRAMES / 2);
+
+        int16_t p16;
+        memcpy(&p16, header, sizeof(p16));
+
+        int predictor = p16;
+        int index = std::min<int>(header[2], 88);
+
+        out[c] = predictor / 32768.f;
+
+        /*two samples per byte, low nibble first*/
+        for (size_t i = 1; i < frames; i++)
+        {
+            int nibble = (nibbles[(i - 1) / 2] >> (((i - 1) & 1) * 4)) & 15;
+
+            step(nibble, predictor, index);
+            out[i * channels + c] = predictor / 32768.f;
+        }
+    }
+
+    return true;
+}
+
+void AdpcmCodec::FirstFrame(const uint8_t* block, int channels, float* out)
+{
+    for (int c = 0; c < channels; c++)
+    {
+        int16_t p16;
+        memcpy(&p16, block + c * ADPCM_HEADER_BYTES, sizeof(p16));
+        out[c] = p16 / 32768.f;
+    }
+}
+
+AdpcmBenchmark AdpcmCodec::Benchmark(const std::vector<uint8_t>& blocks, int channels, size_t frames, int sampleRate)
+{
+    AdpcmBenchmark result;
+    result.pcmBytes = frames * channels * sizeof(int16_t);
+    result.compressedBytes = blocks.size();
+
+    std::vector<float> out(ADPCM_BLOCK_FRAMES * channels);
+    const size_t blockBytes = BlockBytes(channels);
+    const size_t blockCount = BlockCount(frames);
+
+    /*decode at least a few million frames for a stable time*/
+    size_t rounds = std::max<size_t>(1, 4000000 / std::max<size_t>(frames, 1));
+
+    /*keep the decode from being optimized away*/
+    volatile float sink = 0.f;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (size_t b = 0; b < blockCount; b++)
+        {
+            size_t count = std::min<size_t>(ADPCM_BLOCK_FRAMES, frames - b * ADPCM_BLOCK_FRAMES);
+            DecodeBlock(&blocks[b * blockBytes], channels, count, out.data());
+            sink = sink + out[0];
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    result.framesPerSecond = static_cast<double>(frames) * rounds / elapsed.count();
+    result.voiceLoad = sampleRate / result.framesPerSecond;
+
+    return result;
+}
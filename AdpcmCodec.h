@@ -0,0 +1,59 @@
+/* AdpcmCodec.h
+
+ima adpcm with 4 bits per sample, about 4:1 against 16 bit pcm and 8:1
+against the float samples the mixer keeps otherwise.
+
+samples are stored in blocks of ADPCM_BLOCK_FRAMES frames. every block
+starts with one header per channel (first sample and step index), followed
+by the nibbles of each channel. blocks decode independently, so a voice only
+needs the block it is playing and can seek or loop at block granularity.
+clips have one or two channels, Encode and DecodeBlock reject any other
+count. only depends on the standard library.
+
+    Usage:
+    std::vector<uint8_t> blocks;
+    AdpcmCodec::Encode(pcm16, frames, 2, blocks);
+
+    float out[ADPCM_BLOCK_FRAMES * 2];
+    AdpcmCodec::DecodeBlock(&blocks[b * AdpcmCodec::BlockBytes(2)], 2, ADPCM_BLOCK_FRAMES, out);
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define ADPCM_BLOCK_FRAMES 1024
+#define ADPCM_HEADER_BYTES 4
+#define ADPCM_MAX_CHANNELS 2
+
+struct AdpcmBenchmark
+{
+    size_t pcmBytes = 0;
+    size_t compressedBytes = 0;
+
+    /*decoded frames per second of cpu time, and cpu share of one real time voice*/
+    double framesPerSecond = 0.0;
+    double voiceLoad = 0.0;
+};
+
+class AdpcmCodec
+{
+public:
+    static size_t BlockBytes(int channels);
+    static size_t BlockCount(size_t frames);
+
+    /*interleaved 16 bit samples to blocks, appended to out. false for channels outside 1 - ADPCM_MAX_CHANNELS*/
+    static bool Encode(const int16_t* samples, size_t frames, int channels, std::vector<uint8_t>& out);
+
+    /*decode frames (at most ADPCM_BLOCK_FRAMES) of one block into interleaved floats, false for
+      more frames or channels outside 1 - ADPCM_MAX_CHANNELS*/
+    static bool DecodeBlock(const uint8_t* block, int channels, size_t frames, float* out);
+
+    /*first frame of a block, read from its headers*/
+    static void FirstFrame(const uint8_t* block, int channels, float* out);
+
+    static AdpcmBenchmark Benchmark(const std::vector<uint8_t>& blocks, int channels, size_t frames, int sampleRate);
+};
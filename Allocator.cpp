@@ -0,0 +1,148 @@
+#include "Allocator.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+std::atomic<size_t> AllocationCounter::allocations(0);
+std::atomic<size_t> AllocationCounter::bytes(0);
+
+thread_local LinearAllocator* LinearAllocator::bound = nullptr;
+
+#ifdef TRACK_ALLOCATIONS
+/*count every allocation of the program, the other forms of new forward to this one*/
+void* operator new(size_t size)
+{
+    AllocationCounter::allocations++;
+    AllocationCounter::bytes += size;
+
+    void* p = malloc(size ? size : 1);
+
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+#endif
+
+LinearAllocator::LinearAllocator(size_t _blockSize) : blockSize(_blockSize)
+{
+}
+
+LinearAllocator::~LinearAllocator()
+{
+    Reset();
+
+    for (auto& b : blocks)
+    {
+        ::operator delete(b.data);
+    }
+}
+
+void* LinearAllocator::Allocate(size_t size, size_t alignment)
+{
+    /*find a block with enough space, blocks behind current are empty after a reset*/
+    for (; current < blocks.size(); current++)
+    {
+        Block& b = blocks[current];
+
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+        uintptr_t aligned = (base + b.used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+
+        if (aligned + size <= base + b.size)
+        {
+            b.used = aligned + size - base;
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        /*keep filling the current block when only a large allocation does not fit*/
+        if (size > blockSize / 4 && current + 1 == blocks.size())
+        {
+            break;
+        }
+    }
+
+    Block b;
+    b.size = std::max(blockSize, size + alignment);
+    b.data = static_cast<char*>(::operator new(b.size));
+    b.used = 0;
+
+    /*insert in front of the current block so its remaining space is used afterwards*/
+    size_t at = std::min(current, blocks.size());
+    blocks.insert(blocks.begin() + at, b);
+    current = at;
+
+    return Allocate(size, alignment);
+}
+
+bool LinearAllocator::Owns(const void* p) const
+{
+    const char* c = static_cast<const char*>(p);
+
+    for (auto& b : blocks)
+    {
+        if (c >= b.data && c < b.data + b.size)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*run destructors and rewind, the blocks are kept for reuse*/
+void LinearAllocator::Reset()
+{
+    while (destructors)
+    {
+        Destructor* d = destructors;
+        destructors = d->next;
+        d->destroy(d->object);
+    }
+
+    for (auto& b : blocks)
+    {
+        b.used = 0;
+    }
+
+    current = 0;
+}
+
+size_t LinearAllocator::BytesUsed() const
+{
+    size_t used = 0;
+
+    for (auto& b : blocks)
+    {
+        used += b.used;
+    }
+
+    return used;
+}
+
+LinearAllocator::Scope::Scope(LinearAllocator& a)
+{
+    previous = bound;
+    bound = &a;
+}
+
+LinearAllocator::Scope::~Scope()
+{
+    bound = previous;
+}
+
+LinearAllocator* LinearAllocator::Current()
+{
+    return bound;
+}
@@ -0,0 +1,291 @@
+/* Allocator.h
+
+level scoped memory
+
+LinearAllocator hands out memory from large blocks by bumping an offset.
+Reset() releases everything at once and keeps the blocks for the next
+level, destructors of objects created with New() are run in reverse order.
+
+ObjectPool<T> stores objects of one type in contiguous chunks with a free
+list, Clear() destroys all live objects and keeps the chunks. Reserve()
+adds one chunk of exactly the missing size when the count is known.
+
+ArenaAllocator<T> is a stateless std allocator that takes its memory from
+the LinearAllocator bound with LinearAllocator::Scope, containers using it
+must be created and destroyed inside the scope.
+
+with TRACK_ALLOCATIONS defined every global operator new is counted.
+
+    Usage:
+    LinearAllocator arena;
+    {
+        LinearAllocator::Scope scope(arena);
+        std::vector<int, ArenaAllocator<int>> v(100);
+    }
+    arena.Reset();
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "constants.h"
+
+struct AllocationCounter
+{
+    static std::atomic<size_t> allocations;
+    static std::atomic<size_t> bytes;
+
+    static size_t Allocations() { return allocations.load(); }
+    static size_t Bytes() { return bytes.load(); }
+};
+
+class LinearAllocator
+{
+public:
+    explicit LinearAllocator(size_t blockSize = LINEAR_BLOCK_SIZE);
+    ~LinearAllocator();
+
+    LinearAllocator(const LinearAllocator&) = delete;
+    LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template<class T, class... Args>
+    T* New(Args&&... args)
+    {
+        T* object = new(Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        if (!std::is_trivially_destructible<T>::value)
+        {
+            Destructor* d = new(Allocate(sizeof(Destructor), alignof(Destructor))) Destructor;
+            d->destroy = [](void* p) { static_cast<T*>(p)->~T(); };
+            d->object = object;
+            d->next = destructors;
+            destructors = d;
+        }
+
+        return object;
+    }
+
+    bool Owns(const void* p) const;
+    void Reset();
+
+    size_t BytesUsed() const;
+    size_t BlockCount() const { return blocks.size(); }
+
+    /*binds the allocator to ArenaAllocator on this thread*/
+    class Scope
+    {
+    public:
+        explicit Scope(LinearAllocator& a);
+        ~Scope();
+
+    private:
+        LinearAllocator* previous;
+    };
+
+    static LinearAllocator* Current();
+
+private:
+    struct Block
+    {
+        char* data;
+        size_t size;
+        size_t used;
+    };
+
+    struct Destructor
+    {
+        void (*destroy)(void*);
+        void* object;
+        Destructor* next;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t blockSize;
+    Destructor* destructors = nullptr;
+
+    static thread_local LinearAllocator* bound;
+};
+
+template<class T>
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    ArenaAllocator() noexcept {}
+    template<class U> ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        LinearAllocator* a = LinearAllocator::Current();
+        assert(a && "ArenaAllocator used outside of a LinearAllocator::Scope");
+
+        if (a == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+
+        return static_cast<T*>(a->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    /*arena memory is released with LinearAllocator::Reset*/
+    void deallocate(T* p, size_t) noexcept
+    {
+        LinearAllocator* a = LinearAllocator::Current();
+        assert(a && a->Owns(p) && "ArenaAllocator memory released outside of its LinearAllocator::Scope");
+
+        (void)a;
+        (void)p;
+    }
+
+    template<class U> bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+    template<class U> bool operator!=(const ArenaAllocator<U>&) const noexcept { return false; }
+};
+
+template<class T>
+class ObjectPool
+{
+public:
+    explicit ObjectPool(size_t _chunkSize = POOL_CHUNK_SIZE) : chunkSize(_chunkSize) {}
+
+    ~ObjectPool()
+    {
+        Clear();
+
+        for (auto& c : chunks)
+        {
+            ::operator delete(c.slots, std::align_val_t(alignof(Slot)));
+        }
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    template<class... Args>
+    T* Create(Args&&... args)
+    {
+        if (freeList == nullptr)
+        {
+            addChunk(chunkSize);
+        }
+
+        Slot* s = freeList;
+        Slot* next = s->next;
+        T* object = new(s->storage) T(std::forward<Args>(args)...);
+
+        freeList = next;
+        s->alive = true;
+        live++;
+
+        return object;
+    }
+
+    /*the slot knows its chunk, no search*/
+    void Destroy(T* object)
+    {
+        if (object == nullptr)
+        {
+            return;
+        }
+
+        Slot* s = reinterpret_cast<Slot*>(object);
+        assert(s->chunk < chunks.size() && s >= chunks[s->chunk].slots && s < chunks[s->chunk].slots + chunks[s->chunk].size);
+        assert(s->alive);
+
+        object->~T();
+        s->alive = false;
+        s->next = freeList;
+        freeList = s;
+        live--;
+    }
+
+    /*make room for count more objects without further chunks*/
+    void Reserve(size_t count)
+    {
+        size_t available = Capacity() - live;
+
+        if (count > available)
+        {
+            addChunk(count - available);
+        }
+    }
+
+    /*destroy every live object, chunks are kept*/
+    void Clear()
+    {
+        freeList = nullptr;
+
+        for (auto& c : chunks)
+        {
+            for (size_t i = 0; i < c.size; i++)
+            {
+                if (c.slots[i].alive)
+                {
+                    reinterpret_cast<T*>(c.slots[i].storage)->~T();
+                    c.slots[i].alive = false;
+                }
+
+                c.slots[i].next = freeList;
+                freeList = &c.slots[i];
+            }
+        }
+
+        live = 0;
+    }
+
+    size_t Size() const { return live; }
+    size_t Capacity() const { return capacity; }
+
+private:
+    /*storage comes first, objects and slots have the same address*/
+    struct Slot
+    {
+        union
+        {
+            Slot* next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        size_t chunk;
+        bool alive;
+    };
+
+    struct Chunk
+    {
+        Slot* slots;
+        size_t size;
+    };
+
+    void addChunk(size_t size)
+    {
+        Chunk c;
+        c.slots = static_cast<Slot*>(::operator new(sizeof(Slot) * size, std::align_val_t(alignof(Slot))));
+        c.size = size;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            c.slots[i].next = i + 1 < size ? &c.slots[i + 1] : freeList;
+            c.slots[i].chunk = chunks.size();
+            c.slots[i].alive = false;
+        }
+
+        freeList = c.slots;
+        chunks.push_back(c);
+        capacity += size;
+    }
+
+    std::vector<Chunk> chunks;
+    Slot* freeList = nullptr;
+    size_t chunkSize;
+    size_t capacity = 0;
+    size_t live = 0;
+};
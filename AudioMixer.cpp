@@ -0,0 +1,600 @@
+#include "AudioMixer.h"
+#include "AdpcmCodec.h"
+#include "AudioSink.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIXER_SSE
+#include <xmmintrin.h>
+#endif
+
+#define VOICE_SLOT_BITS 16
+#define VOICE_SLOT_MASK 0xFFFF
+
+bool AudioClip::FromPCM(const void* data, size_t bytes, int channels, int sampleRate, int bitsPerSample, bool isFloat, AudioClip& clip)
+{
+    if (channels < 1 || channels > 2 || sampleRate <= 0 || bitsPerSample % 8 != 0 || bitsPerSample == 0)
+        return false;
+
+    if (isFloat && bitsPerSample != 32)
+        return false;
+
+    size_t bytesPerSample = bitsPerSample / 8;
+    size_t count = bytes / bytesPerSample;
+    count -= count % channels;
+
+    const unsigned char* src = static_cast<const unsigned char*>(data);
+
+    clip.channels = channels;
+    clip.sampleRate = sampleRate;
+    clip.samples.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const unsigned char* s = src + i * bytesPerSample;
+        float value = 0.f;
+
+        if (isFloat)
+        {
+            memcpy(&value, s, sizeof(float));
+        }
+        else if (bitsPerSample == 8)
+        {
+            /*8 bit pcm is unsigned*/
+            value = (static_cast<int>(s[0]) - 128) / 128.f;
+        }
+        else if (bitsPerSample == 16)
+        {
+            int16_t v;
+            memcpy(&v, s, sizeof(v));
+            value = v / 32768.f;
+        }
+        else if (bitsPerSample == 24)
+        {
+            /*assembled unsigned, the top byte would shift into the sign bit of an int*/
+            uint32_t u = (static_cast<uint32_t>(s[0]) << 8) | (static_cast<uint32_t>(s[1]) << 16) | (static_cast<uint32_t>(s[2]) << 24);
+            int32_t v = static_cast<int32_t>(u);
+            value = (v >> 8) / 8388608.f;
+        }
+        else if (bitsPerSample == 32)
+        {
+            int32_t v;
+            memcpy(&v, s, sizeof(v));
+            value = static_cast<float>(v / 2147483648.0);
+        }
+        else
+        {
+            return false;
+        }
+
+        clip.samples[i] = value;
+    }
+
+    return true;
+}
+
+void AudioClip::Compress()
+{
+    if (Compressed() || samples.empty())
+        return;
+
+    std::vector<int16_t> pcm(samples.size());
+
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        pcm[i] = static_cast<int16_t>(std::lround(std::clamp(samples[i], -1.f, 1.f) * 32767.f));
+    }
+
+    adpcmFrames = Frames();
+    AdpcmCodec::Encode(pcm.data(), adpcmFrames, channels, adpcm);
+
+    samples.clear();
+    samples.shrink_to_fit();
+}
+
+AudioMixer::AudioMixer(int _sampleRate, size_t maxVoices) : sampleRate(_sampleRate), cursor(0), running(false)
+{
+    maxVoices = std::min<size_t>(maxVoices, VOICE_SLOT_MASK);
+
+    voices.resize(maxVoices);
+    freeVoices.reserve(maxVoices);
+
+    for (size_t i = maxVoices; i > 0; i--)
+    {
+        freeVoices.push_back(static_cast<unsigned int>(i - 1));
+    }
+
+    releaseCoefficient = std::exp(-1.f / (sampleRate * MIXER_LIMITER_RELEASE));
+
+    scratchL.resize(MIXER_BLOCK_FRAMES);
+    scratchR.resize(MIXER_BLOCK_FRAMES);
+    busL.resize(MIXER_BLOCK_FRAMES);
+    busR.resize(MIXER_BLOCK_FRAMES);
+    busGain.resize(MIXER_BLOCK_FRAMES);
+}
+
+AudioMixer::~AudioMixer()
+{
+    StopOutput();
+}
+
+AudioMixer::Voice* AudioMixer::find(unsigned int id)
+{
+    size_t slot = id & VOICE_SLOT_MASK;
+
+    if (slot >= voices.size())
+        return nullptr;
+
+    Voice& v = voices[slot];
+
+    if (!v.active || v.generation != (id >> VOICE_SLOT_BITS))
+        return nullptr;
+
+    return &v;
+}
+
+const AudioMixer::Voice* AudioMixer::find(unsigned int id) const
+{
+    return const_cast<AudioMixer*>(this)->find(id);
+}
+
+unsigned int AudioMixer::Play(const AudioClip* clip, const VoiceParams& params, uint64_t startFrame)
+{
+    if (clip == nullptr || clip->Frames() == 0)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (freeVoices.empty())
+        return 0;
+
+    unsigned int slot = freeVoices.back();
+    freeVoices.pop_back();
+
+    Voice& v = voices[slot];
+
+    /*generation 0 is never used, so 0 is no valid id*/
+    if (++v.generation == 0)
+        v.generation = 1;
+
+    v.clip = clip;
+    v.params = params;
+    v.position = 0.0;
+    v.startFrame = startFrame;
+    v.decodedBlock = SIZE_MAX;
+    v.active = true;
+
+    return (static_cast<unsigned int>(v.generation) << VOICE_SLOT_BITS) | slot;
+}
+
+void AudioMixer::Stop(unsigned int voice)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Voice* v = find(voice);
+
+    if (v)
+    {
+        v->active = false;
+        v->clip = nullptr;
+        freeVoices.push_back(voice & VOICE_SLOT_MASK);
+    }
+}
+
+bool AudioMixer::IsPlaying(unsigned int voice) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return find(voice) != nullptr;
+}
+
+double AudioMixer::Position(unsigned int voice) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const Voice* v = find(voice);
+    return v ? v->position : 0.0;
+}
+
+void AudioMixer::SetGain(unsigned int voice, float gain)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (Voice* v = find(voice))
+        v->params.gain = gain;
+}
+
+void AudioMixer::SetPitch(unsigned int voice, float pitch)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (Voice* v = find(voice))
+        v->params.pitch = std::max(pitch, 0.f);
+}
+
+void AudioMixer::SetPan(unsigned int voice, float pan)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (Voice* v = find(voice))
+        v->params.pan = std::clamp(pan, -1.f, 1.f);
+}
+
+void AudioMixer::SetVoices(const unsigned int* ids, const float* gain, const float* pan, const float* pitch, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (Voice* v = find(ids[i]))
+        {
+            v->params.gain = gain[i];
+            v->params.pan = std::clamp(pan[i], -1.f, 1.f);
+            v->params.pitch = std::max(pitch[i], 0.f);
+        }
+    }
+}
+
+void AudioMixer::SetMasterGain(float gain)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    masterGain = gain;
+}
+
+size_t AudioMixer::ActiveVoices() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return voices.size() - freeVoices.size();
+}
+
+/*dst += src * gain*/
+static void mulAdd(float* dst, const float* src, float gain, size_t n)
+{
+    size_t i = 0;
+
+#ifdef MIXER_SSE
+    __m128 g = _mm_set1_ps(gain);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 d = _mm_loadu_ps(dst + i);
+        __m128 s = _mm_loadu_ps(src + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(d, _mm_mul_ps(s, g)));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        dst[i] += src[i] * gain;
+    }
+}
+
+/*decode one adpcm block of the voice clip, cached until the voice moves on*/
+const float* AudioMixer::decode(Voice& v, size_t block)
+{
+    if (v.decodedBlock != block)
+    {
+        const AudioClip& clip = *v.clip;
+        const size_t blockBytes = AdpcmCodec::BlockBytes(clip.channels);
+        const uint8_t* data = clip.adpcm.data() + block * blockBytes;
+
+        size_t start = block * ADPCM_BLOCK_FRAMES;
+        size_t count = std::min<size_t>(ADPCM_BLOCK_FRAMES, clip.adpcmFrames - start);
+
+        /*sized for stereo once, so switching clips never allocates*/
+        v.block.resize((ADPCM_BLOCK_FRAMES + 1) * 2);
+
+        AdpcmCodec::DecodeBlock(data, clip.channels, count, v.block.data());
+
+        /*guard frame for interpolating across the block end*/
+        if (start + count < clip.adpcmFrames)
+        {
+            AdpcmCodec::FirstFrame(data + blockBytes, clip.channels, &v.block[count * clip.channels]);
+        }
+
+        v.decodedBlock = block;
+    }
+
+    return v.block.data();
+}
+
+/*render up to frames of the voice into the scratch buffers, returns the number of frames written*/
+size_t AudioMixer::resample(Voice& v, size_t frames)
+{
+    const AudioClip& clip = *v.clip;
+    const size_t total = clip.Frames();
+    const int ch = clip.channels;
+    const double step = static_cast<double>(v.params.pitch) * clip.sampleRate / sampleRate;
+
+    double pos = v.position;
+    size_t written = 0;
+
+    while (written < frames)
+    {
+        if (pos >= total)
+        {
+            if (!v.params.loop || step <= 0.0)
+                break;
+
+            pos = std::fmod(pos, static_cast<double>(total));
+        }
+
+        size_t index = static_cast<size_t>(pos);
+
+        /*contiguous frames containing index, whole clip for pcm or one decoded block*/
+        const float* s = clip.samples.data();
+        size_t segmentStart = 0;
+        size_t segmentEnd = total;
+
+        if (clip.Compressed())
+        {
+            size_t block = index / ADPCM_BLOCK_FRAMES;
+
+            s = decode(v, block);
+            segmentStart = block * ADPCM_BLOCK_FRAMES;
+            segmentEnd = std::min(segmentStart + ADPCM_BLOCK_FRAMES, total);
+        }
+
+        /*same rate, copy the run up to the end of the segment*/
+        if (step == 1.0 && pos == static_cast<double>(index))
+        {
+            size_t run = std::min(frames - written, segmentEnd - index);
+            const float* src = s + (index - segmentStart) * ch;
+
+            if (ch == 1)
+            {
+                memcpy(&scratchL[written], src, run * sizeof(float));
+            }
+            else
+            {
+                for (size_t i = 0; i < run; i++)
+                {
+                    scratchL[written + i] = src[i * 2];
+                    scratchR[written + i] = src[i * 2 + 1];
+                }
+            }
+
+            written += run;
+            pos += static_cast<double>(run);
+            continue;
+        }
+
+        /*the frame after the last one is the first frame when looping*/
+        float first[2];
+
+        if (clip.Compressed())
+            AdpcmCodec::FirstFrame(clip.adpcm.data(), ch, first);
+        else
+            memcpy(first, clip.samples.data(), ch * sizeof(float));
+
+        while (written < frames && pos < segmentEnd)
+        {
+            index = static_cast<size_t>(pos);
+
+            const float* a = s + (index - segmentStart) * ch;
+            const float* b = a + ch;
+
+            if (index + 1 >= total)
+                b = v.params.loop ? first : a;
+
+            float t = static_cast<float>(pos - index);
+
+            scratchL[written] = a[0] + (b[0] - a[0]) * t;
+
+            if (ch == 2)
+                scratchR[written] = a[1] + (b[1] - a[1]) * t;
+
+            written++;
+            pos += step;
+        }
+    }
+
+    v.position = pos;
+
+    /*voice ended, the rest of the block stays silent*/
+    if (written < frames)
+    {
+        v.active = false;
+        v.clip = nullptr;
+        freeVoices.push_back(static_cast<unsigned int>(&v - voices.data()));
+    }
+
+    return written;
+}
+
+/*peak limiter with instant attack, writes interleaved and clamped output*/
+void AudioMixer::limit(float* out, size_t frames)
+{
+    for (size_t i = 0; i < frames; i++)
+    {
+        float peak = std::max(std::fabs(busL[i]), std::fabs(busR[i])) * masterGain;
+        float target = peak > MIXER_LIMITER_THRESHOLD ? MIXER_LIMITER_THRESHOLD / peak : 1.f;
+
+        envelope = target < envelope ? target : target + (envelope - target) * releaseCoefficient;
+        busGain[i] = envelope * masterGain;
+    }
+
+    size_t i = 0;
+
+#ifdef MIXER_SSE
+    __m128 hi = _mm_set1_ps(1.f);
+    __m128 lo = _mm_set1_ps(-1.f);
+
+    for (; i + 4 <= frames; i += 4)
+    {
+        __m128 g = _mm_loadu_ps(&busGain[i]);
+        __m128 l = _mm_max_ps(lo, _mm_min_ps(hi, _mm_mul_ps(_mm_loadu_ps(&busL[i]), g)));
+        __m128 r = _mm_max_ps(lo, _mm_min_ps(hi, _mm_mul_ps(_mm_loadu_ps(&busR[i]), g)));
+
+        _mm_storeu_ps(out + i * 2, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(l, r));
+    }
+#endif
+
+    for (; i < frames; i++)
+    {
+        out[i * 2] = std::clamp(busL[i] * busGain[i], -1.f, 1.f);
+        out[i * 2 + 1] = std::clamp(busR[i] * busGain[i], -1.f, 1.f);
+    }
+}
+
+void AudioMixer::Mix(float* out, size_t frames)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    /*mix in blocks so the planar buffers never grow*/
+    for (size_t offset = 0; offset < frames; offset += MIXER_BLOCK_FRAMES)
+    {
+        size_t n = std::min<size_t>(MIXER_BLOCK_FRAMES, frames - offset);
+
+        uint64_t blockStart = cursor;
+
+        std::fill(busL.begin(), busL.begin() + n, 0.f);
+        std::fill(busR.begin(), busR.begin() + n, 0.f);
+
+        for (auto& v : voices)
+        {
+            if (!v.active || v.startFrame >= blockStart + n)
+                continue;
+
+            /*voices scheduled inside this block start at their frame*/
+            size_t skip = v.startFrame > blockStart ? static_cast<size_t>(v.startFrame - blockStart) : 0;
+
+            /*equal power pan for mono clips, stereo clips are balanced and keep full gain at center*/
+            float angle = (std::clamp(v.params.pan, -1.f, 1.f) + 1.f) * 0.785398163f;
+            float panL = std::cos(angle);
+            float panR = std::sin(angle);
+
+            bool stereo = v.clip->channels == 2;
+
+            if (stereo)
+            {
+                panL = std::min(panL * 1.41421356f, 1.f);
+                panR = std::min(panR * 1.41421356f, 1.f);
+            }
+
+            size_t written = resample(v, n - skip);
+
+            mulAdd(busL.data() + skip, scratchL.data(), v.params.gain * panL, written);
+            mulAdd(busR.data() + skip, stereo ? scratchR.data() : scratchL.data(), v.params.gain * panR, written);
+        }
+
+        limit(out + offset * 2, n);
+        cursor += n;
+    }
+}
+
+void AudioMixer::StartOutput(AudioSink* _sink)
+{
+    StopOutput();
+
+    sink = _sink;
+    running = true;
+    output = std::thread(&AudioMixer::run, this);
+}
+
+void AudioMixer::StopOutput()
+{
+    running = false;
+
+    if (output.joinable())
+    {
+        output.join();
+    }
+
+    sink = nullptr;
+}
+
+void AudioMixer::run()
+{
+    std::vector<float> block(MIXER_BLOCK_FRAMES * 2);
+
+    while (running)
+    {
+        Mix(block.data(), MIXER_BLOCK_FRAMES);
+        sink->Submit(block.data(), MIXER_BLOCK_FRAMES);
+    }
+}
+
+MixerBenchmark AudioMixer::Benchmark(double budgetMs)
+{
+    /*one second of a 44.1khz tone, every voice is resampled*/
+    AudioClip clip;
+    clip.sampleRate = 44100;
+    clip.samples.resize(44100);
+
+    for (size_t i = 0; i < clip.samples.size(); i++)
+    {
+        clip.samples[i] = 0.5f * std::sin(i * 0.0628f);
+    }
+
+    std::vector<float> block(MIXER_BLOCK_FRAMES * 2);
+
+    auto measure = [&](size_t count)
+    {
+        AudioMixer mixer(MIXER_SAMPLE_RATE, count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            VoiceParams p;
+            p.gain = 0.1f;
+            p.pitch = 0.75f + (i % 8) * 0.0625f;
+            p.pan = -1.f + 2.f * (i % 16) / 15.f;
+            p.loop = true;
+            mixer.Play(&clip, p);
+        }
+
+        mixer.Mix(block.data(), MIXER_BLOCK_FRAMES);
+
+        const int rounds = 16;
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int r = 0; r < rounds; r++)
+        {
+            mixer.Mix(block.data(), MIXER_BLOCK_FRAMES);
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        return elapsed.count() / rounds;
+    };
+
+    MixerBenchmark result;
+    size_t low = 0;
+    size_t high = 16;
+
+    auto fits = [&](size_t count)
+    {
+        double ms = measure(count);
+
+        if (ms > budgetMs)
+            return false;
+
+        result.voices = count;
+        result.msPerBlock = ms;
+        return true;
+    };
+
+    /*double until over budget, then bisect*/
+    while (high < VOICE_SLOT_MASK && fits(high))
+    {
+        low = high;
+        high *= 2;
+    }
+
+    high = std::min<size_t>(high, VOICE_SLOT_MASK);
+
+    while (high - low > std::max<size_t>(low / 32, 1))
+    {
+        size_t mid = (low + high) / 2;
+
+        if (fits(mid))
+            low = mid;
+        else
+            high = mid;
+    }
+
+    return result;
+}
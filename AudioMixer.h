@@ -0,0 +1,168 @@
+/* AudioMixer.h
+
+platform independent software mixer, only depends on the standard library.
+
+every voice plays an AudioClip with its own gain, pitch and pan. clips are
+resampled to the mixer rate with linear interpolation, the voices are
+summed into a float stereo bus with sse and a peak limiter keeps the master
+bus below MIXER_LIMITER_THRESHOLD. the mixed blocks are handed to an
+AudioSink (see AudioSink.h) on an output thread, or pulled with Mix().
+
+clips can be compressed to ima adpcm (see AdpcmCodec.h), every voice then
+decodes the block it plays into its own buffer while mixing.
+
+voice ids contain a generation, the id of a finished or stopped voice
+stays invalid after its slot is reused.
+
+the mixer counts every mixed frame, Cursor() is the first frame of the next
+block. a voice played with a start frame stays silent until the mix reaches
+that frame and starts exactly there, start frames in the past play at once.
+
+    Usage:
+    AudioClip clip;
+    AudioClip::FromPCM(data, bytes, 1, 22050, 16, false, clip);
+
+    AudioMixer mixer;
+    WavFileSink sink("out.wav", mixer.SampleRate());
+    mixer.StartOutput(&sink);
+
+    VoiceParams p;
+    p.pan = -0.5f;
+    unsigned int voice = mixer.Play(&clip, p);
+    ...
+    mixer.StopOutput();
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define MIXER_SAMPLE_RATE 48000
+#define MIXER_BLOCK_FRAMES 480
+#define MIXER_MAX_VOICES 64
+#define MIXER_LIMITER_THRESHOLD 0.95f
+#define MIXER_LIMITER_RELEASE 0.05f
+#define MIXER_BENCHMARK_BUDGET 5.0
+
+class AudioSink;
+
+/*sound with one or two channels, interleaved float samples or adpcm blocks*/
+struct AudioClip
+{
+    std::vector<float> samples;
+    std::vector<uint8_t> adpcm;
+    size_t adpcmFrames = 0;
+    int channels = 1;
+    int sampleRate = MIXER_SAMPLE_RATE;
+
+    bool Compressed() const { return !adpcm.empty(); }
+    size_t Frames() const { return Compressed() ? adpcmFrames : (channels ? samples.size() / channels : 0); }
+    size_t Bytes() const { return samples.size() * sizeof(float) + adpcm.size(); }
+    double Seconds() const { return sampleRate ? static_cast<double>(Frames()) / sampleRate : 0.0; }
+
+    /*convert 8, 16, 24 or 32 bit integer or 32 bit float pcm*/
+    static bool FromPCM(const void* data, size_t bytes, int channels, int sampleRate, int bitsPerSample, bool isFloat, AudioClip& clip);
+
+    /*encode the float samples to adpcm and release them*/
+    void Compress();
+};
+
+struct VoiceParams
+{
+    float gain = 1.f;
+    float pitch = 1.f;
+
+    /*-1 left, 0 center, 1 right*/
+    float pan = 0.f;
+    bool loop = false;
+};
+
+struct MixerBenchmark
+{
+    size_t voices = 0;
+    double msPerBlock = 0.0;
+};
+
+class AudioMixer
+{
+public:
+    AudioMixer(int sampleRate = MIXER_SAMPLE_RATE, size_t maxVoices = MIXER_MAX_VOICES);
+    ~AudioMixer();
+
+    /*returns 0 when all voices are busy*/
+    unsigned int Play(const AudioClip* clip, const VoiceParams& params, uint64_t startFrame = 0);
+    void Stop(unsigned int voice);
+    bool IsPlaying(unsigned int voice) const;
+
+    /*frames played into the clip, 0 while waiting for the start frame*/
+    double Position(unsigned int voice) const;
+
+    void SetGain(unsigned int voice, float gain);
+    void SetPitch(unsigned int voice, float pitch);
+    void SetPan(unsigned int voice, float pan);
+    void SetMasterGain(float gain);
+
+    /*update many voices under one lock*/
+    void SetVoices(const unsigned int* ids, const float* gain, const float* pan, const float* pitch, size_t count);
+
+    /*mix frames of interleaved stereo into out*/
+    void Mix(float* out, size_t frames);
+
+    /*mix MIXER_BLOCK_FRAMES blocks into the sink on a background thread*/
+    void StartOutput(AudioSink* sink);
+    void StopOutput();
+
+    int SampleRate() const { return sampleRate; }
+    uint64_t Cursor() const { return cursor; }
+    size_t ActiveVoices() const;
+
+    /*largest number of resampled voices mixed per block within budgetMs*/
+    static MixerBenchmark Benchmark(double budgetMs);
+
+private:
+    struct Voice
+    {
+        const AudioClip* clip = nullptr;
+        double position = 0.0;
+        uint64_t startFrame = 0;
+        VoiceParams params;
+
+        /*decoded adpcm block plus the first frame of the next one*/
+        std::vector<float> block;
+        size_t decodedBlock = SIZE_MAX;
+        unsigned short generation = 0;
+        bool active = false;
+    };
+
+    Voice* find(unsigned int id);
+    const Voice* find(unsigned int id) const;
+    size_t resample(Voice& v, size_t frames);
+    const float* decode(Voice& v, size_t block);
+    void limit(float* out, size_t frames);
+    void run();
+
+    int sampleRate;
+    std::vector<Voice> voices;
+    std::vector<unsigned int> freeVoices;
+    mutable std::mutex mutex;
+
+    /*planar buffers of one mix call*/
+    std::vector<float> scratchL, scratchR;
+    std::vector<float> busL, busR, busGain;
+
+    std::atomic<uint64_t> cursor;
+
+    float masterGain = 1.f;
+    float envelope = 1.f;
+    float releaseCoefficient;
+
+    AudioSink* sink = nullptr;
+    std::thread output;
+    std::atomic<bool> running;
+};
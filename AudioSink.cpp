@@ -0,0 +1,136 @@
+#include "AudioSink.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+NullSink::NullSink(int _sampleRate, bool _realTime) : sampleRate(_sampleRate), realTime(_realTime)
+{
+}
+
+void NullSink::Submit(const float* /*samples*/, size_t frames)
+{
+    framesSubmitted += frames;
+
+    if (realTime)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(frames * 1000000ull / sampleRate));
+    }
+}
+
+WavFileSink::WavFileSink(const std::string& file, int _sampleRate) : out(file, std::ios::binary), sampleRate(_sampleRate)
+{
+    if (!out)
+    {
+        throw std::runtime_error("Failed to open wav file for writing");
+    }
+
+    writeHeader();
+}
+
+WavFileSink::~WavFileSink()
+{
+    /*patch the sizes now that the length is known*/
+    out.seekp(0);
+    writeHeader();
+}
+
+void WavFileSink::writeHeader()
+{
+    uint32_t dataSize = static_cast<uint32_t>(dataBytes);
+    uint32_t riffSize = 36 + dataSize;
+    uint32_t fmtSize = 16;
+    uint16_t formatTag = 1;
+    uint16_t channels = 2;
+    uint32_t rate = sampleRate;
+    uint16_t blockAlign = channels * sizeof(short);
+    uint32_t byteRate = rate * blockAlign;
+    uint16_t bits = 16;
+
+    out.write("RIFF", 4);
+    out.write((const char*)&riffSize, 4);
+    out.write("WAVE", 4);
+    out.write("fmt ", 4);
+    out.write((const char*)&fmtSize, 4);
+    out.write((const char*)&formatTag, 2);
+    out.write((const char*)&channels, 2);
+    out.write((const char*)&rate, 4);
+    out.write((const char*)&byteRate, 4);
+    out.write((const char*)&blockAlign, 2);
+    out.write((const char*)&bits, 2);
+    out.write("data", 4);
+    out.write((const char*)&dataSize, 4);
+}
+
+void WavFileSink::Submit(const float* samples, size_t frames)
+{
+    pcm.resize(frames * 2);
+
+    for (size_t i = 0; i < frames * 2; i++)
+    {
+        pcm[i] = static_cast<short>(std::clamp(samples[i], -1.f, 1.f) * 32767.f);
+    }
+
+    out.write((const char*)pcm.data(), pcm.size() * sizeof(short));
+    dataBytes += pcm.size() * sizeof(short);
+}
+
+#ifdef _WIN32
+XAudio2Sink::XAudio2Sink(IXAudio2* xaudio, int sampleRate)
+{
+    WAVEFORMATEX format = {};
+    format.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+    format.nChannels = 2;
+    format.nSamplesPerSec = sampleRate;
+    format.wBitsPerSample = 32;
+    format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
+    format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+    bufferEnd = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+    if (FAILED(xaudio->CreateSourceVoice(&voice, &format, 0, XAUDIO2_DEFAULT_FREQ_RATIO, this)))
+    {
+        throw std::runtime_error("Failed to create mixer output voice");
+    }
+
+    voice->Start();
+}
+
+XAudio2Sink::~XAudio2Sink()
+{
+    voice->Stop();
+    voice->DestroyVoice();
+    CloseHandle(bufferEnd);
+}
+
+void XAudio2Sink::OnBufferEnd(void* context)
+{
+    SetEvent(bufferEnd);
+}
+
+void XAudio2Sink::Submit(const float* samples, size_t frames)
+{
+    /*wait until the voice is done with the oldest buffer*/
+    while (true)
+    {
+        XAUDIO2_VOICE_STATE state;
+        voice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+
+        if (state.BuffersQueued < SINK_BUFFER_COUNT)
+            break;
+
+        WaitForSingleObject(bufferEnd, SINK_WAIT_MS);
+    }
+
+    std::vector<float>& buffer = ring[slot];
+    buffer.assign(samples, samples + frames * 2);
+
+    XAUDIO2_BUFFER xb = {};
+    xb.AudioBytes = static_cast<UINT32>(buffer.size() * sizeof(float));
+    xb.pAudioData = reinterpret_cast<const BYTE*>(buffer.data());
+
+    voice->SubmitSourceBuffer(&xb);
+    slot = (slot + 1) % SINK_BUFFER_COUNT;
+}
+#endif
@@ -0,0 +1,93 @@
+/* AudioSink.h
+
+outputs of the AudioMixer, every sink receives interleaved float stereo.
+
+    NullSink      discards the samples, optionally sleeps to run at real time
+    WavFileSink   writes a 16 bit stereo wav file, usable without audio device
+    XAudio2Sink   plays through one xaudio2 source voice (windows only)
+
+Submit() may block, the XAudio2Sink waits until one of its buffers is
+free and so paces the mixer output thread.
+
+    Usage:
+    WavFileSink sink("mix.wav", MIXER_SAMPLE_RATE);
+    mixer.StartOutput(&sink);
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define SINK_BUFFER_COUNT 3
+#define SINK_WAIT_MS 20
+
+class AudioSink
+{
+public:
+    virtual ~AudioSink() = default;
+    virtual void Submit(const float* samples, size_t frames) = 0;
+};
+
+class NullSink : public AudioSink
+{
+public:
+    NullSink(int sampleRate, bool realTime = false);
+
+    void Submit(const float* samples, size_t frames) override;
+    size_t FramesSubmitted() const { return framesSubmitted; }
+
+private:
+    int sampleRate;
+    bool realTime;
+    size_t framesSubmitted = 0;
+};
+
+class WavFileSink : public AudioSink
+{
+public:
+    WavFileSink(const std::string& file, int sampleRate);
+    ~WavFileSink();
+
+    void Submit(const float* samples, size_t frames) override;
+
+private:
+    void writeHeader();
+
+    std::ofstream out;
+    int sampleRate;
+    size_t dataBytes = 0;
+    std::vector<short> pcm;
+};
+
+#ifdef _WIN32
+#include "xaudio2.h"
+
+class XAudio2Sink : public AudioSink, public IXAudio2VoiceCallback
+{
+public:
+    XAudio2Sink(IXAudio2* xaudio, int sampleRate);
+    ~XAudio2Sink();
+
+    void Submit(const float* samples, size_t frames) override;
+
+    /*voice callbacks, called on the xaudio2 thread*/
+    void STDMETHODCALLTYPE OnBufferEnd(void* context) override;
+    void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32 bytesRequired) override {}
+    void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+    void STDMETHODCALLTYPE OnStreamEnd() override {}
+    void STDMETHODCALLTYPE OnBufferStart(void* context) override {}
+    void STDMETHODCALLTYPE OnLoopEnd(void* context) override {}
+    void STDMETHODCALLTYPE OnVoiceError(void* context, HRESULT error) override {}
+
+private:
+    IXAudio2SourceVoice* voice = nullptr;
+    HANDLE bufferEnd = nullptr;
+
+    std::vector<float> ring[SINK_BUFFER_COUNT];
+    size_t slot = 0;
+};
+#endif
@@ -0,0 +1,207 @@
+#include "AudioStream.h"
+#include "util.h"
+
+AudioStream::AudioStream(const std::wstring& file, IMFAttributes* readerConfig, bool _loop)
+    : fileName(file), config(readerConfig), loop(_loop), stopRequested(false), finished(false)
+{
+    bufferEnd = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+    for (auto& b : ring)
+    {
+        b.reserve(STREAM_BUFFER_SIZE * 2);
+    }
+}
+
+AudioStream::~AudioStream()
+{
+    Stop();
+    CloseHandle(bufferEnd);
+}
+
+IMFSourceReader* AudioStream::OpenReader(const std::wstring& file, IMFAttributes* readerConfig, WAVEFORMATEX& format)
+{
+    DWORD streamIndex = (DWORD)MF_SOURCE_READER_FIRST_AUDIO_STREAM;
+
+    IMFSourceReader* reader = nullptr;
+
+    if (FAILED(MFCreateSourceReaderFromURL(file.c_str(), readerConfig, &reader)))
+    {
+        return nullptr;
+    }
+
+    reader->SetStreamSelection((DWORD)MF_SOURCE_READER_ALL_STREAMS, false);
+    reader->SetStreamSelection(streamIndex, true);
+
+    /*let the reader decode compressed formats to pcm*/
+    IMFMediaType* nativeType = nullptr;
+    GUID subType{};
+
+    reader->GetNativeMediaType(streamIndex, 0, &nativeType);
+    nativeType->GetGUID(MF_MT_SUBTYPE, &subType);
+    DXRelease(nativeType);
+
+    if (subType != MFAudioFormat_Float && subType != MFAudioFormat_PCM)
+    {
+        IMFMediaType* pcmType = nullptr;
+        MFCreateMediaType(&pcmType);
+
+        pcmType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio);
+        pcmType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_PCM);
+        reader->SetCurrentMediaType(streamIndex, NULL, pcmType);
+
+        DXRelease(pcmType);
+    }
+
+    IMFMediaType* outputType = nullptr;
+    WAVEFORMATEX* wfx = nullptr;
+    UINT32 size = 0;
+
+    reader->GetCurrentMediaType(streamIndex, &outputType);
+    HRESULT hr = MFCreateWaveFormatExFromMFMediaType(outputType, &wfx, &size);
+    DXRelease(outputType);
+
+    if (FAILED(hr))
+    {
+        DXRelease(reader);
+        return nullptr;
+    }
+
+    format = *wfx;
+    CoTaskMemFree(wfx);
+
+    return reader;
+}
+
+void AudioStream::Start(IXAudio2SourceVoice* _voice)
+{
+    voice = _voice;
+    stopRequested = false;
+    finished = false;
+
+    worker = std::thread(&AudioStream::run, this);
+}
+
+void AudioStream::Stop()
+{
+    stopRequested = true;
+    SetEvent(bufferEnd);
+
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+void AudioStream::OnBufferEnd(void* context)
+{
+    SetEvent(bufferEnd);
+}
+
+void AudioStream::run()
+{
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+    WAVEFORMATEX format;
+    IMFSourceReader* reader = OpenReader(fileName, config, format);
+
+    size_t slot = 0;
+    bool endOfFile = reader == nullptr;
+
+    while (!stopRequested)
+    {
+        XAUDIO2_VOICE_STATE state;
+        voice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+
+        if (endOfFile && state.BuffersQueued == 0)
+        {
+            break;
+        }
+
+        /*a slot can only be refilled after the voice is done with it*/
+        if (endOfFile || state.BuffersQueued >= STREAM_BUFFER_COUNT)
+        {
+            WaitForSingleObject(bufferEnd, STREAM_WAIT_MS);
+            continue;
+        }
+
+        std::vector<BYTE>& buffer = ring[slot];
+        endOfFile = !fill(reader, buffer);
+
+        if (buffer.empty())
+        {
+            continue;
+        }
+
+        XAUDIO2_BUFFER xb = {};
+        xb.AudioBytes = (UINT32)buffer.size();
+        xb.pAudioData = buffer.data();
+        xb.Flags = endOfFile ? XAUDIO2_END_OF_STREAM : 0;
+
+        voice->SubmitSourceBuffer(&xb);
+        slot = (slot + 1) % STREAM_BUFFER_COUNT;
+    }
+
+    DXRelease(reader);
+    CoUninitialize();
+
+    finished = true;
+}
+
+/*decode about STREAM_BUFFER_SIZE bytes, returns false at the end of a non looping file*/
+bool AudioStream::fill(IMFSourceReader* reader, std::vector<BYTE>& buffer)
+{
+    DWORD streamIndex = (DWORD)MF_SOURCE_READER_FIRST_AUDIO_STREAM;
+
+    buffer.clear();
+
+    while (buffer.size() < STREAM_BUFFER_SIZE)
+    {
+        DWORD flags = 0;
+        IMFSample* sample = nullptr;
+
+        if (FAILED(reader->ReadSample(streamIndex, 0, nullptr, &flags, nullptr, &sample)))
+        {
+            return false;
+        }
+
+        if (flags & MF_SOURCE_READERF_ENDOFSTREAM)
+        {
+            DXRelease(sample);
+
+            if (!loop)
+            {
+                return false;
+            }
+
+            /*rewind to the start of the file*/
+            PROPVARIANT position;
+            PropVariantInit(&position);
+            position.vt = VT_I8;
+            position.hVal.QuadPart = 0;
+
+            reader->SetCurrentPosition(GUID_NULL, position);
+            PropVariantClear(&position);
+            continue;
+        }
+
+        if (sample == nullptr)
+        {
+            continue;
+        }
+
+        IMFMediaBuffer* mediaBuffer = nullptr;
+        BYTE* audio = nullptr;
+        DWORD length = 0;
+
+        sample->ConvertToContiguousBuffer(&mediaBuffer);
+        mediaBuffer->Lock(&audio, nullptr, &length);
+
+        buffer.insert(buffer.end(), audio, audio + length);
+
+        mediaBuffer->Unlock();
+        DXRelease(mediaBuffer);
+        DXRelease(sample);
+    }
+
+    return true;
+}
@@ -0,0 +1,75 @@
+/* AudioStream.h
+
+streams a sound file into a source voice instead of decoding it completely.
+
+a worker thread decodes the file with a media foundation source reader
+into a small ring of buffers and submits them to the voice whenever one
+has finished playing. looping streams rewind the reader at the end of the
+file, otherwise the last buffer is flagged as end of stream.
+
+the stream is the callback of its voice, so it has to outlive the voice:
+
+    AudioStream* s = new AudioStream(file, config, true);
+    xaudio->CreateSourceVoice(&voice, &format, 0, XAUDIO2_DEFAULT_FREQ_RATIO, s);
+    s->Start(voice);
+    voice->Start();
+    ...
+    s->Stop();
+    voice->DestroyVoice();
+    delete s;
+
+*/
+
+#pragma once
+
+#include "xaudio2.h"
+#include <mfapi.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STREAM_BUFFER_COUNT 3
+#define STREAM_BUFFER_SIZE 32768
+#define STREAM_WAIT_MS 50
+
+class AudioStream : public IXAudio2VoiceCallback
+{
+public:
+    AudioStream(const std::wstring& file, IMFAttributes* readerConfig, bool loop);
+    ~AudioStream();
+
+    void Start(IXAudio2SourceVoice* voice);
+    void Stop();
+    bool Finished() const { return finished; }
+
+    /*open a reader that outputs pcm, returns nullptr on failure*/
+    static IMFSourceReader* OpenReader(const std::wstring& file, IMFAttributes* readerConfig, WAVEFORMATEX& format);
+
+    /*voice callbacks, called on the xaudio2 thread*/
+    void STDMETHODCALLTYPE OnBufferEnd(void* context) override;
+    void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32 bytesRequired) override {}
+    void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+    void STDMETHODCALLTYPE OnStreamEnd() override {}
+    void STDMETHODCALLTYPE OnBufferStart(void* context) override {}
+    void STDMETHODCALLTYPE OnLoopEnd(void* context) override {}
+    void STDMETHODCALLTYPE OnVoiceError(void* context, HRESULT error) override {}
+
+private:
+    void run();
+    bool fill(IMFSourceReader* reader, std::vector<BYTE>& buffer);
+
+    std::wstring fileName;
+    IMFAttributes* config = nullptr;
+    bool loop = false;
+
+    IXAudio2SourceVoice* voice = nullptr;
+    std::thread worker;
+    HANDLE bufferEnd = nullptr;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> finished;
+
+    std::vector<BYTE> ring[STREAM_BUFFER_COUNT];
+};
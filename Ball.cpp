@@ -13,10 +13,18 @@ Ball::Ball(std::string id, ResourceManager* r, std::vector<PlayableChar*> p)
     Translation = XMFLOAT3(0.f, ballHeight,0.f);
     
     Rotation = XMFLOAT3(0.f, 0.f, 0.f);
+    Velocity = XMFLOAT3(0.f, 0.f, 0.f);
+    Direction = XMFLOAT3(0.f, 0.f, 0.f);
     spinRotation = 0;
 
     bounceFactor = 0.75f;
     bounceTime = 1.f;
+    resetTime = 0.f;
+    spawnTime = 0.f;
+    inplayTime = 0.f;
+    distanceV = XMFLOAT3(0.f, 0.f, 0.f);
+
+    Seed(Random::Stream(RandomStream::Ball));
 
     players = p;
 
@@ -46,7 +54,10 @@ void Ball::Update(float deltaTime)
         }
         else
         {
-            res->getSound()->add("ball_hit");
+            /*the ground was crossed at bounce time 2 * v / g, during the previous step*/
+            float impact = 2.f * Velocity.y / GRAVITY - (bounceTime - deltaTime);
+            res->getSound()->add3D("ball_hit", Translation, XMFLOAT3(0.f, 0.f, 0.f), false, SOUND_PRIORITY_NORMAL, impact);
+
             bounceTime = 0.f;
             Translation.y = ballHeight;
             Velocity.y = Velocity.y * 0.65f;
@@ -129,7 +140,8 @@ void Ball::Update(float deltaTime)
 
                 DBOUT("Player " << index << " touched the ball\n");
                 bool skip = false;
-                res->getSound()->add("ball_hit");
+                res->getSound()->add3D("ball_hit", Translation, XMFLOAT3(Velocity.x * Direction.x, 0.f, Velocity.x * Direction.z),
+                                       false, SOUND_PRIORITY_NORMAL, contactTime(pPos, players[index]->hitBox) * deltaTime);
                 spinTimer = 0;
 
                 switch (index)
@@ -268,7 +280,7 @@ void Ball::Update(float deltaTime)
 
         if (resetB)
         {
-            res->getSound()->add("boom");
+            res->getSound()->add3D("boom", Translation, XMFLOAT3(0.f, 0.f, 0.f), false, SOUND_PRIORITY_HIGH);
             ballState = BallState::RESET;
             distanceV = Translation;
 
@@ -427,6 +439,35 @@ void Ball::resetBallFull()
 }
 
 
+/*fraction of the step at which the ball moving from 'from' to its position first touched the box*/
+float Ball::contactTime(const XMFLOAT3& from, const BoundingOrientedBox& box) const
+{
+    XMVECTOR start = XMLoadFloat3(&from);
+    XMVECTOR end = XMLoadFloat3(&Translation);
+
+    float low = 0.f;
+    float high = 1.f;
+
+    BoundingSphere s = hitBox;
+    XMStoreFloat3(&s.Center, start);
+
+    if (s.Intersects(box))
+        return 0.f;
+
+    for (int i = 0; i < BALL_CONTACT_ITERATIONS; i++)
+    {
+        float mid = (low + high) * 0.5f;
+        XMStoreFloat3(&s.Center, XMVectorLerp(start, end, mid));
+
+        if (s.Intersects(box))
+            high = mid;
+        else
+            low = mid;
+    }
+
+    return high;
+}
+
 void Ball::resetBall()
 {
     ballState = BallState::FREEZE;
@@ -438,7 +479,7 @@ void Ball::resetBall()
     Translation = XMFLOAT3(0.f, ballHeight, 0.f);
 
     /*random direction*/
-    double rDir = rand() / (RAND_MAX + 1.) * 2 * XM_PI;
+    double rDir = random() * 2 * XM_PI;
 
     Direction.x = (float)cos(rDir);
     Direction.z = (float)sin(rDir);
@@ -446,11 +487,11 @@ void Ball::resetBall()
     double assertTest = sqrt(Direction.x * Direction.x + Direction.z * Direction.z);
     DBOUT("Direction Length: " << assertTest << " (" << rDir << ")\n");
 
-    if (rand() % 2 == 0)
+    if (random() < 0.5f)
     {
         Direction.x *= -1;
     }
-    if (rand() % 2 == 0)
+    if (random() < 0.5f)
     {
         Direction.y *= -1;
     }
@@ -469,4 +510,60 @@ void Ball::resetBall()
     lastHitBy = -1;
     collisionOn = true;
     resetB = false;
-}
\ No newline at end of file
+}
+
+void Ball::Save(BallSnapshot& s) const
+{
+    s.Translation = Translation;
+    s.Rotation = Rotation;
+    s.Velocity = Velocity;
+    s.Direction = Direction;
+    s.distanceV = distanceV;
+    s.Color = Color;
+    s.hitBox = hitBox;
+    s.spinRotation = spinRotation;
+    s.spinTimer = spinTimer;
+    s.bounceTime = bounceTime;
+    s.resetTime = resetTime;
+    s.spawnTime = spawnTime;
+    s.inplayTime = inplayTime;
+    s.lastTouch = lastTouch;
+    s.lastHitBy = lastHitBy;
+    s.collisionOn = collisionOn;
+    s.resetB = resetB;
+    s.ballState = ballState;
+    s.randomState = randomState;
+}
+
+void Ball::Load(const BallSnapshot& s)
+{
+    Translation = s.Translation;
+    Rotation = s.Rotation;
+    Velocity = s.Velocity;
+    Direction = s.Direction;
+    distanceV = s.distanceV;
+    Color = s.Color;
+    hitBox = s.hitBox;
+    spinRotation = s.spinRotation;
+    spinTimer = s.spinTimer;
+    bounceTime = s.bounceTime;
+    resetTime = s.resetTime;
+    spawnTime = s.spawnTime;
+    inplayTime = s.inplayTime;
+    lastTouch = s.lastTouch;
+    lastHitBy = s.lastHitBy;
+    collisionOn = s.collisionOn;
+    resetB = s.resetB;
+    ballState = s.ballState;
+    randomState = s.randomState;
+}
+
+void Ball::Seed(const Pcg32& stream)
+{
+    randomState = stream;
+}
+
+float Ball::random()
+{
+    return randomState.Float();
+}
@@ -7,12 +7,27 @@
 #include "PlayableChar.h"
 
 #define BALL_SPIN_COEFF 0.015
+#define BALL_CONTACT_ITERATIONS 8
 
 enum class BallState
 {
     SPAWN, FREEZE, INPLAY, RESET
 };
 
+/*simulated state of the ball, copied as a whole for rollback*/
+struct BallSnapshot
+{
+    XMFLOAT3 Translation, Rotation, Velocity, Direction, distanceV;
+    XMFLOAT4 Color;
+    BoundingSphere hitBox;
+    double spinRotation, spinTimer;
+    float bounceTime, resetTime, spawnTime, inplayTime;
+    int lastTouch, lastHitBy;
+    bool collisionOn, resetB;
+    BallState ballState;
+    Pcg32 randomState;
+};
+
 class Ball
 {
 
@@ -38,6 +53,12 @@ public:
 
     void resetBallFull();
 
+    void Save(BallSnapshot& s) const;
+    void Load(const BallSnapshot& s);
+
+    /*a stream of the match seed, peers of an online match seed the same directions*/
+    void Seed(const Pcg32& stream);
+
 private:
 
     std::string modelID;
@@ -59,8 +80,13 @@ private:
     int lastHitBy = -1;
 
     BallState ballState;
+
+    /*kept in the ball so a snapshot restores it*/
+    Pcg32 randomState;
     
     void resetBall();
+    float random();
+    float contactTime(const XMFLOAT3& from, const BoundingOrientedBox& box) const;
 
 
 };
\ No newline at end of file
@@ -1,13 +1,14 @@
 #include "Blur.h"
+#include "InputLayout.h"
 
-Blur::Blur() : mBlurredOutputTexSRV(0), mBlurredOutputTexUAV(0), width(0), height(0), format(DXGI_FORMAT_R8G8B8A8_UNORM)
+Blur::Blur() : mBlurredOutputTexSRV(0), mBlurredOutputTexUAV(0), width(0), height(0), format(DXGI_FORMAT_R8G8B8A8_UNORM),
+               quadVB(0), quadIB(0)
 {
 }
 
 Blur::~Blur()
 {
-    DXRelease(mBlurredOutputTexSRV);
-    DXRelease(mBlurredOutputTexUAV);
+    release();
 }
 
 ID3D11ShaderResourceView* Blur::getOutput()
@@ -15,20 +16,97 @@ ID3D11ShaderResourceView* Blur::getOutput()
     return mBlurredOutputTexSRV;
 }
 
-void Blur::Init(ID3D11Device* device, UINT _width, UINT _height, DXGI_FORMAT _format)
+void Blur::release()
 {
-    
-    // Start fresh.
     DXRelease(mBlurredOutputTexSRV);
     DXRelease(mBlurredOutputTexUAV);
 
+    for (auto& l : levels)
+    {
+        for (int i = 0; i < 2; i++)
+        {
+            DXRelease(l.srv[i]);
+            DXRelease(l.uav[i]);
+        }
+
+        DXRelease(l.rtv);
+    }
+
+    levels.clear();
+
+    DXRelease(quadVB);
+    DXRelease(quadIB);
+}
+
+void Blur::Init(ID3D11Device* device, UINT _width, UINT _height, DXGI_FORMAT _format)
+{
+
+    // Start fresh.
+    release();
+
     width = _width;
     height = _height;
     format = _format;
 
+    createTarget(device, width, height, format, &mBlurredOutputTexSRV, &mBlurredOutputTexUAV, nullptr);
+
+    /*mip chain, levels smaller than 2x2 are not worth it*/
+    UINT w = width, h = height;
+
+    for (int m = 0; m < BLUR_MAX_MIPS; m++)
+    {
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+
+        if (w < 2 || h < 2)
+            break;
+
+        Level l;
+        l.width = w;
+        l.height = h;
+
+        createTarget(device, w, h, format, &l.srv[0], &l.uav[0], &l.rtv);
+        createTarget(device, w, h, format, &l.srv[1], &l.uav[1], nullptr);
+
+        levels.push_back(l);
+    }
+
+    /*quad over the whole target, placed by the world matrix in resample*/
+    Vertex::Standard vertices[4] =
+    {
+        Vertex::Standard(-1.f, -1.f, 0.f, 0.f, 1.f, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f),
+        Vertex::Standard(-1.f, +1.f, 0.f, 0.f, 0.f, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f),
+        Vertex::Standard(+1.f, +1.f, 0.f, 1.f, 0.f, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f),
+        Vertex::Standard(+1.f, -1.f, 0.f, 1.f, 1.f, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f)
+    };
+
+    UINT indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+    D3D11_BUFFER_DESC vbd;
+    vbd.Usage = D3D11_USAGE_IMMUTABLE;
+    vbd.ByteWidth = sizeof(vertices);
+    vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    vbd.CPUAccessFlags = 0;
+    vbd.MiscFlags = 0;
+    vbd.StructureByteStride = 0;
+    D3D11_SUBRESOURCE_DATA vinitData;
+    vinitData.pSysMem = vertices;
+    device->CreateBuffer(&vbd, &vinitData, &quadVB);
+
+    D3D11_BUFFER_DESC ibd = vbd;
+    ibd.ByteWidth = sizeof(indices);
+    ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    D3D11_SUBRESOURCE_DATA iinitData;
+    iinitData.pSysMem = indices;
+    device->CreateBuffer(&ibd, &iinitData, &quadIB);
+}
+
+void Blur::createTarget(ID3D11Device* device, UINT w, UINT h, DXGI_FORMAT format, ID3D11ShaderResourceView** srv,
+                        ID3D11UnorderedAccessView** uav, ID3D11RenderTargetView** rtv)
+{
     D3D11_TEXTURE2D_DESC blurredTexDesc;
-    blurredTexDesc.Width = width;
-    blurredTexDesc.Height = height;
+    blurredTexDesc.Width = w;
+    blurredTexDesc.Height = h;
     blurredTexDesc.MipLevels = 1;
     blurredTexDesc.ArraySize = 1;
     blurredTexDesc.Format = format;
@@ -39,6 +117,11 @@ void Blur::Init(ID3D11Device* device, UINT _width, UINT _height, DXGI_FORMAT _fo
     blurredTexDesc.CPUAccessFlags = 0;
     blurredTexDesc.MiscFlags = 0;
 
+    if (rtv != nullptr)
+    {
+        blurredTexDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+    }
+
     ID3D11Texture2D* blurredTex = 0;
     device->CreateTexture2D(&blurredTexDesc, 0, &blurredTex);
 
@@ -50,89 +133,207 @@ void Blur::Init(ID3D11Device* device, UINT _width, UINT _height, DXGI_FORMAT _fo
         srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
         srvDesc.Texture2D.MostDetailedMip = 0;
         srvDesc.Texture2D.MipLevels = 1;
-        device->CreateShaderResourceView(blurredTex, &srvDesc, &mBlurredOutputTexSRV);
+        device->CreateShaderResourceView(blurredTex, &srvDesc, srv);
 
         D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc;
         uavDesc.Format = format;
         uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
         uavDesc.Texture2D.MipSlice = 0;
-        device->CreateUnorderedAccessView(blurredTex, &uavDesc, &mBlurredOutputTexUAV);
+        device->CreateUnorderedAccessView(blurredTex, &uavDesc, uav);
+
+        if (rtv != nullptr)
+        {
+            device->CreateRenderTargetView(blurredTex, 0, rtv);
+        }
     }
     // Views save a reference to the texture so we can release our reference.
     DXRelease(blurredTex);
 }
 
-void Blur::BlurSRV(ID3D11DeviceContext* context, ID3D11ShaderResourceView* inputSRV, ID3D11UnorderedAccessView* inputUAV, int count)
+void Blur::BlurSRV(ID3D11DeviceContext* context, ID3D11ShaderResourceView* inputSRV, ID3D11UnorderedAccessView* inputUAV,
+                   ID3D11RenderTargetView* inputRTV, float sigma, UINT regionWidth, UINT regionHeight)
 {
+    UINT w = regionWidth > 0 ? (std::min)(regionWidth, width) : width;
+    UINT h = regionHeight > 0 ? (std::min)(regionHeight, height) : height;
 
-    for (int i = 0; i < count; i++)
-    {
+    /*the input may still be bound as render target*/
+    context->OMSetRenderTargets(0, 0, 0);
 
-        /*horizontal*/
-        D3DX11_TECHNIQUE_DESC tech;
-        Shaders::blurShader->HorizontalBlur->GetDesc(&tech);
+    int mips = (std::min)(BlurKernel::Mips(sigma, BLUR_SHADER_RADIUS), (int)levels.size());
 
-        for (UINT p = 0; p < tech.Passes; p++)
-        {
-            Shaders::blurShader->SetInput(inputSRV);
-            Shaders::blurShader->SetOutput(mBlurredOutputTexUAV);
+    /*sigma of the smallest level, the kernel is cut off at BLUR_SHADER_RADIUS beyond BLUR_MAX_MIPS*/
+    SetGauss(sigma / (1 << mips));
 
-            Shaders::blurShader->HorizontalBlur->GetPassByIndex(p)->Apply(0, context);
+    if (mips == 0 || inputRTV == nullptr)
+    {
+        blurPass(context, inputSRV, inputUAV, mBlurredOutputTexSRV, mBlurredOutputTexUAV, w, h);
+        return;
+    }
 
-            UINT numGroups = (UINT)ceilf(width / NUM_THREADS);
-            context->Dispatch(numGroups, height, 1);
+    /*size of the input texture, it can be smaller than the blur*/
+    ID3D11Resource* resource = nullptr;
+    inputSRV->GetResource(&resource);
 
-        }
+    D3D11_TEXTURE2D_DESC inputDesc;
+    static_cast<ID3D11Texture2D*>(resource)->GetDesc(&inputDesc);
+    DXRelease(resource);
 
-        /*unbind*/
-        ID3D11ShaderResourceView* nullSRV[1] = { 0 };
-        context->CSSetShaderResources(0, 1, nullSRV);
+    w = (std::min)(w, inputDesc.Width);
+    h = (std::min)(h, inputDesc.Height);
 
-        ID3D11UnorderedAccessView* nullUAV[1] = { 0 };
-        context->CSSetUnorderedAccessViews(0, 1, nullUAV, 0);
+    /*used region of every level*/
+    std::vector<UINT> rw(mips + 1), rh(mips + 1);
+    rw[0] = w;
+    rh[0] = h;
 
-        /*vertical*/
-        Shaders::blurShader->VerticalBlur->GetDesc(&tech);
+    for (int m = 1; m <= mips; m++)
+    {
+        rw[m] = (std::min)((rw[m - 1] + 1) / 2, levels[m - 1].width);
+        rh[m] = (std::min)((rh[m - 1] + 1) / 2, levels[m - 1].height);
+    }
 
-        for (UINT p = 0; p < tech.Passes; p++)
-        {
-            Shaders::blurShader->SetInput(mBlurredOutputTexSRV);
-            Shaders::blurShader->SetOutput(inputUAV);
-            Shaders::blurShader->VerticalBlur->GetPassByIndex(p)->Apply(0, context);
+    /*down*/
+    resample(context, inputSRV, inputDesc.Width, inputDesc.Height, rw[0], rh[0], levels[0].rtv, rw[1], rh[1]);
 
-            UINT numGroups = (UINT)ceilf(height / NUM_THREADS);
-            context->Dispatch(width, numGroups, 1);
-        }
+    for (int m = 2; m <= mips; m++)
+    {
+        const Level& src = levels[m - 2];
+        resample(context, src.srv[0], src.width, src.height, rw[m - 1], rh[m - 1], levels[m - 1].rtv, rw[m], rh[m]);
+    }
 
-        context->CSSetShaderResources(0, 1, nullSRV);
-        context->CSSetUnorderedAccessViews(0, 1, nullUAV, 0);
+    const Level& smallest = levels[mips - 1];
+    blurPass(context, smallest.srv[0], smallest.uav[0], smallest.srv[1], smallest.uav[1], rw[mips], rh[mips]);
 
+    /*up*/
+    for (int m = mips; m >= 1; m--)
+    {
+        const Level& src = levels[m - 1];
+        ID3D11RenderTargetView* rtv = m > 1 ? levels[m - 2].rtv : inputRTV;
+
+        resample(context, src.srv[0], src.width, src.height, rw[m], rh[m], rtv, rw[m - 1], rh[m - 1]);
     }
 
-    context->CSSetShader(0, 0, 0);
+    context->OMSetRenderTargets(0, 0, 0);
 }
 
-void Blur::SetGauss(float s)
+void Blur::blurPass(ID3D11DeviceContext* context, ID3D11ShaderResourceView* srv, ID3D11UnorderedAccessView* uav,
+                    ID3D11ShaderResourceView* tempSRV, ID3D11UnorderedAccessView* tempUAV, UINT w, UINT h)
 {
+    /*horizontal*/
+    D3DX11_TECHNIQUE_DESC tech;
+    Shaders::blurShader->HorizontalBlur->GetDesc(&tech);
 
-    float d = 2.0f * s * s;
+    for (UINT p = 0; p < tech.Passes; p++)
+    {
+        Shaders::blurShader->SetInput(srv);
+        Shaders::blurShader->SetOutput(tempUAV);
 
-    float weights[9];
-    float sum = 0.0f;
-    for (int i = 0; i < 8; ++i)
+        Shaders::blurShader->HorizontalBlur->GetPassByIndex(p)->Apply(0, context);
+
+        UINT numGroups = (UINT)ceilf(w / NUM_THREADS);
+        context->Dispatch(numGroups, h, 1);
+
+    }
+
+    /*unbind*/
+    ID3D11ShaderResourceView* nullSRV[1] = { 0 };
+    context->CSSetShaderResources(0, 1, nullSRV);
+
+    ID3D11UnorderedAccessView* nullUAV[1] = { 0 };
+    context->CSSetUnorderedAccessViews(0, 1, nullUAV, 0);
+
+    /*vertical*/
+    Shaders::blurShader->VerticalBlur->GetDesc(&tech);
+
+    for (UINT p = 0; p < tech.Passes; p++)
     {
-        float x = (float)i;
-        weights[i] = expf(-x * x / d);
+        Shaders::blurShader->SetInput(tempSRV);
+        Shaders::blurShader->SetOutput(uav);
+        Shaders::blurShader->VerticalBlur->GetPassByIndex(p)->Apply(0, context);
 
-        sum += weights[i];
+        UINT numGroups = (UINT)ceilf(h / NUM_THREADS);
+        context->Dispatch(w, numGroups, 1);
     }
 
-    // Divide by the sum so all the weights add up to 1.0.
-    for (int i = 0; i < 8; ++i)
+    context->CSSetShaderResources(0, 1, nullSRV);
+    context->CSSetUnorderedAccessViews(0, 1, nullUAV, 0);
+
+    context->CSSetShader(0, 0, 0);
+}
+
+void Blur::resample(ID3D11DeviceContext* context, ID3D11ShaderResourceView* srv, UINT srcTexW, UINT srcTexH,
+                    UINT srcW, UINT srcH, ID3D11RenderTargetView* rtv, UINT dstW, UINT dstH)
+{
+    /*texel t of the source read by pixel x of the target, t = a * x + b. shrinking averages
+      the texels under a pixel, growing maps the outer texel centers onto each other so
+      the wrapping sampler of the quad never reads past the used region*/
+    auto axis = [](float src, float dst, float& a, float& b)
     {
-        weights[i] /= sum;
+        if (dst < src || src <= 1.f || dst <= 1.f)
+        {
+            a = src / dst;
+            b = 0.f;
+        }
+        else
+        {
+            a = (src - 1.f) / (dst - 1.f);
+            b = 0.5f * (1.f - a);
+        }
+    };
+
+    float ax, bx, ay, by;
+    axis((float)srcW, (float)dstW, ax, bx);
+    axis((float)srcH, (float)dstH, ay, by);
+
+    /*pixels where the quad corners at texel 0 and the texture size land*/
+    float x0 = -bx / ax, x1 = (srcTexW - bx) / ax;
+    float y0 = -by / ay, y1 = (srcTexH - by) / ay;
+
+    float sx = (x1 - x0) / dstW;
+    float sy = (y1 - y0) / dstH;
+
+    XMMATRIX world = XMMatrixScaling(sx, sy, 1.f) * XMMatrixTranslation(-1.f + (x0 + x1) / dstW, 1.f - (y0 + y1) / dstH, 0.f);
+
+    D3D11_VIEWPORT viewport;
+    viewport.TopLeftX = 0.f;
+    viewport.TopLeftY = 0.f;
+    viewport.Width = (float)dstW;
+    viewport.Height = (float)dstH;
+    viewport.MinDepth = 0.f;
+    viewport.MaxDepth = 1.f;
+
+    context->OMSetRenderTargets(1, &rtv, 0);
+    context->RSSetViewports(1, &viewport);
+
+    UINT stride = sizeof(Vertex::Standard);
+    UINT offset = 0;
+
+    context->IASetInputLayout(InputLayouts::Standard);
+    context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    context->IASetVertexBuffers(0, 1, &quadVB, &stride, &offset);
+    context->IASetIndexBuffer(quadIB, DXGI_FORMAT_R32_UINT, 0);
+
+    ID3DX11EffectTechnique* tech = Shaders::fullscreenShader->ViewStandard;
+    D3DX11_TECHNIQUE_DESC techDesc;
+
+    tech->GetDesc(&techDesc);
+    for (UINT p = 0; p < techDesc.Passes; ++p)
+    {
+        Shaders::fullscreenShader->SetWorldViewProj(world);
+        Shaders::fullscreenShader->SetTexture(srv);
+
+        tech->GetPassByIndex(p)->Apply(0, context);
+        context->DrawIndexed(6, 0, 0);
     }
 
-    Shaders::blurShader->SetWeights(weights);
+    /*the source is the next render target*/
+    ID3D11ShaderResourceView* nullSRV[1] = { 0 };
+    context->PSSetShaderResources(0, 1, nullSRV);
+}
 
+void Blur::SetGauss(float s)
+{
+    /*the kernel radius is compiled into the shader*/
+    BlurKernel kernel = BlurKernel::Gaussian(s, BLUR_SHADER_RADIUS);
+    Shaders::blurShader->SetWeights(kernel.Weights().data());
 }
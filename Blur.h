@@ -13,15 +13,49 @@ public:
 
     void Init(ID3D11Device* device, UINT _width, UINT _height, DXGI_FORMAT _format);
 
-    void BlurSRV(ID3D11DeviceContext* context, ID3D11ShaderResourceView* inputSRV,
-                 ID3D11UnorderedAccessView* inputUAV, int count);
+    /*gaussian blur of the input in place, sigma in texels of the input. blur.fx only has
+      BLUR_SHADER_RADIUS taps, so wider blurs halve the input BlurKernel::Mips times with
+      the fullscreen quad, blur the smallest level and scale it up again into inputRTV.
+      only the top left regionWidth x regionHeight texels are blurred if given*/
+    void BlurSRV(ID3D11DeviceContext* context, ID3D11ShaderResourceView* inputSRV, ID3D11UnorderedAccessView* inputUAV,
+                 ID3D11RenderTargetView* inputRTV, float sigma, UINT regionWidth = 0, UINT regionHeight = 0);
 
     void SetGauss(float s);
 
 private:
+    /*half size targets of the mip chain*/
+    struct Level
+    {
+        UINT width = 0;
+        UINT height = 0;
+
+        /*0 holds the image of the level, 1 the horizontal pass*/
+        ID3D11ShaderResourceView* srv[2] = {};
+        ID3D11UnorderedAccessView* uav[2] = {};
+        ID3D11RenderTargetView* rtv = nullptr;
+    };
+
+    void release();
+
+    /*one horizontal and one vertical pass of the 11 tap kernel*/
+    void blurPass(ID3D11DeviceContext* context, ID3D11ShaderResourceView* srv, ID3D11UnorderedAccessView* uav,
+                  ID3D11ShaderResourceView* tempSRV, ID3D11UnorderedAccessView* tempUAV, UINT w, UINT h);
+
+    /*draws the top left srcW x srcH texels of a srcTexW x srcTexH texture over dstW x dstH texels of rtv*/
+    void resample(ID3D11DeviceContext* context, ID3D11ShaderResourceView* srv, UINT srcTexW, UINT srcTexH,
+                  UINT srcW, UINT srcH, ID3D11RenderTargetView* rtv, UINT dstW, UINT dstH);
+
+    static void createTarget(ID3D11Device* device, UINT w, UINT h, DXGI_FORMAT format, ID3D11ShaderResourceView** srv,
+                             ID3D11UnorderedAccessView** uav, ID3D11RenderTargetView** rtv);
+
     UINT width, height;
     DXGI_FORMAT format;
 
     ID3D11ShaderResourceView* mBlurredOutputTexSRV;
     ID3D11UnorderedAccessView* mBlurredOutputTexUAV;
-};
\ No newline at end of file
+
+    std::vector<Level> levels;
+
+    ID3D11Buffer* quadVB;
+    ID3D11Buffer* quadIB;
+};
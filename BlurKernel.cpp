@@ -0,0 +1,397 @@
+#include "BlurKernel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+
+#if defined(__AVX__)
+#define BLUR_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BLUR_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define BLUR_NEON
+#include <arm_neon.h>
+#endif
+
+BlurKernel BlurKernel::Gaussian(float sigma, int radius)
+{
+    BlurKernel k;
+    k.sigma = std::max(sigma, 0.01f);
+    k.radius = radius > 0 ? radius : std::max(1, static_cast<int>(std::ceil(BLUR_SIGMA_RADIUS * k.sigma)));
+    k.weights.resize(2 * k.radius + 1);
+
+    float d = 2.f * k.sigma * k.sigma;
+    float sum = 0.f;
+
+    for (int i = -k.radius; i <= k.radius; i++)
+    {
+        float w = std::exp(-(i * i) / d);
+        k.weights[i + k.radius] = w;
+        sum += w;
+    }
+
+    for (auto& w : k.weights)
+    {
+        w /= sum;
+    }
+
+    return k;
+}
+
+int BlurKernel::Mips(float sigma, int maxRadius)
+{
+    int mips = 0;
+
+    while (mips < BLUR_MAX_MIPS && std::ceil(BLUR_SIGMA_RADIUS * sigma / (1 << mips)) > maxRadius)
+    {
+        mips++;
+    }
+
+    return mips;
+}
+
+std::vector<BlurTap> BlurKernel::Taps() const
+{
+    std::vector<BlurTap> taps;
+
+    for (int i = -radius; i <= radius; i++)
+    {
+        taps.push_back({ static_cast<float>(i), weights[i + radius] });
+    }
+
+    return taps;
+}
+
+std::vector<BlurTap> BlurKernel::LinearTaps() const
+{
+    std::vector<BlurTap> taps;
+    taps.push_back({ 0.f, weights[radius] });
+
+    /*texels i and i + 1 read at the weighted position between them*/
+    for (int i = 1; i <= radius; i += 2)
+    {
+        float w0 = weights[radius + i];
+        float w1 = i + 1 <= radius ? weights[radius + i + 1] : 0.f;
+        float w = w0 + w1;
+        float offset = w > 0.f ? (i * w0 + (i + 1) * w1) / w : static_cast<float>(i);
+
+        taps.push_back({ offset, w });
+        taps.push_back({ -offset, w });
+    }
+
+    return taps;
+}
+
+void BlurImage::Resize(int w, int h)
+{
+    width = std::max(w, 0);
+    height = std::max(h, 0);
+    rgba.assign(static_cast<size_t>(width) * height * 4, 0.f);
+}
+
+/*dst += a * wa + b * wb*/
+static void addWeighted(float* dst, const float* a, float wa, const float* b, float wb, size_t n)
+{
+    size_t i = 0;
+
+#if defined(BLUR_AVX)
+    __m256 va = _mm256_set1_ps(wa);
+    __m256 vb = _mm256_set1_ps(wb);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 d = _mm256_loadu_ps(dst + i);
+        d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(a + i), va));
+        d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_loadu_ps(b + i), vb));
+        _mm256_storeu_ps(dst + i, d);
+    }
+#elif defined(BLUR_SSE)
+    __m128 va = _mm_set1_ps(wa);
+    __m128 vb = _mm_set1_ps(wb);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 d = _mm_loadu_ps(dst + i);
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(a + i), va));
+        d = _mm_add_ps(d, _mm_mul_ps(_mm_loadu_ps(b + i), vb));
+        _mm_storeu_ps(dst + i, d);
+    }
+#elif defined(BLUR_NEON)
+    float32x4_t va = vdupq_n_f32(wa);
+    float32x4_t vb = vdupq_n_f32(wb);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t d = vld1q_f32(dst + i);
+        d = vmlaq_f32(d, vld1q_f32(a + i), va);
+        d = vmlaq_f32(d, vld1q_f32(b + i), vb);
+        vst1q_f32(dst + i, d);
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        dst[i] += a[i] * wa + b[i] * wb;
+    }
+}
+
+/*a tap reads texel floor(offset) and the next one with the fraction*/
+static void splitTap(const BlurTap& t, int& texel, float& w0, float& w1)
+{
+    float f = std::floor(t.offset);
+    texel = static_cast<int>(f);
+    w1 = (t.offset - f) * t.weight;
+    w0 = t.weight - w1;
+}
+
+void CpuBlur::Blur(BlurImage& image, const BlurKernel& kernel)
+{
+    Blur(image, kernel.Taps());
+}
+
+void CpuBlur::Blur(BlurImage& image, const std::vector<BlurTap>& taps)
+{
+    if (image.width == 0 || image.height == 0 || taps.empty())
+        return;
+
+    const int w = image.width;
+    const int h = image.height;
+    const size_t rowFloats = static_cast<size_t>(w) * 4;
+
+    int reach = 0;
+
+    for (const auto& t : taps)
+    {
+        reach = std::max(reach, static_cast<int>(std::ceil(std::fabs(t.offset))) + 1);
+    }
+
+    BlurImage temp;
+    temp.Resize(w, h);
+
+    /*horizontal, the row is padded with its edge texels like the clamped reads of blur.fx*/
+    std::vector<float> padded((static_cast<size_t>(w) + 2 * reach) * 4);
+
+    for (int y = 0; y < h; y++)
+    {
+        const float* src = image.Row(y);
+
+        for (int x = -reach; x < w + reach; x++)
+        {
+            const float* p = src + std::clamp(x, 0, w - 1) * 4;
+            std::copy(p, p + 4, padded.begin() + (x + reach) * 4);
+        }
+
+        float* dst = temp.Row(y);
+
+        for (const auto& t : taps)
+        {
+            int texel;
+            float w0, w1;
+            splitTap(t, texel, w0, w1);
+
+            const float* a = padded.data() + (texel + reach) * 4;
+            addWeighted(dst, a, w0, a + 4, w1, rowFloats);
+        }
+    }
+
+    /*vertical, whole rows at once*/
+    std::fill(image.rgba.begin(), image.rgba.end(), 0.f);
+
+    for (int y = 0; y < h; y++)
+    {
+        float* dst = image.Row(y);
+
+        for (const auto& t : taps)
+        {
+            int texel;
+            float w0, w1;
+            splitTap(t, texel, w0, w1);
+
+            const float* a = temp.Row(std::clamp(y + texel, 0, h - 1));
+            const float* b = temp.Row(std::clamp(y + texel + 1, 0, h - 1));
+            addWeighted(dst, a, w0, b, w1, rowFloats);
+        }
+    }
+}
+
+/*2x2 box, odd sizes repeat the last texel*/
+static BlurImage downsample(const BlurImage& src)
+{
+    BlurImage dst;
+    dst.Resize((src.width + 1) / 2, (src.height + 1) / 2);
+
+    for (int y = 0; y < dst.height; y++)
+    {
+        const float* r0 = src.Row(std::min(2 * y, src.height - 1));
+        const float* r1 = src.Row(std::min(2 * y + 1, src.height - 1));
+        float* d = dst.Row(y);
+
+        for (int x = 0; x < dst.width; x++)
+        {
+            int x0 = std::min(2 * x, src.width - 1) * 4;
+            int x1 = std::min(2 * x + 1, src.width - 1) * 4;
+
+            for (int c = 0; c < 4; c++)
+            {
+                d[x * 4 + c] = 0.25f * (r0[x0 + c] + r0[x1 + c] + r1[x0 + c] + r1[x1 + c]);
+            }
+        }
+    }
+
+    return dst;
+}
+
+/*bilinear with clamped edges, texel centers line up like a sampled texture*/
+static void upsample(const BlurImage& src, BlurImage& dst)
+{
+    float sx = static_cast<float>(src.width) / dst.width;
+    float sy = static_cast<float>(src.height) / dst.height;
+
+    for (int y = 0; y < dst.height; y++)
+    {
+        float fy = std::max((y + 0.5f) * sy - 0.5f, 0.f);
+        int y0 = std::min(static_cast<int>(fy), src.height - 1);
+        int y1 = std::min(y0 + 1, src.height - 1);
+        float ty = fy - y0;
+
+        const float* r0 = src.Row(y0);
+        const float* r1 = src.Row(y1);
+        float* d = dst.Row(y);
+
+        for (int x = 0; x < dst.width; x++)
+        {
+            float fx = std::max((x + 0.5f) * sx - 0.5f, 0.f);
+            int x0 = std::min(static_cast<int>(fx), src.width - 1);
+            int x1 = std::min(x0 + 1, src.width - 1);
+            float tx = fx - x0;
+
+            for (int c = 0; c < 4; c++)
+            {
+                float top = r0[x0 * 4 + c] + (r0[x1 * 4 + c] - r0[x0 * 4 + c]) * tx;
+                float bottom = r1[x0 * 4 + c] + (r1[x1 * 4 + c] - r1[x0 * 4 + c]) * tx;
+                d[x * 4 + c] = top + (bottom - top) * ty;
+            }
+        }
+    }
+}
+
+void CpuBlur::BlurMips(BlurImage& image, float sigma, int mips)
+{
+    mips = std::clamp(mips, 0, BLUR_MAX_MIPS);
+
+    if (mips == 0 || image.width < 2 || image.height < 2)
+    {
+        Blur(image, BlurKernel::Gaussian(sigma));
+        return;
+    }
+
+    std::vector<BlurImage> chain;
+    chain.push_back(downsample(image));
+
+    for (int m = 1; m < mips; m++)
+    {
+        chain.push_back(downsample(chain.back()));
+    }
+
+    Blur(chain.back(), BlurKernel::Gaussian(sigma / (1 << mips)).LinearTaps());
+
+    for (int m = mips - 1; m > 0; m--)
+    {
+        upsample(chain[m], chain[m - 1]);
+    }
+
+    upsample(chain.front(), image);
+}
+
+const char* CpuBlur::Simd()
+{
+#if defined(BLUR_AVX)
+    return "avx";
+#elif defined(BLUR_SSE)
+    return "sse";
+#elif defined(BLUR_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+std::vector<BlurBenchmark> CpuBlur::Benchmark(int width, int height, const std::vector<float>& sigmas)
+{
+    /*noise, so no part of the image is cheaper than another*/
+    BlurImage source;
+    source.Resize(width, height);
+
+    uint32_t state = 0x9E3779B9u;
+
+    for (auto& v : source.rgba)
+    {
+        state = state * 1664525u + 1013904223u;
+        v = (state >> 8) * (1.f / 16777216.f);
+    }
+
+    auto measure = [&](BlurImage& image, auto blur)
+    {
+        const int rounds = 4;
+        double total = 0.0;
+
+        for (int r = 0; r < rounds; r++)
+        {
+            image = source;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            blur(image);
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+            total += elapsed.count();
+        }
+
+        return total / rounds;
+    };
+
+    std::vector<BlurBenchmark> results;
+
+    for (float sigma : sigmas)
+    {
+        BlurKernel kernel = BlurKernel::Gaussian(sigma);
+        std::vector<BlurTap> taps = kernel.Taps();
+        std::vector<BlurTap> linearTaps = kernel.LinearTaps();
+
+        BlurBenchmark b;
+        b.sigma = sigma;
+        b.radius = kernel.Radius();
+        b.mips = BlurKernel::Mips(sigma);
+
+        BlurImage full, linear, mip;
+        b.msTaps = measure(full, [&](BlurImage& i) { Blur(i, taps); });
+        b.msLinearTaps = measure(linear, [&](BlurImage& i) { Blur(i, linearTaps); });
+        b.msMips = measure(mip, [&](BlurImage& i) { BlurMips(i, sigma, b.mips); });
+
+        for (size_t i = 0; i < full.rgba.size(); i++)
+        {
+            b.mipError = std::max(b.mipError, std::fabs(full.rgba[i] - mip.rgba[i]));
+        }
+
+        results.push_back(b);
+    }
+
+    return results;
+}
+
+std::wstring CpuBlur::Report(const std::vector<BlurBenchmark>& results)
+{
+    std::wostringstream report;
+    report << L"Cpu blur (" << Simd() << L"), ms per blur:\n";
+
+    for (const auto& b : results)
+    {
+        report << L"  sigma " << b.sigma << L" radius " << b.radius << L": taps " << b.msTaps
+               << L", linear taps " << b.msLinearTaps << L", " << b.mips << L" mips " << b.msMips
+               << L" (error " << b.mipError << L")\n";
+    }
+
+    return report.str();
+}
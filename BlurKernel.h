@@ -0,0 +1,123 @@
+/* BlurKernel.h
+
+gaussian kernels for separable blurs and a cpu blur using them.
+
+a BlurKernel has any radius and sigma. its taps can be folded in pairs so
+one bilinear fetch between two texels reads both with their weights,
+which halves the fetches of a shader that samples with linear filtering.
+blur.fx is precompiled with BLUR_SHADER_RADIUS and point loads, the gpu
+blur always uses a kernel of that radius. Blur runs wider blurs on a mip
+chain of half size targets and only blurs the smallest level.
+
+CpuBlur blurs float rgba images with the same clamped edges as blur.fx,
+so it is the reference for the gpu blur and a fallback without compute
+shaders. every pass adds shifted rows with avx, sse or neon. wide blurs
+can run on a mip chain: the image is halved BlurKernel::Mips times,
+blurred with the smaller sigma and scaled up bilinearly.
+
+only depends on the standard library.
+
+    Usage:
+    BlurKernel k = BlurKernel::Gaussian(2.5f, BLUR_SHADER_RADIUS);
+    Shaders::blurShader->SetWeights(k.Weights().data());
+
+    BlurImage image;
+    image.Resize(width, height);
+    CpuBlur::Blur(image, BlurKernel::Gaussian(12.f));
+    CpuBlur::BlurMips(image, 12.f, BlurKernel::Mips(12.f));
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*radius of the kernel compiled into blur.fx*/
+#define BLUR_SHADER_RADIUS 5
+
+/*a kernel covers this many sigmas on either side*/
+#define BLUR_SIGMA_RADIUS 3.f
+
+/*larger kernels are run on a mip chain*/
+#define BLUR_MIP_RADIUS 8
+#define BLUR_MAX_MIPS 4
+
+struct BlurTap
+{
+    float offset;
+    float weight;
+};
+
+class BlurKernel
+{
+public:
+    /*radius 0 covers BLUR_SIGMA_RADIUS sigmas, the weights sum to 1*/
+    static BlurKernel Gaussian(float sigma, int radius = 0);
+
+    /*halvings after which a kernel of sigma fits into maxRadius*/
+    static int Mips(float sigma, int maxRadius = BLUR_MIP_RADIUS);
+
+    int Radius() const { return radius; }
+    float Sigma() const { return sigma; }
+
+    /*2 * radius + 1 weights, the center is Weights()[Radius()]*/
+    const std::vector<float>& Weights() const { return weights; }
+
+    /*one tap per texel*/
+    std::vector<BlurTap> Taps() const;
+
+    /*neighbouring taps on either side folded into one fractional offset, center first*/
+    std::vector<BlurTap> LinearTaps() const;
+
+private:
+    int radius = 0;
+    float sigma = 0.f;
+    std::vector<float> weights;
+};
+
+/*rgba floats, row by row*/
+struct BlurImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<float> rgba;
+
+    void Resize(int w, int h);
+    float* Row(int y) { return rgba.data() + static_cast<size_t>(y) * width * 4; }
+    const float* Row(int y) const { return rgba.data() + static_cast<size_t>(y) * width * 4; }
+};
+
+struct BlurBenchmark
+{
+    float sigma = 0.f;
+    int radius = 0;
+    int mips = 0;
+
+    /*per blur of the benchmark image*/
+    double msTaps = 0.0;
+    double msLinearTaps = 0.0;
+    double msMips = 0.0;
+
+    /*largest difference of the mip chain to the full blur*/
+    float mipError = 0.f;
+};
+
+class CpuBlur
+{
+public:
+    static void Blur(BlurImage& image, const BlurKernel& kernel);
+
+    /*taps with fractional offsets are read with linear filtering*/
+    static void Blur(BlurImage& image, const std::vector<BlurTap>& taps);
+
+    /*downsamples mips times, blurs with sigma of the mip and upsamples again*/
+    static void BlurMips(BlurImage& image, float sigma, int mips);
+
+    /*instruction set of the passes*/
+    static const char* Simd();
+
+    /*cost of the three ways against sigma on a width x height image*/
+    static std::vector<BlurBenchmark> Benchmark(int width, int height, const std::vector<float>& sigmas);
+    static std::wstring Report(const std::vector<BlurBenchmark>& results);
+};
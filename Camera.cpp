@@ -122,6 +122,25 @@ BoundingSphere& Camera::getCollisionSphere()
     return collision;
 }
 
+BoundingFrustum Camera::getFrustum()
+{
+    BoundingFrustum f;
+    frustum.Transform(f, XMMatrixInverse(nullptr, getView()));
+    return f;
+}
+
+float Camera::getProjectedSize(const BoundingSphere& s)
+{
+    float dist = XMVectorGetX(XMVector3Length(XMLoadFloat3(&s.Center) - XMLoadFloat3(&position)));
+
+    if (dist <= s.Radius)
+    {
+        return 1.f;
+    }
+
+    return s.Radius / (dist * tanf(0.5f * fovY));
+}
+
 //set frustum
 void Camera::setLens(float _fovy, float _aspect, float _zn, float _zf)
 {
@@ -136,6 +155,7 @@ void Camera::setLens(float _fovy, float _aspect, float _zn, float _zf)
     XMMATRIX p = XMMatrixPerspectiveFovLH(fovY, aspectRatio, nearZ, farZ);
     XMStoreFloat4x4(&projMatrix, p);
 
+    BoundingFrustum::CreateFromMatrix(frustum, p);
 }
 
 //look at
@@ -40,6 +40,12 @@ public:
     //coll
     BoundingSphere& getCollisionSphere();
 
+    //view frustum in world space
+    BoundingFrustum getFrustum();
+
+    //size of a sphere on screen relative to the viewport height
+    float getProjectedSize(const BoundingSphere& s);
+
     //set frustum
     void setLens(float _fovy, float _aspect, float _zn, float _zf);
 
@@ -75,6 +81,7 @@ private:
     XMFLOAT4X4 projMatrix;
 
     BoundingSphere collision;
+    BoundingFrustum frustum;
 
     void UpdateCollision();
 
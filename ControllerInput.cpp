@@ -1,16 +1,38 @@
 #include "ControllerInput.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 
 ControllerInput::ControllerInput() {
 
-    RtlSecureZeroMemory(controllers, sizeof(ControllerState) * MAX_CONTROLLERS);
-    cTimer = 0.f;
+    memset(controllers, 0, sizeof(ControllerState) * MAX_CONTROLLERS);
+    memset(status, 0, sizeof(Status) * MAX_CONTROLLERS);
+    memset(&counters, 0, sizeof(ControllerCounters));
+    cTimer = 0.0;
     isInit = false;
-    currentUpdate = 0;
+
+    for (int i = 0; i < MAX_CONTROLLERS; i++) {
+        nextProbe[i] = 0.0;
+        backoff[i] = CONTROLLER_BACKOFF_MIN;
+        nextStatus[i] = 0.0;
+    }
+
+    statusRequests = 0;
+    statusRunning = true;
+    statusThread = std::thread(&ControllerInput::statusWorker, this);
 }
 
 ControllerInput::~ControllerInput() {
 
-    RtlSecureZeroMemory(controllers, sizeof(ControllerState) * MAX_CONTROLLERS);
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        statusRunning = false;
+    }
+
+    statusSignal.notify_one();
+    statusThread.join();
+
+    memset(controllers, 0, sizeof(ControllerState) * MAX_CONTROLLERS);
     Disable();
 
 }
@@ -20,10 +42,10 @@ ControllerInput::~ControllerInput() {
 void ControllerInput::resetControllerData(int index) {
 
     if (index >= 0 && index < 4) {
-        RtlSecureZeroMemory(&controllers[index], sizeof(ControllerState));
+        memset(&controllers[index], 0, sizeof(ControllerState));
     }
     else {
-        RtlSecureZeroMemory(controllers, sizeof(ControllerState) * MAX_CONTROLLERS);
+        memset(controllers, 0, sizeof(ControllerState) * MAX_CONTROLLERS);
     }
 }
 
@@ -36,23 +58,31 @@ void ControllerInput::Update(float deltaTime) {
 
 void ControllerInput::Update_Internal(float deltaTime, bool init) {
 
-    /*cycle to next controller if needed*/
+    auto start = std::chrono::steady_clock::now();
+
     cTimer += deltaTime;
-    currentUpdate = (currentUpdate + 1) % 4;
-    cTimer -= CAP_BATTERY_POLL_TIME;
 
+    unsigned int queried = 0;
+    unsigned int skipped = 0;
 
     DWORD res;
     for (DWORD i = 0; i < MAX_CONTROLLERS; i++) {
 
-        /*query all controllers*/
+        /*empty slots wait for their backoff*/
+        if (init && !controllers[i].isConnected && cTimer < nextProbe[i]) {
+            skipped++;
+            continue;
+        }
+
         res = XInputGetState(i, &controllers[i].state);
+        queried++;
 
         /*is connected?*/
         if (res == ERROR_SUCCESS) {
             /*mark as new connection in order to query type/battery*/
             int isNewConnection = !controllers[i].isConnected;
             controllers[i].isConnected = true;
+            backoff[i] = CONTROLLER_BACKOFF_MIN;
 
             /*Dead Zone*/
             if ((controllers[i].state.Gamepad.sThumbLX < INPUT_DEADZONE &&
@@ -75,25 +105,101 @@ void ControllerInput::Update_Internal(float deltaTime, bool init) {
 
             /*capabilites and battery information*/
 
-            if (init == false || isNewConnection || (i == currentUpdate && cTimer >= CAP_BATTERY_POLL_TIME)) {
-
-
-                res = XInputGetCapabilities(i, XINPUT_FLAG_GAMEPAD, &controllers[i].capabilities);
-
-                if (res == ERROR_SUCCESS && controllers[i].capabilities.Flags == XINPUT_CAPS_WIRELESS) {
-                    XInputGetBatteryInformation(i, BATTERY_DEVTYPE_GAMEPAD, &controllers[i].batteryInfo);
-                }
+            if (isNewConnection || cTimer >= nextStatus[i]) {
+                requestStatus(i);
+                nextStatus[i] = cTimer + CAP_BATTERY_POLL_TIME;
             }
 
         }else {
+            /*probe again soon after a disconnect, then less and less often*/
+            backoff[i] = controllers[i].isConnected ? CONTROLLER_BACKOFF_MIN : (std::min)(backoff[i] * 2.f, CONTROLLER_BACKOFF_MAX);
+            nextProbe[i] = cTimer + backoff[i];
+
             /*reset data structure*/
             controllers[i].isConnected = false;
             resetControllerData(i);
         }
-        
+
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    /*pick up the results of the worker*/
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+
+        counters.polls++;
+        counters.stateQueries += queried;
+        counters.skippedQueries += skipped;
+        counters.lastPollMs = elapsed.count();
+        counters.maxPollMs = (std::max)(counters.maxPollMs, counters.lastPollMs);
+
+        for (int i = 0; i < MAX_CONTROLLERS; i++) {
+
+            if (!controllers[i].isConnected) {
+                status[i].valid = false;
+            }
+            else if (status[i].valid) {
+                controllers[i].capabilities = status[i].capabilities;
+                controllers[i].batteryInfo = status[i].batteryInfo;
+            }
+        }
+    }
+
+}
+
+/*queue a capability and battery query for the worker*/
+void ControllerInput::requestStatus(int index) {
+
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        statusRequests |= 1u << index;
     }
 
+    statusSignal.notify_one();
+}
+
+void ControllerInput::statusWorker() {
+
+    std::unique_lock<std::mutex> lock(statusMutex);
+
+    while (statusRunning) {
+
+        statusSignal.wait(lock, [this] { return !statusRunning || statusRequests != 0; });
+
+        unsigned int requests = statusRequests;
+        statusRequests = 0;
+
+        for (DWORD i = 0; i < MAX_CONTROLLERS; i++) {
+
+            if (!(requests & (1u << i)))
+                continue;
+
+            /*query without holding the lock*/
+            lock.unlock();
+
+            auto start = std::chrono::steady_clock::now();
+
+            Status s;
+            memset(&s, 0, sizeof(Status));
 
+            DWORD res = XInputGetCapabilities(i, XINPUT_FLAG_GAMEPAD, &s.capabilities);
+
+            if (res == ERROR_SUCCESS && (s.capabilities.Flags & XINPUT_CAPS_WIRELESS)) {
+                XInputGetBatteryInformation(i, BATTERY_DEVTYPE_GAMEPAD, &s.batteryInfo);
+            }
+
+            s.valid = res == ERROR_SUCCESS;
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            lock.lock();
+
+            status[i] = s;
+            counters.statusQueries++;
+            counters.statusMs += elapsed.count();
+        }
+    }
 }
 
 /*access information for controller index*/
@@ -103,6 +209,13 @@ ControllerState* ControllerInput::getState(int index) {
 
 }
 
+ControllerCounters ControllerInput::getCounters() {
+
+    std::lock_guard<std::mutex> lock(statusMutex);
+    return counters;
+
+}
+
 
 /*enable xinput*/
 void ControllerInput::Enable() {
@@ -113,7 +226,7 @@ void ControllerInput::Enable() {
 
 /*disable xinput*/
 void ControllerInput::Disable() {
-    
+
     XInputEnable(false);
 
 }
@@ -2,27 +2,46 @@
 
 polls input and status data from up to 4 controllers
 
+empty slots are expensive to query, so a disconnected slot is only probed
+again after a backoff that doubles from CONTROLLER_BACKOFF_MIN up to
+CONTROLLER_BACKOFF_MAX. capabilities and battery level are queried on a
+worker thread when a controller connects and every CAP_BATTERY_POLL_TIME,
+Update() picks up the results. outside of windows XInputStub.h replaces
+xinput.
+
     Usage:
     i = new ControllerInput();
     ...
     i->Update(deltaTime);
     ...
     *cstatei = i->getState(0);
+    i->getCounters().stateQueries;
 
 
 */
 
 #pragma once
 
+#ifdef _WIN32
 #include <windows.h>
 #include <XInput.h>
 #pragma comment(lib,"xinput.lib")
 #pragma warning(disable : 4995)
+#else
+#include "XInputStub.h"
+#endif
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #define MAX_CONTROLLERS 4
 #define INPUT_DEADZONE (0.24f* float(0x7FFF))
-/*time between checking capabilites/battery level
-  same controller is polled every CAP_BATTERY_POLL_TIME * 4*/
+/*time between capability/battery queries of a connected controller*/
 #define CAP_BATTERY_POLL_TIME 20.f
+/*time between probes of an empty slot, in s*/
+#define CONTROLLER_BACKOFF_MIN 0.1f
+#define CONTROLLER_BACKOFF_MAX 1.f
 
 struct ControllerState {
     XINPUT_STATE state;
@@ -31,6 +50,18 @@ struct ControllerState {
     bool isConnected;
 };
 
+struct ControllerCounters {
+    unsigned long long polls;
+    /*XInputGetState calls, and empty slots skipped because of the backoff*/
+    unsigned long long stateQueries;
+    unsigned long long skippedQueries;
+    /*capability and battery queries of the worker*/
+    unsigned long long statusQueries;
+    double lastPollMs;
+    double maxPollMs;
+    double statusMs;
+};
+
 /*state.wbuttons
     check these values with cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_A
 Device button 	Bitmask
@@ -102,6 +133,7 @@ class ControllerInput{
         void Disable();
         bool isConnected(int index);
         ControllerState* getState(int index);
+        ControllerCounters getCounters();
         float normalizeThumbs(int in);
         float normalizeTriggers(int in);
 
@@ -109,8 +141,31 @@ class ControllerInput{
         ControllerState controllers[MAX_CONTROLLERS];
         void Update_Internal(float deltaTime, bool init);
         void resetControllerData(int index);
+        void requestStatus(int index);
+        void statusWorker();
 
-        float cTimer;
+        /*seconds since start, double so the schedule keeps its resolution in long sessions*/
+        double cTimer;
         bool isInit;
-        int currentUpdate;
-};
\ No newline at end of file
+
+        /*per slot schedule*/
+        double nextProbe[MAX_CONTROLLERS];
+        float backoff[MAX_CONTROLLERS];
+        double nextStatus[MAX_CONTROLLERS];
+
+        /*status worker, results are copied into controllers by Update*/
+        struct Status {
+            XINPUT_CAPABILITIES capabilities;
+            XINPUT_BATTERY_INFORMATION batteryInfo;
+            bool valid;
+        };
+
+        Status status[MAX_CONTROLLERS];
+        unsigned int statusRequests;
+        bool statusRunning;
+        std::mutex statusMutex;
+        std::condition_variable statusSignal;
+        std::thread statusThread;
+
+        ControllerCounters counters;
+};
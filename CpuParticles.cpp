@@ -0,0 +1,533 @@
+#include "CpuParticles.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+#if defined(__AVX__)
+#define PARTICLE_AVX
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define PARTICLE_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define PARTICLE_NEON
+#include <arm_neon.h>
+#endif
+
+ParticleEmitterDesc ParticleEmitterDesc::Rain()
+{
+    /*5 drops a frame spread out above the camera*/
+    ParticleEmitterDesc d;
+    d.rate = 300.f;
+    d.lifetime = 3.f;
+    d.offset[1] = 20.f;
+    d.spread[0] = 35.f;
+    d.spread[2] = 35.f;
+    return d;
+}
+
+ParticleEmitterDesc ParticleEmitterDesc::Fire()
+{
+    /*one flare a frame rising from the emitter*/
+    ParticleEmitterDesc d;
+    d.rate = 60.f;
+    d.lifetime = 6.f;
+    d.speed = 4.f;
+    d.direction[0] = 0.5f;
+    d.direction[2] = 0.5f;
+    return d;
+}
+
+ParticleEmitterDesc ParticleEmitterDesc::Celebration()
+{
+    /*5 pieces a frame, one of each texture*/
+    ParticleEmitterDesc d;
+    d.rate = 300.f;
+    d.lifetime = 3.f;
+    d.offset[1] = 12.f;
+    d.spread[0] = 15.f;
+    d.spread[2] = 15.f;
+    d.types = 5;
+    return d;
+}
+
+void ParticleEmitterDesc::Bounds(const float emit[3], const float acceleration[3], float min[3], float max[3]) const
+{
+    for (int c = 0; c < 3; c++)
+    {
+        float center = emit[c] + offset[c];
+        float reach = spread[c] + speed * std::fabs(direction[c]) * lifetime;
+        float fall = 0.5f * acceleration[c] * lifetime * lifetime;
+
+        min[c] = center - reach + std::min(fall, 0.f);
+        max[c] = center + reach + std::max(fall, 0.f);
+    }
+}
+
+void ParticlePool::Reserve(size_t capacity)
+{
+    for (auto* a : { &posX, &posY, &posZ, &velX, &velY, &velZ, &sizeX, &sizeY, &age })
+    {
+        a->resize(capacity);
+    }
+
+    type.resize(capacity);
+    count = std::min(count, capacity);
+}
+
+void ParticlePool::Remove(size_t i)
+{
+    size_t last = --count;
+
+    posX[i] = posX[last]; posY[i] = posY[last]; posZ[i] = posZ[last];
+    velX[i] = velX[last]; velY[i] = velY[last]; velZ[i] = velZ[last];
+    sizeX[i] = sizeX[last]; sizeY[i] = sizeY[last];
+    age[i] = age[last];
+    type[i] = type[last];
+}
+
+CpuParticleEmitter::CpuParticleEmitter(const ParticleEmitterDesc& desc, size_t maxParticles) : desc(desc), state(desc.seed, static_cast<uint64_t>(RandomStream::Particles))
+{
+    pool.Reserve(maxParticles);
+}
+
+void CpuParticleEmitter::SetEmitPosition(float x, float y, float z)
+{
+    emitPosition[0] = x;
+    emitPosition[1] = y;
+    emitPosition[2] = z;
+}
+
+void CpuParticleEmitter::SetAcceleration(float x, float y, float z)
+{
+    acceleration[0] = x;
+    acceleration[1] = y;
+    acceleration[2] = z;
+}
+
+void CpuParticleEmitter::SetSize(float x, float y)
+{
+    size[0] = x;
+    size[1] = y;
+}
+
+void CpuParticleEmitter::Reset()
+{
+    pool.count = 0;
+    pending = 0.f;
+    nextType = 0;
+    state = Pcg32(desc.seed, static_cast<uint64_t>(RandomStream::Particles));
+}
+
+void CpuParticleEmitter::Update(float dt)
+{
+    Integrate(0, pool.count, dt);
+    Finish(dt);
+}
+
+/*exact for constant acceleration: p += (v + a * dt / 2) * dt, v += a * dt*/
+static void integrateAxis(float* p, float* v, float a, float dt, size_t n)
+{
+    size_t i = 0;
+
+#if defined(PARTICLE_AVX)
+    __m256 vh = _mm256_set1_ps(0.5f * a * dt);
+    __m256 va = _mm256_set1_ps(a * dt);
+    __m256 vdt = _mm256_set1_ps(dt);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 vel = _mm256_loadu_ps(v + i);
+        _mm256_storeu_ps(p + i, _mm256_add_ps(_mm256_loadu_ps(p + i), _mm256_mul_ps(_mm256_add_ps(vel, vh), vdt)));
+        _mm256_storeu_ps(v + i, _mm256_add_ps(vel, va));
+    }
+#elif defined(PARTICLE_SSE)
+    __m128 vh = _mm_set1_ps(0.5f * a * dt);
+    __m128 va = _mm_set1_ps(a * dt);
+    __m128 vdt = _mm_set1_ps(dt);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 vel = _mm_loadu_ps(v + i);
+        _mm_storeu_ps(p + i, _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(_mm_add_ps(vel, vh), vdt)));
+        _mm_storeu_ps(v + i, _mm_add_ps(vel, va));
+    }
+#elif defined(PARTICLE_NEON)
+    float32x4_t vh = vdupq_n_f32(0.5f * a * dt);
+    float32x4_t va = vdupq_n_f32(a * dt);
+    float32x4_t vdt = vdupq_n_f32(dt);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t vel = vld1q_f32(v + i);
+        vst1q_f32(p + i, vmlaq_f32(vld1q_f32(p + i), vaddq_f32(vel, vh), vdt));
+        vst1q_f32(v + i, vaddq_f32(vel, va));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        p[i] += (v[i] + 0.5f * a * dt) * dt;
+        v[i] += a * dt;
+    }
+}
+
+static void addAll(float* x, float value, size_t n)
+{
+    size_t i = 0;
+
+#if defined(PARTICLE_AVX)
+    __m256 vv = _mm256_set1_ps(value);
+
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), vv));
+    }
+#elif defined(PARTICLE_SSE)
+    __m128 vv = _mm_set1_ps(value);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), vv));
+    }
+#elif defined(PARTICLE_NEON)
+    float32x4_t vv = vdupq_n_f32(value);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        vst1q_f32(x + i, vaddq_f32(vld1q_f32(x + i), vv));
+    }
+#endif
+
+    for (; i < n; i++)
+    {
+        x[i] += value;
+    }
+}
+
+void CpuParticleEmitter::Integrate(size_t begin, size_t end, float dt)
+{
+    end = std::min(end, pool.count);
+
+    if (begin >= end)
+        return;
+
+    size_t n = end - begin;
+
+    integrateAxis(pool.posX.data() + begin, pool.velX.data() + begin, acceleration[0], dt, n);
+    integrateAxis(pool.posY.data() + begin, pool.velY.data() + begin, acceleration[1], dt, n);
+    integrateAxis(pool.posZ.data() + begin, pool.velZ.data() + begin, acceleration[2], dt, n);
+    addAll(pool.age.data() + begin, dt, n);
+}
+
+void CpuParticleEmitter::Finish(float dt)
+{
+    cull();
+
+    pending += desc.rate * dt;
+    size_t count = static_cast<size_t>(pending);
+    pending -= count;
+
+    Emit(count);
+}
+
+void CpuParticleEmitter::Advance(float dt)
+{
+    if (dt >= desc.lifetime)
+    {
+        /*all particles alive now are emitted during the last lifetime*/
+        pool.count = 0;
+        pending = 0.f;
+        dt = desc.lifetime;
+    }
+    else
+    {
+        Integrate(0, pool.count, dt);
+        cull();
+    }
+
+    pending += desc.rate * dt;
+    size_t count = static_cast<size_t>(pending);
+    pending -= count;
+
+    Emit(count, dt);
+}
+
+void CpuParticleEmitter::cull()
+{
+    /*backwards, so a moved particle has been checked already*/
+    for (size_t i = pool.count; i-- > 0;)
+    {
+        if (pool.age[i] > desc.lifetime)
+        {
+            pool.Remove(i);
+        }
+    }
+}
+
+void CpuParticleEmitter::Emit(size_t count, float age)
+{
+    count = std::min(count, pool.Capacity() - pool.count);
+
+    for (size_t k = 0; k < count; k++)
+    {
+        size_t i = pool.count++;
+
+        pool.posX[i] = emitPosition[0] + desc.offset[0] + desc.spread[0] * random();
+        pool.posY[i] = emitPosition[1] + desc.offset[1] + desc.spread[1] * random();
+        pool.posZ[i] = emitPosition[2] + desc.offset[2] + desc.spread[2] * random();
+
+        float v[3] = { 0.f, 0.f, 0.f };
+
+        if (desc.speed != 0.f)
+        {
+            /*random unit vector like RandUnitVec3 of the shaders*/
+            float length = 0.f;
+
+            while (length < 1e-4f)
+            {
+                v[0] = random();
+                v[1] = random();
+                v[2] = random();
+                length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            }
+
+            for (int c = 0; c < 3; c++)
+            {
+                v[c] *= desc.speed * desc.direction[c] / length;
+            }
+        }
+
+        /*the oldest first, like emitted one after another*/
+        float t = age * (count - k - 0.5f) / count;
+
+        pool.posX[i] += (v[0] + 0.5f * acceleration[0] * t) * t;
+        pool.posY[i] += (v[1] + 0.5f * acceleration[1] * t) * t;
+        pool.posZ[i] += (v[2] + 0.5f * acceleration[2] * t) * t;
+        pool.velX[i] = v[0] + acceleration[0] * t;
+        pool.velY[i] = v[1] + acceleration[1] * t;
+        pool.velZ[i] = v[2] + acceleration[2] * t;
+        pool.sizeX[i] = size[0];
+        pool.sizeY[i] = size[1];
+        pool.age[i] = t;
+        pool.type[i] = PARTICLE_TYPE_FLARE + nextType;
+
+        nextType = (nextType + 1) % std::max(desc.types, 1u);
+    }
+}
+
+size_t CpuParticleEmitter::Export(ParticleVertex* out, size_t max) const
+{
+    size_t count = std::min(max, pool.count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        /*initial state that reaches the integrated one at this age*/
+        float t = pool.age[i];
+        float p[3] = { pool.posX[i], pool.posY[i], pool.posZ[i] };
+        float v[3] = { pool.velX[i], pool.velY[i], pool.velZ[i] };
+
+        ParticleVertex& o = out[i];
+
+        for (int c = 0; c < 3; c++)
+        {
+            o.initialVel[c] = v[c] - acceleration[c] * t;
+            o.initialPos[c] = p[c] - o.initialVel[c] * t - 0.5f * acceleration[c] * t * t;
+        }
+
+        o.size[0] = pool.sizeX[i];
+        o.size[1] = pool.sizeY[i];
+        o.age = t;
+        o.type = pool.type[i];
+    }
+
+    return count;
+}
+
+float CpuParticleEmitter::random()
+{
+    return state.Float(-1.f, 1.f);
+}
+
+ParticleUpdater::ParticleUpdater(int threads)
+{
+    if (threads <= 0)
+    {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    for (int i = 1; i < threads; i++)
+    {
+        workers.emplace_back(&ParticleUpdater::work, this);
+    }
+}
+
+ParticleUpdater::~ParticleUpdater()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+
+    wake.notify_all();
+
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+}
+
+void ParticleUpdater::Update(const std::vector<CpuParticleEmitter*>& emitters, float dt)
+{
+    jobs.clear();
+
+    for (auto* e : emitters)
+    {
+        for (size_t begin = 0; begin < e->Count(); begin += PARTICLE_JOB_SIZE)
+        {
+            jobs.push_back({ e, begin, std::min(begin + PARTICLE_JOB_SIZE, e->Count()) });
+        }
+    }
+
+    run(jobs.size(), [&](size_t i) { jobs[i].emitter->Integrate(jobs[i].begin, jobs[i].end, dt); });
+    run(emitters.size(), [&](size_t i) { emitters[i]->Finish(dt); });
+}
+
+void ParticleUpdater::run(size_t count, const std::function<void(size_t)>& job)
+{
+    if (count == 0)
+        return;
+
+    if (workers.empty() || count == 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            job(i);
+        }
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = &job;
+        jobCount = count;
+        nextJob = 0;
+        doneJobs = 0;
+        generation++;
+    }
+
+    wake.notify_all();
+
+    size_t done = 0;
+
+    for (size_t i; (i = nextJob++) < count;)
+    {
+        job(i);
+        done++;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneJobs += done;
+
+    /*no worker may still hold this job when the next run starts*/
+    finished.wait(lock, [&] { return doneJobs == jobCount && busy == 0; });
+    current = nullptr;
+}
+
+void ParticleUpdater::work()
+{
+    uint64_t seen = 0;
+
+    for (;;)
+    {
+        const std::function<void(size_t)>* job;
+        size_t count;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || (generation != seen && current); });
+
+            if (quit)
+                return;
+
+            seen = generation;
+            job = current;
+            count = jobCount;
+            busy++;
+        }
+
+        size_t done = 0;
+
+        for (size_t i; (i = nextJob++) < count;)
+        {
+            (*job)(i);
+            done++;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            doneJobs += done;
+            busy--;
+        }
+
+        finished.notify_one();
+    }
+}
+
+std::vector<ParticleBenchmark> ParticleUpdater::Benchmark(const std::vector<size_t>& counts)
+{
+    std::vector<ParticleBenchmark> results;
+
+    ParticleUpdater single(1);
+    ParticleUpdater all;
+
+    for (size_t count : counts)
+    {
+        /*one full pool that lives through the benchmark*/
+        ParticleEmitterDesc desc = ParticleEmitterDesc::Fire();
+        desc.rate = 0.f;
+        desc.lifetime = 1e6f;
+
+        CpuParticleEmitter emitter(desc, count);
+        emitter.Emit(count);
+
+        for (ParticleUpdater* updater : { &single, &all })
+        {
+            const int rounds = 8;
+            updater->Update({ &emitter }, 1.f / 60.f);
+
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (int r = 0; r < rounds; r++)
+            {
+                updater->Update({ &emitter }, 1.f / 60.f);
+            }
+
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+            ParticleBenchmark b;
+            b.particles = count;
+            b.threads = updater->Threads();
+            b.ms = elapsed.count() / rounds;
+            results.push_back(b);
+        }
+    }
+
+    return results;
+}
+
+std::wstring ParticleUpdater::Report(const std::vector<ParticleBenchmark>& results)
+{
+    std::wostringstream report;
+    report << L"Cpu particles:\n";
+
+    for (const auto& b : results)
+    {
+        report << L"  " << b.particles << L" particles on " << b.threads << L" threads: " << b.ms << L" ms, "
+               << b.ParticlesPerMsPerCore() << L" particles per ms per core\n";
+    }
+
+    return report.str();
+}
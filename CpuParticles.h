@@ -0,0 +1,216 @@
+/* CpuParticles.h
+
+particle simulation on the cpu, the alternative to the stream out of
+ParticleSystem. a CpuParticleEmitter keeps its particles in a ParticlePool
+with one array per attribute of Vertex::Particle. positions and
+velocities are integrated under the acceleration with avx, sse or neon,
+particles older than the lifetime of the emitter are removed and new ones
+are emitted at the rate of the emitter, independent of the frame rate.
+
+Export writes the particles in the layout of Vertex::Particle. the draw
+shaders place a particle at 0.5 * a * age^2 + v0 * age + p0, so the
+initial position and velocity are derived from the integrated state.
+
+an emitter that is not seen doesn't need to be updated, Advance moves it
+over the time it was asleep at once. positions are exact under constant
+acceleration, the particles emitted meanwhile are placed at their age.
+
+the ParticleUpdater updates many emitters on worker threads. large pools
+are integrated in chunks of PARTICLE_JOB_SIZE particles, culling and
+emitting run per emitter.
+
+the descriptions of rain, fire and celebration follow the stream out
+shaders at 60 frames per second, the shaders emit once per frame.
+
+only depends on the standard library.
+
+    Usage:
+    CpuParticleEmitter rain(ParticleEmitterDesc::Rain(), 10000);
+    rain.SetEmitPosition(eye);
+    rain.SetAcceleration(-1.f, -9.8f, 0.f);
+
+    ParticleUpdater updater;
+    updater.Update({ &rain, &fire }, deltaTime);
+
+    size_t count = rain.Export(vertices, maxParticles);
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Random.h"
+
+#define PARTICLE_TYPE_EMITTER 0
+#define PARTICLE_TYPE_FLARE 1
+
+/*particles integrated by one job*/
+#define PARTICLE_JOB_SIZE 16384
+
+struct ParticleEmitterDesc
+{
+    /*particles per second and seconds until a particle is removed*/
+    float rate = 60.f;
+    float lifetime = 1.f;
+
+    /*spawn at the emit position plus offset plus a random point of the spread box*/
+    float offset[3] = { 0.f, 0.f, 0.f };
+    float spread[3] = { 0.f, 0.f, 0.f };
+
+    /*speed along a random unit vector scaled per axis*/
+    float speed = 0.f;
+    float direction[3] = { 1.f, 1.f, 1.f };
+
+    /*new particles cycle through the types 1 - types*/
+    uint32_t types = 1;
+
+    uint32_t seed = 1;
+
+    /*box around every particle alive for an emitter at emit under the acceleration*/
+    void Bounds(const float emit[3], const float acceleration[3], float min[3], float max[3]) const;
+
+    static ParticleEmitterDesc Rain();
+    static ParticleEmitterDesc Fire();
+    static ParticleEmitterDesc Celebration();
+};
+
+/*same layout as Vertex::Particle*/
+struct ParticleVertex
+{
+    float initialPos[3];
+    float initialVel[3];
+    float size[2];
+    float age;
+    uint32_t type;
+};
+
+struct ParticlePool
+{
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> sizeX, sizeY;
+    std::vector<float> age;
+    std::vector<uint32_t> type;
+
+    size_t count = 0;
+
+    void Reserve(size_t capacity);
+    size_t Capacity() const { return age.size(); }
+
+    /*moves the last particle into i*/
+    void Remove(size_t i);
+};
+
+class CpuParticleEmitter
+{
+public:
+    CpuParticleEmitter(const ParticleEmitterDesc& desc, size_t maxParticles);
+
+    void SetEmitPosition(float x, float y, float z);
+    void SetAcceleration(float x, float y, float z);
+    void SetSize(float x, float y);
+
+    /*removes all particles and restarts the random numbers*/
+    void Reset();
+
+    /*Integrate over all particles and Finish*/
+    void Update(float dt);
+
+    /*part of an update that can run in parallel on ranges of the pool*/
+    void Integrate(size_t begin, size_t end, float dt);
+
+    /*removes old particles and emits new ones after all ranges are integrated*/
+    void Finish(float dt);
+
+    /*spawns count particles at once, limited by the pool. with age the
+      particles are spread evenly over 0 - age and moved to where they are
+      at their age*/
+    void Emit(size_t count, float age = 0.f);
+
+    /*catches up dt seconds at once for an emitter that was asleep,
+      in closed form instead of simulating every frame*/
+    void Advance(float dt);
+
+    /*particles written, at most max*/
+    size_t Export(ParticleVertex* out, size_t max) const;
+
+    size_t Count() const { return pool.count; }
+    size_t Capacity() const { return pool.Capacity(); }
+    const ParticlePool& Pool() const { return pool; }
+    const ParticleEmitterDesc& Desc() const { return desc; }
+
+private:
+    float random();
+    void cull();
+
+    ParticleEmitterDesc desc;
+    ParticlePool pool;
+
+    float emitPosition[3] = { 0.f, 0.f, 0.f };
+    float acceleration[3] = { 0.f, -9.8f, 0.f };
+    float size[2] = { 1.f, 1.f };
+
+    Pcg32 state;
+    uint32_t nextType = 0;
+
+    /*fraction of a particle carried to the next update*/
+    float pending = 0.f;
+};
+
+struct ParticleBenchmark
+{
+    size_t particles = 0;
+    int threads = 0;
+    double ms = 0.0;
+
+    double ParticlesPerMsPerCore() const { return ms > 0.0 && threads > 0 ? particles / ms / threads : 0.0; }
+};
+
+class ParticleUpdater
+{
+public:
+    /*0 uses every hardware thread, the calling thread works too*/
+    ParticleUpdater(int threads = 0);
+    ~ParticleUpdater();
+
+    void Update(const std::vector<CpuParticleEmitter*>& emitters, float dt);
+
+    int Threads() const { return static_cast<int>(workers.size()) + 1; }
+
+    /*update time of one emitter with each count of particles, single threaded and on all threads*/
+    static std::vector<ParticleBenchmark> Benchmark(const std::vector<size_t>& counts);
+    static std::wstring Report(const std::vector<ParticleBenchmark>& results);
+
+private:
+    struct Job
+    {
+        CpuParticleEmitter* emitter;
+        size_t begin, end;
+    };
+
+    /*runs job(0) - job(count - 1) on all threads and returns when all are done*/
+    void run(size_t count, const std::function<void(size_t)>& job);
+    void work();
+
+    std::vector<std::thread> workers;
+    std::vector<Job> jobs;
+
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    const std::function<void(size_t)>* current = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> nextJob{ 0 };
+    size_t doneJobs = 0;
+    int busy = 0;
+    uint64_t generation = 0;
+    bool quit = false;
+};
@@ -0,0 +1,339 @@
+#include "DdsParser.h"
+#include <cstring>
+#include <fstream>
+
+#define DDSD_DEPTH 0x800000
+#define DDPF_ALPHA 0x2
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDPF_LUMINANCE 0x20000
+#define DDPF_BUMPDUDV 0x80000
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_CUBEMAP_ALLFACES 0xFC00
+#define DDSCAPS2_VOLUME 0x200000
+#define DDS_DIMENSION_TEXTURE1D 2
+#define DDS_DIMENSION_TEXTURE2D 3
+#define DDS_DIMENSION_TEXTURE3D 4
+#define DDS_MISC_TEXTURECUBE 0x4
+
+#define FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+/*bits per texel of a dxgi format, 0 for formats a dds texture can't be loaded in*/
+static uint32_t formatBits(uint32_t format, bool& block)
+{
+    block = false;
+
+    if (format >= 70 && format <= 84)
+    {
+        /*bc1 - bc5, bc1 and bc4 in 8 bytes per block*/
+        block = true;
+        return (format <= 72 || (format >= 79 && format <= 81)) ? 4 : 8;
+    }
+
+    if (format >= 94 && format <= 99)
+    {
+        /*bc6h, bc7*/
+        block = true;
+        return 8;
+    }
+
+    if (format >= 1 && format <= 4) return 128;
+    if (format >= 5 && format <= 8) return 96;
+    if (format >= 9 && format <= 22) return 64;
+    if (format >= 23 && format <= 47) return 32;
+    if (format >= 48 && format <= 59) return 16;
+    if (format >= 60 && format <= 65) return 8;
+    if (format == 67) return 32;
+    if (format == 85 || format == 86 || format == 115) return 16;
+    if (format >= 87 && format <= 93) return 32;
+
+    return 0;
+}
+
+static bool isMask(const uint32_t m[4], uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+{
+    return m[0] == r && m[1] == g && m[2] == b && m[3] == a;
+}
+
+/*dxgi format of the pixel format of an old header, 0 if there is none*/
+static uint32_t legacyFormat(uint32_t flags, uint32_t code, uint32_t bits, const uint32_t m[4])
+{
+    if (flags & DDPF_FOURCC)
+    {
+        switch (code)
+        {
+        case FOURCC('D', 'X', 'T', '1'): return 71;
+        case FOURCC('D', 'X', 'T', '2'): return 74;
+        case FOURCC('D', 'X', 'T', '3'): return 74;
+        case FOURCC('D', 'X', 'T', '4'): return 77;
+        case FOURCC('D', 'X', 'T', '5'): return 77;
+        case FOURCC('A', 'T', 'I', '1'): return 80;
+        case FOURCC('B', 'C', '4', 'U'): return 80;
+        case FOURCC('B', 'C', '4', 'S'): return 81;
+        case FOURCC('A', 'T', 'I', '2'): return 83;
+        case FOURCC('B', 'C', '5', 'U'): return 83;
+        case FOURCC('B', 'C', '5', 'S'): return 84;
+        case 36: return 11;
+        case 110: return 13;
+        case 111: return 54;
+        case 112: return 34;
+        case 113: return 10;
+        case 114: return 41;
+        case 115: return 16;
+        case 116: return 2;
+        default: return 0;
+        }
+    }
+
+    if (flags & DDPF_RGB)
+    {
+        if (bits == 32)
+        {
+            if (isMask(m, 0xff, 0xff00, 0xff0000, 0xff000000)) return 28;
+            if (isMask(m, 0xff0000, 0xff00, 0xff, 0xff000000)) return 87;
+            if (isMask(m, 0xff0000, 0xff00, 0xff, 0)) return 88;
+            if (isMask(m, 0x3ff, 0xffc00, 0x3ff00000, 0xc0000000)) return 24;
+            if (isMask(m, 0xffff, 0xffff0000, 0, 0)) return 35;
+            if (isMask(m, 0xffffffff, 0, 0, 0)) return 41;
+        }
+        else if (bits == 16)
+        {
+            if (isMask(m, 0x7c00, 0x3e0, 0x1f, 0x8000)) return 86;
+            if (isMask(m, 0xf800, 0x7e0, 0x1f, 0)) return 85;
+            if (isMask(m, 0xf00, 0xf0, 0xf, 0xf000)) return 115;
+        }
+
+        return 0;
+    }
+
+    if (flags & DDPF_LUMINANCE)
+    {
+        if (bits == 8 && isMask(m, 0xff, 0, 0, 0)) return 61;
+        if (bits == 16 && isMask(m, 0xffff, 0, 0, 0)) return 56;
+        if (bits == 16 && isMask(m, 0xff, 0, 0, 0xff00)) return 49;
+
+        return 0;
+    }
+
+    if (flags & DDPF_ALPHA)
+    {
+        return bits == 8 ? 65 : 0;
+    }
+
+    if (flags & DDPF_BUMPDUDV)
+    {
+        if (bits == 16 && isMask(m, 0xff, 0xff00, 0, 0)) return 51;
+        if (bits == 32 && isMask(m, 0xff, 0xff00, 0xff0000, 0xff000000)) return 31;
+        if (bits == 32 && isMask(m, 0xffff, 0xffff0000, 0, 0)) return 37;
+    }
+
+    return 0;
+}
+
+uint64_t DdsLayout::MipBytes(uint32_t mip) const
+{
+    uint64_t bytes = 0;
+
+    for (uint32_t s = 0; s < arraySize; s++)
+    {
+        bytes += Subresource(mip, s).bytes;
+    }
+
+    return bytes;
+}
+
+bool ParseDds(const uint8_t* data, size_t size, uint64_t fileSize, DdsLayout& layout)
+{
+    layout = DdsLayout();
+
+    if (!data || size < DDS_MAGIC_BYTES + DDS_HEADER_BYTES || fileSize < size)
+        return false;
+
+    auto u32 = [&](size_t offset)
+    {
+        uint32_t v;
+        memcpy(&v, data + offset, 4);
+        return v;
+    };
+
+    if (memcmp(data, "DDS ", 4) != 0 || u32(4) != DDS_HEADER_BYTES || u32(76) != 32)
+        return false;
+
+    uint32_t headerFlags = u32(8);
+    uint32_t height = u32(12), width = u32(16), depth = u32(24), mips = u32(28);
+    uint32_t formatFlags = u32(80), code = u32(84), bits = u32(88);
+    uint32_t masks[4] = { u32(92), u32(96), u32(100), u32(104) };
+    uint32_t caps2 = u32(112);
+
+    layout.dataOffset = DDS_MAGIC_BYTES + DDS_HEADER_BYTES;
+
+    if ((formatFlags & DDPF_FOURCC) && code == FOURCC('D', 'X', '1', '0'))
+    {
+        if (size < DDS_MAX_HEADER_BYTES)
+            return false;
+
+        uint32_t dimension = u32(132);
+
+        layout.format = u32(128);
+        layout.arraySize = u32(140);
+        layout.bitsPerTexel = formatBits(layout.format, layout.blockCompressed);
+        layout.dataOffset = DDS_MAX_HEADER_BYTES;
+
+        if (layout.bitsPerTexel == 0 || layout.arraySize == 0 || layout.arraySize > DDS_MAX_ARRAY)
+            return false;
+
+        if (dimension == DDS_DIMENSION_TEXTURE1D)
+        {
+            if (height != 1)
+                return false;
+
+            layout.texture1D = true;
+        }
+        else if (dimension == DDS_DIMENSION_TEXTURE3D)
+        {
+            if (layout.arraySize != 1)
+                return false;
+
+            layout.volume = true;
+        }
+        else if (dimension != DDS_DIMENSION_TEXTURE2D)
+        {
+            return false;
+        }
+
+        if (u32(136) & DDS_MISC_TEXTURECUBE)
+        {
+            if (dimension != DDS_DIMENSION_TEXTURE2D || layout.arraySize > DDS_MAX_ARRAY / 6)
+                return false;
+
+            layout.cube = true;
+            layout.arraySize *= 6;
+        }
+    }
+    else
+    {
+        layout.format = legacyFormat(formatFlags, code, bits, masks);
+
+        if (layout.format)
+        {
+            layout.bitsPerTexel = formatBits(layout.format, layout.blockCompressed);
+        }
+        else if (!(formatFlags & DDPF_FOURCC) && bits > 0 && bits <= 128 && bits % 8 == 0)
+        {
+            /*no dxgi format, still the size is known*/
+            layout.bitsPerTexel = bits;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (caps2 & DDSCAPS2_CUBEMAP)
+        {
+            /*partial cube maps are not supported*/
+            if ((caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+                return false;
+
+            layout.cube = true;
+            layout.arraySize = 6;
+        }
+        else if ((caps2 & DDSCAPS2_VOLUME) && (headerFlags & DDSD_DEPTH))
+        {
+            layout.volume = true;
+        }
+    }
+
+    if (!layout.volume)
+        depth = 1;
+
+    if (width == 0 || height == 0 || depth == 0 ||
+        width > DDS_MAX_DIMENSION || height > DDS_MAX_DIMENSION || depth > DDS_MAX_ARRAY)
+        return false;
+
+    if (layout.cube && width != height)
+        return false;
+
+    /*a mip chain ends at 1 x 1 x 1*/
+    uint32_t largest = width > height ? width : height;
+    largest = largest > depth ? largest : depth;
+
+    uint32_t chain = 1;
+
+    while ((largest >> chain) > 0)
+    {
+        chain++;
+    }
+
+    mips = mips == 0 ? 1 : mips;
+
+    if (mips > chain || mips > DDS_MAX_MIPS)
+        return false;
+
+    layout.width = width;
+    layout.height = height;
+    layout.depth = depth;
+    layout.mips = mips;
+    layout.subresources.reserve((size_t)layout.arraySize * mips);
+
+    /*every slice has its whole mip chain, dimensions are limited so nothing overflows 64 bits*/
+    uint64_t offset = layout.dataOffset;
+
+    for (uint32_t s = 0; s < layout.arraySize; s++)
+    {
+        for (uint32_t m = 0; m < mips; m++)
+        {
+            DdsSubresource r;
+            r.width = (width >> m) ? (width >> m) : 1;
+            r.height = (height >> m) ? (height >> m) : 1;
+            r.depth = (depth >> m) ? (depth >> m) : 1;
+
+            uint64_t rows = r.height;
+            uint64_t rowPitch;
+
+            if (layout.blockCompressed)
+            {
+                rows = (r.height + 3) / 4;
+                rowPitch = (uint64_t)((r.width + 3) / 4) * 2 * layout.bitsPerTexel;
+            }
+            else
+            {
+                rowPitch = ((uint64_t)r.width * layout.bitsPerTexel + 7) / 8;
+            }
+
+            /*pitches are 32 bits in d3d*/
+            if (rowPitch * rows > 0xffffffffull)
+                return false;
+
+            r.rowPitch = (uint32_t)rowPitch;
+            r.slicePitch = (uint32_t)(rowPitch * rows);
+            r.bytes = (uint64_t)r.slicePitch * r.depth;
+            r.offset = offset;
+
+            offset += r.bytes;
+
+            if (offset > fileSize)
+                return false;
+
+            layout.subresources.push_back(r);
+        }
+    }
+
+    layout.dataBytes = offset - layout.dataOffset;
+    return true;
+}
+
+bool ReadDdsLayout(const std::string& file, DdsLayout& layout)
+{
+    std::ifstream in(file, std::ios::binary | std::ios::ate);
+
+    if (!in.is_open())
+        return false;
+
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    uint8_t header[DDS_MAX_HEADER_BYTES];
+
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+
+    return ParseDds(header, static_cast<size_t>(in.gcount()), fileSize, layout);
+}
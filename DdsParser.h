@@ -0,0 +1,84 @@
+/* DdsParser.h
+
+reads the header of a dds file and where every mip of every array slice
+is in the file, without touching the data. everything read from the file
+is checked: sizes, counts and offsets are limited, the arithmetic can't
+overflow and a layout is only returned if all subresources end inside the
+file. anything else is rejected, nothing is read past the bytes given.
+
+format is the DXGI_FORMAT value of the texture, 0 if the pixel format has
+no dxgi format. the size is known anyway, such files are loaded by the
+DDSTextureLoader.
+
+only depends on the standard library.
+
+    Usage:
+    DdsLayout layout;
+    if (ParseDds(header, headerBytes, fileBytes, layout) || ReadDdsLayout(file, layout))
+    {
+        const DdsSubresource& s = layout.Subresource(mip, slice);
+        read s.bytes at s.offset
+    }
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define DDS_MAGIC_BYTES 4
+#define DDS_HEADER_BYTES 124
+#define DDS_DX10_BYTES 20
+
+/*the largest header, read at least this much of a file*/
+#define DDS_MAX_HEADER_BYTES (DDS_MAGIC_BYTES + DDS_HEADER_BYTES + DDS_DX10_BYTES)
+
+#define DDS_MAX_DIMENSION 16384
+#define DDS_MAX_ARRAY 2048
+#define DDS_MAX_MIPS 15
+
+struct DdsSubresource
+{
+    uint64_t offset;
+    uint64_t bytes;
+    uint32_t width, height, depth;
+    uint32_t rowPitch, slicePitch;
+};
+
+struct DdsLayout
+{
+    uint32_t width = 0, height = 0, depth = 1;
+    uint32_t mips = 1;
+
+    /*array slices, six per cube*/
+    uint32_t arraySize = 1;
+    bool cube = false;
+    bool volume = false;
+
+    /*a dx10 Texture1D, height is 1*/
+    bool texture1D = false;
+
+    uint32_t format = 0;
+    uint32_t bitsPerTexel = 0;
+    bool blockCompressed = false;
+
+    uint64_t dataOffset = 0;
+    uint64_t dataBytes = 0;
+
+    /*slice * mips + mip, the order of D3D11CalcSubresource and of the file*/
+    std::vector<DdsSubresource> subresources;
+
+    const DdsSubresource& Subresource(uint32_t mip, uint32_t slice) const { return subresources[slice * mips + mip]; }
+
+    /*bytes of one mip over all slices*/
+    uint64_t MipBytes(uint32_t mip) const;
+};
+
+/*size bytes of data are the start of a file of fileSize bytes*/
+bool ParseDds(const uint8_t* data, size_t size, uint64_t fileSize, DdsLayout& layout);
+
+/*reads the header of file and parses it*/
+bool ReadDdsLayout(const std::string& file, DdsLayout& layout);
@@ -100,8 +100,6 @@ HWND DirectXBase::getWindowHandle()
 
 bool DirectXBase::Initialisation()
 {
-    srand((unsigned)time(NULL));
-
     if (!InitWindow() || !InitDirect3D())
     {
         return false;
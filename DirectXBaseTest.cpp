@@ -10,21 +10,138 @@
 #include "RenderStates.h"
 #include "Shader.h"
 #include "InputLayout.h"
+#include "GoldenScene.h"
+#include "TexturePacker.h"
 #include <fstream>
 #include <filesystem>
+#include <sstream>
 
 #pragma warning (disable : 28251) 
 #pragma warning (disable : 6387)
 
+/*the golden image of the level on the cpu, see GoldenScene.h*/
+static bool renderGolden(const std::string& file, const std::string& reference)
+{
+    if (file.empty())
+        return false;
+
+    SoftwareRasterizer raster(GOLDEN_WIDTH, GOLDEN_HEIGHT);
+
+    if (!GoldenScene::RenderMatchStart(raster, "game.lvl"))
+    {
+        DBOUT("Unable to read the level for the golden image" << std::endl);
+        return false;
+    }
+
+    const SoftStats& stats = raster.Stats();
+    DBOUT("Golden image in " << stats.totalMs << " ms, shadow " << stats.shadowMs << " ms, raster " << stats.rasterMs
+          << " ms, " << stats.triangles << " triangles" << std::endl);
+
+    if (!raster.SaveBMP(file) || !raster.SaveTileTimings(std::filesystem::path(file).replace_extension(".csv").string()))
+    {
+        DBOUT("Unable to write " << file.c_str() << std::endl);
+        return false;
+    }
+
+    if (reference.empty())
+        return true;
+
+    int width, height;
+    std::vector<uint32_t> pixels;
+
+    if (!SoftwareRasterizer::LoadBMP(reference, width, height, pixels))
+    {
+        DBOUT("Unable to read " << reference.c_str() << std::endl);
+        return false;
+    }
+
+    size_t different = SoftwareRasterizer::Compare(raster.Pixels(), pixels, GOLDEN_TOLERANCE);
+    DBOUT(different << " of " << raster.Pixels().size() << " pixels differ from " << reference.c_str() << std::endl);
+
+    return different <= raster.Pixels().size() * GOLDEN_MAX_DIFFERENT;
+}
+
 int WINAPI WinMain(HINSTANCE hInstance,
                    HINSTANCE hPrevInstance,
                    LPSTR lpCmdLine,
                    int nShowCmd)
 {
+    /*measure cpu subsystems and exit*/
+    if (strstr(lpCmdLine, "-benchmark"))
+    {
+        std::wostringstream report;
+
+        MixerBenchmark mix = AudioMixer::Benchmark(MIXER_BENCHMARK_BUDGET);
+        report << L"Audio mixer: " << mix.voices << L" voices in " << mix.msPerBlock << L" ms per "
+               << MIXER_BLOCK_FRAMES << L" frame block (budget " << MIXER_BENCHMARK_BUDGET << L" ms)\n";
+
+        SoundEngine sound;
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(std::filesystem::path(SOUND_PATH_EFFECTS)))
+        {
+            sound.loadFile(entry.path().c_str(), SoundType::Effect);
+        }
+
+        report << sound.benchmarkDecode();
+
+        report << CpuBlur::Report(CpuBlur::Benchmark(1280, 720, { 1.f, 2.f, 4.f, 8.f, 16.f, 32.f }));
+        report << ParticleUpdater::Report(ParticleUpdater::Benchmark({ 10000, 100000, 1000000 }));
+
+        DBOUT(report.str());
+        MessageBox(NULL, report.str().c_str(), L"Benchmark", MB_OK);
+        return 0;
+    }
+
+    /*render a golden image on the cpu and exit without a window or device, -golden <file.bmp> [-compare <reference.bmp>]*/
+    if (strstr(lpCmdLine, "-golden"))
+    {
+        std::istringstream args(lpCmdLine);
+        std::string file, reference;
+
+        for (std::string arg; args >> arg;)
+        {
+            if (arg == "-golden")
+                args >> file;
+            else if (arg == "-compare")
+                args >> reference;
+        }
+
+        return renderGolden(file, reference) ? 0 : 1;
+    }
+
+    /*pack the small textures into atlas pages and exit, models use them from the next start on*/
+    if (strstr(lpCmdLine, "-packtextures"))
+    {
+        TexturePacker packer;
+
+        for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(TEXTURE_PATH)))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".dds")
+            {
+                packer.Add(entry.path().stem().u8string(), entry.path().u8string());
+            }
+        }
+
+        bool ok = packer.Pack() && packer.Write(TEXTURE_ATLAS_PATH);
+
+        /*an old manifest would move the models onto stale pages, without one they keep their own textures*/
+        if (!ok)
+        {
+            std::error_code ec;
+            std::filesystem::remove(std::filesystem::path(TEXTURE_ATLAS_PATH) / TEXTURE_ATLAS_MANIFEST, ec);
+        }
+
+        std::wstring report = packer.Report();
+
+        DBOUT(report);
+        MessageBox(NULL, report.c_str(), ok ? L"Texture atlas" : L"Texture atlas failed", MB_OK);
+        return ok ? 0 : 1;
+    }
+
     auto start = chrono::system_clock::now();
 
 
-    DXTest dxbase(hInstance);
+    DXTest dxbase(hInstance, lpCmdLine);
 
     if (!dxbase.Initialisation())
         return 0;
@@ -38,7 +155,7 @@ int WINAPI WinMain(HINSTANCE hInstance,
 }
 
 
-DXTest::DXTest(HINSTANCE hProgramID) : DirectXBase(hProgramID)
+DXTest::DXTest(HINSTANCE hProgramID, const std::string& commandLine) : DirectXBase(hProgramID), commandLine(commandLine)
 {
     wndTitle = L"Pong3D";
 
@@ -60,9 +177,15 @@ DXTest::~DXTest()
     deviceContext->ClearState();
 
     delete input; input = 0;
+    delete particleUpdater; particleUpdater = 0;
+    delete session; session = 0;
+    delete transport; transport = 0;
     delete skybox; skybox = 0;
-    delete res; res = 0;
+
+    /*particle systems give their buffers back before the pool goes*/
     delete gameLevel; delete endLevel;
+    mRain.sleep();
+    delete res; res = 0;
 
     for (auto& i : playCharacters)
         delete i;
@@ -74,6 +197,16 @@ DXTest::~DXTest()
     DXRelease(mOffscreenSRV);
     DXRelease(mOffscreenUAV);
     DXRelease(mOffscreenRTV);
+    DXRelease(mSplitQuadVB);
+    DXRelease(mAtlasSRV);
+    DXRelease(mAtlasUAV);
+    DXRelease(mAtlasRTV);
+    DXRelease(mAtlasDSV);
+
+    if (!frameTraceFile.empty() && !FrameTimeGovernor::SaveTrace(frameTraceFile, frameTrace))
+    {
+        DBOUT("Unable to save frame trace " << frameTraceFile.c_str() << std::endl);
+    }
 
     RenderStates::Destroy();
     Shaders::Destroy();
@@ -104,7 +237,17 @@ bool DXTest::Initialisation()
 
     /*...*/
 
-    input = new InputManager();
+    /*input devices can be replaced from the command line for headless runs*/
+    input = new InputManager(InputManager::ParseDevices(commandLine));
+
+    matchSeed = static_cast<uint64_t>(time(NULL));
+    if (!parseOnline())
+    {
+        return false;
+    }
+
+    Random::Seed(matchSeed);
+    DBOUT(L"Match seed " << matchSeed << std::endl);
     res = new ResourceManager(device, deviceContext, WICFactory, d2dContext);
 
     /*create default cube*/
@@ -113,6 +256,9 @@ bool DXTest::Initialisation()
     res->getModelCollection()->AddModel(DEFAULT_SPHERE, res->getModelCollection()->CreateSphereModel(.5f, 32, 32));
 
 
+    /*models are moved onto the pages of -packtextures*/
+    res->getModelCollection()->ReadTextureAtlas(std::string(TEXTURE_ATLAS_PATH) + "/" + TEXTURE_ATLAS_MANIFEST);
+
     /*load all models*/
     if (!res->AddModelsFromFolder(modelPath))
     {
@@ -126,6 +272,7 @@ bool DXTest::Initialisation()
     }
 
     res->getTextureCollection()->SetDefaultTexture("default");
+    res->getTextureCollection()->SetBudget(textureBudget);
     res->getModelCollection()->SetDefaultModel("defaultCube");
 
     /*load all bitmaps*/
@@ -186,10 +333,10 @@ bool DXTest::Initialisation()
     sceneBounds.Radius = sqrtf(16000);
 
     /*add static models for testing*/
-    gameLevel = new Level(res, device, deviceContext);
+    gameLevel = new Level(res, device, deviceContext, cpuParticles);
     gameLevel->LoadLevel("game.lvl");
 
-    endLevel = new Level(res, device, deviceContext);
+    endLevel = new Level(res, device, deviceContext, cpuParticles);
     endLevel->LoadLevel("end.lvl");
 
     activeLevel = gameLevel;
@@ -200,7 +347,13 @@ bool DXTest::Initialisation()
     raindrop.push_back(L"data/textures/raindrop.dds");
     ID3D11ShaderResourceView* mDrop = CreateTexture2DArraySRV(device, deviceContext, raindrop);
 
-    mRain.init(device, Shaders::rainShader, mDrop, CreateRandomTexture1DSRV(device), 10000);
+    ParticleEmitterDesc rainDesc = ParticleEmitterDesc::Rain();
+    mRain.init(device, Shaders::rainShader, mDrop, res->getRandomTexture(), res->getParticleBuffers(), 10000, rainDesc, cpuParticles);
+
+    if (cpuParticles)
+    {
+        particleUpdater = new ParticleUpdater();
+    }
     mRain.setAcceleration(XMFLOAT3(-1.f, -9.8f, 0.f));
     mRain.setSizeParticle(XMFLOAT2(12.5f, 12.5f));
 
@@ -238,6 +391,10 @@ bool DXTest::Initialisation()
 
     BuildScreenQuadGeometryBuffers();
 
+    /*without timestamp queries the views follow the cpu frame time*/
+    gpuTiming = gpuTimer.Init(device);
+    governor.Reset(SPLITSCREEN_VIEWS);
+
     OnWindowResize();
     themeChannel = res->getSound()->add("theme", true);
 
@@ -251,7 +408,9 @@ void DXTest::OnWindowResize()
     DirectXBase::OnWindowResize();
 
     BuildOffscreenViews();
-    blurEffect.Init(device, wndWidth, wndHeight, DXGI_FORMAT_R8G8B8A8_UNORM);
+
+    /*sized for the atlas, smaller inputs are clamped at their edges*/
+    blurEffect.Init(device, viewLayout.AtlasWidth(), viewLayout.AtlasHeight(), DXGI_FORMAT_R8G8B8A8_UNORM);
 
 
     /*recalc camera*/
@@ -318,6 +477,7 @@ void DXTest::buildShadowTransform()
 void DXTest::switchLevel(Level& lvl)
 {
     if (activeLevel == &lvl) return;
+    if (activeLevel) activeLevel->Suspend();
     lvl.Reset();
     activeLevel = &lvl;
 }
@@ -343,6 +503,16 @@ bool DXTest::UpdateTransition(float deltaTime)
 
 void DXTest::Update(float deltaTime)
 {
+    /*load the textures the last frame asked for*/
+    res->getTextureCollection()->Update(deviceContext);
+
+    textureTelemetryTime += deltaTime;
+
+    if (!textureTelemetryFile.empty() && textureTelemetryTime >= TEXTURE_TELEMETRY_INTERVAL)
+    {
+        textureTelemetryTime = 0.f;
+        res->getTextureCollection()->WriteReport(textureTelemetryFile);
+    }
 
     /*game logic*/
 
@@ -375,9 +545,13 @@ void DXTest::Update(float deltaTime)
     /*but dont update when in transition*/
     if (transitionInProgress == 0)
     {
-        input->UpdateMouse(mousePos);
+        input->UpdateMouse(mousePos.x, mousePos.y);
         input->Update(deltaTime);
     }
+    else
+    {
+        input->Skip();
+    }
 
     /*exit always possible*/
     if (input->ButtonReleased(0, BACK))
@@ -398,6 +572,16 @@ void DXTest::Update(float deltaTime)
             transitionInProgress = 2;
             transToIngame = 0;
             res->getSound()->forceStop(themeChannel);
+
+            if (onlinePlayer >= 0)
+            {
+                startOnlineMatch();
+            }
+            else
+            {
+                Random::Seed(matchSeed + localMatch++);
+                playball->Seed(Random::Stream(RandomStream::Ball));
+            }
         }
 
         if (input->ButtonPressed(0, BUTTON_X))
@@ -422,12 +606,22 @@ void DXTest::Update(float deltaTime)
 
         /*first player press start to continue*/
 
-        if (playerCount > 0)
+        /*online matches start as soon as the fade is done*/
+        if (onlinePlayer >= 0 && players.empty() && transitionInProgress == 0)
+        {
+            registerOnlinePlayers();
+            blurSigma = 0.f;
+            input->usedInputActive = true;
+            transitionInProgress = 1;
+            transToIngame = true;
+        }
+
+        if (playerCount > 0 && onlinePlayer < 0)
         {
 
             if (input->ButtonPressed(players[0]->getInput(), START) && !transToIngame)
             {
-                blurStrength = 0;
+                blurSigma = 0.f;
                 input->usedInputActive = true;
                 transitionInProgress = 1;
                 transToIngame = true;
@@ -444,7 +638,7 @@ void DXTest::Update(float deltaTime)
 
         /*up to 4 players can join*/
 
-        for (int i = 0; i < INPUT_MAX; i++)
+        for (int i = 0; i < INPUT_MAX && onlinePlayer < 0; i++)
         {
             if (playerCount == 3)
             {
@@ -506,6 +700,8 @@ void DXTest::Update(float deltaTime)
     }
     else if (gameState == MainGameState::INGAME)
     {
+        /*dynamic resolution of the split screen views*/
+        updateViewScales(deltaTime);
 
         if (transToEndScreen && transitionInProgress == 0)
         {
@@ -514,13 +710,14 @@ void DXTest::Update(float deltaTime)
             transitionInProgress = 2;
             lightRotationAngle = XM_PIDIV4;
             transToEndScreen = false;
-            res->getSound()->add("cheer_long");
+            res->getSound()->add("cheer_long", false, SOUND_PRIORITY_HIGH);
         }
-        else if (!allDead)
+        /*online a predicted end keeps simulating until it is confirmed*/
+        else if (!transToEndScreen)
         {
 
-            /*pause screen*/
-            if (input->ButtonPressed(players.front()->getInput(), START)){
+            /*pause screen, not online as the other peers keep playing*/
+            if (onlinePlayer < 0 && input->ButtonPressed(players.front()->getInput(), START)){
 
                 if (ingameState == InGameState::PAUSE && pauseFadeTimer >= PAUSE_FADE_TIME)
                 {
@@ -563,185 +760,43 @@ void DXTest::Update(float deltaTime)
 
             /*********/
 
-            activeCamera = playCharacters[players.front()->getCharacter()]->getCamera();
+            activeCamera = playCharacters[players[(std::max)(onlinePlayer, 0)]->getCharacter()]->getCamera();
 
             /*update players and then the ball*/
-
-            /*player input*/
-            for (auto& i : players)
+            if (session)
             {
+                NetInput local = readInput(players[onlinePlayer]->getInput());
+                pendingButtons |= local.buttons;
 
-                int playerCharID = i->getCharacter();
-                int inputID = i->getInput();
-
-                InputData* in = input->getInput(inputID);
-
-                float leftJoystickX = in->trigger[THUMB_LX];
-                float leftJoystickY = in->trigger[THUMB_RX];
-
-                if (input->ButtonPressed(inputID, LEFT_SHOULDER) || input->ButtonPressed(inputID, RIGHT_SHOULDER))
-                {
-                    if (playCharacters[playerCharID]->currState != PCState::DASH)
-                    {
-                        playCharacters[playerCharID]->dashDirection = input->ButtonPressed(inputID, LEFT_SHOULDER) ? -1 : 1;
-                    }
-                    playCharacters[playerCharID]->initDash();
-                }
-
-                if (playCharacters[playerCharID]->currState != PCState::DASH)
-                {
-
-                    if (playCharacters[playerCharID]->metaPosition == 0)
-                    {
-                        playCharacters[playerCharID]->Translation.x += leftJoystickX * playCharacters[playerCharID]->Speed * deltaTime;
-                    }
-                    else if (playCharacters[playerCharID]->metaPosition == 1)
-                    {
-                        playCharacters[playerCharID]->Translation.x -= leftJoystickX * playCharacters[playerCharID]->Speed * deltaTime;
-                    }
-                    else if (playCharacters[playerCharID]->metaPosition == 2)
-                    {
-                        playCharacters[playerCharID]->Translation.z -= leftJoystickX * playCharacters[playerCharID]->Speed * deltaTime;
-                    }
-                    else if (playCharacters[playerCharID]->metaPosition == 3)
-                    {
-                        playCharacters[playerCharID]->Translation.z += leftJoystickX * playCharacters[playerCharID]->Speed * deltaTime;
-                    }
+                /*fixed steps, a stalled session does not build up time*/
+                netTime = (std::min)(netTime + deltaTime, ROLLBACK_STEP * ROLLBACK_MAX_FRAMES);
 
-                }
-                else
+                while (netTime >= ROLLBACK_STEP)
                 {
-                    float dashSpeed = (PLAYER_SPEED * 3.0f) * ((DASH_DURATION - playCharacters[playerCharID]->dashTimer) / DASH_DURATION);
-
-                    //float dashSpeed = (PLAYER_SPEED * 3.5f) * ((DASH_DURATION - playCharacters[playerCharID]->dashTimer) / DASH_DURATION);
-                    playCharacters[playerCharID]->Speed = dashSpeed;
-
-                    if (dashSpeed < PLAYER_SPEED)
-                    {
-                        dashSpeed = PLAYER_SPEED;
-                    }
-
-
-                    if (playCharacters[playerCharID]->metaPosition == 0)
-                    {
-                        playCharacters[playerCharID]->Translation.x += playCharacters[playerCharID]->dashDirection * dashSpeed * deltaTime;
-                    }
-                    else if (playCharacters[playerCharID]->metaPosition == 1)
-                    {
-                        playCharacters[playerCharID]->Translation.x -= playCharacters[playerCharID]->dashDirection * dashSpeed * deltaTime;
-                    }
-                    else if (playCharacters[playerCharID]->metaPosition == 2)
-                    {
-                        playCharacters[playerCharID]->Translation.z -= playCharacters[playerCharID]->dashDirection * dashSpeed * deltaTime;
-                    }
-                    else if (playCharacters[playerCharID]->metaPosition == 3)
-                    {
-                        playCharacters[playerCharID]->Translation.z += playCharacters[playerCharID]->dashDirection * dashSpeed * deltaTime;
-                    }
-
-
-                }
-
-            }
-
-            /*bot*/
-            for (auto& i : playCharacters)
-            {
+                    local.buttons = pendingButtons;
+                    session->AddLocalInput(local);
+                    pendingButtons = 0;
 
-                if (i->npc)
-                {
-                    if (i->Orientation)
-                    {
-                        i->Translation.z = playball->Translation.z;
-                    }
-                    else
+                    if (!session->Advance())
                     {
-                        i->Translation.x = playball->Translation.x;
+                        break;
                     }
-                }
-
-            }
 
-            /*limit movement of all playable chars*/
-            for (auto& i : playCharacters)
-            {
-                if (i->metaPosition == 0)
-                {
-                    if (i->Translation.x <= -PLAYER_MAX_MOVEMENT)
-                    {
-                        i->Translation.x = -PLAYER_MAX_MOVEMENT;
-                    }
-                    else if (i->Translation.x >= PLAYER_MAX_MOVEMENT)
-                    {
-                        i->Translation.x = PLAYER_MAX_MOVEMENT;
-                    }
-                }
-                else if (i->metaPosition == 1)
-                {
-                    if (i->Translation.x <= -PLAYER_MAX_MOVEMENT)
-                    {
-                        i->Translation.x = -PLAYER_MAX_MOVEMENT;
-                    }
-                    else if (i->Translation.x >= PLAYER_MAX_MOVEMENT)
-                    {
-                        i->Translation.x = PLAYER_MAX_MOVEMENT;
-                    }
-                }
-                else if (i->metaPosition == 2)
-                {
-                    if (i->Translation.z <= -PLAYER_MAX_MOVEMENT)
-                    {
-                        i->Translation.z = -PLAYER_MAX_MOVEMENT;
-                    }
-                    else if (i->Translation.z >= PLAYER_MAX_MOVEMENT)
-                    {
-                        i->Translation.z = PLAYER_MAX_MOVEMENT;
-                    }
-                }
-                else
-                {
-                    if (i->Translation.z <= -PLAYER_MAX_MOVEMENT)
-                    {
-                        i->Translation.z = -PLAYER_MAX_MOVEMENT;
-                    }
-                    else if (i->Translation.z >= PLAYER_MAX_MOVEMENT)
-                    {
-                        i->Translation.z = PLAYER_MAX_MOVEMENT;
-                    }
+                    netTime -= ROLLBACK_STEP;
                 }
 
-                i->Update(deltaTime);
+                res->getSound()->setMuted(false);
             }
-
-
-            /*ball*/
-            playball->Update(deltaTime);
-
-            /*check if player dead*/
-            allDead = true;
-            int pAlive = 0;
-            for (auto& i : playCharacters)
+            else
             {
-                if (i->controllingPlayer == nullptr)
-                {
-                    continue;
-                }
+                NetInput inputs[ROLLBACK_MAX_PLAYERS];
 
-                if (i->controllingPlayer->hp <= 0)
-                {
-                    DBOUT("Player " << i->controllingPlayer->pID << " has died!\n");
-                    i->npc = true;
-                    winOrder.push_back(i->controllingPlayer);
-                    DBOUT("Player " << i->controllingPlayer->pID << " added to win order\n");
-                    i->controllingPlayer = nullptr;
-                }
-                else
+                for (size_t i = 0; i < players.size(); i++)
                 {
-                    pAlive++;
-                    allDead = false;
+                    inputs[i] = readInput(players[i]->getInput());
                 }
 
-
+                simulateMatch(inputs, deltaTime);
             }
 
 #ifndef _DEBUG
@@ -765,7 +820,8 @@ void DXTest::Update(float deltaTime)
             //}
 #endif
 
-            if (allDead)
+            /*online the end waits for the deciding frame to be confirmed, a mispredicted death is rolled back*/
+            if (allDead && (session == nullptr || session->ConfirmedFrame() >= session->Frame() - 1))
             {
                 DBOUT("Everyone is dead!\n");
                 transToEndScreen = true;
@@ -778,6 +834,13 @@ void DXTest::Update(float deltaTime)
         switchLevel(*endLevel);
         if (transToRegistration && transitionInProgress == 0)
         {
+            /*the next match starts with the delay this one ended with*/
+            if (session)
+            {
+                onlineDelay = session->InputDelay();
+            }
+
+            delete session; session = nullptr;
             clearData();
             gameState = MainGameState::PLAYER_REGISTRATION;
             transitionInProgress = 2;
@@ -789,9 +852,20 @@ void DXTest::Update(float deltaTime)
 
             endTimer += deltaTime;
 
+            /*the other peers may still need our last inputs*/
+            if (session)
+            {
+                session->Poll();
+            }
+
             /*jump on podium*/
             for (auto& i : players)
             {
+                if (i->getInput() < 0)
+                {
+                    continue;
+                }
+
                 if (playCharacters[i->getCharacter()]->Velocity.y <= 0.f && input->ButtonPressed(i->getInput(), BUTTON_A))
                 {
                     playCharacters[i->getCharacter()]->Velocity.y = 5.f;
@@ -856,6 +930,25 @@ updSound:;
     activeLevel->Update(deltaTime);
     mRain.update(deltaTime, gTime.getTotalTime());
 
+    /*cpu particles of the level and the rain are updated together on the workers*/
+    if (particleUpdater)
+    {
+        std::vector<CpuParticleEmitter*> emitters;
+
+        for (auto& i : activeLevel->particleSystems)
+        {
+            if (i.second->getCpuEmitter() && i.second->isAwake())
+                emitters.push_back(i.second->getCpuEmitter());
+        }
+
+        if (gameState == MainGameState::PLAYER_REGISTRATION && mRain.isAwake())
+        {
+            emitters.push_back(mRain.getCpuEmitter());
+        }
+
+        particleUpdater->Update(emitters, deltaTime);
+    }
+
     /*rotate light*/
     lightRotationAngle += 0.1f * deltaTime;
     XMMATRIX R = XMMatrixRotationY(lightRotationAngle);
@@ -870,6 +963,20 @@ updSound:;
     bPressA.update(deltaTime);
     bPressStart.update(deltaTime);
 
+    /*one sound listener per player camera*/
+    int listeners = 0;
+
+    for (auto& p : players)
+    {
+        if (p->getCharacter() < 0 || listeners == SOUND_MAX_LISTENERS)
+            continue;
+
+        Camera* cam = playCharacters[p->getCharacter()]->getCamera();
+        res->getSound()->setListener(listeners++, cam->getPosition(), cam->getRight());
+    }
+
+    res->getSound()->setListenerCount(listeners);
+
     /*update sound*/
     res->getSound()->update(deltaTime);
 
@@ -885,7 +992,17 @@ void DXTest::Draw()
     ID3D11UnorderedAccessView* tUAView = 0;
     ID3D11RenderTargetView* tRenderTargetView = 0;
 
-    for (int f = 0; f < (gameState == MainGameState::INGAME ? 4 : 1); f++)
+    /*the four views are rendered into one atlas at their split screen size*/
+    bool splitScreen = gameState == MainGameState::INGAME;
+
+    gpuTimer.BeginFrame(deviceContext);
+
+    if (splitScreen)
+    {
+        deviceContext->ClearRenderTargetView(mAtlasRTV, clearColor);
+    }
+
+    for (int f = 0; f < (splitScreen ? 4 : 1); f++)
     {
         if (gameState == MainGameState::PLAYER_REGISTRATION)
         {
@@ -904,9 +1021,9 @@ void DXTest::Draw()
         else
         {
             activeCamera = playCharacters[f]->getCamera();
-            tResourceView = playCharacters[f]->splitScreenSRV;
-            tUAView = playCharacters[f]->splitScreenUAV;
-            tRenderTargetView = playCharacters[f]->splitScreenView;
+            tResourceView = mAtlasSRV;
+            tUAView = mAtlasUAV;
+            tRenderTargetView = mAtlasRTV;
         }
 
         /*draw to shadow map*/
@@ -942,12 +1059,32 @@ void DXTest::Draw()
 
         //ID3D11RenderTargetView* renderTargets[1] = { renderTargetView };
         ID3D11RenderTargetView* renderTargets[1] = { tRenderTargetView };
-        deviceContext->OMSetRenderTargets(1, renderTargets, depthStencilView);
-        deviceContext->RSSetViewports(1, &mainViewport);
+        ID3D11DepthStencilView* tDepthStencilView = depthStencilView;
+        D3D11_VIEWPORT viewport = mainViewport;
+
+        if (splitScreen)
+        {
+            ViewportRect r = viewLayout.Target(f);
+            viewport.TopLeftX = (float)r.x;
+            viewport.TopLeftY = (float)r.y;
+            viewport.Width = (float)r.width;
+            viewport.Height = (float)r.height;
+            tDepthStencilView = mAtlasDSV;
+
+            /*the shadow map does not depend on the scale of the view*/
+            gpuTimer.BeginView(deviceContext, f);
+        }
+
+        deviceContext->OMSetRenderTargets(1, renderTargets, tDepthStencilView);
+        deviceContext->RSSetViewports(1, &viewport);
 
         //deviceContext->ClearRenderTargetView(renderTargetView, clearColor);
-        deviceContext->ClearRenderTargetView(tRenderTargetView, clearColor);
-        deviceContext->ClearDepthStencilView(depthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+        if (!splitScreen)
+        {
+            deviceContext->ClearRenderTargetView(tRenderTargetView, clearColor);
+        }
+
+        deviceContext->ClearDepthStencilView(tDepthStencilView, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
 
         if (!renderWireFrame)
@@ -977,11 +1114,9 @@ void DXTest::Draw()
         /*draw static models*/
         XMMATRIX st = XMLoadFloat4x4(&shadowTransform);
 
-        it = activeLevel->modelsStatic.begin();
-        while (it != activeLevel->modelsStatic.end())
+        for (auto& i : activeLevel->drawOrder)
         {
-            it->second->Draw(device, deviceContext, activeCamera, st);
-            it++;
+            i->Draw(device, deviceContext, activeCamera, st);
         }
 
         //draw ball
@@ -997,10 +1132,15 @@ void DXTest::Draw()
         //render sky box last
         skybox->Draw(deviceContext, *activeCamera);
 
-        /*particle system*/
+        /*particle system, systems out of view are not simulated*/
+
+        BoundingFrustum frustum = activeCamera->getFrustum();
 
         for (auto& i : activeLevel->particleSystems)
         {
+            if (!i.second->isVisible(frustum))
+                continue;
+
             i.second->setEyePos(activeCamera->getPosition());
             i.second->draw(deviceContext, *activeCamera);
         }
@@ -1013,34 +1153,42 @@ void DXTest::Draw()
             mRain.setEyePos(activeCamera->getPosition());
             mRain.setEmitPosition(activeCamera->getPosition());
 
-            mRain.draw(deviceContext, *activeCamera);
+            if (mRain.isVisible(frustum))
+                mRain.draw(deviceContext, *activeCamera);
         }
 
         deviceContext->RSSetState(0);
         deviceContext->OMSetDepthStencilState(0, 0);
         deviceContext->OMSetBlendState(0, blendFactor, 0xffffffff);
 
-        /*blur*/
-
-        renderTargets[0] = renderTargetView;
-        deviceContext->OMSetRenderTargets(1, renderTargets, depthStencilView);
-
-        if (blurStrength > 0)
+        if (splitScreen)
         {
-            blurEffect.BlurSRV(deviceContext, tResourceView, tUAView, blurStrength);
+            gpuTimer.EndView(deviceContext, f);
         }
+    }
 
+    /*blur*/
 
-        DrawScreenQuad(tResourceView);
+    if (blurSigma > 0.f)
+    {
+        /*scaled down views leave part of the atlas unused*/
+        ViewportRect used = splitScreen ? viewLayout.Used() : ViewportRect();
+        blurEffect.BlurSRV(deviceContext, tResourceView, tUAView, tRenderTargetView, blurSigma, used.width, used.height);
+    }
 
+    ID3D11RenderTargetView* renderTargets[1] = { renderTargetView };
+    deviceContext->OMSetRenderTargets(1, renderTargets, depthStencilView);
+    deviceContext->RSSetViewports(1, &mainViewport);
 
-        /*default*/
-        deviceContext->RSSetState(0);
-        deviceContext->OMSetDepthStencilState(0, 0);
-        ID3D11ShaderResourceView* nullSRV[16] = { 0 };
-        deviceContext->PSSetShaderResources(0, 16, nullSRV);
 
-    }
+    DrawScreenQuad(tResourceView);
+
+
+    /*default*/
+    deviceContext->RSSetState(0);
+    deviceContext->OMSetDepthStencilState(0, 0);
+    ID3D11ShaderResourceView* nullSRV[16] = { 0 };
+    deviceContext->PSSetShaderResources(0, 16, nullSRV);
 
     /*D2D and DWrite Rendering*/
 
@@ -1143,6 +1291,7 @@ void DXTest::Draw()
 
     //show backbuffer
                      //this value is vsync => 0 is off, 1 - 4 sync intervalls
+    gpuTimer.EndFrame(deviceContext);
     swapChain->Present(0, 0);
 }
 
@@ -1219,88 +1368,75 @@ void DXTest::BuildScreenQuadGeometryBuffers()
     D3D11_SUBRESOURCE_DATA iinitData;
     iinitData.pSysMem = &indices[0];
     device->CreateBuffer(&ibd, &iinitData, &mScreenQuadIB);
+
+    /*split screen quads, texture coordinates follow the dynamic resolution*/
+    vbd.Usage = D3D11_USAGE_DYNAMIC;
+    vbd.ByteWidth = (UINT)(sizeof(Vertex::Standard) * 4 * SPLITSCREEN_VIEWS);
+    vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    device->CreateBuffer(&vbd, 0, &mSplitQuadVB);
 }
 
 
 void DXTest::DrawScreenQuad(ID3D11ShaderResourceView* srv)
 {
-    
-    for (int k = 0; k < (gameState == MainGameState::INGAME ? 4 : 1); k++)
+    UINT stride = sizeof(Vertex::Standard);
+    UINT offset = 0;
+    ID3D11Buffer* vb = mScreenQuadVB;
+    int quads = 1;
+
+    //splitscreen, one quad per view over its part of the window
+    if (gameState == MainGameState::INGAME)
     {
-        UINT stride = sizeof(Vertex::Standard);
-        UINT offset = 0;
+        D3D11_MAPPED_SUBRESOURCE mapped;
 
-        deviceContext->IASetInputLayout(InputLayouts::Standard);
-        deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        deviceContext->IASetVertexBuffers(0, 1, &mScreenQuadVB, &stride, &offset);
-        deviceContext->IASetIndexBuffer(mScreenQuadIB, DXGI_FORMAT_R32_UINT, 0);
+        if (FAILED(deviceContext->Map(mSplitQuadVB, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+            return;
 
-        // 
-       // XMMATRIX world = XMMatrixIdentity();
-        XMMATRIX world;
+        Vertex::Standard* v = reinterpret_cast<Vertex::Standard*>(mapped.pData);
+        quads = (std::min)(viewLayout.Views(), SPLITSCREEN_VIEWS);
 
-        //splitscreen
-        if (gameState == MainGameState::INGAME)
+        for (int k = 0; k < quads; k++)
         {
-            if (k == 0)
-            {
-                world = XMMATRIX(
-                    0.5f, 0.0f, 0.0f, 0.0f,
-                    0.0f, 0.5f, 0.0f, 0.0f,
-                    0.0f, 0.0f, 1.f, 0.0f,
-                    -0.5f, 0.5f, 0.0f, 1.f);
-            }
-            else if (k == 1)
-            {
-                world = XMMATRIX(
-                    0.5f, 0.0f, 0.0f, 0.0f,
-                    0.0f, 0.5f, 0.0f, 0.0f,
-                    0.0f, 0.0f, 1.0f, 0.0f,
-                    0.5f, 0.5f, 0.0f, 1.0f);
-            }
-            else if (k == 2)
-            {
-                world = XMMATRIX(
-                    0.5f, 0.0f, 0.0f, 0.0f,
-                    0.0f, 0.5f, 0.0f, 0.0f,
-                    0.0f, 0.0f, 1.0f, 0.0f,
-                    -0.5f, -0.5f, 0.0f, 1.0f);
-            }
-            else
-            {
-                world = XMMATRIX(
-                    0.5f, 0.0f, 0.0f, 0.0f,
-                    0.0f, 0.5f, 0.0f, 0.0f,
-                    0.0f, 0.0f, 1.0f, 0.0f,
-                    0.5f, -0.5f, 0.0f, 1.0f);
-            }
-        }
-        //one screen
-        else
-        {
-            world = XMMatrixIdentity();
+            const ViewportRect& r = viewLayout.Screen(k);
+            ViewportUV uv = viewLayout.UV(k);
+
+            float x0 = 2.f * r.x / wndWidth - 1.f;
+            float x1 = 2.f * (r.x + r.width) / wndWidth - 1.f;
+            float y0 = 1.f - 2.f * r.y / wndHeight;
+            float y1 = 1.f - 2.f * (r.y + r.height) / wndHeight;
+
+            /*same corner order as the full screen quad*/
+            v[k * 4 + 0] = Vertex::Standard(x0, y1, 0.f, uv.u0, uv.v1, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f);
+            v[k * 4 + 1] = Vertex::Standard(x0, y0, 0.f, uv.u0, uv.v0, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f);
+            v[k * 4 + 2] = Vertex::Standard(x1, y0, 0.f, uv.u1, uv.v0, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f);
+            v[k * 4 + 3] = Vertex::Standard(x1, y1, 0.f, uv.u1, uv.v1, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f);
         }
-        ID3DX11EffectTechnique* tech = Shaders::fullscreenShader->ViewStandard;
-        D3DX11_TECHNIQUE_DESC techDesc;
 
-        tech->GetDesc(&techDesc);
-        for (UINT p = 0; p < techDesc.Passes; ++p)
-        {
-            Shaders::fullscreenShader->SetWorldViewProj(world);
+        deviceContext->Unmap(mSplitQuadVB, 0);
+        vb = mSplitQuadVB;
+    }
 
-            if (gameState == MainGameState::INGAME)
-            {
-                Shaders::fullscreenShader->SetTexture(playCharacters[k]->splitScreenSRV);
-            }
-            else
-            {
-                Shaders::fullscreenShader->SetTexture(srv);
-            }
+    deviceContext->IASetInputLayout(InputLayouts::Standard);
+    deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    deviceContext->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+    deviceContext->IASetIndexBuffer(mScreenQuadIB, DXGI_FORMAT_R32_UINT, 0);
 
-            //Shaders::fullscreenShader->SetFadeValue(0.f);
+    ID3DX11EffectTechnique* tech = Shaders::fullscreenShader->ViewStandard;
+    D3DX11_TECHNIQUE_DESC techDesc;
 
-            tech->GetPassByIndex(p)->Apply(0, deviceContext);
-            deviceContext->DrawIndexed(6, 0, 0);
+    tech->GetDesc(&techDesc);
+    for (UINT p = 0; p < techDesc.Passes; ++p)
+    {
+        Shaders::fullscreenShader->SetWorldViewProj(XMMatrixIdentity());
+        Shaders::fullscreenShader->SetTexture(srv);
+
+        //Shaders::fullscreenShader->SetFadeValue(0.f);
+
+        tech->GetPassByIndex(p)->Apply(0, deviceContext);
+
+        for (int k = 0; k < quads; k++)
+        {
+            deviceContext->DrawIndexed(6, 0, k * 4);
         }
     }
 }
@@ -1313,10 +1449,10 @@ void DXTest::BuildOffscreenViews()
     DXRelease(mOffscreenRTV);
     DXRelease(mOffscreenUAV);
 
-    for (auto& i : playCharacters)
-    {
-        DXRelease(i->splitScreenView);
-    }
+    DXRelease(mAtlasSRV);
+    DXRelease(mAtlasRTV);
+    DXRelease(mAtlasUAV);
+    DXRelease(mAtlasDSV);
 
     /*main offscreen view*/
     D3D11_TEXTURE2D_DESC texDesc;
@@ -1346,32 +1482,31 @@ void DXTest::BuildOffscreenViews()
     DXRelease(offscreenTex);
 
 
-    /*split screen views*/
-    for (auto& i : playCharacters)
-    {
-        D3D11_TEXTURE2D_DESC texDesc;
+    /*split screen atlas, one slot per view at its quadrant size*/
+    viewLayout.Build(wndWidth, wndHeight, 2, 2);
 
-        texDesc.Width = wndWidth;
-        texDesc.Height = wndHeight;
-        texDesc.MipLevels = 1;
-        texDesc.ArraySize = 1;
-        texDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-        texDesc.SampleDesc.Count = 1;
-        texDesc.SampleDesc.Quality = 0;
-        texDesc.Usage = D3D11_USAGE_DEFAULT;
-        texDesc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS;
-        texDesc.CPUAccessFlags = 0;
-        texDesc.MiscFlags = 0;
+    texDesc.Width = viewLayout.AtlasWidth();
+    texDesc.Height = viewLayout.AtlasHeight();
 
-        ID3D11Texture2D* offscreenTex = 0;
-        device->CreateTexture2D(&texDesc, 0, &offscreenTex);
+    ID3D11Texture2D* atlasTex = 0;
+    device->CreateTexture2D(&texDesc, 0, &atlasTex);
 
-        device->CreateShaderResourceView(offscreenTex, 0, &(i->splitScreenSRV));
-        device->CreateRenderTargetView(offscreenTex, 0, &(i->splitScreenView));
-        device->CreateUnorderedAccessView(offscreenTex, 0, &(i->splitScreenUAV));
+    device->CreateShaderResourceView(atlasTex, 0, &mAtlasSRV);
+    device->CreateRenderTargetView(atlasTex, 0, &mAtlasRTV);
+    device->CreateUnorderedAccessView(atlasTex, 0, &mAtlasUAV);
 
-        DXRelease(offscreenTex);
-    }
+    DXRelease(atlasTex);
+
+    /*render target and depth buffer must have the same size*/
+    D3D11_TEXTURE2D_DESC depthDesc = texDesc;
+    depthDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+    depthDesc.BindFlags = D3D11_BIND_DEPTH_STENCIL;
+
+    ID3D11Texture2D* depthTex = 0;
+    device->CreateTexture2D(&depthDesc, 0, &depthTex);
+    device->CreateDepthStencilView(depthTex, 0, &mAtlasDSV);
+
+    DXRelease(depthTex);
 }
 
 void DXTest::clearData()
@@ -1396,7 +1531,7 @@ void DXTest::clearData()
 
     playerCount = 0;
     allDead = false;
-    blurStrength = 1;
+    blurSigma = BLUR_SCREEN_SIGMA;
     endTimer = 0.f;
 
     playCharacters[0]->Translation = XMFLOAT3(0.f, PLAYER_HEIGHT, 0.f);
@@ -1487,4 +1622,449 @@ void DXTest::setupEndScreen()
         counter++;
     }
 
-}
\ No newline at end of file
+}
+
+void DXTest::simulateMatch(const NetInput* inputs, float deltaTime)
+{
+    /*player input*/
+    for (size_t p = 0; p < players.size(); p++)
+    {
+
+        int playerCharID = players[p]->getCharacter();
+
+        float leftJoystickX = inputs[p].Move();
+
+        if (inputs[p].buttons & (NET_BUTTON_DASH_LEFT | NET_BUTTON_DASH_RIGHT))
+        {
+            if (playCharacters[playerCharID]->currState != PCState::DASH)
+            {
+                playCharacters[playerCharID]->dashDirection = (inputs[p].buttons & NET_BUTTON_DASH_LEFT) ? -1 : 1;
+            }
+            playCharacters[playerCharID]->initDash();
+        }
+
+        if (playCharacters[playerCharID]->currState != PCState::DASH)
+        {
+
+            if (playCharacters[playerCharID]->metaPosition == 0)
+            {
+                playCharacters[playerCharID]->Translation.x += leftJoystickX * playCharacters[playerCharID]->Speed * deltaTime;
+            }
+            else if (playCharacters[playerCharID]->metaPosition == 1)
+            {
+                playCharacters[playerCharID]->Translation.x -= leftJoystickX * playCharacters[playerCharID]->Speed * deltaTime;
+            }
+            else if (playCharacters[playerCharID]->metaPosition == 2)
+            {
+                playCharacters[playerCharID]->Translation.z -= leftJoystickX * playCharacters[playerCharID]->Speed * deltaTime;
+            }
+            else if (playCharacters[playerCharID]->metaPosition == 3)
+            {
+                playCharacters[playerCharID]->Translation.z += leftJoystickX * playCharacters[playerCharID]->Speed * deltaTime;
+            }
+
+        }
+        else
+        {
+            float dashSpeed = (PLAYER_SPEED * 3.0f) * ((DASH_DURATION - playCharacters[playerCharID]->dashTimer) / DASH_DURATION);
+
+            //float dashSpeed = (PLAYER_SPEED * 3.5f) * ((DASH_DURATION - playCharacters[playerCharID]->dashTimer) / DASH_DURATION);
+            playCharacters[playerCharID]->Speed = dashSpeed;
+
+            if (dashSpeed < PLAYER_SPEED)
+            {
+                dashSpeed = PLAYER_SPEED;
+            }
+
+
+            if (playCharacters[playerCharID]->metaPosition == 0)
+            {
+                playCharacters[playerCharID]->Translation.x += playCharacters[playerCharID]->dashDirection * dashSpeed * deltaTime;
+            }
+            else if (playCharacters[playerCharID]->metaPosition == 1)
+            {
+                playCharacters[playerCharID]->Translation.x -= playCharacters[playerCharID]->dashDirection * dashSpeed * deltaTime;
+            }
+            else if (playCharacters[playerCharID]->metaPosition == 2)
+            {
+                playCharacters[playerCharID]->Translation.z -= playCharacters[playerCharID]->dashDirection * dashSpeed * deltaTime;
+            }
+            else if (playCharacters[playerCharID]->metaPosition == 3)
+            {
+                playCharacters[playerCharID]->Translation.z += playCharacters[playerCharID]->dashDirection * dashSpeed * deltaTime;
+            }
+
+
+        }
+
+    }
+
+    /*bot*/
+    for (auto& i : playCharacters)
+    {
+
+        if (i->npc)
+        {
+            if (i->Orientation)
+            {
+                i->Translation.z = playball->Translation.z;
+            }
+            else
+            {
+                i->Translation.x = playball->Translation.x;
+            }
+        }
+
+    }
+
+    /*limit movement of all playable chars*/
+    for (auto& i : playCharacters)
+    {
+        if (i->metaPosition == 0)
+        {
+            if (i->Translation.x <= -PLAYER_MAX_MOVEMENT)
+            {
+                i->Translation.x = -PLAYER_MAX_MOVEMENT;
+            }
+            else if (i->Translation.x >= PLAYER_MAX_MOVEMENT)
+            {
+                i->Translation.x = PLAYER_MAX_MOVEMENT;
+            }
+        }
+        else if (i->metaPosition == 1)
+        {
+            if (i->Translation.x <= -PLAYER_MAX_MOVEMENT)
+            {
+                i->Translation.x = -PLAYER_MAX_MOVEMENT;
+            }
+            else if (i->Translation.x >= PLAYER_MAX_MOVEMENT)
+            {
+                i->Translation.x = PLAYER_MAX_MOVEMENT;
+            }
+        }
+        else if (i->metaPosition == 2)
+        {
+            if (i->Translation.z <= -PLAYER_MAX_MOVEMENT)
+            {
+                i->Translation.z = -PLAYER_MAX_MOVEMENT;
+            }
+            else if (i->Translation.z >= PLAYER_MAX_MOVEMENT)
+            {
+                i->Translation.z = PLAYER_MAX_MOVEMENT;
+            }
+        }
+        else
+        {
+            if (i->Translation.z <= -PLAYER_MAX_MOVEMENT)
+            {
+                i->Translation.z = -PLAYER_MAX_MOVEMENT;
+            }
+            else if (i->Translation.z >= PLAYER_MAX_MOVEMENT)
+            {
+                i->Translation.z = PLAYER_MAX_MOVEMENT;
+            }
+        }
+
+        i->Update(deltaTime);
+    }
+
+
+    /*ball*/
+    playball->Update(deltaTime);
+
+    /*check if player dead*/
+    allDead = true;
+    int pAlive = 0;
+    for (auto& i : playCharacters)
+    {
+        if (i->controllingPlayer == nullptr)
+        {
+            continue;
+        }
+
+        if (i->controllingPlayer->hp <= 0)
+        {
+            DBOUT("Player " << i->controllingPlayer->pID << " has died!\n");
+            i->npc = true;
+            winOrder.push_back(i->controllingPlayer);
+            DBOUT("Player " << i->controllingPlayer->pID << " added to win order\n");
+            i->controllingPlayer = nullptr;
+        }
+        else
+        {
+            pAlive++;
+            allDead = false;
+        }
+
+
+    }
+}
+
+NetInput DXTest::readInput(int inputID)
+{
+    NetInput n;
+    InputData* in = input->getInput(inputID);
+
+    /*quantized so a step gives the same result on every peer*/
+    float moveX = (std::max)(-1.f, (std::min)(1.f, in->trigger[THUMB_LX]));
+    n.moveX = (int8_t)lroundf(moveX * 127.f);
+
+    if (input->ButtonPressed(inputID, LEFT_SHOULDER))
+    {
+        n.buttons |= NET_BUTTON_DASH_LEFT;
+    }
+    else if (input->ButtonPressed(inputID, RIGHT_SHOULDER))
+    {
+        n.buttons |= NET_BUTTON_DASH_RIGHT;
+    }
+
+    return n;
+}
+
+void DXTest::SaveState(void* state)
+{
+    MatchSnapshot* m = static_cast<MatchSnapshot*>(state);
+
+    /*players are stored by their index*/
+    auto index = [this](Player* p)
+    {
+        for (size_t i = 0; i < players.size(); i++)
+        {
+            if (players[i] == p)
+                return (int)i;
+        }
+
+        return -1;
+    };
+
+    playball->Save(m->ball);
+
+    for (int i = 0; i < 4; i++)
+    {
+        playCharacters[i]->Save(m->chars[i]);
+        m->controlled[i] = index(playCharacters[i]->controllingPlayer);
+    }
+
+    for (size_t i = 0; i < players.size(); i++)
+    {
+        m->hp[i] = players[i]->hp;
+    }
+
+    m->winCount = 0;
+
+    for (auto& w : winOrder)
+    {
+        m->winOrder[m->winCount++] = index(w);
+    }
+
+    m->allDead = allDead;
+}
+
+void DXTest::LoadState(const void* state)
+{
+    const MatchSnapshot* m = static_cast<const MatchSnapshot*>(state);
+
+    playball->Load(m->ball);
+
+    for (int i = 0; i < 4; i++)
+    {
+        playCharacters[i]->Load(m->chars[i]);
+        playCharacters[i]->controllingPlayer = m->controlled[i] < 0 ? nullptr : players[m->controlled[i]];
+    }
+
+    for (size_t i = 0; i < players.size(); i++)
+    {
+        players[i]->hp = m->hp[i];
+    }
+
+    winOrder.clear();
+
+    for (int i = 0; i < m->winCount; i++)
+    {
+        winOrder.push_back(players[m->winOrder[i]]);
+    }
+
+    allDead = m->allDead;
+}
+
+void DXTest::Step(const NetInput* inputs, int count, bool replay)
+{
+    ASSERT(count == (int)players.size());
+
+    /*a replayed step has already been heard*/
+    res->getSound()->setMuted(replay);
+    simulateMatch(inputs, ROLLBACK_STEP);
+}
+
+void DXTest::updateViewScales(float deltaTime)
+{
+    frameTiming.cpuMs = deltaTime * 1000.f;
+
+    /*gpu timings arrive a few frames late, a frame without one keeps the scales*/
+    if (gpuTiming && !gpuTimer.Read(deviceContext, frameTiming))
+        return;
+
+    std::vector<float> scales;
+
+    for (int k = 0; k < viewLayout.Views(); k++)
+    {
+        scales.push_back(viewLayout.Scale(k));
+    }
+
+    if (!frameTraceFile.empty())
+    {
+        frameTrace.push_back(FrameTimeGovernor::Normalize(frameTiming, scales));
+    }
+
+    governor.Update(frameTiming);
+
+    for (int k = 0; k < (std::min)(viewLayout.Views(), governor.Views()); k++)
+    {
+        viewLayout.SetScale(k, governor.Scale(k));
+    }
+}
+
+bool DXTest::parseOnline()
+{
+    std::vector<std::string> args;
+    std::istringstream in(commandLine);
+
+    for (std::string arg; in >> arg;)
+    {
+        args.push_back(arg);
+    }
+
+    try
+    {
+        parseArguments(args);
+    }
+    catch (const std::exception& e)
+    {
+        std::string what = e.what();
+        MessageBox(wndHandle, std::wstring(what.begin(), what.end()).c_str(), L"Error", MB_OK);
+        return false;
+    }
+
+    return true;
+}
+
+void DXTest::parseArguments(const std::vector<std::string>& args)
+{
+    for (size_t i = 0; i < args.size(); i++)
+    {
+        if (args[i] == "-online" && i + 2 < args.size())
+        {
+            onlinePlayer = std::stoi(args[i + 1]);
+            onlinePort = (unsigned short)std::stoul(args[i + 2]);
+
+            /*one address:port per remote player, in player order*/
+            for (i += 3; i < args.size() && args[i][0] != '-'; i++)
+            {
+                onlinePeers.push_back(args[i]);
+            }
+
+            i--;
+        }
+        else if (args[i] == "-delay" && i + 1 < args.size())
+        {
+            onlineDelay = std::stoi(args[++i]);
+            onlineAdaptiveDelay = false;
+        }
+        else if (args[i] == "-frametrace" && i + 1 < args.size())
+        {
+            frameTraceFile = args[++i];
+        }
+        else if (args[i] == "-cpuparticles")
+        {
+            cpuParticles = true;
+        }
+        else if (args[i] == "-seed" && i + 1 < args.size())
+        {
+            matchSeed = std::stoull(args[++i]);
+        }
+        else if (args[i] == "-texturebudget" && i + 1 < args.size())
+        {
+            textureBudget = std::stoull(args[++i]) * 1024 * 1024;
+        }
+        else if (args[i] == "-texturetelemetry" && i + 1 < args.size())
+        {
+            textureTelemetryFile = args[++i];
+        }
+    }
+
+    if (onlinePlayer >= 0 && (onlinePeers.empty() || onlinePeers.size() >= ROLLBACK_MAX_PLAYERS || onlinePlayer > (int)onlinePeers.size()))
+    {
+        throw std::exception("Invalid online arguments");
+    }
+
+    /*a port in use or a peer that does not resolve fails here and not in the middle of the game*/
+    if (onlinePlayer >= 0)
+    {
+        transport = new UdpTransport(onlinePort);
+
+        for (int k = 0, peer = 0; k <= (int)onlinePeers.size(); k++)
+        {
+            peerIDs.push_back(k == onlinePlayer ? -1 : transport->AddPeer(onlinePeers[peer++]));
+        }
+    }
+}
+
+void DXTest::registerOnlinePlayers()
+{
+    int count = (int)onlinePeers.size() + 1;
+
+    /*player k plays character k, only the local player reads an input*/
+    for (int k = 0; k < count; k++)
+    {
+        Player* p = new Player();
+        p->AssignCharacter(k);
+        p->AssignInput(k == onlinePlayer ? 0 : -1);
+        p->AssignColor(playerColors[k]);
+        p->pID = k + 1;
+
+        playCharacters[k]->Color = p->getColor();
+        playCharacters[k]->npc = false;
+        playCharacters[k]->controllingPlayer = p;
+        players.push_back(p);
+    }
+
+    playerCount = count;
+    input->addUsedInput(0);
+    regState = count > 3 ? RegistrationState::FULL : RegistrationState::JOINED;
+
+    DBOUT("Online as player " << onlinePlayer + 1 << " of " << count << std::endl);
+}
+
+void DXTest::startOnlineMatch()
+{
+    /*every peer starts from the same state*/
+    Random::Seed((onlineMatch + 1) * 2654435761u);
+    playball->Seed(Random::Stream(RandomStream::Ball));
+    playball->resetBallFull();
+
+    for (auto& c : playCharacters)
+    {
+        PlayableCharSnapshot s;
+        c->Save(s);
+
+        s.Translation.y = PLAYER_HEIGHT;
+        s.Velocity = XMFLOAT3(0.f, 0.f, 0.f);
+        s.Speed = PLAYER_SPEED;
+        s.currState = PCState::REST;
+        s.prevState = PCState::REST;
+        s.dashTimer = 0.f;
+        s.jumpTime = 0.f;
+        s.dashCooldown = 0.f;
+        s.dashDirection = 1;
+
+        c->Load(s);
+    }
+
+    delete session;
+    session = new RollbackSession(this, sizeof(MatchSnapshot), transport, (int)players.size(), onlinePlayer, peerIDs,
+                                  onlineDelay, onlineMatch++);
+    session->SetAdaptiveDelay(onlineAdaptiveDelay);
+
+    netTime = 0.f;
+    pendingButtons = 0;
+}
@@ -22,6 +22,9 @@
 #include "PlayableChar.h"
 #include "Player.h"
 #include "ParticleSystem.h"
+#include "RollbackSession.h"
+#include "ViewportLayout.h"
+#include "GpuTimer.h"
 #include <filesystem>
 
 enum class MainGameState
@@ -39,10 +42,24 @@ enum class RegistrationState
     BLANK, JOINED, FULL
 };
 
-class DXTest : public DirectXBase
+/*everything a match step changes, saved and restored by the rollback session*/
+struct MatchSnapshot
+{
+    BallSnapshot ball;
+    PlayableCharSnapshot chars[4];
+    int hp[ROLLBACK_MAX_PLAYERS];
+
+    /*player index controlling each character, -1 for none*/
+    int controlled[4];
+    int winOrder[ROLLBACK_MAX_PLAYERS];
+    int winCount;
+    bool allDead;
+};
+
+class DXTest : public DirectXBase, public RollbackGame
 {
 public:
-    DXTest(HINSTANCE hProgramID);
+    DXTest(HINSTANCE hProgramID, const std::string& commandLine = "");
     ~DXTest();
 
     bool Initialisation();
@@ -51,9 +68,15 @@ public:
     void Draw();
     bool goFullscreen(bool s);
 
+    /*rollback game*/
+    void SaveState(void* state);
+    void LoadState(const void* state);
+    void Step(const NetInput* inputs, int count, bool replay);
+
 private:
 
     /*+++*/
+    std::string commandLine;
     InputManager* input;
     ResourceManager* res;
     Level* activeLevel, *gameLevel, *endLevel;
@@ -91,6 +114,36 @@ private:
     void clearData();
     void setupEndScreen();
 
+    /*one match step, inputs are in the order of players*/
+    void simulateMatch(const NetInput* inputs, float deltaTime);
+    NetInput readInput(int inputID);
+
+    /*online match, -online <player> <port> <peer address:port>... [-delay frames],
+      without -delay the delay follows the round trip*/
+    int onlinePlayer = -1;
+    unsigned short onlinePort = 0;
+    std::vector<std::string> onlinePeers;
+    std::vector<int> peerIDs;
+    int onlineDelay = ROLLBACK_INPUT_DELAY;
+    bool onlineAdaptiveDelay = true;
+    unsigned char onlineMatch = 0;
+    UdpTransport* transport = nullptr;
+    RollbackSession* session = nullptr;
+    float netTime = 0.f;
+
+    /*-seed <n>, local matches of a run repeat from it, otherwise the start time*/
+    uint64_t matchSeed = 0;
+    unsigned int localMatch = 0;
+
+    /*dash presses wait here for the next fixed step*/
+    unsigned char pendingButtons = 0;
+
+    /*false after telling the user about invalid arguments or a socket that could not be opened*/
+    bool parseOnline();
+    void parseArguments(const std::vector<std::string>& args);
+    void registerOnlinePlayers();
+    void startOnlineMatch();
+
     /*lighting*/
     DirectionalLight gDirLights;
     float lightRotationAngle = 0.f;
@@ -108,14 +161,16 @@ private:
 
     /*render related*/
 
-    /*particle system*/
+    /*particle system, -cpuparticles simulates all of them on the cpu*/
     ParticleSystem mRain;
+    bool cpuParticles = false;
+    ParticleUpdater* particleUpdater = nullptr;
     float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
 
     void switchLevel(Level& lvl);
 
     Blur blurEffect;
-    int blurStrength = 0;
+    float blurSigma = 0.f;
 
     int transitionInProgress = 0;
     bool UpdateTransition(float deltaTime);
@@ -134,6 +189,29 @@ private:
     ID3D11UnorderedAccessView* mOffscreenUAV;
     ID3D11RenderTargetView* mOffscreenRTV;
 
+    /*split screen views share one atlas, see ViewportLayout.h*/
+    ViewportLayout viewLayout;
+    ID3D11ShaderResourceView* mAtlasSRV = 0;
+    ID3D11UnorderedAccessView* mAtlasUAV = 0;
+    ID3D11RenderTargetView* mAtlasRTV = 0;
+    ID3D11DepthStencilView* mAtlasDSV = 0;
+    ID3D11Buffer* mSplitQuadVB = 0;
+
+    /*dynamic resolution, -frametrace <file> saves the timings of matches for FrameTimeGovernor::Replay*/
+    GpuTimer gpuTimer;
+    FrameTimeGovernor governor;
+    FrameTiming frameTiming;
+    bool gpuTiming = false;
+    std::string frameTraceFile;
+    std::vector<FrameTiming> frameTrace;
+
+    void updateViewScales(float deltaTime);
+
+    /*-texturebudget <MB> limits the resident textures, -texturetelemetry <file> reports them every second*/
+    uint64_t textureBudget = TEXTURE_BUDGET_DEFAULT;
+    std::string textureTelemetryFile;
+    float textureTelemetryTime = 0.f;
+
     bool renderWireFrame = false;
 
     /*D2D / UI*/
@@ -0,0 +1,242 @@
+#include "FrameTimeGovernor.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+FrameTimeGovernor::FrameTimeGovernor(const GovernorConfig& config) : config(config)
+{
+}
+
+void FrameTimeGovernor::Reset(int views)
+{
+    controllers.assign(std::clamp(views, 0, GOVERNOR_MAX_VIEWS), Controller());
+
+    for (auto& c : controllers)
+    {
+        c.scale = config.maxScale;
+    }
+}
+
+void FrameTimeGovernor::Update(const FrameTiming& timing)
+{
+    int views = Views();
+
+    if (views == 0)
+        return;
+
+    if (timing.gpuMs >= 0.f && timing.views >= views)
+    {
+        /*the work all views share is taken off the budget first*/
+        float shared = timing.gpuMs;
+
+        for (int i = 0; i < views; i++)
+        {
+            shared -= timing.viewMs[i];
+        }
+
+        float budget = (config.targetMs - std::max(shared, 0.f)) / views;
+
+        for (int i = 0; i < views; i++)
+        {
+            step(controllers[i], timing.viewMs[i], budget);
+        }
+    }
+    else
+    {
+        float frameMs = timing.gpuMs >= 0.f ? timing.gpuMs : timing.cpuMs;
+
+        for (auto& c : controllers)
+        {
+            step(c, frameMs, config.targetMs);
+        }
+    }
+}
+
+std::vector<float> FrameTimeGovernor::Scales() const
+{
+    std::vector<float> s;
+
+    for (const auto& c : controllers)
+    {
+        s.push_back(c.scale);
+    }
+
+    return s;
+}
+
+void FrameTimeGovernor::step(Controller& c, float measuredMs, float budgetMs)
+{
+    c.smoothedMs = c.smoothedMs < 0.f ? measuredMs : c.smoothedMs + (measuredMs - c.smoothedMs) * config.smoothing;
+
+    /*positive with headroom, a view over a budget of nothing is far too slow*/
+    float error = budgetMs > 0.f ? (budgetMs - c.smoothedMs) / budgetMs : -1.f;
+    error = std::clamp(error, -1.f, 1.f);
+
+    if (std::fabs(error) < config.deadband)
+    {
+        error = 0.f;
+    }
+
+    float derivative = error - c.prevError;
+    c.prevError = error;
+
+    float pd = config.kp * error + config.kd * derivative;
+    float integral = c.integral + error;
+
+    /*no windup while the scale is held at a bound: the integral only moves until the scale
+      reaches it, so it does not keep the scale off the bound after the load changed*/
+    if (config.ki > 0.f)
+    {
+        float high = (config.maxScale - config.maxScale - pd) / config.ki;
+        float low = (config.minScale - config.maxScale - pd) / config.ki;
+
+        if (error > 0.f && integral > high)
+        {
+            integral = std::max(c.integral, high);
+        }
+        else if (error < 0.f && integral < low)
+        {
+            integral = std::min(c.integral, low);
+        }
+    }
+
+    c.integral = integral;
+
+    float scale = config.maxScale + pd + config.ki * c.integral;
+    c.scale = std::clamp(scale, config.minScale, config.maxScale);
+}
+
+FrameTiming FrameTimeGovernor::Simulate(const FrameTiming& cost, const std::vector<float>& scales)
+{
+    FrameTiming t = cost;
+
+    if (scales.empty())
+        return t;
+
+    /*without times of the views the whole frame is assumed to follow the pixel count*/
+    float area = 0.f;
+
+    for (float s : scales)
+    {
+        area += s * s;
+    }
+
+    area /= scales.size();
+
+    if (cost.views > 0)
+    {
+        int views = std::min(cost.views, static_cast<int>(scales.size()));
+
+        for (int i = 0; i < views; i++)
+        {
+            t.viewMs[i] = cost.viewMs[i] * scales[i] * scales[i];
+
+            if (t.gpuMs >= 0.f)
+            {
+                t.gpuMs += t.viewMs[i] - cost.viewMs[i];
+            }
+        }
+    }
+    else if (t.gpuMs >= 0.f)
+    {
+        t.gpuMs *= area;
+    }
+
+    if (t.gpuMs < 0.f)
+    {
+        t.cpuMs *= area;
+    }
+
+    return t;
+}
+
+FrameTiming FrameTimeGovernor::Normalize(const FrameTiming& measured, const std::vector<float>& scales)
+{
+    std::vector<float> inverse;
+
+    for (float s : scales)
+    {
+        inverse.push_back(s > 0.f ? 1.f / s : 1.f);
+    }
+
+    return Simulate(measured, inverse);
+}
+
+std::vector<float> FrameTimeGovernor::Replay(const std::vector<FrameTiming>& trace, int views, const GovernorConfig& config)
+{
+    FrameTimeGovernor governor(config);
+    governor.Reset(views);
+
+    std::vector<float> result;
+
+    for (const auto& cost : trace)
+    {
+        governor.Update(Simulate(cost, governor.Scales()));
+
+        for (int i = 0; i < governor.Views(); i++)
+        {
+            result.push_back(governor.Scale(i));
+        }
+    }
+
+    return result;
+}
+
+bool FrameTimeGovernor::LoadTrace(const std::string& file, std::vector<FrameTiming>& trace)
+{
+    std::ifstream in(file);
+
+    if (!in)
+        return false;
+
+    std::string line;
+
+    while (std::getline(in, line))
+    {
+        line = line.substr(0, line.find('#'));
+
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        std::istringstream ls(line);
+        FrameTiming t;
+
+        if (!(ls >> t.cpuMs >> t.gpuMs >> t.views) || t.views < 0 || t.views > GOVERNOR_MAX_VIEWS)
+            return false;
+
+        for (int i = 0; i < t.views; i++)
+        {
+            if (!(ls >> t.viewMs[i]))
+                return false;
+        }
+
+        trace.push_back(t);
+    }
+
+    return true;
+}
+
+bool FrameTimeGovernor::SaveTrace(const std::string& file, const std::vector<FrameTiming>& trace)
+{
+    std::ofstream f(file);
+
+    if (!f.is_open())
+        return false;
+
+    f << "# cpuMs gpuMs views viewMs..., at full resolution\n";
+
+    for (const auto& t : trace)
+    {
+        f << t.cpuMs << " " << t.gpuMs << " " << t.views;
+
+        for (int i = 0; i < t.views; i++)
+        {
+            f << " " << t.viewMs[i];
+        }
+
+        f << "\n";
+    }
+
+    return f.good();
+}
@@ -0,0 +1,132 @@
+/* FrameTimeGovernor.h
+
+picks the render scale of every split screen view from the frame timings.
+every view has its own pid controller. with gpu timings of the single
+views, a view gets an equal share of the frame budget that is left after
+the work all views share (shadow map, composite, ui) and is scaled by its
+own time. with only the gpu frame time or only the cpu frame time, all
+views follow the frame time.
+
+the error is relative to the budget and the controller runs once per
+frame, independent of the frame time, so the same timings always give the
+same scales. scales stay within the configured bounds, the integral only
+moves until a scale reaches a bound, so a view is back at full resolution
+as soon as it has headroom again.
+
+a trace stores the cost of every frame at full resolution. Simulate
+stands in for the gpu, the time of a view grows with its pixel count, so
+Replay runs the controller in a closed loop over a recorded trace without
+a device.
+
+only depends on the standard library.
+
+    Usage:
+    FrameTimeGovernor governor;
+    governor.Reset(4);
+
+    FrameTiming t;
+    t.cpuMs = deltaTime * 1000.f;
+    gpuTimer.Read(context, t);
+    governor.Update(t);
+
+    layout.SetScale(view, governor.Scale(view));
+
+    trace.push_back(FrameTimeGovernor::Normalize(t, scales));
+    FrameTimeGovernor::SaveTrace("frames.txt", trace);
+
+    trace file lines are "cpuMs gpuMs views viewMs...", a negative time is
+    unknown, # starts a comment:
+    16.6 12.1 4 2.5 2.4 2.6 2.5
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#define GOVERNOR_MAX_VIEWS 4
+
+#define GOVERNOR_TARGET_MS (1000.f / 60.f)
+#define GOVERNOR_MIN_SCALE 0.5f
+#define GOVERNOR_MAX_SCALE 1.f
+
+/*gains on the relative error*/
+#define GOVERNOR_KP 0.15f
+#define GOVERNOR_KI 0.04f
+#define GOVERNOR_KD 0.05f
+
+/*weight of a new timing in the smoothed time*/
+#define GOVERNOR_SMOOTHING 0.2f
+
+/*relative errors below this are ignored*/
+#define GOVERNOR_DEADBAND 0.03f
+
+struct FrameTiming
+{
+    float cpuMs = 0.f;
+
+    /*negative if the gpu time is unknown*/
+    float gpuMs = -1.f;
+
+    /*0 if the gpu times of the views are unknown*/
+    int views = 0;
+    float viewMs[GOVERNOR_MAX_VIEWS] = {};
+};
+
+struct GovernorConfig
+{
+    float targetMs = GOVERNOR_TARGET_MS;
+    float minScale = GOVERNOR_MIN_SCALE;
+    float maxScale = GOVERNOR_MAX_SCALE;
+
+    float kp = GOVERNOR_KP;
+    float ki = GOVERNOR_KI;
+    float kd = GOVERNOR_KD;
+
+    float smoothing = GOVERNOR_SMOOTHING;
+    float deadband = GOVERNOR_DEADBAND;
+};
+
+class FrameTimeGovernor
+{
+public:
+    FrameTimeGovernor(const GovernorConfig& config = GovernorConfig());
+
+    /*all views back to the maximum scale*/
+    void Reset(int views);
+
+    void Update(const FrameTiming& timing);
+
+    int Views() const { return static_cast<int>(controllers.size()); }
+    float Scale(int view) const { return controllers[view].scale; }
+    std::vector<float> Scales() const;
+
+    const GovernorConfig& Config() const { return config; }
+
+    /*timing of a frame with the given scales from its cost at full resolution*/
+    static FrameTiming Simulate(const FrameTiming& cost, const std::vector<float>& scales);
+
+    /*cost at full resolution of a frame measured with the given scales*/
+    static FrameTiming Normalize(const FrameTiming& measured, const std::vector<float>& scales);
+
+    /*scales after every frame of the trace, frame by frame*/
+    static std::vector<float> Replay(const std::vector<FrameTiming>& trace, int views, const GovernorConfig& config = GovernorConfig());
+
+    static bool LoadTrace(const std::string& file, std::vector<FrameTiming>& trace);
+    static bool SaveTrace(const std::string& file, const std::vector<FrameTiming>& trace);
+
+private:
+    struct Controller
+    {
+        float scale = 1.f;
+        float smoothedMs = -1.f;
+        float integral = 0.f;
+        float prevError = 0.f;
+    };
+
+    void step(Controller& c, float measuredMs, float budgetMs);
+
+    GovernorConfig config;
+    std::vector<Controller> controllers;
+};
@@ -0,0 +1,503 @@
+#include "GoldenScene.h"
+#include "TangentSpace.h"
+#include "json.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#define GOLDEN_PI 3.14159265f
+
+/*same as DXTest::Initialisation*/
+static const SoftFloat4 playerColors[4] =
+{
+    { 0.3f, 0.55f, 1.f, 1.f }, { 1.f, 0.2f, 0.25f, 1.f }, { 1.f, 0.8f, 0.22f, 1.f }, { 0.f, 0.5f, 0.2f, 1.f }
+};
+
+static float radians(float degrees)
+{
+    return degrees * GOLDEN_PI / 180.f;
+}
+
+/*same steps as ModelCollection::quantizeTiling*/
+static float quantizeTiling(float tiling)
+{
+    float steps = std::round(tiling / PRIMITIVE_TILING_STEP);
+
+    return (std::max)(steps, 1.f) * PRIMITIVE_TILING_STEP;
+}
+
+/*start position of a character like DXTest::clearData*/
+static SoftFloat3 playerPosition(int player)
+{
+    SoftFloat3 p = { 0.f, PLAYER_HEIGHT, 0.f };
+
+    switch (player)
+    {
+        case 0: p.z = -PLAYER_DISTANCE; break;
+        case 1: p.z = PLAYER_DISTANCE; break;
+        case 2: p.x = -PLAYER_DISTANCE; break;
+        case 3: p.x = PLAYER_DISTANCE; break;
+    }
+
+    return p;
+}
+
+GoldenScene::GoldenScene()
+{
+    /*the light of DXTest at the start of a match*/
+    SetLight(SoftLight(), { 0.f, 0.f, 0.f }, std::sqrt(16000.f));
+}
+
+bool GoldenScene::LoadLevel(const std::string& fileName)
+{
+    scene.instances.clear();
+
+    std::ifstream in(std::string(LEVEL_PATH) + fileName);
+
+    if (!in.is_open())
+        return false;
+
+    nlohmann::json lvl = nlohmann::json::parse(in, nullptr, false);
+
+    if (lvl.is_discarded() || !lvl.contains("static"))
+        return false;
+
+    for (auto& i : lvl["static"])
+    {
+        if (i.value("isInvisible", false))
+            continue;
+
+        std::string id = i.value("model", "");
+        std::string shader = i.value("shader", "");
+
+        SoftShading shading;
+
+        /*same techniques as Level::ReadStaticModels*/
+        if (shader == "basictexture")
+            shading = SoftShading::Texture;
+        else if (shader == "basicnotexture")
+            shading = SoftShading::NoTexture;
+        else if (shader == "basicnolighting")
+            shading = SoftShading::NoLighting;
+        else if (shader == "normalmap")
+            shading = SoftShading::NormalMap;
+        else if (shader == "onlyshadow")
+            shading = SoftShading::OnlyShadow;
+        else
+            return false;
+
+        auto& position = i["position"];
+        auto& scale = i["scale"];
+        auto& rotation = i["rotation"];
+
+        SoftFloat3 s = { scale[0].get<float>(), scale[1].get<float>(), scale[2].get<float>() };
+
+        const SoftModel* model;
+
+        /*scaled default planes and cubes get their own primitive with tiled uvs*/
+        if (id == DEFAULT_PLANE || id == DEFAULT_CUBE)
+        {
+            model = getPrimitive(id == DEFAULT_PLANE, quantizeTiling(s.x / TEXTURE_TILE_SIZE), quantizeTiling(s.y / TEXTURE_TILE_SIZE),
+                                 quantizeTiling(s.z / TEXTURE_TILE_SIZE));
+        }
+        else
+        {
+            model = getModel(id);
+        }
+
+        if (!model)
+            return false;
+
+        SoftMatrix world = SoftMatrix::Scaling(s.x, s.y, s.z) * model->axisRot *
+                           SoftMatrix::RotationRollPitchYaw(radians(rotation[0].get<float>()), radians(rotation[1].get<float>()),
+                                                            radians(rotation[2].get<float>())) *
+                           SoftMatrix::Translation(position[0].get<float>(), position[1].get<float>(), position[2].get<float>());
+
+        for (size_t m = 0; m < model->meshes.size(); m++)
+        {
+            SoftInstance instance;
+            instance.mesh = &model->meshes[m];
+            instance.world = world;
+            instance.shading = shading;
+            instance.castsShadow = i.value("castsShadow", true);
+            instance.diffuse = getTexture(i.value("overwriteTexture", model->diffuse[m]));
+
+            if (shading == SoftShading::NormalMap)
+            {
+                instance.normalMap = getTexture(i.value("overwriteNormal", model->normal[m]));
+            }
+
+            scene.instances.push_back(instance);
+        }
+    }
+
+    return true;
+}
+
+bool GoldenScene::AddModel(const std::string& id, const SoftMatrix& world, const SoftFloat4& color, bool castsShadow)
+{
+    const SoftModel* model = getModel(id);
+
+    if (!model)
+        return false;
+
+    for (size_t m = 0; m < model->meshes.size(); m++)
+    {
+        SoftInstance instance;
+        instance.mesh = &model->meshes[m];
+        instance.world = world;
+        instance.diffuse = getTexture(model->diffuse[m]);
+        instance.shading = SoftShading::StaticColor;
+        instance.color = color;
+        instance.castsShadow = castsShadow;
+
+        scene.instances.push_back(instance);
+    }
+
+    return true;
+}
+
+bool GoldenScene::AddCharacters()
+{
+    const SoftModel* bar = getModel("bar");
+
+    if (!bar)
+        return false;
+
+    for (int k = 0; k < SPLITSCREEN_VIEWS; k++)
+    {
+        SoftFloat3 p = playerPosition(k);
+
+        /*the side players are turned like in DXTest::clearData, the rotation comes before axisRot like PlayableChar*/
+        float roll = k == 2 ? GOLDEN_PI / 2.f : (k == 3 ? -GOLDEN_PI / 2.f : 0.f);
+        SoftMatrix world = SoftMatrix::RotationRollPitchYaw(0.f, 0.f, roll) * bar->axisRot * SoftMatrix::Translation(p.x, p.y, p.z);
+
+        AddModel("bar", world, playerColors[k]);
+    }
+
+    return true;
+}
+
+void GoldenScene::SetCamera(const SoftFloat3& eye, const SoftFloat3& target, float aspect, const SoftViewport& viewport)
+{
+    scene.view = SoftMatrix::LookAtLH(eye, target, { 0.f, 1.f, 0.f });
+    scene.proj = SoftMatrix::PerspectiveFovLH(0.2f * GOLDEN_PI, aspect, .01f, 1000.f);
+    scene.eye = eye;
+    scene.viewport = viewport;
+}
+
+void GoldenScene::SetPlayerCamera(int player, float aspect, const SoftViewport& viewport)
+{
+    SoftFloat3 p = playerPosition(player);
+    SoftFloat3 eye = { p.x, p.y + CAMERA_DIST_UP, p.z };
+    SoftFloat3 target = { 0.f, 0.f, 0.f };
+
+    /*same placement as PlayableChar::Update*/
+    switch (player)
+    {
+        case 0: eye.z -= CAMERA_DIST_BACK; target.x = p.x; break;
+        case 1: eye.z += CAMERA_DIST_BACK; target.x = p.x; break;
+        case 2: eye.x -= CAMERA_DIST_BACK; target.z = p.z; break;
+        case 3: eye.x += CAMERA_DIST_BACK; target.z = p.z; break;
+    }
+
+    SetCamera(eye, target, aspect, viewport);
+}
+
+void GoldenScene::SetLight(const SoftLight& light, const SoftFloat3& center, float radius)
+{
+    scene.light = light;
+
+    const SoftFloat3& d = light.direction;
+    SoftFloat3 eye = { center.x - 2.f * radius * d.x, center.y - 2.f * radius * d.y, center.z - 2.f * radius * d.z };
+
+    SoftMatrix view = SoftMatrix::LookAtLH(eye, center, { 0.f, 1.f, 0.f });
+
+    /*the bounding sphere in light space*/
+    float c[3];
+
+    for (int k = 0; k < 3; k++)
+    {
+        c[k] = center.x * view.m[0][k] + center.y * view.m[1][k] + center.z * view.m[2][k] + view.m[3][k];
+    }
+
+    SoftMatrix proj = SoftMatrix::OrthographicOffCenterLH(c[0] - radius, c[0] + radius, c[1] - radius, c[1] + radius,
+                                                          c[2] - radius, c[2] + radius);
+
+    /*ndc to texture space*/
+    SoftMatrix t = SoftMatrix::Identity();
+    t.m[0][0] = 0.5f; t.m[1][1] = -0.5f;
+    t.m[3][0] = 0.5f; t.m[3][1] = 0.5f;
+
+    scene.shadows = true;
+    scene.lightViewProj = view * proj;
+    scene.shadowTransform = view * proj * t;
+}
+
+bool GoldenScene::RenderMatchStart(SoftwareRasterizer& raster, const std::string& levelFile)
+{
+    GoldenScene scene;
+
+    if (!scene.LoadLevel(levelFile) || !scene.AddCharacters())
+        return false;
+
+    /*the silver clear color of DXTest*/
+    raster.Clear({ 0.75f, 0.75f, 0.75f, 1.f });
+
+    float aspect = static_cast<float>(raster.Width()) / raster.Height();
+
+    /*split screen like the composition in DXTest::Draw*/
+    for (int k = 0; k < SPLITSCREEN_VIEWS; k++)
+    {
+        SoftViewport viewport;
+        viewport.width = raster.Width() / 2;
+        viewport.height = raster.Height() / 2;
+        viewport.x = (k % 2) * viewport.width;
+        viewport.y = (k / 2) * viewport.height;
+
+        scene.SetPlayerCamera(k, aspect, viewport);
+        raster.Render(scene.Get());
+    }
+
+    return true;
+}
+
+const GoldenScene::SoftModel* GoldenScene::getModel(const std::string& id)
+{
+    auto it = models.find(id);
+
+    if (it == models.end())
+    {
+        std::unique_ptr<SoftModel> model = std::make_unique<SoftModel>();
+
+        if (!readB3D(std::string(MODEL_PATH) + "/" + id + ".b3d", *model))
+        {
+            model = nullptr;
+        }
+
+        it = models.emplace(id, std::move(model)).first;
+    }
+
+    /*unknown models are drawn as the default cube like ModelCollection::Get*/
+    if (!it->second)
+    {
+        return getPrimitive(false, 1.f, 1.f, 1.f);
+    }
+
+    return it->second.get();
+}
+
+const GoldenScene::SoftModel* GoldenScene::getPrimitive(bool plane, float tileX, float tileY, float tileZ)
+{
+    std::string key = std::string(plane ? "plane:" : "box:") + std::to_string(tileX) + "," + std::to_string(tileY) + "," +
+                      std::to_string(tileZ);
+
+    std::unique_ptr<SoftModel>& model = models[key];
+
+    if (!model)
+    {
+        model = std::make_unique<SoftModel>();
+        model->meshes.resize(1);
+        model->diffuse.push_back("default");
+        model->normal.push_back("");
+
+        if (plane)
+            GoldenScene::plane(model->meshes[0], tileX, tileZ);
+        else
+            box(model->meshes[0], tileX, tileY, tileZ);
+
+        /*same material as ModelCollection::CreatePrimitiveModel*/
+        SoftMaterial& mat = model->meshes[0].material;
+        mat.ambient = { 0.5f, 0.5f, 0.5f, 1.f };
+        mat.diffuse = { 1.f, 1.f, 1.f, 1.f };
+        mat.specular = { 0.6f, 0.6f, 0.6f, 16.f };
+    }
+
+    return model.get();
+}
+
+const SoftTexture* GoldenScene::getTexture(const std::string& id)
+{
+    auto it = textures.find(id);
+
+    if (it == textures.end())
+    {
+        std::unique_ptr<SoftTexture> texture = std::make_unique<SoftTexture>();
+
+        if (!texture->LoadDDS(std::string(TEXTURE_PATH) + "/" + id + ".dds"))
+        {
+            texture = nullptr;
+        }
+
+        it = textures.emplace(id, std::move(texture)).first;
+    }
+
+    /*unknown ids are drawn with the default texture like TextureCollection::Get*/
+    if (!it->second && id != "default")
+    {
+        return getTexture("default");
+    }
+
+    return it->second.get();
+}
+
+/*same format as ModelLoader::LoadB3D*/
+bool GoldenScene::readB3D(const std::string& file, SoftModel& model)
+{
+    std::ifstream in(file, std::ios::binary);
+    char header[4];
+
+    if (!in.read(header, 4) || std::string(header, 4) != "b3df")
+        return false;
+
+    char count = 0;
+    in.read(&count, 1);
+
+    if (count < 0)
+        return false;
+
+    auto floats = [&](float* f, int n)
+    {
+        in.read(reinterpret_cast<char*>(f), n * sizeof(float));
+    };
+
+    model.meshes.resize(count);
+    model.diffuse.resize(count);
+    model.normal.resize(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        SoftMesh& mesh = model.meshes[i];
+
+        floats(&mesh.material.ambient.x, 3);
+        floats(&mesh.material.diffuse.x, 3);
+        floats(&mesh.material.specular.x, 4);
+        mesh.material.ambient.w = 0.f;
+        mesh.material.diffuse.w = 0.f;
+
+        std::string bump;
+        std::string* maps[3] = { &model.diffuse[i], &model.normal[i], &bump };
+
+        for (auto map : maps)
+        {
+            short length = 0;
+            in.read(reinterpret_cast<char*>(&length), sizeof(length));
+
+            if (length < 0)
+                return false;
+
+            map->resize(length);
+            in.read(&(*map)[0], length);
+        }
+
+        int vertexCount = 0;
+        in.read(reinterpret_cast<char*>(&vertexCount), sizeof(vertexCount));
+
+        if (!in || vertexCount < 0)
+            return false;
+
+        /*the handedness is not stored, TangentSpace fills it in*/
+        std::vector<TangentVertex> vertices(vertexCount);
+
+        for (auto& v : vertices)
+        {
+            floats(v.position, 3);
+            floats(v.uv, 2);
+            floats(v.normal, 3);
+            floats(v.tangent, 3);
+            v.tangent[3] = 0.f;
+        }
+
+        int indexCount = 0;
+        in.read(reinterpret_cast<char*>(&indexCount), sizeof(indexCount));
+
+        if (!in || indexCount < 0)
+            return false;
+
+        std::vector<unsigned int> indices(indexCount);
+        in.read(reinterpret_cast<char*>(indices.data()), indexCount * sizeof(unsigned int));
+
+        if (!in)
+            return false;
+
+        for (auto index : indices)
+        {
+            if (index >= vertices.size())
+                return false;
+        }
+
+        TangentSpace::Process(vertices, indices);
+
+        mesh.vertices.resize(vertices.size());
+
+        for (size_t v = 0; v < vertices.size(); v++)
+        {
+            const TangentVertex& t = vertices[v];
+            mesh.vertices[v] = { { t.position[0], t.position[1], t.position[2] }, { t.uv[0], t.uv[1] },
+                                 { t.normal[0], t.normal[1], t.normal[2] }, { t.tangent[0], t.tangent[1], t.tangent[2] } };
+        }
+
+        mesh.indices.assign(indices.begin(), indices.end());
+    }
+
+    /*a quarter turn around x like Model::axisRot*/
+    model.axisRot = SoftMatrix::RotationRollPitchYaw(radians(90.f), 0.f, 0.f);
+
+    return true;
+}
+
+/*same vertices as PrimitiveGenerator::Plane with one cell, visible on both sides*/
+void GoldenScene::plane(SoftMesh& mesh, float tileU, float tileV)
+{
+    for (int z = 0; z <= 1; z++)
+    {
+        for (int x = 0; x <= 1; x++)
+        {
+            mesh.vertices.push_back({ { -0.5f + x, 0.f, -0.5f + z }, { x * tileU, (1.f - z) * tileV }, { 0.f, 1.f, 0.f }, { 1.f, 0.f, 0.f } });
+        }
+    }
+
+    mesh.indices = { 0, 2, 3,  0, 3, 1,  0, 3, 2,  0, 1, 3 };
+}
+
+/*same vertices as PrimitiveGenerator::Box of size 1*/
+void GoldenScene::box(SoftMesh& mesh, float tileX, float tileY, float tileZ)
+{
+    const float h = 0.5f;
+
+    /*position, uv, normal, tangent of the four corners of every face*/
+    const float faces[6][4][11] =
+    {
+        { { -h, -h, -h, 0, 1, 0, 0, -1, 1, 0, 0 }, { -h, +h, -h, 0, 0, 0, 0, -1, 1, 0, 0 },
+          { +h, +h, -h, 1, 0, 0, 0, -1, 1, 0, 0 }, { +h, -h, -h, 1, 1, 0, 0, -1, 1, 0, 0 } },
+        { { -h, -h, +h, 1, 1, 0, 0, 1, -1, 0, 0 }, { +h, -h, +h, 0, 1, 0, 0, 1, -1, 0, 0 },
+          { +h, +h, +h, 0, 0, 0, 0, 1, -1, 0, 0 }, { -h, +h, +h, 1, 0, 0, 0, 1, -1, 0, 0 } },
+        { { -h, +h, -h, 0, 1, 0, 1, 0, 1, 0, 0 }, { -h, +h, +h, 0, 0, 0, 1, 0, 1, 0, 0 },
+          { +h, +h, +h, 1, 0, 0, 1, 0, 1, 0, 0 }, { +h, +h, -h, 1, 1, 0, 1, 0, 1, 0, 0 } },
+        { { -h, -h, -h, 1, 1, 0, -1, 0, -1, 0, 0 }, { +h, -h, -h, 0, 1, 0, -1, 0, -1, 0, 0 },
+          { +h, -h, +h, 0, 0, 0, -1, 0, -1, 0, 0 }, { -h, -h, +h, 1, 0, 0, -1, 0, -1, 0, 0 } },
+        { { -h, -h, +h, 0, 1, -1, 0, 0, 0, 0, -1 }, { -h, +h, +h, 0, 0, -1, 0, 0, 0, 0, -1 },
+          { -h, +h, -h, 1, 0, -1, 0, 0, 0, 0, -1 }, { -h, -h, -h, 1, 1, -1, 0, 0, 0, 0, -1 } },
+        { { +h, -h, -h, 0, 1, 1, 0, 0, 0, 0, 1 }, { +h, +h, -h, 0, 0, 1, 0, 0, 0, 0, 1 },
+          { +h, +h, +h, 1, 0, 1, 0, 0, 0, 0, 1 }, { +h, -h, +h, 1, 1, 1, 0, 0, 0, 0, 1 } }
+    };
+
+    /*front and back span x y, top and bottom x z, left and right z y*/
+    const float tiling[3][2] = { { tileX, tileY }, { tileX, tileZ }, { tileZ, tileY } };
+
+    for (int f = 0; f < 6; f++)
+    {
+        uint32_t base = static_cast<uint32_t>(mesh.vertices.size());
+
+        for (auto& c : faces[f])
+        {
+            mesh.vertices.push_back({ { c[0], c[1], c[2] }, { c[3] * tiling[f / 2][0], c[4] * tiling[f / 2][1] },
+                                      { c[5], c[6], c[7] }, { c[8], c[9], c[10] } });
+        }
+
+        for (uint32_t i : { 0u, 1u, 2u, 0u, 2u, 3u })
+        {
+            mesh.indices.push_back(base + i);
+        }
+    }
+}
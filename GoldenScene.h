@@ -0,0 +1,92 @@
+/* GoldenScene.h
+
+builds the scene of the SoftwareRasterizer straight from the data files,
+without a window or a d3d device, so golden images can be rendered on
+machines without a gpu. the static models of a level are read from its
+json, models from their .b3d files and textures from TEXTURE_PATH.
+
+it mirrors what the game does when it loads: default planes and cubes
+become tiled primitives like ModelCollection::AddPrimitive, .b3d meshes
+run through TangentSpace like ModelLoader, unknown models are drawn as
+the default cube and unknown textures with the default texture. meshes
+are drawn with their full level of detail and the texture atlas is not
+used. particles, the skybox and the ball are not part of the image.
+
+the golden image is the game level at the start of a match: the four
+characters at their spots, seen from the four split screen cameras, lit
+and shadowed like DXTest.
+
+only depends on the standard library.
+
+    Usage:
+    SoftwareRasterizer raster(1920, 1080);
+    GoldenScene::RenderMatchStart(raster, "game.lvl");
+    raster.SaveBMP("golden.bmp");
+
+    GoldenScene scene;
+    scene.LoadLevel("game.lvl");
+    scene.AddModel("bar", world, color);
+    scene.SetCamera(eye, target, aspect, viewport);
+    raster.Render(scene.Get());
+
+*/
+
+#pragma once
+
+#include "constants.h"
+#include "SoftwareRasterizer.h"
+#include <map>
+#include <memory>
+
+class GoldenScene
+{
+public:
+    GoldenScene();
+
+    /*clears the level and loads the static models of LEVEL_PATH/fileName, false if the level can't be read*/
+    bool LoadLevel(const std::string& fileName);
+
+    /*drawn like BasicStaticColor, false if the model can't be read*/
+    bool AddModel(const std::string& id, const SoftMatrix& world, const SoftFloat4& color, bool castsShadow = true);
+
+    /*the characters at their spots at the start of a match*/
+    bool AddCharacters();
+
+    /*lens of the player cameras, aspect of the whole window*/
+    void SetCamera(const SoftFloat3& eye, const SoftFloat3& target, float aspect, const SoftViewport& viewport);
+
+    /*camera of a player at the start of a match*/
+    void SetPlayerCamera(int player, float aspect, const SoftViewport& viewport);
+
+    /*shadow map over the bounding sphere of the scene like DXTest::buildShadowTransform*/
+    void SetLight(const SoftLight& light, const SoftFloat3& center, float radius);
+
+    const SoftScene& Get() const { return scene; }
+
+    /*the level with the characters in four split screen views, false if the data can't be read*/
+    static bool RenderMatchStart(SoftwareRasterizer& raster, const std::string& levelFile);
+
+private:
+    struct SoftModel
+    {
+        std::vector<SoftMesh> meshes;
+        std::vector<std::string> diffuse, normal;
+
+        /*.b3d models lie on their side, see Model::axisRot*/
+        SoftMatrix axisRot = SoftMatrix::Identity();
+    };
+
+    /*nullptr for models that failed to load*/
+    const SoftModel* getModel(const std::string& id);
+    const SoftModel* getPrimitive(bool plane, float tileX, float tileY, float tileZ);
+    const SoftTexture* getTexture(const std::string& id);
+
+    static bool readB3D(const std::string& file, SoftModel& model);
+    static void plane(SoftMesh& mesh, float tileU, float tileV);
+    static void box(SoftMesh& mesh, float tileX, float tileY, float tileZ);
+
+    SoftScene scene;
+
+    std::map<std::string, std::unique_ptr<SoftModel>> models;
+    std::map<std::string, std::unique_ptr<SoftTexture>> textures;
+};
@@ -0,0 +1,165 @@
+#include "GpuTimer.h"
+
+GpuTimer::GpuTimer()
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    release();
+}
+
+bool GpuTimer::Init(ID3D11Device* device)
+{
+    release();
+
+    D3D11_QUERY_DESC disjointDesc = { D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+    D3D11_QUERY_DESC timestampDesc = { D3D11_QUERY_TIMESTAMP, 0 };
+
+    bool ok = true;
+
+    for (auto& f : frames)
+    {
+        ok &= SUCCEEDED(device->CreateQuery(&disjointDesc, &f.disjoint));
+        ok &= SUCCEEDED(device->CreateQuery(&timestampDesc, &f.begin));
+        ok &= SUCCEEDED(device->CreateQuery(&timestampDesc, &f.end));
+
+        for (int i = 0; i < GOVERNOR_MAX_VIEWS; i++)
+        {
+            ok &= SUCCEEDED(device->CreateQuery(&timestampDesc, &f.viewBegin[i]));
+            ok &= SUCCEEDED(device->CreateQuery(&timestampDesc, &f.viewEnd[i]));
+        }
+    }
+
+    if (!ok)
+    {
+        DBOUT("Unable to create gpu timer queries" << endl);
+        release();
+    }
+
+    return ok;
+}
+
+void GpuTimer::BeginFrame(ID3D11DeviceContext* context)
+{
+    Frame& f = frames[current];
+
+    /*all frames are still in flight, this one is not measured*/
+    recording = f.disjoint != 0 && !f.pending;
+
+    if (!recording)
+        return;
+
+    f.views = 0;
+    context->Begin(f.disjoint);
+    context->End(f.begin);
+}
+
+void GpuTimer::BeginView(ID3D11DeviceContext* context, int view)
+{
+    if (!recording || view < 0 || view >= GOVERNOR_MAX_VIEWS)
+        return;
+
+    context->End(frames[current].viewBegin[view]);
+}
+
+void GpuTimer::EndView(ID3D11DeviceContext* context, int view)
+{
+    if (!recording || view < 0 || view >= GOVERNOR_MAX_VIEWS)
+        return;
+
+    Frame& f = frames[current];
+    context->End(f.viewEnd[view]);
+    f.views = (std::max)(f.views, view + 1);
+}
+
+void GpuTimer::EndFrame(ID3D11DeviceContext* context)
+{
+    if (!recording)
+        return;
+
+    Frame& f = frames[current];
+    context->End(f.end);
+    context->End(f.disjoint);
+
+    f.pending = true;
+    current = (current + 1) % GPU_TIMER_FRAMES;
+    recording = false;
+}
+
+bool GpuTimer::Read(ID3D11DeviceContext* context, FrameTiming& timing)
+{
+    /*the oldest frame is the next one to be recorded*/
+    Frame* f = 0;
+
+    for (int i = 0; i < GPU_TIMER_FRAMES && !f; i++)
+    {
+        Frame& c = frames[(current + i) % GPU_TIMER_FRAMES];
+
+        if (c.pending)
+            f = &c;
+    }
+
+    if (!f)
+        return false;
+
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+
+    if (context->GetData(f->disjoint, &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+        return false;
+
+    f->pending = false;
+
+    if (disjoint.Disjoint || disjoint.Frequency == 0)
+        return false;
+
+    auto ms = [&](ID3D11Query* a, ID3D11Query* b, float& out)
+    {
+        UINT64 t0, t1;
+
+        if (context->GetData(a, &t0, sizeof(t0), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            context->GetData(b, &t1, sizeof(t1), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+            return false;
+
+        out = (float)((double)(t1 - t0) * 1000.0 / (double)disjoint.Frequency);
+        return true;
+    };
+
+    FrameTiming t = timing;
+
+    if (!ms(f->begin, f->end, t.gpuMs))
+        return false;
+
+    t.views = f->views;
+
+    for (int i = 0; i < f->views; i++)
+    {
+        if (!ms(f->viewBegin[i], f->viewEnd[i], t.viewMs[i]))
+            return false;
+    }
+
+    timing = t;
+    return true;
+}
+
+void GpuTimer::release()
+{
+    for (auto& f : frames)
+    {
+        DXRelease(f.disjoint);
+        DXRelease(f.begin);
+        DXRelease(f.end);
+
+        for (int i = 0; i < GOVERNOR_MAX_VIEWS; i++)
+        {
+            DXRelease(f.viewBegin[i]);
+            DXRelease(f.viewEnd[i]);
+        }
+
+        f.views = 0;
+        f.pending = false;
+    }
+
+    current = 0;
+    recording = false;
+}
@@ -0,0 +1,61 @@
+/* GpuTimer.h
+
+measures the gpu time of a frame and of the split screen views with
+timestamp queries. the results of a frame are read GPU_TIMER_FRAMES frames
+later, so reading never waits for the gpu. frames the gpu clock was
+disjoint in are dropped.
+
+    Usage:
+    gpuTimer.Init(device);
+
+    gpuTimer.BeginFrame(context);
+    gpuTimer.BeginView(context, view);
+    gpuTimer.EndView(context, view);
+    gpuTimer.EndFrame(context);
+
+    FrameTiming t;
+    gpuTimer.Read(context, t);
+
+*/
+
+#pragma once
+
+#include "util.h"
+#include "FrameTimeGovernor.h"
+
+#define GPU_TIMER_FRAMES 4
+
+class GpuTimer
+{
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    bool Init(ID3D11Device* device);
+
+    void BeginFrame(ID3D11DeviceContext* context);
+    void BeginView(ID3D11DeviceContext* context, int view);
+    void EndView(ID3D11DeviceContext* context, int view);
+    void EndFrame(ID3D11DeviceContext* context);
+
+    /*fills gpuMs and the view times of the oldest finished frame, false if none has finished*/
+    bool Read(ID3D11DeviceContext* context, FrameTiming& timing);
+
+private:
+    struct Frame
+    {
+        ID3D11Query* disjoint = 0;
+        ID3D11Query* begin = 0;
+        ID3D11Query* end = 0;
+        ID3D11Query* viewBegin[GOVERNOR_MAX_VIEWS] = {};
+        ID3D11Query* viewEnd[GOVERNOR_MAX_VIEWS] = {};
+        int views = 0;
+        bool pending = false;
+    };
+
+    void release();
+
+    Frame frames[GPU_TIMER_FRAMES];
+    int current = 0;
+    bool recording = false;
+};
@@ -0,0 +1,403 @@
+#include "InputDevice.h"
+#include "NetSocket.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include "ControllerInput.h"
+#endif
+
+#ifdef _WIN32
+
+void KeyboardDevice::Read(InputData* out, float deltaTime)
+{
+    short keyboard[256];
+
+    memset(keyboard, 0, sizeof(short)*256);
+
+    for (int i = 0; i < 256; i++)
+    {
+        keyboard[i] = GetAsyncKeyState(i);
+    }
+
+    out[0].type = TYPE_KEYBOARD;
+    out[0].isConnected = true;
+
+    if (out[0].isConnected)
+    {
+        /*trigger*/
+        out[0].trigger[THUMB_LY] = keyboard[charToVKey('s')] ? -1.f : 0.f;
+        out[0].trigger[THUMB_LY] += keyboard[charToVKey('w')] ? 1.f : 0.f;
+        out[0].trigger[THUMB_LX] = keyboard[charToVKey('a')] ? -1.f : 0.f;
+        out[0].trigger[THUMB_LX] += keyboard[charToVKey('d')] ? 1.f : 0.f;
+        out[0].trigger[LEFT_TRIGGER] = keyboard[charToVKey('q')] ? 1.f : 0.f;
+        out[0].trigger[RIGHT_TRIGGER] = keyboard[charToVKey('e')] ? 1.f : 0.f;
+
+        /*buttons*/
+        out[0].buttons[BUTTON_A] = keyboard[VK_SPACE];
+        out[0].buttons[BUTTON_B] = keyboard[VK_CONTROL];
+        out[0].buttons[BUTTON_X] = keyboard[charToVKey('x')];
+        out[0].buttons[BUTTON_Y] = keyboard[charToVKey('y')];
+        out[0].buttons[DPAD_UP] = keyboard[VK_UP];
+        out[0].buttons[DPAD_DOWN] = keyboard[VK_DOWN];
+        out[0].buttons[DPAD_LEFT] = keyboard[VK_LEFT];
+        out[0].buttons[DPAD_RIGHT] = keyboard[VK_RIGHT];
+        out[0].buttons[LEFT_SHOULDER] = 0;
+        out[0].buttons[RIGHT_SHOULDER] = 0;
+        out[0].buttons[START] = keyboard[VK_RETURN];
+        out[0].buttons[BACK] = keyboard[VK_ESCAPE];
+        out[0].buttons[LEFT_THUMB] = 0;
+        out[0].buttons[RIGHT_THUMB] = 0;
+    }
+}
+
+int KeyboardDevice::charToVKey(char c)
+{
+    int k = (int)c - 32;
+    return (k < 65 || k > 90) ? -1 : k;
+}
+
+XInputDevice::XInputDevice()
+{
+    controller = new ControllerInput();
+}
+
+XInputDevice::~XInputDevice()
+{
+    delete controller;
+}
+
+int XInputDevice::Slots() const
+{
+    return MAX_CONTROLLERS;
+}
+
+void XInputDevice::Read(InputData* out, float deltaTime)
+{
+    controller->Update(deltaTime);
+
+    for (int c = 0; c < MAX_CONTROLLERS; c++)
+    {
+        //skip if not connected
+        ControllerState *cs = controller->getState(c);
+
+        if (!cs->isConnected)
+        {
+            continue;
+        }
+
+        out[c].isConnected = true;
+        out[c].type = TYPE_GAMEPAD;
+
+
+        /*buttons*/
+        if (cs->state.Gamepad.wButtons != 0)
+        {
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_A)
+            {
+                out[c].buttons[BUTTON_A] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_B)
+            {
+                out[c].buttons[BUTTON_B] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_X)
+            {
+                out[c].buttons[BUTTON_X] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_Y)
+            {
+                out[c].buttons[BUTTON_Y] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_DPAD_UP)
+            {
+                out[c].buttons[DPAD_UP] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_DPAD_DOWN)
+            {
+                out[c].buttons[DPAD_DOWN] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_DPAD_LEFT)
+            {
+                out[c].buttons[DPAD_LEFT] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_DPAD_RIGHT)
+            {
+                out[c].buttons[DPAD_RIGHT] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_LEFT_SHOULDER)
+            {
+                out[c].buttons[LEFT_SHOULDER] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_RIGHT_SHOULDER)
+            {
+                out[c].buttons[RIGHT_SHOULDER] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_START)
+            {
+                out[c].buttons[START] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_BACK)
+            {
+                out[c].buttons[BACK] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_LEFT_THUMB)
+            {
+                out[c].buttons[LEFT_THUMB] = true;
+            }
+            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_RIGHT_THUMB)
+            {
+                out[c].buttons[RIGHT_THUMB] = true;
+            }
+        }
+
+        /*triggers*/
+
+        out[c].trigger[LEFT_TRIGGER] = controller->normalizeTriggers(cs->state.Gamepad.bLeftTrigger);
+        out[c].trigger[RIGHT_TRIGGER] = controller->normalizeTriggers(cs->state.Gamepad.bRightTrigger);
+
+        out[c].trigger[THUMB_LX] = controller->normalizeThumbs(cs->state.Gamepad.sThumbLX);
+        out[c].trigger[THUMB_LY] = controller->normalizeThumbs(cs->state.Gamepad.sThumbLY);
+        out[c].trigger[THUMB_RX] = controller->normalizeThumbs(cs->state.Gamepad.sThumbRX);
+        out[c].trigger[THUMB_RY] = controller->normalizeThumbs(cs->state.Gamepad.sThumbRY);
+    }
+}
+
+#endif
+
+/*script names of buttons and triggers*/
+static const struct
+{
+    const char* name;
+    bool button;
+    int id;
+} controls[] =
+{
+    { "A", true, BUTTON_A }, { "B", true, BUTTON_B }, { "X", true, BUTTON_X }, { "Y", true, BUTTON_Y },
+    { "UP", true, DPAD_UP }, { "DOWN", true, DPAD_DOWN }, { "LEFT", true, DPAD_LEFT }, { "RIGHT", true, DPAD_RIGHT },
+    { "LB", true, LEFT_SHOULDER }, { "RB", true, RIGHT_SHOULDER }, { "START", true, START }, { "BACK", true, BACK },
+    { "LS", true, LEFT_THUMB }, { "RS", true, RIGHT_THUMB },
+    { "LT", false, LEFT_TRIGGER }, { "RT", false, RIGHT_TRIGGER },
+    { "LX", false, THUMB_LX }, { "LY", false, THUMB_LY }, { "RX", false, THUMB_RX }, { "RY", false, THUMB_RY }
+};
+
+static void idleGamepad(InputData& d)
+{
+    memset(&d, 0, sizeof(InputData));
+    d.type = TYPE_GAMEPAD;
+    d.isConnected = true;
+}
+
+ScriptedDevice::ScriptedDevice(int slots) : slots(slots), state(slots)
+{
+    for (auto& d : state)
+    {
+        idleGamepad(d);
+    }
+}
+
+ScriptedDevice::ScriptedDevice(int slots, Generator generator) : ScriptedDevice(slots)
+{
+    this->generator = generator;
+}
+
+void ScriptedDevice::Load(const std::string& file)
+{
+    std::ifstream in(file);
+
+    if (!in)
+    {
+        throw std::runtime_error("Unable to open input script " + file);
+    }
+
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(in, line))
+    {
+        lineNumber++;
+
+        line = line.substr(0, line.find('#'));
+
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        std::istringstream ls(line);
+        Entry e;
+        std::string name;
+
+        if (!(ls >> e.step >> e.slot >> name >> e.value) || e.slot < 0 || e.slot >= slots)
+        {
+            throw std::runtime_error("Invalid input script line " + std::to_string(lineNumber) + " in " + file);
+        }
+
+        auto c = std::find_if(std::begin(controls), std::end(controls), [&](const auto& c) { return name == c.name; });
+
+        if (c == std::end(controls))
+        {
+            throw std::runtime_error("Unknown control " + name + " in " + file);
+        }
+
+        e.button = c->button;
+        e.id = c->id;
+        entries.push_back(e);
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.step < b.step; });
+    next = 0;
+}
+
+ScriptedDevice::Generator ScriptedDevice::Soak(uint32_t seed)
+{
+    return [seed](uint64_t step, InputData* out, int slots)
+    {
+        for (int s = 0; s < slots; s++)
+        {
+            /*new buttons every 8 steps from a hash of seed, step and slot*/
+            uint64_t h = (step / 8) * 0x9E3779B97F4A7C15ull ^ (static_cast<uint64_t>(seed) << 32 | s);
+            h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+            h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+            h ^= h >> 31;
+
+            for (int b = 0; b < BUTTON_COUNT; b++)
+            {
+                /*hold back back, it leaves the game*/
+                out[s].buttons[b] = b != BACK && (h >> (b * 3) & 7) == 0;
+            }
+
+            float t = static_cast<float>(step) * 0.01f + s;
+            out[s].trigger[THUMB_LX] = std::sin(t * 1.3f);
+            out[s].trigger[THUMB_LY] = std::cos(t * 0.7f);
+            out[s].trigger[THUMB_RX] = std::sin(t * 0.4f);
+            out[s].trigger[THUMB_RY] = std::sin(t * 0.9f);
+        }
+    };
+}
+
+void ScriptedDevice::Read(InputData* out, float /*deltaTime*/)
+{
+    if (generator)
+    {
+        for (int s = 0; s < slots; s++)
+        {
+            idleGamepad(out[s]);
+        }
+
+        generator(step++, out, slots);
+        return;
+    }
+
+    while (next < entries.size() && entries[next].step <= step)
+    {
+        const Entry& e = entries[next++];
+
+        if (e.button)
+            state[e.slot].buttons[e.id] = e.value != 0.f;
+        else
+            state[e.slot].trigger[e.id] = std::clamp(e.value, -1.f, 1.f);
+    }
+
+    std::copy(state.begin(), state.end(), out);
+    step++;
+}
+
+bool ScriptedDevice::Finished() const
+{
+    return !generator && next == entries.size();
+}
+
+LoopbackDevice::LoopbackDevice(int slots, unsigned short port) : slots(slots), state(slots)
+{
+    socket = OpenUdpSocket(port, true);
+
+    if (socket == NET_INVALID_SOCKET)
+    {
+        throw std::runtime_error("Unable to open the input loopback port " + std::to_string(port));
+    }
+
+    memset(state.data(), 0, sizeof(InputData) * state.size());
+}
+
+LoopbackDevice::~LoopbackDevice()
+{
+    CloseUdpSocket(socket);
+}
+
+void LoopbackDevice::Read(InputData* out, float /*deltaTime*/)
+{
+    InputPacket packet;
+    uint32_t address;
+    unsigned short port;
+
+    for (size_t received; (received = ReceiveUdp(socket, &packet, sizeof(packet), address, port)) > 0;)
+    {
+        InputData data;
+
+        if (received == sizeof(packet) && packet.slot < static_cast<uint32_t>(slots) && Decode(packet, data))
+        {
+            state[packet.slot] = data;
+        }
+    }
+
+    std::copy(state.begin(), state.end(), out);
+}
+
+bool LoopbackDevice::Send(int slot, const InputData& data, unsigned short port)
+{
+    intptr_t s = OpenUdpSocket(0, true);
+
+    if (s == NET_INVALID_SOCKET)
+        return false;
+
+    InputPacket packet = Encode(slot, data);
+
+    bool sent = SendUdp(s, NET_LOOPBACK_ADDRESS, port, &packet, sizeof(packet));
+
+    CloseUdpSocket(s);
+    return sent;
+}
+
+InputPacket LoopbackDevice::Encode(int slot, const InputData& data)
+{
+    InputPacket packet = {};
+    packet.slot = static_cast<uint32_t>(slot);
+    packet.type = data.type;
+    packet.connected = data.isConnected ? 1 : 0;
+
+    for (int b = 0; b < BUTTON_COUNT; b++)
+    {
+        if (data.buttons[b])
+            packet.buttons |= 1u << b;
+    }
+
+    std::copy(data.trigger, data.trigger + TRIGGER_COUNT, packet.trigger);
+    return packet;
+}
+
+bool LoopbackDevice::Decode(const InputPacket& packet, InputData& data)
+{
+    if (packet.connected > 1 || (packet.buttons >> BUTTON_COUNT) != 0)
+        return false;
+
+    data.type = packet.type;
+    data.isConnected = packet.connected != 0;
+
+    for (int b = 0; b < BUTTON_COUNT; b++)
+    {
+        data.buttons[b] = (packet.buttons >> b & 1u) != 0;
+    }
+
+    for (int t = 0; t < TRIGGER_COUNT; t++)
+    {
+        if (!std::isfinite(packet.trigger[t]))
+            return false;
+
+        data.trigger[t] = std::clamp(packet.trigger[t], -1.f, 1.f);
+    }
+
+    return true;
+}
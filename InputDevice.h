@@ -0,0 +1,198 @@
+/* InputDevice.h
+
+sources of InputData for the InputManager. every device fills Slots()
+consecutive input indices, the default devices are the keyboard (index 0)
+and four xinput controllers (index 1 - 4).
+
+realtime devices are read on the polling thread of the InputManager. a
+ScriptedDevice is not realtime, it advances one step per game update, so
+a script drives the game the same way at any frame rate. it replays a file
+or calls a generator every step. a LoopbackDevice receives InputPackets
+from another process over udp on the local machine.
+
+the ScriptedDevice and LoopbackDevice only depend on the standard library
+and the socket api, the keyboard and xinput devices need windows.
+
+    Usage:
+    ScriptedDevice* s = new ScriptedDevice(INPUT_MAX);
+    s->Load("registration.txt");
+    InputManager* input = new InputManager({ s });
+
+    script lines are "step slot control value", # starts a comment. a press
+    and its release need different steps:
+    0 1 A 1
+    2 1 A 0
+    10 1 LX -0.5
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define BUTTON_COUNT 14
+#define TRIGGER_COUNT 6
+
+/*types*/
+#define TYPE_KEYBOARD 0
+#define TYPE_GAMEPAD 1
+
+/*buttons*/
+#define BUTTON_A 0
+#define BUTTON_B 1
+#define BUTTON_X 2
+#define BUTTON_Y 3
+#define DPAD_UP 4
+#define DPAD_DOWN 5
+#define DPAD_LEFT 6
+#define DPAD_RIGHT 7
+#define LEFT_SHOULDER 8
+#define RIGHT_SHOULDER 9
+#define START 10
+#define BACK 11
+#define LEFT_THUMB 12
+#define RIGHT_THUMB 13
+
+/*triggers*/
+#define LEFT_TRIGGER 0
+#define RIGHT_TRIGGER 1
+#define THUMB_LX 2
+#define THUMB_LY 3
+#define THUMB_RX 4
+#define THUMB_RY 5
+
+struct InputData
+{
+    int type;
+    bool isConnected;
+    bool buttons[BUTTON_COUNT];
+    float trigger[TRIGGER_COUNT]; /* value between -1 - +1 or 0 - +1*/
+};
+
+
+
+#define INPUT_LOOPBACK_PORT 27015
+
+class InputDevice
+{
+public:
+    virtual ~InputDevice() = default;
+
+    virtual int Slots() const = 0;
+
+    /*realtime devices are read on the polling thread, others once per game step*/
+    virtual bool Realtime() const { return true; }
+
+    /*fill Slots() entries of out, they are cleared before*/
+    virtual void Read(InputData* out, float deltaTime) = 0;
+};
+
+#ifdef _WIN32
+
+class ControllerInput;
+
+class KeyboardDevice : public InputDevice
+{
+public:
+    int Slots() const override { return 1; }
+    void Read(InputData* out, float deltaTime) override;
+
+private:
+    int charToVKey(char c);
+};
+
+class XInputDevice : public InputDevice
+{
+public:
+    XInputDevice();
+    ~XInputDevice();
+
+    int Slots() const override;
+    void Read(InputData* out, float deltaTime) override;
+
+private:
+    ControllerInput* controller;
+};
+
+#endif
+
+/*gamepads driven by a script file or a generator*/
+class ScriptedDevice : public InputDevice
+{
+public:
+    /*fills the slots of one step, they start as connected idle gamepads*/
+    using Generator = std::function<void(uint64_t step, InputData* out, int slots)>;
+
+    ScriptedDevice(int slots);
+    ScriptedDevice(int slots, Generator generator);
+
+    void Load(const std::string& file);
+
+    /*random but repeatable button mashing and stick movement*/
+    static Generator Soak(uint32_t seed);
+
+    int Slots() const override { return slots; }
+    bool Realtime() const override { return false; }
+    void Read(InputData* out, float deltaTime) override;
+
+    uint64_t Step() const { return step; }
+    bool Finished() const;
+
+private:
+    struct Entry
+    {
+        uint64_t step;
+        int slot;
+        bool button;
+        int id;
+        float value;
+    };
+
+    int slots;
+    uint64_t step = 0;
+    size_t next = 0;
+    std::vector<Entry> entries;
+    std::vector<InputData> state;
+    Generator generator;
+};
+
+/*InputData on the wire, buttons as a bitmask so no byte ends up in a bool*/
+struct InputPacket
+{
+    uint32_t slot;
+    int32_t type;
+    uint32_t connected;
+    uint32_t buttons;
+    float trigger[TRIGGER_COUNT];
+};
+
+static_assert(BUTTON_COUNT <= 32, "InputPacket buttons do not fit the bitmask");
+
+/*gamepads sent as InputPackets to a udp port on the local machine*/
+class LoopbackDevice : public InputDevice
+{
+public:
+    LoopbackDevice(int slots, unsigned short port = INPUT_LOOPBACK_PORT);
+    ~LoopbackDevice();
+
+    int Slots() const override { return slots; }
+    void Read(InputData* out, float deltaTime) override;
+
+    /*send the state of one slot from another process*/
+    static bool Send(int slot, const InputData& data, unsigned short port = INPUT_LOOPBACK_PORT);
+
+    static InputPacket Encode(int slot, const InputData& data);
+
+    /*false for packets that can not come from Encode*/
+    static bool Decode(const InputPacket& packet, InputData& data);
+
+private:
+    int slots;
+    intptr_t socket;
+
+    /*latest state per slot*/
+    std::vector<InputData> state;
+};
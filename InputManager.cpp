@@ -1,35 +1,128 @@
 #include "InputManager.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include "util.h"
+#include <timeapi.h>
+#pragma comment(lib,"winmm.lib")
+#else
+#define DBOUT(s)
+#endif
+
+static int64_t timestamp()
+{
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
 
-InputManager::InputManager()
+static double milliseconds(int64_t ticks)
 {
-    RtlSecureZeroMemory(&data[0], sizeof(InputData) * INPUT_MAX);
-    RtlSecureZeroMemory(&prevData[0], sizeof(InputData) * INPUT_MAX);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::duration(ticks)).count();
+}
+
+InputManager::InputManager(const std::vector<InputDevice*>& inputDevices) : devices(inputDevices), polling(false)
+{
+    memset(&data[0], 0, sizeof(InputData) * INPUT_MAX);
+    memset(&prevData[0], 0, sizeof(InputData) * INPUT_MAX);
+    memset(&state[0], 0, sizeof(InputData) * INPUT_MAX);
+    memset(&polled[0], 0, sizeof(InputData) * INPUT_MAX);
+    memset(pressed, 0, sizeof(pressed));
+    memset(released, 0, sizeof(released));
+
+#ifdef _WIN32
+    if (devices.empty())
+    {
+        devices.push_back(new KeyboardDevice());
+        devices.push_back(new XInputDevice());
+    }
+#endif
+
+    int slots = 0;
+
+    for (auto* d : devices)
+    {
+        slots += d->Slots();
+    }
+
+    if (slots > INPUT_MAX)
+    {
+        throw std::runtime_error("Input devices use more than INPUT_MAX slots");
+    }
 
-    controller = new ControllerInput();
-    mouseDelta = {};
     mouseSense = .5f;
+    lastPoll = timestamp();
+
+    /*scripted devices are read once per game step instead*/
+    if (std::any_of(devices.begin(), devices.end(), [](InputDevice* d) { return d->Realtime(); }))
+    {
+        polling = true;
+        pollThread = std::thread(&InputManager::poll, this);
+    }
 }
 
 InputManager::~InputManager()
 {
+    polling = false;
+
+    if (pollThread.joinable())
+        pollThread.join();
+
+    for (auto* d : devices)
+    {
+        delete d;
+    }
 }
 
-void InputManager::Update(float deltaTime)
+std::vector<InputDevice*> InputManager::ParseDevices(const std::string& commandLine)
 {
-    //read devices first
+    std::vector<std::string> args;
+    std::istringstream in(commandLine);
 
-    //read keyboard mouse to index 0
-    short keyboard[256];
-    
-    memset(keyboard, 0, sizeof(short)*256);
-    
-    for (int i = 0; i < 256; i++)
+    for (std::string arg; in >> arg;)
+    {
+        args.push_back(arg);
+    }
+
+    /*optional number after an option*/
+    auto number = [&](size_t i, unsigned long fallback)
+    {
+        if (i + 1 < args.size() && !args[i + 1].empty() && isdigit((unsigned char)args[i + 1][0]))
+            return std::stoul(args[i + 1]);
+
+        return fallback;
+    };
+
+    for (size_t i = 0; i < args.size(); i++)
     {
-        keyboard[i] = GetAsyncKeyState(i);
+        if (args[i] == "-script" && i + 1 < args.size())
+        {
+            auto script = std::make_unique<ScriptedDevice>(INPUT_MAX);
+            script->Load(args[i + 1]);
+            return { script.release() };
+        }
+
+        if (args[i] == "-soak")
+        {
+            return { new ScriptedDevice(INPUT_MAX, ScriptedDevice::Soak((uint32_t)number(i, 1))) };
+        }
+
+        if (args[i] == "-loopback")
+        {
+            return { new LoopbackDevice(INPUT_MAX, (unsigned short)number(i, INPUT_LOOPBACK_PORT)) };
+        }
     }
 
-    //read controllers to 1-5
-    controller->Update(deltaTime);
+    return {};
+}
+
+void InputManager::Update(float deltaTime)
+{
+    if (!pollThread.joinable())
+        pollDevices();
 
     //set previous
     for (int i = 0; i < INPUT_MAX; i++)
@@ -37,141 +130,197 @@ void InputManager::Update(float deltaTime)
         prevData[i] = data[i];
     }
 
-    //clear previous
-    RtlSecureZeroMemory(&data[0], sizeof(InputData)*(MAX_CONTROLLERS+1));
+    consume(true);
 
-    //read keyboard
+    //only show used inputs
+    for (int i = 0; i < INPUT_MAX; i++)
+    {
+        if (isUsedInput(i))
+        {
+            data[i] = state[i];
+        }
+        else
+        {
+            memset(&data[i], 0, sizeof(InputData));
+        }
+    }
 
+    //mouse is read on the window thread
     if (isUsedInput(0))
     {
+        data[0].trigger[THUMB_RX] = (float)mouseX * mouseSense;
+        data[0].trigger[THUMB_RY] = (float)mouseY * mouseSense;
+    }
 
-        data[0].type = TYPE_KEYBOARD;
-        data[0].isConnected = true;
+    latencyTime += deltaTime;
 
-        if (data[0].isConnected)
-        {
-            /*trigger*/
-            data[0].trigger[THUMB_LY] = keyboard[charToVKey('s')] ? -1.f : 0.f;
-            data[0].trigger[THUMB_LY] += keyboard[charToVKey('w')] ? 1.f : 0.f;
-            data[0].trigger[THUMB_LX] = keyboard[charToVKey('a')] ? -1.f : 0.f;
-            data[0].trigger[THUMB_LX] += keyboard[charToVKey('d')] ? 1.f : 0.f;
-            data[0].trigger[THUMB_RX] = (float)mouseDelta.x * mouseSense;
-            data[0].trigger[THUMB_RY] = (float)mouseDelta.y * mouseSense;
-            data[0].trigger[LEFT_TRIGGER] = keyboard[charToVKey('q')] ? 1.f : 0.f;
-            data[0].trigger[RIGHT_TRIGGER] = keyboard[charToVKey('e')] ? 1.f : 0.f;
-
-            /*buttons*/
-            data[0].buttons[BUTTON_A] = keyboard[VK_SPACE];
-            data[0].buttons[BUTTON_B] = keyboard[VK_CONTROL];
-            data[0].buttons[BUTTON_X] = keyboard[charToVKey('x')];
-            data[0].buttons[BUTTON_Y] = keyboard[charToVKey('y')];
-            data[0].buttons[DPAD_UP] = keyboard[VK_UP];
-            data[0].buttons[DPAD_DOWN] = keyboard[VK_DOWN];
-            data[0].buttons[DPAD_LEFT] = keyboard[VK_LEFT];
-            data[0].buttons[DPAD_RIGHT] = keyboard[VK_RIGHT];
-            data[0].buttons[LEFT_SHOULDER] = 0;
-            data[0].buttons[RIGHT_SHOULDER] = 0;
-            data[0].buttons[START] = keyboard[VK_RETURN];
-            data[0].buttons[BACK] = keyboard[VK_ESCAPE];
-            data[0].buttons[LEFT_THUMB] = 0;
-            data[0].buttons[RIGHT_THUMB] = 0;
-        }
+    if (latencyTime >= INPUT_LATENCY_WINDOW)
+    {
+        latencyWindow.average = latencyWindow.events ? latencySum / latencyWindow.events : 0.0;
+        latency = latencyWindow;
+
+        DBOUT("Input latency: " << latency.average << " ms average, " << latency.max << " ms max, " << latency.events << " events\n");
+
+        latencyWindow = InputLatency();
+        latencySum = 0.0;
+        latencyTime = 0.f;
     }
-    //read controllers
-    for (int c = 0; c < MAX_CONTROLLERS; c++)
+}
+
+void InputManager::Skip()
+{
+    if (!pollThread.joinable())
+        pollDevices();
+
+    consume(false);
+}
+
+/*apply all events polled before now to the device state*/
+void InputManager::consume(bool report)
+{
+    int64_t now = timestamp();
+
+    memset(pressed, 0, sizeof(pressed));
+    memset(released, 0, sizeof(released));
+
+    InputEvent e;
+
+    while (queue.Pop(e, now))
     {
-        if (!isUsedInput(c + 1)) continue;
-        //skip if not connected
-        ControllerState *cs = controller->getState(c);
+        InputData& s = state[e.index];
+
+        switch (e.type)
+        {
+            case INPUT_EVENT_CONNECT:
+                s.isConnected = e.value != 0.f;
+                s.type = e.id;
+                break;
 
-        if (!cs->isConnected)
+            case INPUT_EVENT_BUTTON:
+            {
+                bool down = e.value != 0.f;
+
+                /*a press and release within one step still counts as a press*/
+                if (report && isUsedInput(e.index) && down != s.buttons[e.id])
+                {
+                    if (down)
+                        pressed[e.index][e.id] = true;
+                    else
+                        released[e.index][e.id] = true;
+                }
+
+                s.buttons[e.id] = down;
+                break;
+            }
+
+            case INPUT_EVENT_TRIGGER:
+                s.trigger[e.id] = e.value;
+                break;
+        }
+
+        if (report)
         {
-            continue;
+            double ms = milliseconds(now - e.time);
+
+            latencyWindow.events++;
+            latencyWindow.max = (std::max)(latencyWindow.max, ms);
+            latencySum += ms;
         }
+    }
+}
 
-        data[c + 1].isConnected = true;
-        data[c + 1].type = TYPE_GAMEPAD;
+/*polling thread*/
+void InputManager::poll()
+{
+#ifdef _WIN32
+    timeBeginPeriod(INPUT_POLL_INTERVAL_MS);
+#endif
+
+    while (polling)
+    {
+        pollDevices();
+        std::this_thread::sleep_for(std::chrono::milliseconds(INPUT_POLL_INTERVAL_MS));
+    }
+
+#ifdef _WIN32
+    timeEndPeriod(INPUT_POLL_INTERVAL_MS);
+#endif
+}
+
+/*read all devices and push every change as an event*/
+void InputManager::pollDevices()
+{
+    InputData current[INPUT_MAX];
+    InputEvent events[INPUT_MAX * (BUTTON_COUNT + TRIGGER_COUNT + 1)];
 
+    int64_t now = timestamp();
+    readDevices(current, (float)(milliseconds(now - lastPoll) / 1000.0));
+    lastPoll = now;
 
-        /*buttons*/
-        if (cs->state.Gamepad.wButtons != 0)
+    size_t count = 0;
+
+    for (int i = 0; i < INPUT_MAX; i++)
+    {
+        InputEvent e;
+        e.time = now;
+        e.index = (unsigned char)i;
+
+        if (current[i].isConnected != polled[i].isConnected || current[i].type != polled[i].type)
         {
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_A)
-            {
-                data[c + 1].buttons[BUTTON_A] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_B)
-            {
-                data[c + 1].buttons[BUTTON_B] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_X)
-            {
-                data[c + 1].buttons[BUTTON_X] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_Y)
-            {
-                data[c + 1].buttons[BUTTON_Y] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_DPAD_UP)
-            {
-                data[c + 1].buttons[DPAD_UP] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_DPAD_DOWN)
-            {
-                data[c + 1].buttons[DPAD_DOWN] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_DPAD_LEFT)
-            {
-                data[c + 1].buttons[DPAD_LEFT] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_DPAD_RIGHT)
-            {
-                data[c + 1].buttons[DPAD_RIGHT] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_LEFT_SHOULDER)
-            {
-                data[c + 1].buttons[LEFT_SHOULDER] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_RIGHT_SHOULDER)
-            {
-                data[c + 1].buttons[RIGHT_SHOULDER] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_START)
-            {
-                data[c + 1].buttons[START] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_BACK)
-            {
-                data[c + 1].buttons[BACK] = true;
-            }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_LEFT_THUMB)
+            e.type = INPUT_EVENT_CONNECT;
+            e.id = (unsigned char)current[i].type;
+            e.value = current[i].isConnected ? 1.f : 0.f;
+            events[count++] = e;
+        }
+
+        for (int b = 0; b < BUTTON_COUNT; b++)
+        {
+            if (current[i].buttons[b] != polled[i].buttons[b])
             {
-                data[c + 1].buttons[LEFT_THUMB] = true;
+                e.type = INPUT_EVENT_BUTTON;
+                e.id = (unsigned char)b;
+                e.value = current[i].buttons[b] ? 1.f : 0.f;
+                events[count++] = e;
             }
-            if (cs->state.Gamepad.wButtons & XINPUT_GAMEPAD_RIGHT_THUMB)
+        }
+
+        for (int t = 0; t < TRIGGER_COUNT; t++)
+        {
+            if (current[i].trigger[t] != polled[i].trigger[t])
             {
-                data[c + 1].buttons[RIGHT_THUMB] = true;
+                e.type = INPUT_EVENT_TRIGGER;
+                e.id = (unsigned char)t;
+                e.value = current[i].trigger[t];
+                events[count++] = e;
             }
         }
+    }
 
-        /*triggers*/
-
-        data[c + 1].trigger[LEFT_TRIGGER] = controller->normalizeTriggers(cs->state.Gamepad.bLeftTrigger);
-        data[c + 1].trigger[RIGHT_TRIGGER] = controller->normalizeTriggers(cs->state.Gamepad.bRightTrigger);
-
-        data[c + 1].trigger[THUMB_LX] = controller->normalizeThumbs(cs->state.Gamepad.sThumbLX);
-        data[c + 1].trigger[THUMB_LY] = controller->normalizeThumbs(cs->state.Gamepad.sThumbLY);
-        data[c + 1].trigger[THUMB_RX] = controller->normalizeThumbs(cs->state.Gamepad.sThumbRX);
-        data[c + 1].trigger[THUMB_RY] = controller->normalizeThumbs(cs->state.Gamepad.sThumbRY);
+    /*with a full queue the changes are pushed by a later poll*/
+    if (count == 0 || queue.Push(events, count))
+    {
+        memcpy(polled, current, sizeof(polled));
     }
+}
+
+void InputManager::readDevices(InputData* out, float deltaTime)
+{
+    memset(out, 0, sizeof(InputData) * INPUT_MAX);
 
+    /*devices fill consecutive slots in their order*/
+    int slot = 0;
 
+    for (auto* d : devices)
+    {
+        d->Read(out + slot, deltaTime);
+        slot += d->Slots();
+    }
 }
 
-void InputManager::UpdateMouse(POINT& p)
+void InputManager::UpdateMouse(int x, int y)
 {
-    p.y *= -1;
-    mouseDelta = p;
+    mouseX = x;
+    mouseY = -y;
 }
 
 void InputManager::SetMouseSense(float sense)
@@ -199,12 +348,17 @@ InputData* InputManager::getPrevInput(int index)
 
 bool InputManager::ButtonPressed(int index, int button)
 {
-    return data[index].buttons[button] && !prevData[index].buttons[button];
+    return pressed[index][button];
 }
 
 bool InputManager::ButtonReleased(int index, int button)
 {
-    return !data[index].buttons[button] && prevData[index].buttons[button];
+    return released[index][button];
+}
+
+const InputLatency& InputManager::getLatency() const
+{
+    return latency;
 }
 
 void InputManager::addUsedInput(int a)
@@ -229,9 +383,3 @@ bool InputManager::isUsedInput(int a)
     }
     return false;
 }
-
-int InputManager::charToVKey(char c)
-{
-    int k = (int)c - 32;
-    return (k < 65 || k > 90) ? -1 : k;
-}
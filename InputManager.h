@@ -1,48 +1,25 @@
 #pragma once
 
-#include "ControllerInput.h"
+#include "InputDevice.h"
+#include "InputQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
 #include <vector>
 
-#define BUTTON_COUNT 14
-#define TRIGGER_COUNT 6
 #define INPUT_MAX 5
 
-/*types*/
-#define TYPE_KEYBOARD 0
-#define TYPE_GAMEPAD 1
-
-/*buttons*/
-#define BUTTON_A 0
-#define BUTTON_B 1
-#define BUTTON_X 2
-#define BUTTON_Y 3
-#define DPAD_UP 4
-#define DPAD_DOWN 5
-#define DPAD_LEFT 6
-#define DPAD_RIGHT 7
-#define LEFT_SHOULDER 8
-#define RIGHT_SHOULDER 9
-#define START 10
-#define BACK 11
-#define LEFT_THUMB 12
-#define RIGHT_THUMB 13
-
-/*triggers*/
-#define LEFT_TRIGGER 0
-#define RIGHT_TRIGGER 1
-#define THUMB_LX 2
-#define THUMB_LY 3
-#define THUMB_RX 4
-#define THUMB_RY 5
-
-
-
-struct InputData
+/*devices are polled on their own thread, events are consumed once per game step*/
+#define INPUT_POLL_INTERVAL_MS 1
+#define INPUT_LATENCY_WINDOW 10.f
+
+/*time from the poll that found an event to the game step that consumed it, in ms*/
+struct InputLatency
 {
-    int type;
-    bool isConnected;
-    bool buttons[BUTTON_COUNT];
-    float trigger[TRIGGER_COUNT]; /* value between -1 - +1 or 0 - +1*/
+    unsigned int events = 0;
+    double average = 0.0;
+    double max = 0.0;
 };
 
 class InputManager
@@ -50,11 +27,19 @@ class InputManager
 
 public:
 
-    InputManager();
+    /*takes ownership of the devices, keyboard and xinput controllers without any*/
+    InputManager(const std::vector<InputDevice*>& inputDevices = {});
     ~InputManager();
 
+    /*-script file, -soak [seed] or -loopback [port], no devices otherwise*/
+    static std::vector<InputDevice*> ParseDevices(const std::string& commandLine);
+
+    /*consume the events of this step, presses and releases shorter than a step are latched*/
     void Update(float deltaTime);
-    void UpdateMouse(POINT& p);
+
+    /*consume events without reporting them, while input is ignored*/
+    void Skip();
+    void UpdateMouse(int x, int y);
     void SetMouseSense(float sense);
 
     InputData* getInput(int index);
@@ -66,15 +51,40 @@ public:
     void addUsedInput(int a);
     void clearUsedInput();
     bool usedInputActive = false;
+
+    /*latency of the last completed INPUT_LATENCY_WINDOW*/
+    const InputLatency& getLatency() const;
 private:
-    ControllerInput* controller;
+    std::vector<InputDevice*> devices;
 
     InputData data[INPUT_MAX];
     InputData prevData[INPUT_MAX];
     std::vector<int> usedInputs;
 
+    /*device state built from the events, data only shows the used inputs*/
+    InputData state[INPUT_MAX];
+    bool pressed[INPUT_MAX][BUTTON_COUNT];
+    bool released[INPUT_MAX][BUTTON_COUNT];
+
+    /*polling thread, or the game update without realtime devices*/
+    void poll();
+    void pollDevices();
+    void readDevices(InputData* out, float deltaTime);
+    void consume(bool report);
+
+    InputQueue queue;
+    InputData polled[INPUT_MAX];
+    std::thread pollThread;
+    std::atomic<bool> polling;
+    int64_t lastPoll;
+
+    InputLatency latency;
+    InputLatency latencyWindow;
+    double latencySum = 0.0;
+    float latencyTime = 0.f;
+
     bool isUsedInput(int a);
-    int charToVKey(char c);
-    POINT mouseDelta;
+    int mouseX = 0;
+    int mouseY = 0;
     float mouseSense;
 };
\ No newline at end of file
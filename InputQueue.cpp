@@ -0,0 +1,45 @@
+#include "InputQueue.h"
+
+InputQueue::InputQueue() : head(0), tail(0)
+{
+}
+
+bool InputQueue::Push(const InputEvent* events, size_t count)
+{
+    size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+
+    if (INPUT_QUEUE_SIZE - (t - h) < count)
+        return false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        ring[(t + i) & (INPUT_QUEUE_SIZE - 1)] = events[i];
+    }
+
+    /*publish all events at once*/
+    tail.store(t + count, std::memory_order_release);
+    return true;
+}
+
+bool InputQueue::Pop(InputEvent& e, int64_t until)
+{
+    size_t h = head.load(std::memory_order_relaxed);
+
+    if (h == tail.load(std::memory_order_acquire))
+        return false;
+
+    const InputEvent& next = ring[h & (INPUT_QUEUE_SIZE - 1)];
+
+    if (next.time > until)
+        return false;
+
+    e = next;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+size_t InputQueue::Size() const
+{
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+}
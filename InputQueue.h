@@ -0,0 +1,70 @@
+/* InputQueue.h
+
+lock free ring of timestamped input events between one producer (the input
+polling thread) and one consumer (the game update).
+
+the producer pushes all events of one poll or none of them, so the consumer
+never sees half of a device change. events carry the std::chrono::steady_clock
+ticks of the poll that found them, the consumer only takes events up to the
+time of its step.
+
+    Usage:
+    InputEvent e[2];
+    ...
+    if (!queue.Push(e, 2)) keep the state and try again next poll
+    ...
+    InputEvent ev;
+    while (queue.Pop(ev, stepTime))
+    {
+        ...
+    }
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*power of two*/
+#define INPUT_QUEUE_SIZE 1024
+
+/*event types*/
+#define INPUT_EVENT_CONNECT 0
+#define INPUT_EVENT_BUTTON 1
+#define INPUT_EVENT_TRIGGER 2
+
+struct InputEvent
+{
+    int64_t time;
+    unsigned char index;
+    unsigned char type;
+
+    /*button or trigger, device type for connect events*/
+    unsigned char id;
+
+    /*button state, trigger value or connection state*/
+    float value;
+};
+
+class InputQueue
+{
+public:
+    InputQueue();
+
+    /*producer*/
+    bool Push(const InputEvent* events, size_t count);
+
+    /*consumer, only events with a time up to until*/
+    bool Pop(InputEvent& e, int64_t until);
+
+    size_t Size() const;
+
+private:
+    InputEvent ring[INPUT_QUEUE_SIZE];
+
+    /*written by the consumer and the producer, on their own cache lines*/
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
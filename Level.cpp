@@ -1,32 +1,33 @@
 #include "Level.h"
+#include <algorithm>
+#include <tuple>
 
 
-Level::Level(ResourceManager* r, ID3D11Device* d, ID3D11DeviceContext* c)
+Level::Level(ResourceManager* r, ID3D11Device* d, ID3D11DeviceContext* c, bool cpuParticles)
 {
     res = r;
     device = d;
     context = c;
+    this->cpuParticles = cpuParticles;
 }
 
 Level::~Level()
 {
-    /*clear pointer maps*/
-    for (auto& i : modelsStatic)
-    {
-        delete i.second;
-    }
+    /*clear pointer maps, the objects are destroyed with their pools*/
     modelsStatic.clear();
-
-    for (auto& i : particleSystems)
-    {
-        delete i.second;
-    }
+    drawOrder.clear();
     particleSystems.clear();
 
+    instancePool.Clear();
+    particlePool.Clear();
 }
 
 bool Level::LoadLevel(std::string fileName)
 {
+#ifdef TRACK_ALLOCATIONS
+    size_t allocations = AllocationCounter::Allocations();
+#endif
+
     std::string buf;
     /*open file and check*/
     buf = LEVEL_PATH;
@@ -42,22 +43,35 @@ bool Level::LoadLevel(std::string fileName)
         return false;
     }
 
-    json lvl;
-    try
     {
-        lvl = json::parse(fin);
-    }
-    catch (json::parse_error& e)
-    {
-        throw std::exception(e.what());
-        return false;
+        /*the parsed document only lives in the load arena*/
+        LinearAllocator::Scope scope(loadArena);
+
+        json lvl;
+        try
+        {
+            lvl = json::parse(fin);
+        }
+        catch (json::parse_error& e)
+        {
+            throw std::exception(e.what());
+            return false;
+        }
+        fin.close();
+
+        /*read different parts*/
+        ReadStaticModels(lvl);
+        ReadParticleSystems(lvl);
     }
-    fin.close();
 
-    /*read different parts*/
-    ReadStaticModels(lvl);
-    ReadParticleSystems(lvl);
-   
+    SortStaticModels();
+
+    loadArena.Reset();
+
+#ifdef TRACK_ALLOCATIONS
+    DBOUT("Level " << fileName << " loaded with " << AllocationCounter::Allocations() - allocations << " allocations" << std::endl);
+#endif
+
     return true;
 }
 
@@ -83,6 +97,14 @@ void Level::Reset()
 
 }
 
+void Level::Suspend()
+{
+    for (auto& i : particleSystems)
+    {
+        i.second->sleep();
+    }
+}
+
 void Level::ReadStaticModels(const json& j)
 {
     
@@ -101,7 +123,7 @@ void Level::ReadStaticModels(const json& j)
             return;
         }
 
-        ModelInstanceStatic* mis = new ModelInstanceStatic(res, i["model"]);
+        ModelInstanceStatic* mis = instancePool.Create(res, i["model"]);
 
         /*shader*/
         std::string shaderString = i["shader"];
@@ -159,12 +181,15 @@ void Level::ReadStaticModels(const json& j)
             mis->OverwriteNormalMap(i["overwriteNormal"]);
         }
 
+        /*scaled default planes and cubes get their own primitive with tiled uvs*/
         if (mis->GetModelID() == DEFAULT_PLANE || mis->GetModelID() == DEFAULT_CUBE)
         {
-            XMMATRIX _r = XMMatrixRotationRollPitchYaw(0, 0, 0);
-            XMMATRIX _t = XMMatrixTranslation(0, 0, 0);
-            XMMATRIX _s = XMMatrixScaling(mis->Scale.x / 4, mis->Scale.z / 4, 1.f);
-            XMStoreFloat4x4(&mis->TextureTransform, _r * _s * _t);
+            PrimitiveDesc desc;
+            desc.shape = mis->GetModelID() == DEFAULT_PLANE ? PrimitiveShape::Plane : PrimitiveShape::Box;
+            desc.size = XMFLOAT3(1.f, mis->GetModelID() == DEFAULT_PLANE ? 0.f : 1.f, 1.f);
+            desc.tiling = XMFLOAT3(mis->Scale.x / TEXTURE_TILE_SIZE, mis->Scale.y / TEXTURE_TILE_SIZE, mis->Scale.z / TEXTURE_TILE_SIZE);
+
+            mis->SetModelID(res->getModelCollection()->AddPrimitive(desc));
         }
 
         /*other*/
@@ -188,6 +213,36 @@ void Level::ReadStaticModels(const json& j)
 
 }
 
+void Level::SortStaticModels()
+{
+    drawOrder.clear();
+
+    for (auto& i : modelsStatic)
+    {
+        drawOrder.push_back(i.second);
+    }
+
+    /*by the textures of the first mesh, meshes on the same atlas page bind the same textures*/
+    auto key = [](ModelInstanceStatic* i)
+    {
+        Model* model = i->getModel();
+        std::string diffuse, normal;
+
+        if (!model->meshes.empty())
+        {
+            diffuse = i->getDiffuseMapID(model->meshes.front());
+            normal = i->getNormalMapID(model->meshes.front());
+        }
+
+        return std::make_tuple(i->usedShader, i->usedTechnique, diffuse, normal);
+    };
+
+    std::stable_sort(drawOrder.begin(), drawOrder.end(), [&](ModelInstanceStatic* a, ModelInstanceStatic* b)
+    {
+        return key(a) < key(b);
+    });
+}
+
 void Level::ReadParticleSystems(const json& j)
 {
     if (!exists(j, "dynamic"))
@@ -225,7 +280,7 @@ void Level::ReadParticleSystems(const json& j)
             return;
         }
 
-        ParticleSystem* p = new ParticleSystem();
+        ParticleSystem* p = particlePool.Create();
 
         std::vector<std::wstring> texture;
 
@@ -264,11 +319,15 @@ void Level::ReadParticleSystems(const json& j)
         std::string shaderString = i["shader"];
         if (shaderString == "fire")
         {
-            p->init(device, Shaders::fireShader, mTArr, CreateRandomTexture1DSRV(device), i["maxParticles"]);
+            ParticleEmitterDesc desc = ParticleEmitterDesc::Fire();
+            desc.seed = i["id"];
+            p->init(device, Shaders::fireShader, mTArr, res->getRandomTexture(), res->getParticleBuffers(), i["maxParticles"], desc, cpuParticles);
         }
         else if (shaderString == "celebration")
         {
-            p->init(device, Shaders::celebrationShader, mTArr, CreateRandomTexture1DSRV(device), i["maxParticles"]);
+            ParticleEmitterDesc desc = ParticleEmitterDesc::Celebration();
+            desc.seed = i["id"];
+            p->init(device, Shaders::celebrationShader, mTArr, res->getRandomTexture(), res->getParticleBuffers(), i["maxParticles"], desc, cpuParticles);
         }
 
         p->setEmitPosition(XMFLOAT3(i["position"][0], i["position"][1], i["position"][2]));
@@ -3,15 +3,18 @@
 #include "util.h"
 #include "ModelInstanceStatic.h"
 #include "ParticleSystem.h"
+#include "Allocator.h"
 #include "json.hpp"
 #include <fstream>
 
-using json = nlohmann::json;
+/*json document allocated from the level load arena*/
+using json = nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t, std::uint64_t, double, ArenaAllocator>;
 
 class Level
 {
 public:
-    Level(ResourceManager* r, ID3D11Device* d, ID3D11DeviceContext* c);
+    /*cpuParticles simulates the particle systems on the cpu, see CpuParticles.h*/
+    Level(ResourceManager* r, ID3D11Device* d, ID3D11DeviceContext* c, bool cpuParticles = false);
     ~Level();
 
     bool LoadLevel(std::string fileName);
@@ -19,19 +22,33 @@ public:
     void Update(float deltaTime);
     void Reset();
 
+    /*puts the particle systems to sleep while another level is active*/
+    void Suspend();
+
     std::map<int, ModelInstanceStatic*> modelsStatic;
+
+    /*static models sorted by shader and textures, neighbours share their bindings*/
+    std::vector<ModelInstanceStatic*> drawOrder;
+
     std::map<int, ParticleSystem*> particleSystems;
 
 private:
     void ReadStaticModels(const json& j);
     void ReadParticleSystems(const json& j);
+    void SortStaticModels();
     ResourceManager* res = 0;
     ID3D11Device* device = 0;
     ID3D11DeviceContext* context = 0;
     float totalTime = 0.f;
+    bool cpuParticles = false;
+
+    /*level scoped storage, released at once when the level is destroyed*/
+    ObjectPool<ModelInstanceStatic> instancePool;
+    ObjectPool<ParticleSystem> particlePool;
+    LinearAllocator loadArena;
 };
 
-static bool exists(const nlohmann::json& j, const std::string& key)
+static bool exists(const json& j, const std::string& key)
 {
     return j.find(key) != j.end();
 }
\ No newline at end of file
@@ -0,0 +1,277 @@
+#include "MeshClusterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+
+/*weight of the normal deviation against the number of new vertices when growing a cluster*/
+#define CLUSTER_CONE_WEIGHT 1.5f
+
+MeshClusterizer::MeshClusterizer(const float* _positions, size_t _stride, size_t _vertexCount)
+    : positions(_positions), stride(_stride), vertexCount(_vertexCount)
+{
+}
+
+const float* MeshClusterizer::position(unsigned int v) const
+{
+    return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+}
+
+std::vector<MeshCluster> MeshClusterizer::Build(std::vector<unsigned int>& indices, size_t maxVertices, size_t maxTriangles)
+{
+    std::vector<MeshCluster> clusters;
+
+    size_t triCount = indices.size() / 3;
+
+    if (triCount == 0 || maxVertices < 3 || maxTriangles == 0)
+    {
+        return clusters;
+    }
+
+    /*unit face normals*/
+    std::vector<float> triNormals(triCount * 3, 0.f);
+
+    for (size_t t = 0; t < triCount; t++)
+    {
+        const float* p0 = position(indices[t * 3 + 0]);
+        const float* p1 = position(indices[t * 3 + 1]);
+        const float* p2 = position(indices[t * 3 + 2]);
+
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float n[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                       e1[2] * e2[0] - e1[0] * e2[2],
+                       e1[0] * e2[1] - e1[1] * e2[0] };
+
+        float len = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+        if (len > 0.f)
+        {
+            triNormals[t * 3 + 0] = n[0] / len;
+            triNormals[t * 3 + 1] = n[1] / len;
+            triNormals[t * 3 + 2] = n[2] / len;
+        }
+    }
+
+    /*vertex to triangle adjacency*/
+    std::vector<unsigned int> adjOffset(vertexCount + 1, 0);
+    std::vector<unsigned int> adjTris(triCount * 3);
+
+    for (size_t i = 0; i < triCount * 3; i++)
+    {
+        adjOffset[indices[i] + 1]++;
+    }
+
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        adjOffset[v + 1] += adjOffset[v];
+    }
+
+    std::vector<unsigned int> fill(adjOffset.begin(), adjOffset.end() - 1);
+
+    for (size_t i = 0; i < triCount * 3; i++)
+    {
+        adjTris[fill[indices[i]]++] = (unsigned int)(i / 3);
+    }
+
+    std::vector<bool> triUsed(triCount, false);
+    std::vector<unsigned int> vertCluster(vertexCount, UINT32_MAX);
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    std::vector<unsigned int> clusterTris;
+    std::vector<unsigned int> candidates;
+    size_t clusterVerts = 0;
+    size_t seed = 0;
+
+    float axis[3] = { 0.f, 0.f, 0.f };
+
+    while (true)
+    {
+        /*start a new cluster at the next unused triangle*/
+        while (seed < triCount && triUsed[seed]) seed++;
+
+        if (seed == triCount)
+        {
+            break;
+        }
+
+        unsigned int clusterID = (unsigned int)clusters.size();
+        clusterTris.clear();
+        candidates.clear();
+        clusterVerts = 0;
+        axis[0] = axis[1] = axis[2] = 0.f;
+
+        unsigned int next = (unsigned int)seed;
+
+        while (true)
+        {
+            /*add triangle*/
+            triUsed[next] = true;
+            clusterTris.push_back(next);
+
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[next * 3 + k];
+
+                if (vertCluster[v] != clusterID)
+                {
+                    vertCluster[v] = clusterID;
+                    clusterVerts++;
+
+                    for (unsigned int a = adjOffset[v]; a < adjOffset[v + 1]; a++)
+                    {
+                        if (!triUsed[adjTris[a]]) candidates.push_back(adjTris[a]);
+                    }
+                }
+
+                axis[k] += triNormals[next * 3 + k];
+            }
+
+            if (clusterTris.size() >= maxTriangles)
+            {
+                break;
+            }
+
+            float axisLen = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            float invLen = axisLen > 0.f ? 1.f / axisLen : 0.f;
+
+            /*pick the neighbour that adds the fewest vertices and bends the cone the least*/
+            float bestScore = FLT_MAX;
+            size_t best = SIZE_MAX;
+
+            for (size_t i = 0; i < candidates.size();)
+            {
+                unsigned int t = candidates[i];
+
+                if (triUsed[t])
+                {
+                    candidates[i] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+
+                size_t newVerts = 0;
+                for (int k = 0; k < 3; k++)
+                {
+                    if (vertCluster[indices[t * 3 + k]] != clusterID) newVerts++;
+                }
+
+                if (clusterVerts + newVerts <= maxVertices)
+                {
+                    float dp = (axis[0] * triNormals[t * 3 + 0] + axis[1] * triNormals[t * 3 + 1] + axis[2] * triNormals[t * 3 + 2]) * invLen;
+                    float score = (float)newVerts + (1.f - dp) * CLUSTER_CONE_WEIGHT;
+
+                    if (score < bestScore)
+                    {
+                        bestScore = score;
+                        best = i;
+                    }
+                }
+
+                i++;
+            }
+
+            if (best == SIZE_MAX)
+            {
+                break;
+            }
+
+            next = candidates[best];
+        }
+
+        /*emit cluster*/
+        MeshCluster c;
+        c.startIndex = (unsigned int)result.size();
+        c.indexCount = (unsigned int)(clusterTris.size() * 3);
+
+        for (unsigned int t : clusterTris)
+        {
+            result.push_back(indices[t * 3 + 0]);
+            result.push_back(indices[t * 3 + 1]);
+            result.push_back(indices[t * 3 + 2]);
+        }
+
+        computeBounds(c, result, triNormals, clusterTris);
+        clusters.push_back(c);
+    }
+
+    /*trailing indices that do not form a triangle are dropped*/
+    indices.swap(result);
+
+    return clusters;
+}
+
+void MeshClusterizer::computeBounds(MeshCluster& c, const std::vector<unsigned int>& clusterIndices, const std::vector<float>& triNormals,
+                                    const std::vector<unsigned int>& clusterTris) const
+{
+    /*sphere around the center of the bounding box*/
+    float bMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float bMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (unsigned int i = c.startIndex; i < c.startIndex + c.indexCount; i++)
+    {
+        const float* p = position(clusterIndices[i]);
+
+        for (int k = 0; k < 3; k++)
+        {
+            bMin[k] = std::min(bMin[k], p[k]);
+            bMax[k] = std::max(bMax[k], p[k]);
+        }
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        c.center[k] = 0.5f * (bMin[k] + bMax[k]);
+    }
+
+    float r2 = 0.f;
+
+    for (unsigned int i = c.startIndex; i < c.startIndex + c.indexCount; i++)
+    {
+        const float* p = position(clusterIndices[i]);
+
+        float d[3] = { p[0] - c.center[0], p[1] - c.center[1], p[2] - c.center[2] };
+        r2 = std::max(r2, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    }
+
+    c.radius = sqrtf(r2);
+
+    /*normal cone around the average face normal*/
+    float axis[3] = { 0.f, 0.f, 0.f };
+
+    for (unsigned int t : clusterTris)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            axis[k] += triNormals[t * 3 + k];
+        }
+    }
+
+    float len = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+    if (len <= 0.f)
+    {
+        return;
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        c.coneAxis[k] = axis[k] / len;
+    }
+
+    float minDot = 1.f;
+
+    for (unsigned int t : clusterTris)
+    {
+        const float* n = &triNormals[t * 3];
+
+        /*degenerate triangles are never rasterized*/
+        if (n[0] == 0.f && n[1] == 0.f && n[2] == 0.f) continue;
+
+        minDot = std::min(minDot, n[0] * c.coneAxis[0] + n[1] * c.coneAxis[1] + n[2] * c.coneAxis[2]);
+    }
+
+    c.coneCutoff = minDot <= 0.f ? 1.f : sqrtf(1.f - minDot * minDot);
+}
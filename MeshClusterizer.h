@@ -0,0 +1,54 @@
+/* MeshClusterizer.h
+
+splits a triangle list into small clusters (meshlets) with a bounding
+sphere and a normal cone each, so the renderer can skip clusters that
+are outside the view frustum or completely facing away from the camera.
+
+clusters are grown greedily over shared vertices, the index list is
+reordered so every cluster is one contiguous index range. only depends
+on the standard library.
+
+    Usage:
+    MeshClusterizer c(&vertices[0].Pos.x, sizeof(Vertex::Standard), vertices.size());
+    std::vector<MeshCluster> clusters = c.Build(indices, 64, 124);
+
+    backfacing test (camera position in mesh space):
+    dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+struct MeshCluster
+{
+    unsigned int startIndex = 0;
+    unsigned int indexCount = 0;
+
+    float center[3] = { 0.f, 0.f, 0.f };
+    float radius = 0.f;
+
+    /*cutoff of 1 means the cone is too wide to ever cull*/
+    float coneAxis[3] = { 0.f, 0.f, 0.f };
+    float coneCutoff = 1.f;
+};
+
+class MeshClusterizer
+{
+public:
+    MeshClusterizer(const float* positions, size_t stride, size_t vertexCount);
+
+    /*reorders indices, returns the clusters in index buffer order*/
+    std::vector<MeshCluster> Build(std::vector<unsigned int>& indices, size_t maxVertices, size_t maxTriangles);
+
+private:
+    const float* position(unsigned int v) const;
+    void computeBounds(MeshCluster& c, const std::vector<unsigned int>& clusterIndices, const std::vector<float>& triNormals,
+                       const std::vector<unsigned int>& clusterTris) const;
+
+    const float* positions;
+    size_t stride;
+    size_t vertexCount;
+};
@@ -0,0 +1,418 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cfloat>
+
+void MeshSimplifier::Quadric::add(const Quadric& q)
+{
+    a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+    b2 += q.b2; bc += q.bc; bd += q.bd;
+    c2 += q.c2; cd += q.cd;
+    d2 += q.d2;
+}
+
+/*v^T * Q * v with v = (x, y, z, 1)*/
+double MeshSimplifier::Quadric::evaluate(const float* p) const
+{
+    double x = p[0], y = p[1], z = p[2];
+
+    double r = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+             + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+             + c2 * z * z + 2.0 * cd * z
+             + d2;
+
+    return r < 0.0 ? 0.0 : r;
+}
+
+MeshSimplifier::MeshSimplifier(const float* _positions, size_t _stride, size_t _vertexCount, const std::vector<unsigned int>& indices)
+    : positions(_positions), stride(_stride), vertexCount(_vertexCount), source(indices)
+{
+    /*extent is used to make the error independent of the model scale*/
+    float bMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+    float bMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        const float* p = position((unsigned int)i);
+
+        for (int k = 0; k < 3; k++)
+        {
+            bMin[k] = std::min(bMin[k], p[k]);
+            bMax[k] = std::max(bMax[k], p[k]);
+        }
+    }
+
+    extent = 0.0;
+    for (int k = 0; k < 3; k++)
+    {
+        extent = std::max(extent, (double)(bMax[k] - bMin[k]));
+    }
+
+    if (extent <= 0.0)
+    {
+        extent = 1.0;
+    }
+}
+
+const float* MeshSimplifier::position(unsigned int v) const
+{
+    return reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+}
+
+SimplifyResult MeshSimplifier::Simplify(float targetRatio, float maxError)
+{
+    return SimplifyChain(std::vector<float>(1, targetRatio), maxError)[0];
+}
+
+std::vector<SimplifyResult> MeshSimplifier::SimplifyChain(const std::vector<float>& targetRatios, float maxError)
+{
+    std::vector<SimplifyResult> results(targetRatios.size());
+
+    if (targetRatios.empty() || source.size() < 3)
+    {
+        return results;
+    }
+
+    /*reset working state*/
+    size_t triCount = source.size() / 3;
+
+    tris.assign(source.begin(), source.begin() + triCount * 3);
+    triAlive.assign(triCount, true);
+    vertTris.assign(vertexCount, std::vector<unsigned int>());
+    quadrics.assign(vertexCount, Quadric());
+    locked.assign(vertexCount, false);
+    removed.assign(vertexCount, false);
+    version.assign(vertexCount, 0);
+    liveTris = 0;
+
+    /*plane quadrics, cost is the sum of squared distances to the original planes*/
+    for (size_t t = 0; t < triCount; t++)
+    {
+        unsigned int* c = &tris[t * 3];
+
+        if (c[0] == c[1] || c[1] == c[2] || c[0] == c[2])
+        {
+            triAlive[t] = false;
+            continue;
+        }
+
+        const float* p0 = position(c[0]);
+        const float* p1 = position(c[1]);
+        const float* p2 = position(c[2]);
+
+        double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        double n[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                        e1[2] * e2[0] - e1[0] * e2[2],
+                        e1[0] * e2[1] - e1[1] * e2[0] };
+
+        double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+        liveTris++;
+        for (int k = 0; k < 3; k++)
+        {
+            vertTris[c[k]].push_back((unsigned int)t);
+        }
+
+        if (len <= 0.0)
+        {
+            continue;
+        }
+
+        n[0] /= len; n[1] /= len; n[2] /= len;
+        double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+
+        Quadric q;
+        q.a2 = n[0] * n[0]; q.ab = n[0] * n[1]; q.ac = n[0] * n[2]; q.ad = n[0] * d;
+        q.b2 = n[1] * n[1]; q.bc = n[1] * n[2]; q.bd = n[1] * d;
+        q.c2 = n[2] * n[2]; q.cd = n[2] * d;
+        q.d2 = d * d;
+
+        for (int k = 0; k < 3; k++)
+        {
+            quadrics[c[k]].add(q);
+        }
+    }
+
+    /*collect undirected edges, lock border and non manifold vertices
+      (this also keeps uv seams intact because seam vertices are split)*/
+    std::vector<uint64_t> edges;
+    edges.reserve(liveTris * 3);
+
+    for (size_t t = 0; t < triCount; t++)
+    {
+        if (!triAlive[t]) continue;
+
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = tris[t * 3 + k];
+            unsigned int b = tris[t * 3 + (k + 1) % 3];
+            if (a > b) std::swap(a, b);
+            edges.push_back(((uint64_t)a << 32) | b);
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<Collapse> heap;
+    heap.reserve(edges.size());
+
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i]) j++;
+
+        unsigned int a = (unsigned int)(edges[i] >> 32);
+        unsigned int b = (unsigned int)(edges[i] & 0xFFFFFFFF);
+
+        if (j - i != 2)
+        {
+            locked[a] = true;
+            locked[b] = true;
+        }
+
+        i = j;
+    }
+
+    for (size_t i = 0; i < edges.size(); i++)
+    {
+        if (i > 0 && edges[i] == edges[i - 1]) continue;
+
+        unsigned int a = (unsigned int)(edges[i] >> 32);
+        unsigned int b = (unsigned int)(edges[i] & 0xFFFFFFFF);
+
+        Quadric q = quadrics[a];
+        q.add(quadrics[b]);
+
+        if (!locked[a]) heap.push_back({ q.evaluate(position(b)), a, b, 0, 0 });
+        if (!locked[b]) heap.push_back({ q.evaluate(position(a)), b, a, 0, 0 });
+    }
+
+    std::make_heap(heap.begin(), heap.end());
+
+    /*collapse until every ratio is reached*/
+    double maxCost = (double)maxError * extent;
+    maxCost *= maxCost;
+
+    double worst = 0.0;
+    size_t next = 0;
+
+    while (next < targetRatios.size())
+    {
+        size_t target = (size_t)(targetRatios[next] * (float)triCount);
+
+        if (liveTris <= target)
+        {
+            snapshot(results[next++], worst);
+            continue;
+        }
+
+        if (heap.empty())
+        {
+            break;
+        }
+
+        std::pop_heap(heap.begin(), heap.end());
+        Collapse c = heap.back();
+        heap.pop_back();
+
+        /*outdated entry*/
+        if (removed[c.from] || removed[c.to] || version[c.from] != c.fromVersion || version[c.to] != c.toVersion)
+        {
+            continue;
+        }
+
+        if (c.cost > maxCost)
+        {
+            break;
+        }
+
+        if (collapseFlips(c.from, c.to) || breaksLink(c.from, c.to))
+        {
+            continue;
+        }
+
+        /*move all triangles of from to to*/
+        for (unsigned int t : vertTris[c.from])
+        {
+            if (!triAlive[t]) continue;
+
+            unsigned int* tc = &tris[t * 3];
+
+            if (tc[0] == c.to || tc[1] == c.to || tc[2] == c.to)
+            {
+                triAlive[t] = false;
+                liveTris--;
+                continue;
+            }
+
+            for (int k = 0; k < 3; k++)
+            {
+                if (tc[k] == c.from) tc[k] = c.to;
+            }
+
+            vertTris[c.to].push_back(t);
+        }
+
+        std::vector<unsigned int>& vt = vertTris[c.to];
+        vt.erase(std::remove_if(vt.begin(), vt.end(), [this](unsigned int t) { return !triAlive[t]; }), vt.end());
+
+        quadrics[c.to].add(quadrics[c.from]);
+        removed[c.from] = true;
+        vertTris[c.from].clear();
+        version[c.to]++;
+
+        worst = std::max(worst, c.cost);
+
+        pushEdges(c.to, heap);
+    }
+
+    /*ratios that could not be reached within the error bound*/
+    while (next < targetRatios.size())
+    {
+        snapshot(results[next++], worst);
+    }
+
+    return results;
+}
+
+/*queue both collapse directions for all edges around v*/
+void MeshSimplifier::pushEdges(unsigned int v, std::vector<Collapse>& heap)
+{
+    for (unsigned int t : vertTris[v])
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int w = tris[t * 3 + k];
+            if (w == v) continue;
+
+            Quadric q = quadrics[v];
+            q.add(quadrics[w]);
+
+            if (!locked[v])
+            {
+                heap.push_back({ q.evaluate(position(w)), v, w, version[v], version[w] });
+                std::push_heap(heap.begin(), heap.end());
+            }
+
+            if (!locked[w])
+            {
+                heap.push_back({ q.evaluate(position(v)), w, v, version[w], version[v] });
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+    }
+}
+
+/*link condition: the neighbours from and to have in common may only be the opposite
+  vertices of the triangles on the edge, any other one would end up on an edge with
+  more than two triangles or on a duplicate face*/
+bool MeshSimplifier::breaksLink(unsigned int from, unsigned int to) const
+{
+    std::vector<unsigned int> ringFrom, ringTo, opposite;
+
+    for (unsigned int t : vertTris[from])
+    {
+        if (!triAlive[t]) continue;
+
+        const unsigned int* tc = &tris[t * 3];
+        bool onEdge = tc[0] == to || tc[1] == to || tc[2] == to;
+
+        for (int k = 0; k < 3; k++)
+        {
+            if (tc[k] == from || tc[k] == to) continue;
+
+            ringFrom.push_back(tc[k]);
+
+            if (onEdge) opposite.push_back(tc[k]);
+        }
+    }
+
+    for (unsigned int t : vertTris[to])
+    {
+        if (!triAlive[t]) continue;
+
+        const unsigned int* tc = &tris[t * 3];
+
+        for (int k = 0; k < 3; k++)
+        {
+            if (tc[k] != from && tc[k] != to) ringTo.push_back(tc[k]);
+        }
+    }
+
+    std::sort(ringFrom.begin(), ringFrom.end());
+    std::sort(ringTo.begin(), ringTo.end());
+    std::sort(opposite.begin(), opposite.end());
+
+    for (unsigned int v : ringFrom)
+    {
+        if (std::binary_search(ringTo.begin(), ringTo.end(), v) &&
+            !std::binary_search(opposite.begin(), opposite.end(), v))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*reject collapses that would turn a remaining triangle upside down*/
+bool MeshSimplifier::collapseFlips(unsigned int from, unsigned int to) const
+{
+    const float* pt = position(to);
+
+    for (unsigned int t : vertTris[from])
+    {
+        if (!triAlive[t]) continue;
+
+        const unsigned int* tc = &tris[t * 3];
+
+        if (tc[0] == to || tc[1] == to || tc[2] == to)
+        {
+            continue;
+        }
+
+        const float* p[3];
+        const float* q[3];
+
+        for (int k = 0; k < 3; k++)
+        {
+            p[k] = position(tc[k]);
+            q[k] = tc[k] == from ? pt : p[k];
+        }
+
+        double a1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+        double a2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+        double b1[3] = { q[1][0] - q[0][0], q[1][1] - q[0][1], q[1][2] - q[0][2] };
+        double b2[3] = { q[2][0] - q[0][0], q[2][1] - q[0][1], q[2][2] - q[0][2] };
+
+        double n0[3] = { a1[1] * a2[2] - a1[2] * a2[1], a1[2] * a2[0] - a1[0] * a2[2], a1[0] * a2[1] - a1[1] * a2[0] };
+        double n1[3] = { b1[1] * b2[2] - b1[2] * b2[1], b1[2] * b2[0] - b1[0] * b2[2], b1[0] * b2[1] - b1[1] * b2[0] };
+
+        if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] <= 0.0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MeshSimplifier::snapshot(SimplifyResult& r, double worstCost) const
+{
+    r.indices.clear();
+    r.indices.reserve(liveTris * 3);
+
+    for (size_t t = 0; t < triAlive.size(); t++)
+    {
+        if (!triAlive[t]) continue;
+
+        r.indices.push_back(tris[t * 3 + 0]);
+        r.indices.push_back(tris[t * 3 + 1]);
+        r.indices.push_back(tris[t * 3 + 2]);
+    }
+
+    r.triangleCount = liveTris;
+    r.error = (float)(sqrt(worstCost) / extent);
+}
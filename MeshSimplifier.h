@@ -0,0 +1,82 @@
+/* MeshSimplifier.h
+
+quadric error metric mesh simplification (Garland & Heckbert)
+
+collapses edges onto one of their end points, so no new vertices are
+created and the simplified index lists can share the vertex buffer of
+the original mesh. only depends on the standard library.
+
+    Usage:
+    MeshSimplifier s(&vertices[0].Pos.x, sizeof(Vertex::Standard), vertices.size(), indices);
+    std::vector<SimplifyResult> chain = s.SimplifyChain({ 0.5f, 0.25f }, 0.05f);
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+struct SimplifyResult
+{
+    std::vector<unsigned int> indices;
+    size_t triangleCount = 0;
+    /*error of the worst collapse, relative to the mesh extent*/
+    float error = 0.f;
+};
+
+class MeshSimplifier
+{
+public:
+    MeshSimplifier(const float* positions, size_t stride, size_t vertexCount, const std::vector<unsigned int>& indices);
+
+    /*simplify towards targetRatio * triangle count, stop early if maxError is reached*/
+    SimplifyResult Simplify(float targetRatio, float maxError);
+
+    /*one collapse sequence, snapshot taken every time a ratio is reached (ratios descending)*/
+    std::vector<SimplifyResult> SimplifyChain(const std::vector<float>& targetRatios, float maxError);
+
+private:
+
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+
+        void add(const Quadric& q);
+        double evaluate(const float* p) const;
+    };
+
+    struct Collapse
+    {
+        double cost;
+        unsigned int from, to;
+        unsigned int fromVersion, toVersion;
+
+        bool operator<(const Collapse& o) const { return cost > o.cost; }
+    };
+
+    const float* position(unsigned int v) const;
+    void pushEdges(unsigned int v, std::vector<Collapse>& heap);
+    bool collapseFlips(unsigned int from, unsigned int to) const;
+    bool breaksLink(unsigned int from, unsigned int to) const;
+    void snapshot(SimplifyResult& r, double worstCost) const;
+
+    const float* positions;
+    size_t stride;
+    size_t vertexCount;
+    std::vector<unsigned int> source;
+
+    /*working state*/
+    std::vector<unsigned int> tris;
+    std::vector<bool> triAlive;
+    std::vector<std::vector<unsigned int>> vertTris;
+    std::vector<Quadric> quadrics;
+    std::vector<bool> locked;
+    std::vector<bool> removed;
+    std::vector<unsigned int> version;
+    size_t liveTris = 0;
+    double extent = 1.0;
+};
@@ -1,7 +1,12 @@
 #include "Model.h"
+#include "MeshSimplifier.h"
+#include "TangentSpace.h"
+#include <algorithm>
+#include <execution>
 
 
-Model::Model(ID3D11Device* dev)
+/*meshes are added one at a time unless ReserveMeshes knows the count*/
+Model::Model(ID3D11Device* dev) : meshPool(1)
 {
     device = dev;
     axisRot = XMMatrixRotationRollPitchYaw(XMConvertToRadians(90), 0.f, 0.f);
@@ -9,11 +14,19 @@ Model::Model(ID3D11Device* dev)
 
 Model::~Model()
 {
-    for (auto& i : meshes)
-    {
-        delete i;
-    }
-    
+    /*meshes are destroyed with the pool*/
+    meshes.clear();
+}
+
+Mesh* Model::CreateMesh()
+{
+    return meshPool.Create();
+}
+
+void Model::ReserveMeshes(size_t count)
+{
+    meshes.reserve(count);
+    meshPool.Reserve(count);
 }
 
 /*create vertex and indexbuffers for all meshes of the model*/
@@ -28,3 +41,123 @@ void Model::CreateBuffers()
     }
 
 }
+
+/*repair missing or broken normals and tangents of all meshes in parallel, may add vertices at mirrored uv seams*/
+void Model::GenerateTangentSpace()
+{
+    std::for_each(std::execution::par, meshes.begin(), meshes.end(), [](Mesh* m)
+    {
+        std::vector<TangentVertex> vertices(m->vertices.size());
+
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const Vertex::Standard& v = m->vertices[i];
+            vertices[i] = { { v.Pos.x, v.Pos.y, v.Pos.z }, { v.Tex.x, v.Tex.y },
+                            { v.Normal.x, v.Normal.y, v.Normal.z }, { v.TangentU.x, v.TangentU.y, v.TangentU.z, v.TangentU.w } };
+        }
+
+        TangentSpaceReport r = TangentSpace::Process(vertices, m->indices);
+
+        if (r.normalsGenerated)
+            DBOUT("Regenerated normals for " << m->vertices.size() << " vertices" << std::endl);
+
+        if (r.tangentsGenerated)
+            DBOUT("Regenerated tangents for " << m->vertices.size() << " vertices, " << r.splitVertices << " split at mirrored uv seams" << std::endl);
+
+        m->vertices.resize(vertices.size());
+
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const TangentVertex& v = vertices[i];
+            m->vertices[i] = Vertex::Standard(v.position[0], v.position[1], v.position[2], v.uv[0], v.uv[1],
+                                              v.normal[0], v.normal[1], v.normal[2], v.tangent[0], v.tangent[1], v.tangent[2]);
+            m->vertices[i].TangentU.w = v.tangent[3];
+        }
+
+        m->hasTextureCoordinates = r.hasTextureCoordinates;
+        m->hasTangentu = true;
+    });
+}
+
+/*split large meshes into clusters, reorders the indices so this has to run before GenerateLODs*/
+void Model::GenerateClusters()
+{
+    for (auto& m : meshes)
+    {
+        m->clusters.clear();
+
+        if (m->indices.size() / 3 < CLUSTER_MIN_TRIANGLES)
+        {
+            continue;
+        }
+
+        MeshClusterizer clusterizer(&m->vertices[0].Pos.x, sizeof(Vertex::Standard), m->vertices.size());
+        m->clusters = clusterizer.Build(m->indices, CLUSTER_MAX_VERTICES, CLUSTER_MAX_TRIANGLES);
+
+        DBOUT("Clusters: " << m->clusters.size() << " for " << m->indices.size() / 3 << " triangles" << std::endl);
+    }
+}
+
+/*build simplified index lists for every mesh that is large enough*/
+void Model::GenerateLODs(const LODSettings& settings)
+{
+    lodScreenSizes = settings.screenSizes;
+    lodErrors.assign(settings.targetRatios.size() + 1, 0.f);
+
+    for (auto& m : meshes)
+    {
+        MeshLOD full;
+        full.indexCount = (UINT)m->indices.size();
+
+        m->lods.clear();
+        m->lodIndices.clear();
+        m->lods.push_back(full);
+
+        if (m->indices.size() / 3 < settings.minTriangles)
+        {
+            continue;
+        }
+
+        MeshSimplifier simplifier(&m->vertices[0].Pos.x, sizeof(Vertex::Standard), m->vertices.size(), m->indices);
+        std::vector<SimplifyResult> chain = simplifier.SimplifyChain(settings.targetRatios, settings.maxError);
+
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            /*error bound reached, reuse the previous level*/
+            if (chain[i].indices.size() >= m->lods.back().indexCount)
+            {
+                m->lods.push_back(m->lods.back());
+                lodErrors[i + 1] = (std::max)(lodErrors[i + 1], m->lods.back().error);
+                continue;
+            }
+
+            MeshLOD l;
+            l.startIndex = (UINT)(m->indices.size() + m->lodIndices.size());
+            l.indexCount = (UINT)chain[i].indices.size();
+            l.error = chain[i].error;
+
+            m->lodIndices.insert(m->lodIndices.end(), chain[i].indices.begin(), chain[i].indices.end());
+            m->lods.push_back(l);
+            lodErrors[i + 1] = (std::max)(lodErrors[i + 1], l.error);
+
+            DBOUT("LOD " << i + 1 << ": " << chain[i].triangleCount << " of " << full.indexCount / 3
+                  << " triangles, error " << chain[i].error << std::endl);
+        }
+    }
+}
+
+/*pick the level of detail for the size of the model on screen (fraction of viewport height)*/
+UINT Model::SelectLOD(float screenSize)
+{
+    UINT lod = 0;
+
+    for (size_t i = 0; i < lodScreenSizes.size(); i++)
+    {
+        if (screenSize < lodScreenSizes[i])
+        {
+            lod = (UINT)i + 1;
+        }
+    }
+
+    return lod;
+}
@@ -1,24 +1,28 @@
 #pragma once
 
 #include "util.h"
+#include "MeshClusterizer.h"
+#include "Allocator.h"
 
 namespace Vertex
 {
 
     struct Standard
     {
-        Standard(XMFLOAT3 p, XMFLOAT2 t, XMFLOAT3 n, XMFLOAT3 tu) : Pos(p), Tex(t), Normal(n), TangentU(tu) {}
+        Standard(XMFLOAT3 p, XMFLOAT2 t, XMFLOAT3 n, XMFLOAT3 tu) : Pos(p), Tex(t), Normal(n), TangentU(tu.x, tu.y, tu.z, 1.f) {}
         Standard() : Pos(), Tex(), Normal(), TangentU() { RtlSecureZeroMemory(this, sizeof(this)); }
         Standard(float px, float py, float pz,
                         float u, float v,
                         float nx, float ny, float nz,
                         float tx, float ty, float tz
                         )
-            : Pos(px, py, pz), Tex(u,v), Normal(nx,ny,nz), TangentU(tx,ty,tz){ }
+            : Pos(px, py, pz), Tex(u,v), Normal(nx,ny,nz), TangentU(tx,ty,tz,1.f){ }
         XMFLOAT3 Pos;
         XMFLOAT2 Tex;
         XMFLOAT3 Normal;
-        XMFLOAT3 TangentU;
+
+        /*w is the handedness, bitangent = w * cross(normal, tangent)*/
+        XMFLOAT4 TangentU;
     };
 
     struct StandardSkinned
@@ -103,6 +107,14 @@ struct SpotLight
     float Pad; // Pad the last float so we can set an array of lights if we wanted.
 };
 
+/*index range of one level of detail inside the index buffer*/
+struct MeshLOD
+{
+    UINT startIndex = 0;
+    UINT indexCount = 0;
+    float error = 0.f;
+};
+
 class Mesh
 {
 public:
@@ -110,6 +122,13 @@ public:
     std::vector<UINT> indices;
     Material::Standard material;
 
+    /*lods[0] is the full mesh, lodIndices are appended behind indices in the index buffer*/
+    std::vector<MeshLOD> lods;
+    std::vector<UINT> lodIndices;
+
+    /*clusters of lods[0] in mesh space, empty for small meshes*/
+    std::vector<MeshCluster> clusters;
+
     bool hasTextureCoordinates = false;
     bool hasTangentu = false;
 
@@ -118,6 +137,13 @@ public:
     std::string normalMapID;
     std::string bumpMapID;
 
+    /*uvs moved onto an atlas page, uv = atlasOffset + uv * atlasScale, see TexturePacker.h*/
+    bool inAtlas = false;
+    XMFLOAT2 atlasScale = XMFLOAT2(1.f, 1.f);
+    XMFLOAT2 atlasOffset = XMFLOAT2(0.f, 0.f);
+    std::string unpackedDiffuseMapID;
+    std::string unpackedNormalMapID;
+
     ~Mesh()
     {
         DXRelease(vertex);
@@ -125,9 +151,23 @@ public:
     }
 
 
+    const MeshLOD& getLOD(UINT lod) const
+    {
+        return lods[lod < lods.size() ? lod : lods.size() - 1];
+    }
+
     /*create vertex and index buffer on gpu*/
     void createBuffers(ID3D11Device* device)
     {
+        if (lods.empty())
+        {
+            MeshLOD full;
+            full.indexCount = (UINT)indices.size();
+            lods.push_back(full);
+        }
+
+        std::vector<UINT> allIndices(indices);
+        allIndices.insert(allIndices.end(), lodIndices.begin(), lodIndices.end());
 
         D3D11_BUFFER_DESC vbd;
         vbd.Usage = D3D11_USAGE_IMMUTABLE;
@@ -143,12 +183,12 @@ public:
 
         D3D11_BUFFER_DESC ibd;
         ibd.Usage = D3D11_USAGE_IMMUTABLE;
-        ibd.ByteWidth = (UINT)(sizeof(UINT) * indices.size());
+        ibd.ByteWidth = (UINT)(sizeof(UINT) * allIndices.size());
         ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
         ibd.CPUAccessFlags = 0;
         ibd.MiscFlags = 0;
 
-        initData.pSysMem = &indices[0];
+        initData.pSysMem = &allIndices[0];
 
         device->CreateBuffer(&ibd, &initData, &index);
 
@@ -157,6 +197,15 @@ public:
 };
 
 
+/*settings for the generated level of detail chain, one screen size per ratio*/
+struct LODSettings
+{
+    std::vector<float> targetRatios = { 0.5f, 0.25f, 0.1f };
+    std::vector<float> screenSizes = { 0.25f, 0.12f, 0.05f };
+    float maxError = LOD_MAX_ERROR;
+    UINT minTriangles = LOD_MIN_TRIANGLES;
+};
+
 class Model
 {
 
@@ -168,9 +217,23 @@ public:
 
     void CreateBuffers();
 
+    /*meshes are owned by the model*/
+    Mesh* CreateMesh();
+    void ReserveMeshes(size_t count);
+
+    void GenerateTangentSpace();
+    void GenerateClusters();
+    void GenerateLODs(const LODSettings& settings);
+    UINT SelectLOD(float screenSize);
+
+    std::vector<float> lodScreenSizes;
+
+    /*worst simplification error of every level over all meshes, relative to the mesh extent, lodErrors[0] is 0*/
+    std::vector<float> lodErrors;
+
     XMMATRIX axisRot;
 private:
     ID3D11Device* device;
-    
+    ObjectPool<Mesh> meshPool;
 
 };
\ No newline at end of file
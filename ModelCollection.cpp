@@ -55,6 +55,10 @@ bool ModelCollection::Add(std::string file)
         return false;
     }
 
+    m->GenerateClusters();
+    m->GenerateLODs(LODSettings());
+    packMeshes(m);
+
     return AddModel(id, m);
 }
 
@@ -108,181 +112,100 @@ bool ModelCollection::SetDefaultModel(std::string id)
     return true;
 }
 
-/*create a basic cube*/
-Model* ModelCollection::CreateCubeModel(float width, float height, float depth)
+/*memoized primitive, the key of the description is the model id*/
+std::string ModelCollection::AddPrimitive(const PrimitiveDesc& desc)
 {
-    Model* model = new Model(device);
-    Mesh* mesh = new Mesh();
-    Material::Standard mat;
-    Vertex::Standard v[24];
-
-    float w = width * .5f;
-    float h = height * .5f;
-    float d = depth * .5f;
-
-    /*define faces*/
-    v[0] = Vertex::Standard(XMFLOAT3(-w, -h, -d), XMFLOAT2(0.f, 1.f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f));
-    v[1] = Vertex::Standard(XMFLOAT3(-w, +h, -d), XMFLOAT2(0.f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f));
-    v[2] = Vertex::Standard(XMFLOAT3(+w, +h, -d), XMFLOAT2(1.f, 0.f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f));
-    v[3] = Vertex::Standard(XMFLOAT3(+w, -h, -d), XMFLOAT2(1.f, 1.f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f));
-
-    v[4] = Vertex::Standard(-w, -h, +d, 1.f, 1.f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f);
-    v[5] = Vertex::Standard(+w, -h, +d, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f);
-    v[6] = Vertex::Standard(+w, +h, +d, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f);
-    v[7] = Vertex::Standard(-w, +h, +d, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f);
-
-    v[8] = Vertex::Standard(-w, +h, -d, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-    v[9] = Vertex::Standard(-w, +h, +d, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-    v[10] = Vertex::Standard(+w, +h, +d, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-    v[11] = Vertex::Standard(+w, +h, -d, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f);
-
-    v[12] = Vertex::Standard(-w, -h, -d, 1.0f, 1.0f, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-    v[13] = Vertex::Standard(+w, -h, -d, 0.0f, 1.0f, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-    v[14] = Vertex::Standard(+w, -h, +d, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-    v[15] = Vertex::Standard(-w, -h, +d, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f);
-
-    v[16] = Vertex::Standard(-w, -h, +d, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f);
-    v[17] = Vertex::Standard(-w, +h, +d, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f);
-    v[18] = Vertex::Standard(-w, +h, -d, 1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f);
-    v[19] = Vertex::Standard(-w, -h, -d, 1.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f);
-
-    v[20] = Vertex::Standard(+w, -h, -d, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-    v[21] = Vertex::Standard(+w, +h, -d, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-    v[22] = Vertex::Standard(+w, +h, +d, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-    v[23] = Vertex::Standard(+w, -h, +d, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
-    
-    mesh->hasTextureCoordinates = true;
-    mesh->hasTangentu = true;
-
-    mesh->diffuseMapID = "default";
-
-    mesh->vertices.assign(&v[0], &v[24]);
-
-    /*indices*/
-    UINT i[36];
-
-    i[0] = 0; i[1] = 1; i[2] = 2;
-    i[3] = 0; i[4] = 2; i[5] = 3;
-    i[6] = 4; i[7] = 5; i[8] = 6;
-    i[9] = 4; i[10] = 6; i[11] = 7;
-    i[12] = 8; i[13] = 9; i[14] = 10;
-    i[15] = 8; i[16] = 10; i[17] = 11;
-    i[18] = 12; i[19] = 13; i[20] = 14;
-    i[21] = 12; i[22] = 14; i[23] = 15;
-    i[24] = 16; i[25] = 17; i[26] = 18;
-    i[27] = 16; i[28] = 18; i[29] = 19;
-    i[30] = 20; i[31] = 21; i[32] = 22;
-    i[33] = 20; i[34] = 22; i[35] = 23;
-
-    mesh->indices.assign(&i[0], &i[36]);
+    /*every distinct tiling would be a model of its own, round to steps so similar scales share one*/
+    PrimitiveDesc shared = desc;
+    shared.tiling.x = quantizeTiling(desc.tiling.x);
+    shared.tiling.y = quantizeTiling(desc.tiling.y);
+    shared.tiling.z = quantizeTiling(desc.tiling.z);
 
-    model->collisionBox.CreateFromPoints(model->collisionBox, 24, &v[0].Pos, sizeof(Vertex::Standard));
+    std::string id = shared.Key();
 
-    /*material*/
-
-    mat.Ambient = XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f);
-    mat.Diffuse = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-    mat.Specular = XMFLOAT4(0.6f, 0.6f, 0.6f, 16.0f);
-
-    mesh->material = mat;
-
-    /*mesh in model*/
-    model->meshes.clear();
-    model->meshes.push_back(mesh);
-    model->axisRot = XMMatrixIdentity();
+    if (collection.find(id) == collection.end())
+    {
+        AddModel(id, CreatePrimitiveModel(shared));
+    }
 
-    return model;
+    return id;
 }
 
-/*create a basic sphere*/
-Model* ModelCollection::CreateSphereModel(float radius, int slices, int stacks)
+float ModelCollection::quantizeTiling(float tiling)
 {
-    Model* model = new Model(device);
-    Mesh* mesh = new Mesh();
-    Material::Standard mat;
-                                //pos             //tex     //normal       //tang
-    Vertex::Standard top(0.f, radius, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 1.f, 0.f, 0.f);
-    Vertex::Standard bot(0.f, -radius, 0.f, 0.f, 1.f,0.f, -1.f, 0.f, 1.f, 0.f, 0.f);
-
-    mesh->vertices.clear();
-    mesh->indices.clear();
-
-    mesh->vertices.push_back(top);
-
-    float phiStep = XM_PI / stacks;
-    float thetaStep = XM_PI * 2.f / slices;
+    float steps = roundf(tiling / PRIMITIVE_TILING_STEP);
 
+    return (std::max)(steps, 1.f) * PRIMITIVE_TILING_STEP;
+}
 
-    for (int i = 1; i <= stacks - 1; i++)
+bool ModelCollection::ReadTextureAtlas(const std::string& file)
+{
+    if (!atlas.Read(file))
     {
-        float phi = i * phiStep;
-
-        for (int j = 0; j <= slices; ++j)
-        {
-            float theta = j * thetaStep;
-
-            Vertex::Standard v;
+        DBOUT("no texture atlas in " << file.c_str() << endl);
+        return false;
+    }
 
-            v.Pos.x = radius * sinf(phi) * cosf(theta);
-            v.Pos.y = radius * cosf(phi);
-            v.Pos.z = radius * sinf(phi) * sinf(theta);
+    DBOUT("texture atlas with " << atlas.Size() << " textures" << endl);
+    return true;
+}
 
-            v.TangentU.x = -radius * sinf(phi) * sinf(theta);
-            v.TangentU.y = 0.0f;
-            v.TangentU.z = +radius * sinf(phi) * cosf(theta);
+/*move the uvs of meshes onto the atlas page of their textures*/
+void ModelCollection::packMeshes(Model* m)
+{
+    if (atlas.Size() == 0)
+        return;
 
-            XMVECTOR T = XMLoadFloat3(&v.TangentU);
-            XMStoreFloat3(&v.TangentU, XMVector3Normalize(T));
+    for (auto& mesh : m->meshes)
+    {
+        AtlasPlacement p;
 
-            XMVECTOR p = XMLoadFloat3(&v.Pos);
-            XMStoreFloat3(&v.Normal, XMVector3Normalize(p));
+        if (!mesh->hasTextureCoordinates || !atlas.Find(mesh->diffuseMapID, mesh->normalMapID, p))
+            continue;
 
-            v.Tex.x = theta / XM_2PI;
-            v.Tex.y = phi / XM_PI;
+        /*tiled uvs repeat the texture, that does not work inside a page*/
+        bool inside = true;
 
-            mesh->vertices.push_back(v);
+        for (auto& v : mesh->vertices)
+        {
+            if (v.Tex.x < -ATLAS_UV_EPSILON || v.Tex.x > 1.f + ATLAS_UV_EPSILON ||
+                v.Tex.y < -ATLAS_UV_EPSILON || v.Tex.y > 1.f + ATLAS_UV_EPSILON)
+            {
+                inside = false;
+                break;
+            }
         }
-    }
-
-    mesh->vertices.push_back(bot);
 
-    //indices
+        if (!inside)
+            continue;
 
-    for (int i = 1; i <= slices; ++i)
-    {
-        mesh->indices.push_back(0);
-        mesh->indices.push_back(i + 1);
-        mesh->indices.push_back(i);
-    }
-
-    int baseIndex = 1;
-    int ringVertexCount = slices + 1;
-    for (int i = 0; i < stacks - 2; ++i)
-    {
-        for (int j = 0; j < slices; ++j)
+        for (auto& v : mesh->vertices)
         {
-            mesh->indices.push_back(baseIndex + i * ringVertexCount + j);
-            mesh->indices.push_back(baseIndex + i * ringVertexCount + j + 1);
-            mesh->indices.push_back(baseIndex + (i + 1) * ringVertexCount + j);
-
-            mesh->indices.push_back(baseIndex + (i + 1) * ringVertexCount + j);
-            mesh->indices.push_back(baseIndex + i * ringVertexCount + j + 1);
-            mesh->indices.push_back(baseIndex + (i + 1) * ringVertexCount + j + 1);
+            v.Tex.x = p.offset[0] + v.Tex.x * p.scale[0];
+            v.Tex.y = p.offset[1] + v.Tex.y * p.scale[1];
         }
-    }
 
-    int southPoleIndex = (int)mesh->vertices.size() - 1;
+        mesh->inAtlas = true;
+        mesh->atlasScale = XMFLOAT2(p.scale[0], p.scale[1]);
+        mesh->atlasOffset = XMFLOAT2(p.offset[0], p.offset[1]);
+        mesh->unpackedDiffuseMapID = mesh->diffuseMapID;
+        mesh->unpackedNormalMapID = mesh->normalMapID;
+        mesh->diffuseMapID = p.page;
 
-    baseIndex = southPoleIndex - ringVertexCount;
-
-    for (int i = 0; i < slices; ++i)
-    {
-        mesh->indices.push_back(southPoleIndex);
-        mesh->indices.push_back(baseIndex + i);
-        mesh->indices.push_back(baseIndex + i + 1);
+        if (!mesh->normalMapID.empty())
+            mesh->normalMapID = p.normalPage;
     }
+}
+
+/*create a model with one mesh of the described primitive*/
+Model* ModelCollection::CreatePrimitiveModel(const PrimitiveDesc& desc)
+{
+    Model* model = new Model(device);
+    Mesh* mesh = model->CreateMesh();
+    PrimitiveGenerator::Create(desc, mesh);
+    Material::Standard mat;
 
-    model->collisionBox.CreateFromPoints(model->collisionBox, 24, &mesh->vertices[0].Pos, sizeof(Vertex::Standard));
+    model->collisionBox.CreateFromPoints(model->collisionBox, mesh->vertices.size(), &mesh->vertices[0].Pos, sizeof(Vertex::Standard));
 
     /*material*/
 
@@ -301,68 +224,34 @@ Model* ModelCollection::CreateSphereModel(float radius, int slices, int stacks)
     return model;
 }
 
-/*create a basic 4 vertices plane which is visible on both sides*/
-Model* ModelCollection::CreatePlaneModel(float width, float height)
+/*create a basic cube*/
+Model* ModelCollection::CreateCubeModel(float width, float height, float depth)
 {
-    Model* model = new Model(device);
-    Mesh* mesh = new Mesh();
-    Material::Standard mat;
-
-    float w = width / 2;
-    float h = height / 2;
-
-    /*4 vertices*/
-
-    mesh->vertices.push_back(Vertex::Standard(XMFLOAT3(-w, 0.f, -h),       //pos
-                             XMFLOAT2(0.f, 1.f),    //u v coord
-                             XMFLOAT3(0.f, 1.f, 0.f),   //normal
-                             XMFLOAT3(1.f, 0.f, 0.f))); //tangent
-    mesh->vertices.push_back(Vertex::Standard(XMFLOAT3(-w, 0.f, h),       //pos
-                             XMFLOAT2(0.f, 0.f),    //u v coord
-                             XMFLOAT3(0.f, 1.f, 0.f),   //normal
-                             XMFLOAT3(1.f, 0.f, 0.f))); //tangent
-    mesh->vertices.push_back(Vertex::Standard(XMFLOAT3(w, 0.f, h),       //pos
-                             XMFLOAT2(1.f, 0.f),    //u v coord
-                             XMFLOAT3(0.f, 1.f, 0.f),   //normal
-                             XMFLOAT3(1.f, 0.f, 0.f))); //tangent
-    mesh->vertices.push_back(Vertex::Standard(XMFLOAT3(w, 0.f, -h),       //pos
-                             XMFLOAT2(1.f, 1.f),    //u v coord
-                             XMFLOAT3(0.f, 1.f, 0.f),   //normal
-                             XMFLOAT3(1.f, 0.f, 0.f))); //tangent
-
-    /*indices, plane is visible on both sides*/
-    mesh->indices.push_back(0);
-    mesh->indices.push_back(1);
-    mesh->indices.push_back(2);
-
-    mesh->indices.push_back(0);
-    mesh->indices.push_back(2);
-    mesh->indices.push_back(3);
+    PrimitiveDesc desc;
+    desc.shape = PrimitiveShape::Box;
+    desc.size = XMFLOAT3(width, height, depth);
 
-    mesh->indices.push_back(0);
-    mesh->indices.push_back(2);
-    mesh->indices.push_back(1);
-
-    mesh->indices.push_back(0);
-    mesh->indices.push_back(3);
-    mesh->indices.push_back(2);
-
-    model->collisionBox.CreateFromPoints(model->collisionBox, 24, &mesh->vertices[0].Pos, sizeof(Vertex::Standard));
-
-
-    /*material*/
-    mat.Ambient = XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f);
-    mat.Diffuse = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
-    mat.Specular = XMFLOAT4(0.6f, 0.6f, 0.6f, 16.0f);
-
-    mesh->material = mat;
+    return CreatePrimitiveModel(desc);
+}
 
-    mesh->diffuseMapID = "default";
+/*create a basic sphere*/
+Model* ModelCollection::CreateSphereModel(float radius, int slices, int stacks)
+{
+    PrimitiveDesc desc;
+    desc.shape = PrimitiveShape::UVSphere;
+    desc.size = XMFLOAT3(radius, radius, radius);
+    desc.tessellation[0] = slices;
+    desc.tessellation[1] = stacks;
 
+    return CreatePrimitiveModel(desc);
+}
 
-    model->meshes.clear();
-    model->meshes.push_back(mesh);
-    model->axisRot = XMMatrixIdentity();
+/*create a basic 4 vertices plane which is visible on both sides*/
+Model* ModelCollection::CreatePlaneModel(float width, float height)
+{
+    PrimitiveDesc desc;
+    desc.shape = PrimitiveShape::Plane;
+    desc.size = XMFLOAT3(width, 0.f, height);
 
-    return model;
+    return CreatePrimitiveModel(desc);
 }
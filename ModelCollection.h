@@ -2,6 +2,8 @@
 
 #include "util.h"
 #include "ModelLoader.h"
+#include "PrimitiveGenerator.h"
+#include "TexturePacker.h"
 
 class ModelCollection
 {
@@ -17,8 +19,19 @@ public:
     Model* CreateCubeModel(float width, float height, float depth);
     Model* CreateSphereModel(float radius, int slices, int stacks);
     Model* CreatePlaneModel(float width, float height);
+    Model* CreatePrimitiveModel(const PrimitiveDesc& desc);
+
+    /*returns the id of the primitive, created on first use, tiling is rounded to PRIMITIVE_TILING_STEP*/
+    std::string AddPrimitive(const PrimitiveDesc& desc);
+
+    /*models added afterwards draw meshes with textures in the atlas from its pages*/
+    bool ReadTextureAtlas(const std::string& file);
 
 private:
+    void packMeshes(Model* m);
+    static float quantizeTiling(float tiling);
+
+    TextureAtlas atlas;
     ModelLoader* loader;
     std::map<std::string, Model*> collection;
     ID3D11Device* device;
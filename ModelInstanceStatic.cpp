@@ -27,7 +27,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
 {
     if (isInvisible) return;
 
-    Model* model = resources->getModel(modelID);
+    Model* model = getModel();
 
     XMMATRIX _r = XMMatrixRotationRollPitchYaw(Rotation.x, Rotation.y, Rotation.z);
     XMMATRIX _t = XMMatrixTranslation(Translation.x, Translation.y, Translation.z);
@@ -40,6 +40,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
     XMMATRIX viewProj = c->getViewProj();
 
     XMMATRIX world = XMLoadFloat4x4(&World);
+    UINT lod = selectLOD(model, c, world);
     XMMATRIX wvp = world * view * proj;
 
     XMMATRIX wit = DXMath::InverseTranspose(world);
@@ -94,16 +95,9 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                             Shaders::basicTextureShader->SetWorldInvTranspose(wit);
                             Shaders::basicTextureShader->SetMaterial(m->material);
 
-                            if (useOverwriteDiffuse)
-                            {
-                                Shaders::basicTextureShader->SetTexture(resources->getTexture(ovrwrTex));
-                            }
-                            else
-                            {
-                                Shaders::basicTextureShader->SetTexture(resources->getTexture(m->diffuseMapID));
-                            }
+                            Shaders::basicTextureShader->SetTexture(resources->getTexture(getDiffuseMapID(m)));
 
-                            Shaders::basicTextureShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::basicTextureShader->SetTexTransform(getTexTransform(m));
                             Shaders::basicTextureShader->SetShadowTransform(world * shadowT);
                             break;
 
@@ -113,16 +107,9 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                             Shaders::basicTextureShader->SetWorldInvTranspose(wit);
                             Shaders::basicTextureShader->SetMaterial(m->material);
 
-                            if (useOverwriteDiffuse)
-                            {
-                                Shaders::basicTextureShader->SetTexture(resources->getTexture(ovrwrTex));
-                            }
-                            else
-                            {
-                                Shaders::basicTextureShader->SetTexture(resources->getTexture(m->diffuseMapID));
-                            }
+                            Shaders::basicTextureShader->SetTexture(resources->getTexture(getDiffuseMapID(m)));
 
-                            Shaders::basicTextureShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::basicTextureShader->SetTexTransform(getTexTransform(m));
                             Shaders::basicTextureShader->SetShadowTransform(world * shadowT);
                             break;
 
@@ -133,16 +120,9 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                             Shaders::basicTextureShader->SetWorldInvTranspose(wit);
                             Shaders::basicTextureShader->SetMaterial(m->material);
 
-                            if (useOverwriteDiffuse)
-                            {
-                                Shaders::basicTextureShader->SetTexture(resources->getTexture(ovrwrTex));
-                            }
-                            else
-                            {
-                                Shaders::basicTextureShader->SetTexture(resources->getTexture(m->diffuseMapID));
-                            }
+                            Shaders::basicTextureShader->SetTexture(resources->getTexture(getDiffuseMapID(m)));
 
-                            Shaders::basicTextureShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::basicTextureShader->SetTexTransform(getTexTransform(m));
                             Shaders::basicTextureShader->SetShadowTransform(world * shadowT);
                             break;
 
@@ -151,7 +131,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                             Shaders::basicTextureShader->SetWorldInvTranspose(wit);
                             Shaders::basicTextureShader->SetWorldViewProj(wvp);
                             Shaders::basicTextureShader->SetMaterial(m->material);
-                            Shaders::basicTextureShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::basicTextureShader->SetTexTransform(getTexTransform(m));
                             Shaders::basicTextureShader->SetShadowTransform(world* shadowT);
                             break;
 
@@ -166,25 +146,11 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                             Shaders::normalMapShader->SetWorldInvTranspose(wit);
                             Shaders::normalMapShader->SetMaterial(m->material);
 
-                            if (useOverwriteDiffuse)
-                            {
-                                Shaders::normalMapShader->SetTexture(resources->getTexture(ovrwrTex));
-                            }
-                            else
-                            {
-                                Shaders::normalMapShader->SetTexture(resources->getTexture(m->diffuseMapID));
-                            }
+                            Shaders::normalMapShader->SetTexture(resources->getTexture(getDiffuseMapID(m)));
 
-                            if (useOverwriteNormalMap)
-                            {
-                                Shaders::normalMapShader->SetNormalMap(resources->getTexture(ovrwrNrm));
-                            }
-                            else
-                            {
-                                Shaders::normalMapShader->SetNormalMap(resources->getTexture(m->normalMapID));
-                            }
+                            Shaders::normalMapShader->SetNormalMap(resources->getTexture(getNormalMapID(m)));
 
-                            Shaders::normalMapShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::normalMapShader->SetTexTransform(getTexTransform(m));
                             Shaders::normalMapShader->SetShadowTransform(world* shadowT);
                             break;
                     }
@@ -194,7 +160,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
 
             /*apply and draw*/
             tech->GetPassByIndex(p)->Apply(0, deviceContext);
-            deviceContext->DrawIndexed((UINT)(m->indices.size()), 0, 0);
+            drawMesh(deviceContext, m, lod, c, world);
         }
 
 
@@ -209,7 +175,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
 
 void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* deviceContext, Camera* c, XMMATRIX shadowT, ID3D11ShaderResourceView* srv)
 {
-    Model* model = resources->getModel(modelID);
+    Model* model = getModel();
 
     XMMATRIX _r = XMMatrixRotationRollPitchYaw(Rotation.x, Rotation.y, Rotation.z);
     XMMATRIX _t = XMMatrixTranslation(Translation.x, Translation.y, Translation.z);
@@ -222,6 +188,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
     XMMATRIX viewProj = c->getViewProj();
 
     XMMATRIX world = XMLoadFloat4x4(&World);
+    UINT lod = selectLOD(model, c, world);
     XMMATRIX wvp = world * view * proj;
 
     XMMATRIX wit = DXMath::InverseTranspose(world);
@@ -284,7 +251,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                                 Shaders::basicTextureShader->SetTexture(srv);
                             }
 
-                            Shaders::basicTextureShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::basicTextureShader->SetTexTransform(unpackTransform(m) * XMLoadFloat4x4(&TextureTransform));
                             Shaders::basicTextureShader->SetShadowTransform(world * shadowT);
                             break;
 
@@ -304,7 +271,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                                 Shaders::basicTextureShader->SetTexture(srv);
                             }
 
-                            Shaders::basicTextureShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::basicTextureShader->SetTexTransform(unpackTransform(m) * XMLoadFloat4x4(&TextureTransform));
                             Shaders::basicTextureShader->SetShadowTransform(world * shadowT);
                             break;
 
@@ -313,7 +280,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                             Shaders::basicTextureShader->SetWorldInvTranspose(wit);
                             Shaders::basicTextureShader->SetWorldViewProj(wvp);
                             Shaders::basicTextureShader->SetMaterial(m->material);
-                            Shaders::basicTextureShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::basicTextureShader->SetTexTransform(unpackTransform(m) * XMLoadFloat4x4(&TextureTransform));
                             Shaders::basicTextureShader->SetShadowTransform(world * shadowT);
                             break;
 
@@ -343,10 +310,10 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
                             }
                             else
                             {
-                                Shaders::normalMapShader->SetNormalMap(resources->getTexture(m->normalMapID));
+                                Shaders::normalMapShader->SetNormalMap(resources->getTexture(m->inAtlas ? m->unpackedNormalMapID : m->normalMapID));
                             }
 
-                            Shaders::normalMapShader->SetTexTransform(XMLoadFloat4x4(&TextureTransform));
+                            Shaders::normalMapShader->SetTexTransform(unpackTransform(m) * XMLoadFloat4x4(&TextureTransform));
                             Shaders::normalMapShader->SetShadowTransform(world * shadowT);
                             break;
                     }
@@ -356,7 +323,7 @@ void ModelInstanceStatic::Draw(ID3D11Device* device, ID3D11DeviceContext* device
 
             /*apply and draw*/
             tech->GetPassByIndex(p)->Apply(0, deviceContext);
-            deviceContext->DrawIndexed((UINT)(m->indices.size()), 0, 0);
+            drawMesh(deviceContext, m, lod, c, world);
         }
 
 
@@ -371,7 +338,7 @@ void ModelInstanceStatic::ShadowDraw(ID3D11Device* device, ID3D11DeviceContext*
 {
     if (!castsShadow) return;
 
-    Model* model = resources->getModel(modelID);
+    Model* model = getModel();
 
     XMMATRIX _r = XMMatrixRotationRollPitchYaw(Rotation.x, Rotation.y, Rotation.z);
     XMMATRIX _t = XMMatrixTranslation(Translation.x, Translation.y, Translation.z);
@@ -384,6 +351,7 @@ void ModelInstanceStatic::ShadowDraw(ID3D11Device* device, ID3D11DeviceContext*
     XMMATRIX viewProj = XMMatrixMultiply(view, proj);
 
     XMMATRIX world = XMLoadFloat4x4(&World);
+    UINT lod = selectLOD(model, c, world);
     XMMATRIX wvp = world * view * proj;
 
     XMMATRIX wit = DXMath::InverseTranspose(world);
@@ -416,7 +384,7 @@ void ModelInstanceStatic::ShadowDraw(ID3D11Device* device, ID3D11DeviceContext*
 
             /*apply and draw*/
             tech->GetPassByIndex(p)->Apply(0, deviceContext);
-            deviceContext->DrawIndexed((UINT)(m->indices.size()), 0, 0);
+            drawMesh(deviceContext, m, lod, nullptr, world);
         }
 
 
@@ -440,3 +408,133 @@ void ModelInstanceStatic::OverwriteNormalMap(std::string id)
     useOverwriteNormalMap = true;
     ovrwrNrm = id;
 }
+
+std::string ModelInstanceStatic::getDiffuseMapID(const Mesh* m) const
+{
+    if (useOverwriteDiffuse)
+        return ovrwrTex;
+
+    return unpacked(m) ? m->unpackedDiffuseMapID : m->diffuseMapID;
+}
+
+std::string ModelInstanceStatic::getNormalMapID(const Mesh* m) const
+{
+    if (useOverwriteNormalMap)
+        return ovrwrNrm;
+
+    return unpacked(m) ? m->unpackedNormalMapID : m->normalMapID;
+}
+
+XMMATRIX ModelInstanceStatic::getTexTransform(const Mesh* m) const
+{
+    XMMATRIX t = XMLoadFloat4x4(&TextureTransform);
+
+    return unpacked(m) ? unpackTransform(m) * t : t;
+}
+
+/*the atlas page is only used when nothing else changes the textures or uvs of the mesh*/
+bool ModelInstanceStatic::unpacked(const Mesh* m) const
+{
+    return m->inAtlas && (useOverwriteDiffuse || useOverwriteNormalMap || !XMMatrixIsIdentity(XMLoadFloat4x4(&TextureTransform)));
+}
+
+/*from the atlas page back to the uvs of the texture*/
+XMMATRIX ModelInstanceStatic::unpackTransform(const Mesh* m) const
+{
+    if (!m->inAtlas)
+        return XMMatrixIdentity();
+
+    return XMMatrixTranslation(-m->atlasOffset.x, -m->atlasOffset.y, 0.f) *
+           XMMatrixScaling(1.f / m->atlasScale.x, 1.f / m->atlasScale.y, 1.f);
+}
+
+/*level of detail from the screen size of the transformed bounding sphere*/
+UINT ModelInstanceStatic::selectLOD(Model* model, Camera* c, CXMMATRIX world)
+{
+    BoundingSphere bounds;
+    BoundingSphere::CreateFromBoundingBox(bounds, model->collisionBox);
+    bounds.Transform(bounds, world);
+
+    return model->SelectLOD(c->getProjectedSize(bounds));
+}
+
+/*draw the selected lod, for lod 0 only the clusters inside the frustum and facing the camera*/
+void ModelInstanceStatic::drawMesh(ID3D11DeviceContext* deviceContext, Mesh* m, UINT lod, Camera* c, CXMMATRIX world)
+{
+    const MeshLOD& l = m->getLOD(lod);
+
+    if (c == nullptr || l.startIndex != 0 || m->clusters.empty())
+    {
+        deviceContext->DrawIndexed(l.indexCount, l.startIndex, 0);
+        return;
+    }
+
+    BoundingFrustum frustum = c->getFrustum();
+
+    /*cone test in mesh space, mirrored transforms flip the winding*/
+    XMVECTOR det;
+    XMMATRIX invWorld = XMMatrixInverse(&det, world);
+    XMVECTOR eye = XMVector3TransformCoord(c->getPositionXM(), invWorld);
+    bool useCones = XMVectorGetX(det) > 0.f;
+
+    UINT start = 0;
+    UINT count = 0;
+
+    for (auto& cl : m->clusters)
+    {
+        XMVECTOR center = XMVectorSet(cl.center[0], cl.center[1], cl.center[2], 1.f);
+
+        if (useCones)
+        {
+            XMVECTOR axis = XMVectorSet(cl.coneAxis[0], cl.coneAxis[1], cl.coneAxis[2], 0.f);
+            XMVECTOR d = center - eye;
+
+            if (XMVectorGetX(XMVector3Dot(d, axis)) >= cl.coneCutoff * XMVectorGetX(XMVector3Length(d)) + cl.radius)
+            {
+                continue;
+            }
+        }
+
+        BoundingSphere bounds;
+        XMStoreFloat3(&bounds.Center, center);
+        bounds.Radius = cl.radius;
+        bounds.Transform(bounds, world);
+
+        if (!frustum.Intersects(bounds))
+        {
+            continue;
+        }
+
+        /*merge neighbouring visible clusters into one draw call*/
+        if (count > 0 && start + count == cl.startIndex)
+        {
+            count += cl.indexCount;
+        }
+        else
+        {
+            if (count > 0)
+            {
+                deviceContext->DrawIndexed(count, start, 0);
+            }
+
+            start = cl.startIndex;
+            count = cl.indexCount;
+        }
+    }
+
+    if (count > 0)
+    {
+        deviceContext->DrawIndexed(count, start, 0);
+    }
+}
+
+/*resolve the model once instead of a map lookup per draw call*/
+Model* ModelInstanceStatic::getModel()
+{
+    if (model == nullptr)
+    {
+        model = resources->getModel(modelID);
+    }
+
+    return model;
+}
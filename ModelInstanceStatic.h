@@ -14,6 +14,7 @@ public:
     void SetModelID(std::string id)
     {
         modelID = id;
+        model = nullptr;
     }
     std::string GetModelID()
     {
@@ -34,6 +35,15 @@ public:
     void OverwriteDiffuseMap(std::string id);
     void OverwriteNormalMap(std::string id);
 
+    Model* getModel();
+
+    /*texture ids a mesh of the model is drawn with, including overwrites*/
+    std::string getDiffuseMapID(const Mesh* m) const;
+    std::string getNormalMapID(const Mesh* m) const;
+
+    /*meshes moved into a texture atlas are moved back for other textures, see TexturePacker.h*/
+    XMMATRIX getTexTransform(const Mesh* m) const;
+
 
 
     /*public properties*/
@@ -47,6 +57,11 @@ public:
     UShader::UsedTechnique usedTechnique;
 private:
 
+    UINT selectLOD(Model* model, Camera* c, CXMMATRIX world);
+    void drawMesh(ID3D11DeviceContext* deviceContext, Mesh* m, UINT lod, Camera* c, CXMMATRIX world);
+    bool unpacked(const Mesh* m) const;
+    XMMATRIX unpackTransform(const Mesh* m) const;
+
     bool useOverwriteDiffuse;
     bool useOverwriteNormalMap;
     std::string ovrwrTex;
@@ -56,4 +71,5 @@ private:
     ResourceManager* resources = 0;
 
     std::string modelID;
+    Model* model = nullptr;
 };
\ No newline at end of file
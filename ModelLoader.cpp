@@ -4,8 +4,6 @@
 
 #pragma warning( disable : 26451)
 
-//#define CHECK_NORMALS
-
 bool ModelLoader::LoadB3D(const std::string& fileName, Model* m)
 {
     /*open file*/
@@ -43,7 +41,7 @@ bool ModelLoader::LoadB3D(const std::string& fileName, Model* m)
     char numMeshes = 0;
     file.read(&numMeshes, sizeof(numMeshes));
 
-    m->meshes.reserve((size_t)numMeshes);
+    m->ReserveMeshes((size_t)numMeshes);
 
     XMFLOAT3 cMin(+FLT_MAX, +FLT_MAX, +FLT_MAX);
     XMFLOAT3 cMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
@@ -53,7 +51,7 @@ bool ModelLoader::LoadB3D(const std::string& fileName, Model* m)
 
     for (char i = 0; i < numMeshes; i++)
     {
-        m->meshes.push_back(new Mesh());
+        m->meshes.push_back(m->CreateMesh());
 
         /*read material*/
 
@@ -75,32 +73,16 @@ bool ModelLoader::LoadB3D(const std::string& fileName, Model* m)
 
         /*read map strings*/
 
-        short slen = 0;
-        file.read((char*)(&slen), sizeof(short));
-
-        char* dmap = new char[ (int)(slen) + 1];
-        file.read(dmap, slen);
-        dmap[slen] = '\0';
-
-        slen = 0;
-        file.read((char*)(&slen), sizeof(short));
-
-        char* nmap = new char[(int)(slen)+ 1];
-        file.read(nmap, slen);
-        nmap[slen] = '\0';
-
-        slen = 0;
-        file.read((char*)(&slen), sizeof(short));
+        std::string* maps[3] = { &m->meshes[i]->diffuseMapID, &m->meshes[i]->normalMapID, &m->meshes[i]->bumpMapID };
 
-        char* bmap = new char[(int)(slen)+ 1];
-        file.read(bmap, slen);
-        bmap[slen] = '\0';
-
-        m->meshes[i]->diffuseMapID = dmap;
-        m->meshes[i]->normalMapID = nmap;
-        m->meshes[i]->bumpMapID = bmap;
+        for (auto& map : maps)
+        {
+            short slen = 0;
+            file.read((char*)(&slen), sizeof(short));
 
-        delete[] dmap; delete[] nmap; delete[] bmap;
+            map->resize(slen);
+            file.read(&(*map)[0], slen);
+        }
 
         /*read number of vertices*/
         int vertCount = 0;
@@ -122,15 +104,6 @@ bool ModelLoader::LoadB3D(const std::string& fileName, Model* m)
             file.read((char*)(&m->meshes[i]->vertices[j].Normal.y), sizeof(float));
             file.read((char*)(&m->meshes[i]->vertices[j].Normal.z), sizeof(float));
 
-#ifdef CHECK_NORMALS
-            if (m->meshes[i]->vertices[j].Normal.x > 1 ||
-                m->meshes[i]->vertices[j].Normal.y > 1 ||
-                m->meshes[i]->vertices[j].Normal.z > 1)
-            {
-                throw std::exception("normal > 1");
-            }
-#endif
-
             file.read((char*)(&m->meshes[i]->vertices[j].TangentU.x), sizeof(float));
             file.read((char*)(&m->meshes[i]->vertices[j].TangentU.y), sizeof(float));
             file.read((char*)(&m->meshes[i]->vertices[j].TangentU.z), sizeof(float));
@@ -157,6 +130,9 @@ bool ModelLoader::LoadB3D(const std::string& fileName, Model* m)
 
     }
 
+    /*repair missing or broken normals and tangents*/
+    m->GenerateTangentSpace();
+
     /*finalize collision*/
 
     XMStoreFloat3(&m->collisionBox.Center, 0.5f * (vMin + vMax));
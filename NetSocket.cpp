@@ -0,0 +1,142 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib,"ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "NetSocket.h"
+
+static sockaddr_in makeAddress(uint32_t address, unsigned short port)
+{
+    sockaddr_in a = {};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(port);
+    a.sin_addr.s_addr = htonl(address);
+    return a;
+}
+
+intptr_t OpenUdpSocket(unsigned short port, bool loopbackOnly)
+{
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+        return NET_INVALID_SOCKET;
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (s == INVALID_SOCKET)
+    {
+        WSACleanup();
+        return NET_INVALID_SOCKET;
+    }
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (s < 0)
+        return NET_INVALID_SOCKET;
+#endif
+
+    sockaddr_in address = makeAddress(loopbackOnly ? NET_LOOPBACK_ADDRESS : INADDR_ANY, port);
+
+    if (bind(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        CloseUdpSocket(static_cast<intptr_t>(s));
+        return NET_INVALID_SOCKET;
+    }
+
+    /*reads never wait for datagrams*/
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK);
+#endif
+
+    return static_cast<intptr_t>(s);
+}
+
+void CloseUdpSocket(intptr_t s)
+{
+    if (s == NET_INVALID_SOCKET)
+        return;
+
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(s));
+    WSACleanup();
+#else
+    close(static_cast<int>(s));
+#endif
+}
+
+bool ResolveAddress(const std::string& host, uint32_t& address)
+{
+    in_addr a;
+
+    if (inet_pton(AF_INET, host.c_str(), &a) != 1)
+        return false;
+
+    address = ntohl(a.s_addr);
+    return true;
+}
+
+bool SendUdp(intptr_t s, uint32_t address, unsigned short port, const void* data, size_t size)
+{
+    sockaddr_in to = makeAddress(address, port);
+
+#ifdef _WIN32
+    int sent = sendto(static_cast<SOCKET>(s), static_cast<const char*>(data), static_cast<int>(size), 0,
+                      reinterpret_cast<sockaddr*>(&to), sizeof(to));
+#else
+    ssize_t sent = sendto(static_cast<int>(s), data, size, 0, reinterpret_cast<sockaddr*>(&to), sizeof(to));
+#endif
+
+    return sent == static_cast<int>(size);
+}
+
+size_t ReceiveUdp(intptr_t s, void* data, size_t capacity, uint32_t& address, unsigned short& port)
+{
+    sockaddr_in from = {};
+    socklen_t length = sizeof(from);
+
+#ifdef _WIN32
+    int received = recvfrom(static_cast<SOCKET>(s), static_cast<char*>(data), static_cast<int>(capacity), 0,
+                            reinterpret_cast<sockaddr*>(&from), &length);
+
+    /*an icmp port unreachable of an earlier send or a truncated datagram, the next one may be fine*/
+    if (received < 0)
+    {
+        int error = WSAGetLastError();
+        return error == WSAECONNRESET || error == WSAEMSGSIZE ? NET_RECEIVE_SKIPPED : 0;
+    }
+#else
+#ifdef __linux__
+    /*the full length of the datagram, to see if it was truncated*/
+    const int flags = MSG_TRUNC;
+#else
+    const int flags = 0;
+#endif
+
+    ssize_t received = recvfrom(static_cast<int>(s), data, capacity, flags, reinterpret_cast<sockaddr*>(&from), &length);
+
+    if (received < 0)
+        return errno == ECONNREFUSED ? NET_RECEIVE_SKIPPED : 0;
+
+    if (static_cast<size_t>(received) > capacity)
+        return NET_RECEIVE_SKIPPED;
+#endif
+
+    /*an empty datagram*/
+    if (received == 0)
+        return NET_RECEIVE_SKIPPED;
+
+    address = ntohl(from.sin_addr.s_addr);
+    port = ntohs(from.sin_port);
+    return static_cast<size_t>(received);
+}
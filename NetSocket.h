@@ -0,0 +1,42 @@
+/* NetSocket.h
+
+thin non blocking udp socket functions over winsock and bsd sockets, used
+by the LoopbackDevice and the UdpTransport. addresses are ipv4 in host
+byte order.
+
+    Usage:
+    intptr_t s = OpenUdpSocket(port, false);
+    if (s == NET_INVALID_SOCKET) ...
+
+    uint32_t address;
+    ResolveAddress("127.0.0.1", address);
+    SendUdp(s, address, 27016, data, size);
+
+    for (size_t n; (n = ReceiveUdp(s, buffer, sizeof(buffer), address, port)) > 0;)
+        if (n != NET_RECEIVE_SKIPPED) ...
+    CloseUdpSocket(s);
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define NET_INVALID_SOCKET ((intptr_t)-1)
+#define NET_LOOPBACK_ADDRESS 0x7F000001u
+#define NET_RECEIVE_SKIPPED ((size_t)-1)
+
+/*bound to port (0 for any) on all interfaces or only the loopback address*/
+intptr_t OpenUdpSocket(unsigned short port, bool loopbackOnly);
+void CloseUdpSocket(intptr_t s);
+
+/*dotted ipv4 address*/
+bool ResolveAddress(const std::string& host, uint32_t& address);
+
+bool SendUdp(intptr_t s, uint32_t address, unsigned short port, const void* data, size_t size);
+
+/*size of the received datagram, 0 when none is waiting, NET_RECEIVE_SKIPPED when a datagram
+  larger than capacity or an error report of an earlier send was dropped and more may be waiting*/
+size_t ReceiveUdp(intptr_t s, void* data, size_t capacity, uint32_t& address, unsigned short& port);
@@ -0,0 +1,162 @@
+#include "NetTransport.h"
+#include "NetSocket.h"
+#include <cstring>
+#include <stdexcept>
+
+UdpTransport::UdpTransport(unsigned short port)
+{
+    socket = OpenUdpSocket(port, false);
+
+    if (socket == NET_INVALID_SOCKET)
+    {
+        throw std::runtime_error("Unable to open udp port " + std::to_string(port));
+    }
+}
+
+UdpTransport::~UdpTransport()
+{
+    CloseUdpSocket(socket);
+}
+
+int UdpTransport::AddPeer(const std::string& peer)
+{
+    size_t colon = peer.rfind(':');
+    Peer p;
+
+    if (colon == std::string::npos || !ResolveAddress(peer.substr(0, colon), p.address))
+    {
+        throw std::runtime_error("Invalid peer address " + peer);
+    }
+
+    p.port = static_cast<unsigned short>(std::stoul(peer.substr(colon + 1)));
+    peers.push_back(p);
+
+    return static_cast<int>(peers.size()) - 1;
+}
+
+bool UdpTransport::Send(int peer, const void* data, size_t size)
+{
+    if (peer < 0 || peer >= static_cast<int>(peers.size()))
+        return false;
+
+    return SendUdp(socket, peers[peer].address, peers[peer].port, data, size);
+}
+
+size_t UdpTransport::Receive(void* data, size_t capacity, int& peer)
+{
+    uint32_t address;
+    unsigned short port;
+
+    for (size_t received; (received = ReceiveUdp(socket, data, capacity, address, port)) > 0;)
+    {
+        if (received == NET_RECEIVE_SKIPPED)
+            continue;
+
+        for (size_t i = 0; i < peers.size(); i++)
+        {
+            if (peers[i].address == address && peers[i].port == port)
+            {
+                peer = static_cast<int>(i);
+                return received;
+            }
+        }
+    }
+
+    return 0;
+}
+
+class LoopbackNetwork::LoopbackEndpoint : public NetTransport
+{
+public:
+    LoopbackEndpoint(LoopbackNetwork* network, int index) : network(network), index(index) {}
+
+    bool Send(int peer, const void* data, size_t size) override
+    {
+        return network->send(index, peer, data, size);
+    }
+
+    size_t Receive(void* data, size_t capacity, int& peer) override
+    {
+        return network->receive(index, data, capacity, peer);
+    }
+
+private:
+    LoopbackNetwork* network;
+    int index;
+};
+
+LoopbackNetwork::LoopbackNetwork(int count, const LoopbackSettings& settings) : settings(settings), random(settings.seed)
+{
+    for (int i = 0; i < count; i++)
+    {
+        endpoints.push_back(std::make_unique<LoopbackEndpoint>(this, i));
+    }
+}
+
+LoopbackNetwork::~LoopbackNetwork()
+{
+}
+
+NetTransport* LoopbackNetwork::Endpoint(int index)
+{
+    return endpoints[index].get();
+}
+
+void LoopbackNetwork::Advance(double ms)
+{
+    time += ms;
+}
+
+bool LoopbackNetwork::send(int from, int to, const void* data, size_t size)
+{
+    if (to < 0 || to >= static_cast<int>(endpoints.size()) || size > NET_MAX_PACKET)
+        return false;
+
+    sent++;
+
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    /*a lost datagram is still sent successfully*/
+    if (unit(random) < settings.loss)
+    {
+        lost++;
+        return true;
+    }
+
+    Datagram d;
+    d.arrival = time + settings.latencyMs + (unit(random) * 2.0 - 1.0) * settings.jitterMs;
+    d.from = from;
+    d.to = to;
+    d.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size);
+
+    inFlight.push_back(std::move(d));
+    return true;
+}
+
+size_t LoopbackNetwork::receive(int to, void* data, size_t capacity, int& peer)
+{
+    /*earliest arrived datagram for this endpoint*/
+    size_t next = inFlight.size();
+
+    for (size_t i = 0; i < inFlight.size(); i++)
+    {
+        if (inFlight[i].to == to && inFlight[i].arrival <= time &&
+            (next == inFlight.size() || inFlight[i].arrival < inFlight[next].arrival))
+        {
+            next = i;
+        }
+    }
+
+    if (next == inFlight.size())
+        return 0;
+
+    Datagram d = std::move(inFlight[next]);
+    inFlight.erase(inFlight.begin() + next);
+
+    /*like udp, the rest of a datagram larger than the buffer is lost*/
+    size_t size = d.data.size() < capacity ? d.data.size() : capacity;
+    memcpy(data, d.data.data(), size);
+    peer = d.from;
+
+    return size;
+}
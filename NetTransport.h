@@ -0,0 +1,122 @@
+/* NetTransport.h
+
+unreliable, unordered datagrams between the peers of a match. peers are
+numbered by the transport, a UdpTransport numbers them in the order they
+were added, a LoopbackNetwork by endpoint.
+
+the LoopbackNetwork connects endpoints inside one process. every datagram
+is delayed by the latency plus a random jitter and dropped with the loss
+probability, so datagrams can also arrive out of order. time only moves
+with Advance(), a test or a game step decides how fast the network runs.
+the random numbers come from the seed, a run with the same calls is the
+same every time.
+
+    Usage:
+    LoopbackSettings settings;
+    settings.latencyMs = 40.0;
+    settings.loss = 0.05;
+
+    LoopbackNetwork network(2, settings);
+    network.Endpoint(0)->Send(1, data, size);
+    network.Advance(16.0);
+
+    int peer;
+    size_t n = network.Endpoint(1)->Receive(buffer, sizeof(buffer), peer);
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#define NET_MAX_PACKET 1024
+
+class NetTransport
+{
+public:
+    virtual ~NetTransport() = default;
+
+    virtual bool Send(int peer, const void* data, size_t size) = 0;
+
+    /*size of the next datagram and its peer, 0 when none is waiting*/
+    virtual size_t Receive(void* data, size_t capacity, int& peer) = 0;
+};
+
+class UdpTransport : public NetTransport
+{
+public:
+    UdpTransport(unsigned short port);
+    ~UdpTransport();
+
+    /*"address:port", returns the peer number*/
+    int AddPeer(const std::string& peer);
+
+    bool Send(int peer, const void* data, size_t size) override;
+
+    /*datagrams of unknown senders are dropped*/
+    size_t Receive(void* data, size_t capacity, int& peer) override;
+
+private:
+    intptr_t socket;
+
+    struct Peer
+    {
+        uint32_t address;
+        unsigned short port;
+    };
+
+    std::vector<Peer> peers;
+};
+
+struct LoopbackSettings
+{
+    double latencyMs = 0.0;
+    double jitterMs = 0.0;
+
+    /*probability to drop a datagram, 0 - 1*/
+    double loss = 0.0;
+    uint32_t seed = 1;
+};
+
+class LoopbackNetwork
+{
+public:
+    LoopbackNetwork(int endpoints, const LoopbackSettings& settings = LoopbackSettings());
+    ~LoopbackNetwork();
+
+    NetTransport* Endpoint(int index);
+
+    void Advance(double ms);
+    double Time() const { return time; }
+
+    unsigned long long Sent() const { return sent; }
+    unsigned long long Lost() const { return lost; }
+
+private:
+    class LoopbackEndpoint;
+
+    struct Datagram
+    {
+        double arrival;
+        int from;
+        int to;
+        std::vector<uint8_t> data;
+    };
+
+    bool send(int from, int to, const void* data, size_t size);
+    size_t receive(int to, void* data, size_t capacity, int& peer);
+
+    LoopbackSettings settings;
+    std::vector<std::unique_ptr<LoopbackEndpoint>> endpoints;
+    std::vector<Datagram> inFlight;
+    std::mt19937 random;
+    double time = 0.0;
+
+    unsigned long long sent = 0;
+    unsigned long long lost = 0;
+};
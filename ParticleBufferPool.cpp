@@ -0,0 +1,98 @@
+#include "ParticleBufferPool.h"
+#include "InputLayout.h"
+
+ParticleBufferPool::ParticleBufferPool(ID3D11Device* device) : device(device)
+{
+}
+
+ParticleBufferPool::~ParticleBufferPool()
+{
+    for (auto& e : entries)
+    {
+        DXRelease(e.buffer);
+    }
+}
+
+ID3D11Buffer* ParticleBufferPool::Acquire(ParticleBufferType type, UINT particles)
+{
+    /*smallest free buffer that fits*/
+    Entry* best = nullptr;
+
+    for (auto& e : entries)
+    {
+        if (!e.used && e.type == type && e.capacity >= particles && (!best || e.capacity < best->capacity))
+        {
+            best = &e;
+        }
+    }
+
+    if (!best)
+    {
+        UINT capacity = PARTICLE_BUFFER_MIN;
+
+        while (capacity < particles)
+        {
+            capacity *= 2;
+        }
+
+        D3D11_BUFFER_DESC vbd;
+        vbd.ByteWidth = sizeof(Vertex::Particle) * capacity;
+        vbd.MiscFlags = 0;
+        vbd.StructureByteStride = 0;
+
+        if (type == ParticleBufferType::DYNAMIC)
+        {
+            /*cpu particles are written every frame*/
+            vbd.Usage = D3D11_USAGE_DYNAMIC;
+            vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+            vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        }
+        else
+        {
+            vbd.Usage = D3D11_USAGE_DEFAULT;
+            vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_STREAM_OUTPUT;
+            vbd.CPUAccessFlags = 0;
+        }
+
+        ID3D11Buffer* buffer = 0;
+
+        if (FAILED(device->CreateBuffer(&vbd, 0, &buffer)))
+        {
+            DBOUT("Unable to create particle buffer for " << capacity << " particles" << endl);
+            return 0;
+        }
+
+        entries.push_back({ buffer, type, capacity, false });
+        best = &entries.back();
+    }
+
+    best->used = true;
+    bytesInUse += sizeof(Vertex::Particle) * best->capacity;
+    peakBytes = (std::max)(peakBytes, bytesInUse);
+
+    return best->buffer;
+}
+
+void ParticleBufferPool::Release(ID3D11Buffer* buffer)
+{
+    for (auto& e : entries)
+    {
+        if (e.buffer == buffer && e.used)
+        {
+            e.used = false;
+            bytesInUse -= sizeof(Vertex::Particle) * e.capacity;
+            return;
+        }
+    }
+}
+
+UINT ParticleBufferPool::Capacity(ID3D11Buffer* buffer) const
+{
+    for (auto& e : entries)
+    {
+        if (e.buffer == buffer)
+            return e.capacity;
+    }
+
+    return 0;
+}
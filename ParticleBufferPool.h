@@ -0,0 +1,59 @@
+/* ParticleBufferPool.h
+
+vertex buffers for particle systems, shared by all levels. a particle
+system takes its buffers when it wakes up and gives them back when it goes
+to sleep, so only the systems awake at the same time need memory and the
+pool grows to the peak of them instead of holding maxParticles of every
+system. capacities are rounded up to powers of two so buffers fit other
+systems later. the buffers are released with the pool.
+
+    Usage:
+    ParticleBufferPool pool(device);
+
+    ID3D11Buffer* vb = pool.Acquire(ParticleBufferType::STREAM_OUT, maxParticles);
+    pool.Release(vb);
+
+*/
+
+#pragma once
+
+#include "util.h"
+
+#define PARTICLE_BUFFER_MIN 256
+
+enum class ParticleBufferType
+{
+    STREAM_OUT, DYNAMIC
+};
+
+class ParticleBufferPool
+{
+public:
+    ParticleBufferPool(ID3D11Device* device);
+    ~ParticleBufferPool();
+
+    /*a free buffer for at least particles, 0 if none can be created*/
+    ID3D11Buffer* Acquire(ParticleBufferType type, UINT particles);
+    void Release(ID3D11Buffer* buffer);
+
+    /*particles that fit in a buffer of this pool*/
+    UINT Capacity(ID3D11Buffer* buffer) const;
+
+    size_t Buffers() const { return entries.size(); }
+    size_t BytesInUse() const { return bytesInUse; }
+    size_t PeakBytes() const { return peakBytes; }
+
+private:
+    struct Entry
+    {
+        ID3D11Buffer* buffer;
+        ParticleBufferType type;
+        UINT capacity;
+        bool used;
+    };
+
+    ID3D11Device* device;
+    std::vector<Entry> entries;
+    size_t bytesInUse = 0;
+    size_t peakBytes = 0;
+};
@@ -1,6 +1,8 @@
 #include "ParticleSystem.h"
 #include "InputLayout.h"
 
+static_assert(sizeof(ParticleVertex) == sizeof(Vertex::Particle), "ParticleVertex must match Vertex::Particle");
+
 ParticleSystem::ParticleSystem()
 {
     firstRun = true;
@@ -16,9 +18,9 @@ ParticleSystem::ParticleSystem()
 
 ParticleSystem::~ParticleSystem()
 {
+    sleep();
     DXRelease(mInitVB);
-    DXRelease(mDrawVB);
-    DXRelease(mStreamVB);
+    delete cpu;
 }
 
 float ParticleSystem::getAge()
@@ -34,6 +36,11 @@ void ParticleSystem::setEyePos(const XMFLOAT3& eyePosW)
 void ParticleSystem::setEmitPosition(const XMFLOAT3& emitPosW)
 {
     mEmitPositionW = emitPosW;
+
+    if (cpu)
+        cpu->SetEmitPosition(emitPosW.x, emitPosW.y, emitPosW.z);
+
+    updateBounds();
 }
 
 void ParticleSystem::setEmitDirection(const XMFLOAT3& emitDirW)
@@ -44,26 +51,142 @@ void ParticleSystem::setEmitDirection(const XMFLOAT3& emitDirW)
 void ParticleSystem::setAcceleration(const XMFLOAT3& acc)
 {
     mAcceleration = acc;
+
+    if (cpu)
+        cpu->SetAcceleration(acc.x, acc.y, acc.z);
+
+    updateBounds();
 }
 
 void ParticleSystem::setSizeParticle(const XMFLOAT2& size)
 {
     mSizeParticle = size;
+
+    if (cpu)
+        cpu->SetSize(size.x, size.y);
+
+    updateBounds();
+}
+
+CpuParticleEmitter* ParticleSystem::getCpuEmitter()
+{
+    return cpu;
+}
+
+const BoundingBox& ParticleSystem::getBounds()
+{
+    return bounds;
 }
 
+bool ParticleSystem::isVisible(const BoundingFrustum& frustum)
+{
+    if (!frustum.Intersects(bounds))
+        return false;
+
+    unseenTime = 0.f;
+
+    if (!awake)
+        wake();
 
+    return awake;
+}
+
+bool ParticleSystem::isAwake()
+{
+    return awake;
+}
+
+void ParticleSystem::wake()
+{
+    if (cpu)
+    {
+        mDrawVB = buffers->Acquire(ParticleBufferType::DYNAMIC, maxParticles);
+
+        if (!mDrawVB)
+            return;
+
+        /*the particles are where they would be after the time asleep*/
+        cpu->Advance(pendingTime);
+        pendingTime = 0.f;
+    }
+    else
+    {
+        mDrawVB = buffers->Acquire(ParticleBufferType::STREAM_OUT, maxParticles);
+        mStreamVB = buffers->Acquire(ParticleBufferType::STREAM_OUT, maxParticles);
+
+        if (!mDrawVB || !mStreamVB)
+        {
+            buffers->Release(mDrawVB);
+            buffers->Release(mStreamVB);
+            mDrawVB = mStreamVB = 0;
+            return;
+        }
+
+        mDrawOffset = sizeof(Vertex::Particle) * (buffers->Capacity(mDrawVB) - maxParticles);
+        mStreamOffset = sizeof(Vertex::Particle) * (buffers->Capacity(mStreamVB) - maxParticles);
+
+        /*the buffers held other particles, start over and simulate the last
+          lifetime in draw, that is where all particles alive now come from*/
+        firstRun = true;
+        pendingTime = (std::min)(age, desc.lifetime);
+    }
+
+    awake = true;
+}
+
+void ParticleSystem::sleep()
+{
+    if (!awake)
+        return;
+
+    buffers->Release(mDrawVB);
+    buffers->Release(mStreamVB);
+    mDrawVB = mStreamVB = 0;
+
+    awake = false;
+}
+
+void ParticleSystem::updateBounds()
+{
+    float emit[3] = { mEmitPositionW.x, mEmitPositionW.y, mEmitPositionW.z };
+    float acc[3] = { mAcceleration.x, mAcceleration.y, mAcceleration.z };
+    float min[3], max[3];
+
+    desc.Bounds(emit, acc, min, max);
+
+    /*billboards reach half their size past the particle*/
+    float pad = 0.5f * (std::max)(mSizeParticle.x, mSizeParticle.y);
+
+    XMFLOAT3 a(min[0] - pad, min[1] - pad, min[2] - pad);
+    XMFLOAT3 b(max[0] + pad, max[1] + pad, max[2] + pad);
+
+    BoundingBox::CreateFromPoints(bounds, XMLoadFloat3(&a), XMLoadFloat3(&b));
+}
 
 void ParticleSystem::init(ID3D11Device* device, ParticleEffect* fx, ID3D11ShaderResourceView* texArraySRV,
-                          ID3D11ShaderResourceView* randomTexSRV, UINT maxP)
+                          ID3D11ShaderResourceView* randomTexSRV, ParticleBufferPool* buffers, UINT maxP,
+                          const ParticleEmitterDesc& desc, bool onCpu)
 {
+    sleep();
+
     maxParticles = maxP;
 
     effect = fx;
+    this->desc = desc;
+    this->buffers = buffers;
 
     mTexArraySRV = texArraySRV;
     mRandomSRV = randomTexSRV;
 
-    mSizeParticle = XMFLOAT2(1.f, 1.f);
+    if (onCpu)
+    {
+        delete cpu;
+        cpu = new CpuParticleEmitter(desc, maxParticles);
+        cpu->SetEmitPosition(mEmitPositionW.x, mEmitPositionW.y, mEmitPositionW.z);
+        cpu->SetAcceleration(mAcceleration.x, mAcceleration.y, mAcceleration.z);
+    }
+
+    setSizeParticle(XMFLOAT2(1.f, 1.f));
 
     buildVertexBuffer(device);
 }
@@ -72,6 +195,10 @@ void ParticleSystem::reset()
 {
     firstRun = true;
     age = 0.0f;
+    pendingTime = 0.f;
+
+    if (cpu)
+        cpu->Reset();
 }
 
 void ParticleSystem::update(float dt, float gt)
@@ -80,18 +207,28 @@ void ParticleSystem::update(float dt, float gt)
     timeStep = dt;
 
     age += dt;
+    unseenTime += dt;
+    simulatedFrame = false;
+
+    /*awake cpu particles are updated by the ParticleUpdater, the rest catches up later*/
+    if (!cpu || !awake)
+        pendingTime += dt;
+
+    if (awake && unseenTime > PARTICLE_SLEEP_TIME)
+        sleep();
 }
 
 void ParticleSystem::draw(ID3D11DeviceContext* dc, Camera& cam)
 {
+    if (!awake)
+        return;
+
     XMMATRIX VP = cam.getViewProj();
 
     //
     // Set constants.
     //
     effect->SetViewProj(VP);
-    effect->SetGameTime(gameTime);
-    effect->SetTimeStep(timeStep);
     effect->SetEyePosW(mEyePosW);
     effect->SetEmitPosW(mEmitPositionW);
     effect->SetEmitDirW(mEmitDirectionW);
@@ -106,6 +243,83 @@ void ParticleSystem::draw(ID3D11DeviceContext* dc, Camera& cam)
     dc->IASetInputLayout(InputLayouts::Particle);
     dc->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
 
+    if (cpu)
+    {
+        effect->SetGameTime(gameTime);
+        effect->SetTimeStep(timeStep);
+        drawCpu(dc);
+        return;
+    }
+
+    /*the first view that sees the system simulates it, the others only draw*/
+    if (pendingTime > 0.f && !simulatedFrame)
+        simulate(dc);
+
+    effect->SetGameTime(gameTime);
+    effect->SetTimeStep(timeStep);
+
+    /*still catching up, the particles would be seen in fast forward*/
+    if (firstRun || pendingTime > 0.f)
+        return;
+
+    //
+    // Draw the updated particle system we just streamed-out. 
+    //
+    UINT stride = sizeof(Vertex::Particle);
+
+    dc->IASetVertexBuffers(0, 1, &mDrawVB, &stride, &mDrawOffset);
+
+    D3DX11_TECHNIQUE_DESC techDesc;
+    effect->DrawTech->GetDesc(&techDesc);
+    for (UINT p = 0; p < techDesc.Passes; ++p)
+    {
+        effect->DrawTech->GetPassByIndex(p)->Apply(0, dc);
+
+        dc->DrawAuto();
+    }
+}
+
+void ParticleSystem::simulate(ID3D11DeviceContext* dc)
+{
+    simulatedFrame = true;
+
+    /*particles older than the lifetime are gone, only the last lifetime is simulated*/
+    if (pendingTime > desc.lifetime)
+    {
+        firstRun = true;
+        pendingTime = desc.lifetime;
+    }
+
+    /*the shaders emit once per step, so long gaps are run in frame sized steps*/
+    float step = (std::max)(PARTICLE_CATCHUP_STEP, desc.lifetime / PARTICLE_MAX_CATCHUP_STEPS);
+    int steps = (std::max)(1, (int)std::lround(pendingTime / step));
+
+    bool done = steps <= PARTICLE_FRAME_CATCHUP_STEPS;
+
+    if (done)
+    {
+        step = pendingTime / steps;
+    }
+    else
+    {
+        steps = PARTICLE_FRAME_CATCHUP_STEPS;
+    }
+
+    float start = gameTime - pendingTime;
+
+    for (int k = 0; k < steps; k++)
+    {
+        streamOut(dc, step, start + (k + 1) * step);
+    }
+
+    pendingTime = done ? 0.f : pendingTime - steps * step;
+}
+
+void ParticleSystem::streamOut(ID3D11DeviceContext* dc, float dt, float gt)
+{
+    effect->SetGameTime(gt);
+    effect->SetTimeStep(dt);
+
     UINT stride = sizeof(Vertex::Particle);
     UINT offset = 0;
 
@@ -114,13 +328,13 @@ void ParticleSystem::draw(ID3D11DeviceContext* dc, Camera& cam)
     if (firstRun)
         dc->IASetVertexBuffers(0, 1, &mInitVB, &stride, &offset);
     else
-        dc->IASetVertexBuffers(0, 1, &mDrawVB, &stride, &offset);
+        dc->IASetVertexBuffers(0, 1, &mDrawVB, &stride, &mDrawOffset);
 
     //
     // Draw the current particle list using stream-out only to update them.  
     // The updated vertices are streamed-out to the target VB. 
     //
-    dc->SOSetTargets(1, &mStreamVB, &offset);
+    dc->SOSetTargets(1, &mStreamVB, &mStreamOffset);
 
     D3DX11_TECHNIQUE_DESC techDesc;
     effect->StreamOutTech->GetDesc(&techDesc);
@@ -145,24 +359,45 @@ void ParticleSystem::draw(ID3D11DeviceContext* dc, Camera& cam)
 
     // ping-pong the vertex buffers
     std::swap(mDrawVB, mStreamVB);
+    std::swap(mDrawOffset, mStreamOffset);
+}
 
-    //
-    // Draw the updated particle system we just streamed-out. 
-    //
+void ParticleSystem::drawCpu(ID3D11DeviceContext* dc)
+{
+    /*the particles are updated already, only the draw pass runs*/
+    D3D11_MAPPED_SUBRESOURCE mapped;
+
+    if (FAILED(dc->Map(mDrawVB, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+        return;
+
+    UINT count = (UINT)cpu->Export(reinterpret_cast<ParticleVertex*>(mapped.pData), maxParticles);
+    dc->Unmap(mDrawVB, 0);
+
+    if (count == 0)
+        return;
 
+    UINT stride = sizeof(Vertex::Particle);
+    UINT offset = 0;
     dc->IASetVertexBuffers(0, 1, &mDrawVB, &stride, &offset);
 
+    D3DX11_TECHNIQUE_DESC techDesc;
     effect->DrawTech->GetDesc(&techDesc);
     for (UINT p = 0; p < techDesc.Passes; ++p)
     {
         effect->DrawTech->GetPassByIndex(p)->Apply(0, dc);
 
-        dc->DrawAuto();
+        dc->Draw(count, 0);
     }
 }
 
 void ParticleSystem::buildVertexBuffer(ID3D11Device* device)
 {
+    /*cpu particles and the ping-pong buffers come from the pool when awake*/
+    if (cpu)
+        return;
+
+    DXRelease(mInitVB);
+
     //
     // Create the buffer to kick-off the particle system.
     //
@@ -186,13 +421,4 @@ void ParticleSystem::buildVertexBuffer(ID3D11Device* device)
     vinitData.pSysMem = &p;
 
     device->CreateBuffer(&vbd, &vinitData, &mInitVB);
-
-    //
-    // Create the ping-pong buffers for stream-out and drawing.
-    //
-    vbd.ByteWidth = sizeof(Vertex::Particle) * maxParticles;
-    vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER | D3D11_BIND_STREAM_OUTPUT;
-
-    device->CreateBuffer(&vbd, 0, &mDrawVB);
-    device->CreateBuffer(&vbd, 0, &mStreamVB);
 }
\ No newline at end of file
@@ -2,6 +2,18 @@
 #include "util.h"
 #include "Camera.h"
 #include "Shader.h"
+#include "CpuParticles.h"
+#include "ParticleBufferPool.h"
+
+/*seconds a system is not seen until it sleeps and gives back its buffers*/
+#define PARTICLE_SLEEP_TIME 1.f
+
+/*a system that wasn't simulated for a while catches up in steps of this, at most max steps.
+  a frame runs at most PARTICLE_FRAME_CATCHUP_STEPS of them, the rest is caught up in the
+  next frames and the system is drawn again once it is there*/
+#define PARTICLE_CATCHUP_STEP (1.f / 60.f)
+#define PARTICLE_MAX_CATCHUP_STEPS 360
+#define PARTICLE_FRAME_CATCHUP_STEPS 16
 
 class ParticleSystem
 {
@@ -16,8 +28,25 @@ public:
     void setAcceleration(const XMFLOAT3& acc);
     void setSizeParticle(const XMFLOAT2& size);
 
+    /*desc describes what the shader emits, simulated on the cpu with onCpu
+      and with stream out on the gpu otherwise. the vertex buffers are taken
+      from buffers while the system is awake*/
     void init(ID3D11Device* device, ParticleEffect* fx, ID3D11ShaderResourceView* texArraySRV,
-              ID3D11ShaderResourceView* randomSRV, UINT maxP);
+              ID3D11ShaderResourceView* randomSRV, ParticleBufferPool* buffers, UINT maxP,
+              const ParticleEmitterDesc& desc, bool onCpu = false);
+
+    /*0 for gpu particles, updated by a ParticleUpdater while awake*/
+    CpuParticleEmitter* getCpuEmitter();
+
+    /*box around every particle alive*/
+    const BoundingBox& getBounds();
+
+    /*true if the bounds are in the frustum, a sleeping system wakes up and catches up*/
+    bool isVisible(const BoundingFrustum& frustum);
+    bool isAwake();
+
+    /*gives the buffers back, the particles continue from their state when seen again*/
+    void sleep();
 
     void reset();
     void update(float deltaTime, float gt);
@@ -25,7 +54,12 @@ public:
 
 private:
 
+    void wake();
+    void simulate(ID3D11DeviceContext* context);
+    void streamOut(ID3D11DeviceContext* context, float dt, float gt);
+    void updateBounds();
     void buildVertexBuffer(ID3D11Device* device);
+    void drawCpu(ID3D11DeviceContext* context);
 
     UINT maxParticles = 0;
     bool firstRun = true;
@@ -33,6 +67,14 @@ private:
     float timeStep = 0.f;
     float age = 0.f;
 
+    /*seconds since the system was seen and simulation time the gpu hasn't run yet*/
+    bool awake = false;
+    float unseenTime = 0.f;
+    float pendingTime = 0.f;
+
+    /*the catch up steps of this frame ran already*/
+    bool simulatedFrame = false;
+
     XMFLOAT3 mEyePosW;
     XMFLOAT3 mEmitPositionW;
     XMFLOAT3 mEmitDirectionW;
@@ -40,9 +82,18 @@ private:
     XMFLOAT2 mSizeParticle;
 
     ParticleEffect* effect = 0;
+    ParticleEmitterDesc desc;
+    BoundingBox bounds;
 
+    ParticleBufferPool* buffers = 0;
     ID3D11Buffer* mInitVB = 0, * mDrawVB = 0, *mStreamVB = 0;
 
+    /*pooled buffers can hold more than maxParticles, they are bound this many bytes in so
+      stream out stops at maxParticles. DrawAuto counts from the same offset*/
+    UINT mDrawOffset = 0, mStreamOffset = 0;
+
+    CpuParticleEmitter* cpu = 0;
+
     ID3D11ShaderResourceView* mTexArraySRV, * mRandomSRV;
 
 };
\ No newline at end of file
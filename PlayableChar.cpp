@@ -32,9 +32,6 @@ PlayableChar::PlayableChar(std::string id, ResourceManager* r)
 PlayableChar::~PlayableChar()
 {
     delete cam;
-    DXRelease(splitScreenSRV);
-    DXRelease(splitScreenUAV);
-    DXRelease(splitScreenView);
 }
 
 void PlayableChar::Update(float deltaTime)
@@ -47,7 +44,7 @@ void PlayableChar::Update(float deltaTime)
 
         if (currState == PCState::JUMP && prevState == PCState::REST)
         {
-            res->getSound()->add("boing");
+            res->getSound()->add3D("boing", Translation, XMFLOAT3(0.f, 0.f, 0.f));
         }
 
         jumpTime += deltaTime;
@@ -109,11 +106,11 @@ void PlayableChar::initDash()
         currState = PCState::DASH;
         dashCooldown = DASH_CD;
         dashTimer = 0.f;
-        res->getSound()->add("woosh");
+        res->getSound()->add3D("woosh", Translation, XMFLOAT3(0.f, 0.f, 0.f));
     }
     else
     {
-        res->getSound()->add("no");
+        res->getSound()->add3D("no", Translation, XMFLOAT3(0.f, 0.f, 0.f));
     }
 }
 
@@ -222,3 +219,35 @@ void PlayableChar::ShadowDraw(ID3D11Device* device, ID3D11DeviceContext* deviceC
 
 
 }
+
+void PlayableChar::Save(PlayableCharSnapshot& s) const
+{
+    s.Translation = Translation;
+    s.Rotation = Rotation;
+    s.Velocity = Velocity;
+    s.Speed = Speed;
+    s.hitBox = hitBox;
+    s.currState = currState;
+    s.prevState = prevState;
+    s.dashTimer = dashTimer;
+    s.jumpTime = jumpTime;
+    s.dashCooldown = dashCooldown;
+    s.dashDirection = dashDirection;
+    s.npc = npc;
+}
+
+void PlayableChar::Load(const PlayableCharSnapshot& s)
+{
+    Translation = s.Translation;
+    Rotation = s.Rotation;
+    Velocity = s.Velocity;
+    Speed = s.Speed;
+    hitBox = s.hitBox;
+    currState = s.currState;
+    prevState = s.prevState;
+    dashTimer = s.dashTimer;
+    jumpTime = s.jumpTime;
+    dashCooldown = s.dashCooldown;
+    dashDirection = s.dashDirection;
+    npc = s.npc;
+}
@@ -11,9 +11,6 @@
 #define DASH_CD 1.5f
 #define DASH_DURATION .35f
 
-#define CAMERA_DIST_UP 6.0f
-#define CAMERA_DIST_BACK 40.0f
-
 enum class PCState
 {
     REST,
@@ -22,6 +19,18 @@ enum class PCState
     DASH
 };
 
+/*simulated state of a character, copied as a whole for rollback*/
+struct PlayableCharSnapshot
+{
+    XMFLOAT3 Translation, Rotation, Velocity;
+    float Speed;
+    BoundingOrientedBox hitBox;
+    PCState currState, prevState;
+    float dashTimer, jumpTime, dashCooldown;
+    int dashDirection;
+    bool npc;
+};
+
 
 class PlayableChar
 {
@@ -38,6 +47,9 @@ public:
 
     void initDash();
 
+    void Save(PlayableCharSnapshot& s) const;
+    void Load(const PlayableCharSnapshot& s);
+
     void Draw(ID3D11Device* device, ID3D11DeviceContext* deviceContext, Camera* c, XMMATRIX shadowT);
     void ShadowDraw(ID3D11Device* device, ID3D11DeviceContext* deviceContext, Camera* c, XMMATRIX lightView, XMMATRIX lightProj);
 
@@ -48,9 +60,6 @@ public:
     int metaPosition = -1;
     XMFLOAT4 Color;
     Player* controllingPlayer = 0;
-    ID3D11RenderTargetView* splitScreenView;
-    ID3D11ShaderResourceView* splitScreenSRV;
-    ID3D11UnorderedAccessView* splitScreenUAV;
 
     PCState currState, prevState;
     float dashTimer = 0.f;
@@ -0,0 +1,415 @@
+#include "PrimitiveGenerator.h"
+#include <algorithm>
+
+std::string PrimitiveDesc::Key() const
+{
+    static const char* names[] = { "uvsphere", "icosphere", "capsule", "box", "plane" };
+
+    std::ostringstream key;
+    key << "primitive:" << names[(int)shape]
+        << ":" << size.x << "," << size.y << "," << size.z
+        << ":" << tessellation[0] << "," << tessellation[1]
+        << ":" << tiling.x << "," << tiling.y << "," << tiling.z;
+
+    return key.str();
+}
+
+void PrimitiveGenerator::Create(const PrimitiveDesc& desc, Mesh* m)
+{
+    switch (desc.shape)
+    {
+        case PrimitiveShape::UVSphere:
+            UVSphere(m, desc.size.x, desc.tessellation[0], desc.tessellation[1], desc.tiling.x, desc.tiling.y);
+            break;
+        case PrimitiveShape::Icosphere:
+            Icosphere(m, desc.size.x, desc.tessellation[0], desc.tiling.x, desc.tiling.y);
+            break;
+        case PrimitiveShape::Capsule:
+            Capsule(m, desc.size.x, desc.size.y, desc.tessellation[0], desc.tessellation[1], desc.tiling.x, desc.tiling.y);
+            break;
+        case PrimitiveShape::Box:
+            Box(m, desc.size.x, desc.size.y, desc.size.z, desc.tiling);
+            break;
+        case PrimitiveShape::Plane:
+            Plane(m, desc.size.x, desc.size.z, desc.tessellation[0], desc.tessellation[1], desc.tiling.x, desc.tiling.z);
+            break;
+    }
+
+    m->hasTextureCoordinates = true;
+    m->hasTangentu = true;
+}
+
+/*sin and cos of start + i * step, four angles at once*/
+void PrimitiveGenerator::sinCosTable(int count, float start, float step, std::vector<float>& s, std::vector<float>& c)
+{
+    s.resize(count);
+    c.resize(count);
+
+    XMVECTOR angle = XMVectorAdd(XMVectorReplicate(start), XMVectorMultiply(XMVectorSet(0.f, 1.f, 2.f, 3.f), XMVectorReplicate(step)));
+    XMVECTOR advance = XMVectorReplicate(4.f * step);
+
+    for (int i = 0; i < count; i += 4)
+    {
+        XMVECTOR vs, vc;
+        XMVectorSinCos(&vs, &vc, angle);
+
+        XMFLOAT4 fs, fc;
+        XMStoreFloat4(&fs, vs);
+        XMStoreFloat4(&fc, vc);
+
+        const float* ps = &fs.x;
+        const float* pc = &fc.x;
+
+        for (int k = 0; k < 4 && i + k < count; k++)
+        {
+            s[i + k] = ps[k];
+            c[i + k] = pc[k];
+        }
+
+        angle = XMVectorAdd(angle, advance);
+    }
+}
+
+/*revolve the rows around the y axis, rows go from top to bottom*/
+void PrimitiveGenerator::lathe(Mesh* m, const std::vector<LatheRow>& rows, float radius, int slices, float tileU)
+{
+    std::vector<float> sinTheta, cosTheta;
+    sinCosTable(slices + 1, 0.f, XM_2PI / slices, sinTheta, cosTheta);
+
+    UINT base = (UINT)m->vertices.size();
+    UINT ringCount = slices + 1;
+
+    for (auto& r : rows)
+    {
+        for (int j = 0; j <= slices; j++)
+        {
+            Vertex::Standard v;
+
+            v.Normal = XMFLOAT3(r.sinPhi * cosTheta[j], r.cosPhi, r.sinPhi * sinTheta[j]);
+            v.Pos = XMFLOAT3(radius * v.Normal.x, radius * v.Normal.y + r.y, radius * v.Normal.z);
+            v.TangentU = XMFLOAT4(-sinTheta[j], 0.f, cosTheta[j], 1.f);
+            v.Tex = XMFLOAT2(tileU * j / slices, r.v);
+
+            m->vertices.push_back(v);
+        }
+    }
+
+    for (UINT i = 0; i + 1 < rows.size(); i++)
+    {
+        /*the first triangle collapses at the top pole, the second at the bottom pole*/
+        bool topPole = rows[i].sinPhi == 0.f;
+        bool botPole = rows[i + 1].sinPhi == 0.f;
+
+        for (UINT j = 0; j < (UINT)slices; j++)
+        {
+            UINT a = base + i * ringCount + j;
+            UINT b = base + (i + 1) * ringCount + j;
+
+            if (!topPole)
+            {
+                m->indices.push_back(a);
+                m->indices.push_back(a + 1);
+                m->indices.push_back(b);
+            }
+
+            if (!botPole)
+            {
+                m->indices.push_back(b);
+                m->indices.push_back(a + 1);
+                m->indices.push_back(b + 1);
+            }
+        }
+    }
+}
+
+void PrimitiveGenerator::UVSphere(Mesh* m, float radius, int slices, int stacks, float tileU, float tileV)
+{
+    slices = std::max(slices, 3);
+    stacks = std::max(stacks, 2);
+
+    std::vector<float> sinPhi, cosPhi;
+    sinCosTable(stacks + 1, 0.f, XM_PI / stacks, sinPhi, cosPhi);
+
+    /*exact poles so the degenerate triangles are detected*/
+    sinPhi[0] = sinPhi[stacks] = 0.f;
+
+    std::vector<LatheRow> rows(stacks + 1);
+
+    for (int i = 0; i <= stacks; i++)
+    {
+        rows[i] = { sinPhi[i], cosPhi[i], 0.f, tileV * i / stacks };
+    }
+
+    lathe(m, rows, radius, slices, tileU);
+}
+
+void PrimitiveGenerator::Capsule(Mesh* m, float radius, float height, int slices, int stacks, float tileU, float tileV)
+{
+    slices = std::max(slices, 3);
+    stacks = std::max(stacks, 1);
+
+    /*one table for both hemispheres, the equator ring is duplicated to form the cylinder*/
+    std::vector<float> sinPhi, cosPhi;
+    sinCosTable(2 * stacks + 1, 0.f, XM_PI / (2 * stacks), sinPhi, cosPhi);
+
+    sinPhi[0] = sinPhi[2 * stacks] = 0.f;
+    cosPhi[stacks] = 0.f;
+
+    /*v follows the arc length of the profile*/
+    float capLength = XM_PIDIV2 * radius;
+    float total = 2.f * capLength + height;
+
+    std::vector<LatheRow> rows;
+    rows.reserve(2 * stacks + 2);
+
+    for (int i = 0; i <= stacks; i++)
+    {
+        float v = capLength * i / stacks / total;
+        rows.push_back({ sinPhi[i], cosPhi[i], 0.5f * height, tileV * v });
+    }
+
+    for (int i = stacks; i <= 2 * stacks; i++)
+    {
+        float v = (capLength + height + capLength * (i - stacks) / stacks) / total;
+        rows.push_back({ sinPhi[i], cosPhi[i], -0.5f * height, tileV * v });
+    }
+
+    lathe(m, rows, radius, slices, tileU);
+}
+
+void PrimitiveGenerator::Icosphere(Mesh* m, float radius, int subdivisions, float tileU, float tileV)
+{
+    const float t = (1.f + sqrtf(5.f)) * 0.5f;
+
+    std::vector<XMFLOAT3> points =
+    {
+        XMFLOAT3(-1.f, t, 0.f), XMFLOAT3(1.f, t, 0.f), XMFLOAT3(-1.f, -t, 0.f), XMFLOAT3(1.f, -t, 0.f),
+        XMFLOAT3(0.f, -1.f, t), XMFLOAT3(0.f, 1.f, t), XMFLOAT3(0.f, -1.f, -t), XMFLOAT3(0.f, 1.f, -t),
+        XMFLOAT3(t, 0.f, -1.f), XMFLOAT3(t, 0.f, 1.f), XMFLOAT3(-t, 0.f, -1.f), XMFLOAT3(-t, 0.f, 1.f)
+    };
+
+    std::vector<UINT> faces =
+    {
+        0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+        1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+        3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+        4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1
+    };
+
+    for (auto& p : points)
+    {
+        XMStoreFloat3(&p, XMVector3Normalize(XMLoadFloat3(&p)));
+    }
+
+    /*split every triangle into four, shared edges reuse their midpoint*/
+    for (int s = 0; s < subdivisions; s++)
+    {
+        std::map<std::pair<UINT, UINT>, UINT> midpoints;
+        std::vector<UINT> next;
+        next.reserve(faces.size() * 4);
+
+        auto midpoint = [&](UINT a, UINT b)
+        {
+            std::pair<UINT, UINT> key(std::min(a, b), std::max(a, b));
+            auto it = midpoints.find(key);
+
+            if (it != midpoints.end())
+            {
+                return it->second;
+            }
+
+            XMFLOAT3 p;
+            XMStoreFloat3(&p, XMVector3Normalize(XMLoadFloat3(&points[a]) + XMLoadFloat3(&points[b])));
+            points.push_back(p);
+
+            UINT id = (UINT)points.size() - 1;
+            midpoints.insert(std::make_pair(key, id));
+            return id;
+        };
+
+        for (size_t f = 0; f < faces.size(); f += 3)
+        {
+            UINT a = faces[f], b = faces[f + 1], c = faces[f + 2];
+            UINT ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+
+            UINT tris[12] = { a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca };
+            next.insert(next.end(), &tris[0], &tris[12]);
+        }
+
+        faces.swap(next);
+    }
+
+    /*spherical uv mapping*/
+    UINT base = (UINT)m->vertices.size();
+
+    for (auto& p : points)
+    {
+        Vertex::Standard v;
+
+        float theta = atan2f(p.z, p.x);
+        if (theta < 0.f) theta += XM_2PI;
+
+        v.Normal = p;
+        v.Pos = XMFLOAT3(radius * p.x, radius * p.y, radius * p.z);
+        v.Tex = XMFLOAT2(theta / XM_2PI, acosf(std::max(-1.f, std::min(1.f, p.y))) / XM_PI);
+
+        float len = sqrtf(p.x * p.x + p.z * p.z);
+        v.TangentU = len > 0.f ? XMFLOAT4(-p.z / len, 0.f, p.x / len, 1.f) : XMFLOAT4(1.f, 0.f, 0.f, 1.f);
+
+        m->vertices.push_back(v);
+    }
+
+    /*triangles crossing the u seam get duplicated vertices with u + 1*/
+    std::map<UINT, UINT> wrapped;
+
+    for (size_t f = 0; f < faces.size(); f += 3)
+    {
+        UINT id[3] = { base + faces[f], base + faces[f + 1], base + faces[f + 2] };
+
+        float uMin = std::min(m->vertices[id[0]].Tex.x, std::min(m->vertices[id[1]].Tex.x, m->vertices[id[2]].Tex.x));
+        float uMax = std::max(m->vertices[id[0]].Tex.x, std::max(m->vertices[id[1]].Tex.x, m->vertices[id[2]].Tex.x));
+
+        if (uMax - uMin > 0.5f)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                if (m->vertices[id[k]].Tex.x >= 0.5f) continue;
+
+                auto it = wrapped.find(id[k]);
+
+                if (it == wrapped.end())
+                {
+                    Vertex::Standard v = m->vertices[id[k]];
+                    v.Tex.x += 1.f;
+                    m->vertices.push_back(v);
+
+                    it = wrapped.insert(std::make_pair(id[k], (UINT)m->vertices.size() - 1)).first;
+                }
+
+                id[k] = it->second;
+            }
+        }
+
+        /*clockwise when seen from outside*/
+        XMVECTOR p0 = XMLoadFloat3(&m->vertices[id[0]].Pos);
+        XMVECTOR p1 = XMLoadFloat3(&m->vertices[id[1]].Pos);
+        XMVECTOR p2 = XMLoadFloat3(&m->vertices[id[2]].Pos);
+
+        if (XMVectorGetX(XMVector3Dot(XMVector3Cross(p1 - p0, p2 - p0), p0 + p1 + p2)) < 0.f)
+        {
+            std::swap(id[1], id[2]);
+        }
+
+        m->indices.insert(m->indices.end(), &id[0], &id[3]);
+    }
+
+    for (auto& v : m->vertices)
+    {
+        v.Tex.x *= tileU;
+        v.Tex.y *= tileV;
+    }
+}
+
+void PrimitiveGenerator::Box(Mesh* m, float width, float height, float depth, const XMFLOAT3& tiling)
+{
+    float w = width * .5f;
+    float h = height * .5f;
+    float d = depth * .5f;
+
+    Vertex::Standard v[24];
+
+    /*front and back span x y*/
+    v[0] = Vertex::Standard(-w, -h, -d, 0.f, 1.f, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f);
+    v[1] = Vertex::Standard(-w, +h, -d, 0.f, 0.f, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f);
+    v[2] = Vertex::Standard(+w, +h, -d, 1.f, 0.f, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f);
+    v[3] = Vertex::Standard(+w, -h, -d, 1.f, 1.f, 0.f, 0.f, -1.f, 1.f, 0.f, 0.f);
+
+    v[4] = Vertex::Standard(-w, -h, +d, 1.f, 1.f, 0.f, 0.f, 1.f, -1.f, 0.f, 0.f);
+    v[5] = Vertex::Standard(+w, -h, +d, 0.f, 1.f, 0.f, 0.f, 1.f, -1.f, 0.f, 0.f);
+    v[6] = Vertex::Standard(+w, +h, +d, 0.f, 0.f, 0.f, 0.f, 1.f, -1.f, 0.f, 0.f);
+    v[7] = Vertex::Standard(-w, +h, +d, 1.f, 0.f, 0.f, 0.f, 1.f, -1.f, 0.f, 0.f);
+
+    /*top and bottom span x z*/
+    v[8] = Vertex::Standard(-w, +h, -d, 0.f, 1.f, 0.f, 1.f, 0.f, 1.f, 0.f, 0.f);
+    v[9] = Vertex::Standard(-w, +h, +d, 0.f, 0.f, 0.f, 1.f, 0.f, 1.f, 0.f, 0.f);
+    v[10] = Vertex::Standard(+w, +h, +d, 1.f, 0.f, 0.f, 1.f, 0.f, 1.f, 0.f, 0.f);
+    v[11] = Vertex::Standard(+w, +h, -d, 1.f, 1.f, 0.f, 1.f, 0.f, 1.f, 0.f, 0.f);
+
+    v[12] = Vertex::Standard(-w, -h, -d, 1.f, 1.f, 0.f, -1.f, 0.f, -1.f, 0.f, 0.f);
+    v[13] = Vertex::Standard(+w, -h, -d, 0.f, 1.f, 0.f, -1.f, 0.f, -1.f, 0.f, 0.f);
+    v[14] = Vertex::Standard(+w, -h, +d, 0.f, 0.f, 0.f, -1.f, 0.f, -1.f, 0.f, 0.f);
+    v[15] = Vertex::Standard(-w, -h, +d, 1.f, 0.f, 0.f, -1.f, 0.f, -1.f, 0.f, 0.f);
+
+    /*left and right span z y*/
+    v[16] = Vertex::Standard(-w, -h, +d, 0.f, 1.f, -1.f, 0.f, 0.f, 0.f, 0.f, -1.f);
+    v[17] = Vertex::Standard(-w, +h, +d, 0.f, 0.f, -1.f, 0.f, 0.f, 0.f, 0.f, -1.f);
+    v[18] = Vertex::Standard(-w, +h, -d, 1.f, 0.f, -1.f, 0.f, 0.f, 0.f, 0.f, -1.f);
+    v[19] = Vertex::Standard(-w, -h, -d, 1.f, 1.f, -1.f, 0.f, 0.f, 0.f, 0.f, -1.f);
+
+    v[20] = Vertex::Standard(+w, -h, -d, 0.f, 1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f);
+    v[21] = Vertex::Standard(+w, +h, -d, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f);
+    v[22] = Vertex::Standard(+w, +h, +d, 1.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f);
+    v[23] = Vertex::Standard(+w, -h, +d, 1.f, 1.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f);
+
+    XMFLOAT2 faceTiling[3] = { XMFLOAT2(tiling.x, tiling.y), XMFLOAT2(tiling.x, tiling.z), XMFLOAT2(tiling.z, tiling.y) };
+
+    UINT base = (UINT)m->vertices.size();
+
+    for (int i = 0; i < 24; i++)
+    {
+        v[i].Tex.x *= faceTiling[i / 8].x;
+        v[i].Tex.y *= faceTiling[i / 8].y;
+        m->vertices.push_back(v[i]);
+    }
+
+    for (UINT f = 0; f < 6; f++)
+    {
+        UINT i[6] = { 0, 1, 2, 0, 2, 3 };
+
+        for (int k = 0; k < 6; k++)
+        {
+            m->indices.push_back(base + f * 4 + i[k]);
+        }
+    }
+}
+
+/*grid in the xz plane, visible on both sides*/
+void PrimitiveGenerator::Plane(Mesh* m, float width, float depth, int cellsX, int cellsZ, float tileU, float tileV)
+{
+    cellsX = std::max(cellsX, 1);
+    cellsZ = std::max(cellsZ, 1);
+
+    float w = width * .5f;
+    float d = depth * .5f;
+
+    UINT base = (UINT)m->vertices.size();
+    UINT rowCount = cellsX + 1;
+
+    for (int z = 0; z <= cellsZ; z++)
+    {
+        for (int x = 0; x <= cellsX; x++)
+        {
+            float fx = (float)x / cellsX;
+            float fz = (float)z / cellsZ;
+
+            m->vertices.push_back(Vertex::Standard(XMFLOAT3(-w + fx * width, 0.f, -d + fz * depth),
+                                                   XMFLOAT2(fx * tileU, (1.f - fz) * tileV),
+                                                   XMFLOAT3(0.f, 1.f, 0.f),
+                                                   XMFLOAT3(1.f, 0.f, 0.f)));
+        }
+    }
+
+    for (UINT z = 0; z < (UINT)cellsZ; z++)
+    {
+        for (UINT x = 0; x < (UINT)cellsX; x++)
+        {
+            UINT a = base + z * rowCount + x;
+            UINT b = a + rowCount;
+            UINT c = b + 1;
+            UINT e = a + 1;
+
+            UINT i[12] = { a, b, c,  a, c, e,  a, c, b,  a, e, c };
+            m->indices.insert(m->indices.end(), &i[0], &i[12]);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+/* PrimitiveGenerator.h
+
+parametric primitives: uv sphere, icosphere, capsule, box and plane.
+texture coordinates are scaled by the tiling factors, so large floors and
+walls repeat their texture without a texture transform. sin and cos are
+precomputed in tables, four angles per XMVectorSinCos call.
+
+    Usage:
+    PrimitiveDesc desc;
+    desc.shape = PrimitiveShape::Plane;
+    desc.tiling = XMFLOAT3(40.f, 1.f, 40.f);
+    Mesh* mesh = model->CreateMesh();
+    PrimitiveGenerator::Create(desc, mesh);
+
+*/
+
+#pragma once
+
+#include "Model.h"
+
+enum class PrimitiveShape
+{
+    UVSphere,
+    Icosphere,
+    Capsule,
+    Box,
+    Plane
+};
+
+struct PrimitiveDesc
+{
+    PrimitiveShape shape = PrimitiveShape::Box;
+
+    /*box: width height depth, plane: width - depth, spheres: radius, capsule: radius cylinder height*/
+    XMFLOAT3 size = XMFLOAT3(1.f, 1.f, 1.f);
+
+    /*uv sphere and capsule: slices stacks, icosphere: subdivisions, plane: cells along x z*/
+    int tessellation[2] = { 1, 1 };
+
+    /*texture repeats along x y z, box faces use the two axes spanning the face*/
+    XMFLOAT3 tiling = XMFLOAT3(1.f, 1.f, 1.f);
+
+    /*unique id built from all parameters, used as model id*/
+    std::string Key() const;
+};
+
+class PrimitiveGenerator
+{
+public:
+    static void Create(const PrimitiveDesc& desc, Mesh* m);
+
+    static void UVSphere(Mesh* m, float radius, int slices, int stacks, float tileU, float tileV);
+    static void Icosphere(Mesh* m, float radius, int subdivisions, float tileU, float tileV);
+    static void Capsule(Mesh* m, float radius, float height, int slices, int stacks, float tileU, float tileV);
+    static void Box(Mesh* m, float width, float height, float depth, const XMFLOAT3& tiling);
+    static void Plane(Mesh* m, float width, float depth, int cellsX, int cellsZ, float tileU, float tileV);
+
+private:
+    /*one ring of a surface of revolution*/
+    struct LatheRow
+    {
+        float sinPhi, cosPhi;
+        float y, v;
+    };
+
+    static void sinCosTable(int count, float start, float step, std::vector<float>& s, std::vector<float>& c);
+    static void lathe(Mesh* m, const std::vector<LatheRow>& rows, float radius, int slices, float tileU);
+};
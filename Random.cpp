@@ -0,0 +1,226 @@
+#include "Random.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define RANDOM_SSE
+#include <emmintrin.h>
+#endif
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+static uint64_t matchSeed = 0;
+static Pcg32 shared;
+
+uint64_t SplitMix64::Next()
+{
+    state += 0x9e3779b97f4a7c15ull;
+    return Mix(state);
+}
+
+uint64_t SplitMix64::Mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+Pcg32::Pcg32(uint64_t seed, uint64_t stream)
+{
+    state = 0;
+    inc = (stream << 1) | 1;
+    Next();
+    state += seed;
+    Next();
+}
+
+uint32_t Pcg32::Next()
+{
+    uint64_t old = state;
+    state = old * 6364136223846793005ull + inc;
+
+    uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    uint32_t rot = static_cast<uint32_t>(old >> 59);
+
+    return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+float Pcg32::Float()
+{
+    return (Next() >> 8) * (1.f / 16777216.f);
+}
+
+float Pcg32::Float(float a, float b)
+{
+    return a + Float() * (b - a);
+}
+
+uint32_t Pcg32::Below(uint32_t n)
+{
+    if (n == 0)
+        return 0;
+
+    /*reject the top values that don't fill a whole range of n*/
+    uint32_t threshold = (0u - n) % n;
+
+    for (;;)
+    {
+        uint32_t r = Next();
+
+        if (r >= threshold)
+            return r % n;
+    }
+}
+
+void Random::Seed(uint64_t seed)
+{
+    matchSeed = seed;
+    shared = Stream(RandomStream::Shared);
+}
+
+uint64_t Random::MatchSeed()
+{
+    return matchSeed;
+}
+
+Pcg32 Random::Stream(RandomStream stream, uint64_t index)
+{
+    SplitMix64 s(matchSeed ^ SplitMix64::Mix((static_cast<uint64_t>(stream) << 32) ^ index));
+
+    uint64_t seed = s.Next();
+    return Pcg32(seed, s.Next());
+}
+
+Pcg32& Random::Shared()
+{
+    return shared;
+}
+
+void Random::Philox(uint64_t key, uint64_t counter, uint32_t out[4])
+{
+    const uint32_t c[4] = { static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), 0, 0 };
+    Philox128(key, c, out);
+}
+
+void Random::Philox128(uint64_t key, const uint32_t counter[4], uint32_t out[4])
+{
+    uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+    uint32_t k[2] = { static_cast<uint32_t>(key), static_cast<uint32_t>(key >> 32) };
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++)
+    {
+        uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c[0];
+        uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c[2];
+
+        uint32_t n[4] = {
+            static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+            static_cast<uint32_t>(p1),
+            static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+            static_cast<uint32_t>(p0)
+        };
+
+        c[0] = n[0]; c[1] = n[1]; c[2] = n[2]; c[3] = n[3];
+        k[0] += PHILOX_W0;
+        k[1] += PHILOX_W1;
+    }
+
+    out[0] = c[0]; out[1] = c[1]; out[2] = c[2]; out[3] = c[3];
+}
+
+#ifdef RANDOM_SSE
+/*low and high 32 bits of the four products a * m*/
+static void mulHiLo(__m128i a, __m128i m, __m128i& hi, __m128i& lo)
+{
+    __m128i even = _mm_shuffle_epi32(_mm_mul_epu32(a, m), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i odd = _mm_shuffle_epi32(_mm_mul_epu32(_mm_srli_epi64(a, 32), m), _MM_SHUFFLE(3, 1, 2, 0));
+
+    lo = _mm_unpacklo_epi32(even, odd);
+    hi = _mm_unpackhi_epi32(even, odd);
+}
+
+/*four blocks, one per lane, written block after block*/
+static void philox4(uint64_t key, uint64_t counter, float* out, float scale, float offset)
+{
+    __m128i c0 = _mm_setr_epi32(static_cast<int>(counter), static_cast<int>(counter + 1),
+                                static_cast<int>(counter + 2), static_cast<int>(counter + 3));
+    __m128i c1 = _mm_setr_epi32(static_cast<int>(counter >> 32), static_cast<int>((counter + 1) >> 32),
+                                static_cast<int>((counter + 2) >> 32), static_cast<int>((counter + 3) >> 32));
+    __m128i c2 = _mm_setzero_si128();
+    __m128i c3 = _mm_setzero_si128();
+
+    uint32_t k0 = static_cast<uint32_t>(key);
+    uint32_t k1 = static_cast<uint32_t>(key >> 32);
+
+    const __m128i m0 = _mm_set1_epi32(static_cast<int>(PHILOX_M0));
+    const __m128i m1 = _mm_set1_epi32(static_cast<int>(PHILOX_M1));
+
+    for (int r = 0; r < PHILOX_ROUNDS; r++)
+    {
+        __m128i hi0, lo0, hi1, lo1;
+        mulHiLo(c0, m0, hi0, lo0);
+        mulHiLo(c2, m1, hi1, lo1);
+
+        __m128i n0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32(static_cast<int>(k0)));
+        __m128i n2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32(static_cast<int>(k1)));
+
+        c0 = n0;
+        c1 = lo1;
+        c2 = n2;
+        c3 = lo0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    /*24 bits to a float, then one row per block*/
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 o = _mm_set1_ps(offset);
+
+    __m128 f0 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(c0, 8)), s), o);
+    __m128 f1 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(c1, 8)), s), o);
+    __m128 f2 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(c2, 8)), s), o);
+    __m128 f3 = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(c3, 8)), s), o);
+
+    _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+
+    _mm_storeu_ps(out, f0);
+    _mm_storeu_ps(out + 4, f1);
+    _mm_storeu_ps(out + 8, f2);
+    _mm_storeu_ps(out + 12, f3);
+}
+#endif
+
+void Random::Fill(float* out, size_t count, uint64_t key, uint64_t counter, float a, float b)
+{
+    float scale = (b - a) * (1.f / 16777216.f);
+    size_t i = 0;
+
+#ifdef RANDOM_SSE
+    for (; i + 16 <= count; i += 16, counter += 4)
+    {
+        philox4(key, counter, out + i, scale, a);
+    }
+#endif
+
+    for (; i < count; i += 4, counter++)
+    {
+        uint32_t block[4];
+        Philox(key, counter, block);
+
+        for (size_t j = 0; j < 4 && i + j < count; j++)
+        {
+            out[i + j] = (block[j] >> 8) * scale + a;
+        }
+    }
+}
+
+const char* Random::Simd()
+{
+#ifdef RANDOM_SSE
+    return "sse";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,92 @@
+/* Random.h
+
+random numbers for everything that has to repeat from a seed.
+
+SplitMix64 derives seeds, Pcg32 is the stream a system keeps and saves
+with its state, Philox is counter based: the numbers at any counter of a
+key are computed without a state, so a buffer is filled in any order and
+in batches of four blocks with sse.
+
+Random holds the match seed. every system takes its own stream from it,
+the same match seed gives the same match. Shared() is for values that
+don't need to repeat, it is restarted with the match seed too and must
+only be used on the main thread.
+
+only depends on the standard library.
+
+    Usage:
+    Random::Seed(matchSeed);
+    Pcg32 r = Random::Stream(RandomStream::Ball);
+    float angle = r.Float(0.f, 6.283f);
+
+    std::vector<float> values(4096);
+    Random::Fill(values.data(), values.size(), RANDOM_TEXTURE_KEY, 0, -1.f, 1.f);
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define RANDOM_TEXTURE_KEY 0x52414e44u
+
+enum class RandomStream : uint32_t
+{
+    Shared, Ball, Particles
+};
+
+struct SplitMix64
+{
+    uint64_t state;
+
+    explicit SplitMix64(uint64_t seed = 0) : state(seed) {}
+
+    uint64_t Next();
+
+    /*the output function alone, a well mixed hash of x*/
+    static uint64_t Mix(uint64_t x);
+};
+
+/*pcg32 xsh rr, plain data so snapshots can copy it*/
+struct Pcg32
+{
+    uint64_t state = 0x853c49e6748fea9bull;
+    uint64_t inc = 0xda3e39cb94b95bdbull;
+
+    Pcg32() = default;
+    Pcg32(uint64_t seed, uint64_t stream);
+
+    uint32_t Next();
+
+    /*0 - 1, 1 excluded*/
+    float Float();
+    float Float(float a, float b);
+
+    /*0 - n - 1 without modulo bias*/
+    uint32_t Below(uint32_t n);
+};
+
+class Random
+{
+public:
+    static void Seed(uint64_t matchSeed);
+    static uint64_t MatchSeed();
+
+    /*a stream of the match seed, index tells apart several users of one stream*/
+    static Pcg32 Stream(RandomStream stream, uint64_t index = 0);
+
+    static Pcg32& Shared();
+
+    /*philox 4x32-10, four numbers at counter of key*/
+    static void Philox(uint64_t key, uint64_t counter, uint32_t out[4]);
+
+    /*the same with all 128 bits of the counter, as in Random123*/
+    static void Philox128(uint64_t key, const uint32_t counter[4], uint32_t out[4]);
+
+    /*count floats a - b from the blocks starting at counter, 4 per block*/
+    static void Fill(float* out, size_t count, uint64_t key, uint64_t counter = 0, float a = 0.f, float b = 1.f);
+
+    /*instruction set of Fill*/
+    static const char* Simd();
+};
@@ -10,6 +10,7 @@ ResourceManager::ResourceManager(ID3D11Device* dev, ID3D11DeviceContext* con,Mic
     modCollection = new ModelCollection(dev);
     sound = new SoundEngine();
     bitmap = new BitmapManager(fac, d2con);
+    particleBuffers = new ParticleBufferPool(dev);
 }
 
 ResourceManager::~ResourceManager()
@@ -17,6 +18,9 @@ ResourceManager::~ResourceManager()
     delete texCollection;
     delete modCollection;
     delete sound;
+    delete particleBuffers;
+
+    DXRelease(randomTexture);
 }
 
 /*load all models in specified folder*/
@@ -90,3 +94,18 @@ BitmapManager* ResourceManager::getBitmap()
 {
     return bitmap;
 }
+
+ParticleBufferPool* ResourceManager::getParticleBuffers()
+{
+    return particleBuffers;
+}
+
+ID3D11ShaderResourceView* ResourceManager::getRandomTexture()
+{
+    if (!randomTexture)
+    {
+        randomTexture = CreateRandomTexture1DSRV(device);
+    }
+
+    return randomTexture;
+}
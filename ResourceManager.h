@@ -5,6 +5,7 @@
 #include "ModelCollection.h"
 #include "SoundEngine.h"
 #include "BitmapManager.h"
+#include "ParticleBufferPool.h"
 #include <filesystem>
 
 class ResourceManager
@@ -23,10 +24,14 @@ public:
     ModelCollection* getModelCollection();
     SoundEngine* getSound();
     BitmapManager* getBitmap();
+    ParticleBufferPool* getParticleBuffers();
 
     ID3D11ShaderResourceView* getTexture(std::string id);
     Model* getModel(std::string id);
 
+    /*1d texture of random values for the particle shaders, created once*/
+    ID3D11ShaderResourceView* getRandomTexture();
+
 private:
     ID3D11Device* device;
     ID3D11DeviceContext* context;
@@ -35,5 +40,8 @@ private:
     ModelCollection* modCollection;
     SoundEngine* sound;
     BitmapManager* bitmap;
+    ParticleBufferPool* particleBuffers;
+
+    ID3D11ShaderResourceView* randomTexture = nullptr;
 
 };
\ No newline at end of file
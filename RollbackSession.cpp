@@ -0,0 +1,280 @@
+#include "RollbackSession.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+RollbackSession::RollbackSession(RollbackGame* game, size_t stateSize, NetTransport* transport, int players, int localPlayer,
+                                 const std::vector<int>& peers, int inputDelay, uint8_t match)
+    : game(game), transport(transport), stateSize(stateSize), players(players), localPlayer(localPlayer),
+      inputDelay(std::clamp(inputDelay, 0, ROLLBACK_MAX_DELAY)), match(match), peers(peers)
+{
+    if (players < 1 || players > ROLLBACK_MAX_PLAYERS || localPlayer < 0 || localPlayer >= players ||
+        static_cast<int>(peers.size()) < players)
+    {
+        throw std::runtime_error("Invalid rollback session players");
+    }
+
+    for (int p = 0; p < ROLLBACK_MAX_PLAYERS; p++)
+    {
+        confirmed[p] = -1;
+        acked[p] = -1;
+        remoteFrame[p] = -1;
+        roundTrip[p] = 0;
+    }
+
+    /*nothing is scheduled for the first inputDelay frames*/
+    for (int f = 0; f < this->inputDelay; f++)
+    {
+        inputs[localPlayer][f] = NetInput();
+    }
+
+    confirmed[localPlayer] = this->inputDelay - 1;
+    rollbackFrame = INT_MAX;
+
+    snapshots.resize((ROLLBACK_MAX_FRAMES + 2) * stateSize);
+    packet.resize(NET_MAX_PACKET);
+
+    game->SaveState(snapshot(0));
+}
+
+uint8_t* RollbackSession::snapshot(int snapshotFrame)
+{
+    return &snapshots[(snapshotFrame % (ROLLBACK_MAX_FRAMES + 2)) * stateSize];
+}
+
+void RollbackSession::AddLocalInput(const NetInput& input)
+{
+    int target = std::max(frame + inputDelay, confirmed[localPlayer] + 1);
+
+    /*added more often than the session advances*/
+    if (target > frame + ROLLBACK_MAX_DELAY)
+        return;
+
+    /*a grown delay repeats the last input for the frames in between*/
+    NetInput last = inputFor(localPlayer, confirmed[localPlayer]);
+
+    for (int f = confirmed[localPlayer] + 1; f < target; f++)
+    {
+        inputs[localPlayer][f % ROLLBACK_HISTORY] = last;
+    }
+
+    inputs[localPlayer][target % ROLLBACK_HISTORY] = input;
+    confirmed[localPlayer] = target;
+}
+
+void RollbackSession::SetInputDelay(int frames)
+{
+    inputDelay = std::clamp(frames, 0, ROLLBACK_MAX_DELAY);
+}
+
+int RollbackSession::RecommendedDelay() const
+{
+    /*one way latency, rounded up*/
+    return std::clamp((stats.roundTrip + 1) / 2, 0, ROLLBACK_MAX_DELAY);
+}
+
+int RollbackSession::ConfirmedFrame() const
+{
+    int c = INT_MAX;
+
+    for (int p = 0; p < players; p++)
+    {
+        c = std::min(c, confirmed[p]);
+    }
+
+    return c;
+}
+
+NetInput RollbackSession::inputFor(int player, int inputFrame) const
+{
+    if (confirmed[player] < 0)
+        return NetInput();
+
+    /*predict the last known input*/
+    int f = std::min(inputFrame, confirmed[player]);
+    return inputs[player][f % ROLLBACK_HISTORY];
+}
+
+void RollbackSession::confirm(int player, int inputFrame, const NetInput& input)
+{
+    /*inputs are taken in order, a gap is filled by a later datagram*/
+    if (inputFrame != confirmed[player] + 1)
+        return;
+
+    /*far ahead inputs would overwrite the ring*/
+    if (inputFrame >= frame + ROLLBACK_HISTORY - ROLLBACK_MAX_FRAMES - 2)
+        return;
+
+    inputs[player][inputFrame % ROLLBACK_HISTORY] = input;
+    confirmed[player] = inputFrame;
+
+    if (inputFrame < frame && used[player][inputFrame % ROLLBACK_HISTORY] != input)
+    {
+        rollbackFrame = std::min(rollbackFrame, inputFrame);
+    }
+}
+
+void RollbackSession::simulate(int fromFrame, bool replay)
+{
+    NetInput step[ROLLBACK_MAX_PLAYERS];
+
+    for (int f = fromFrame; f < frame; f++)
+    {
+        for (int p = 0; p < players; p++)
+        {
+            step[p] = inputFor(p, f);
+            used[p][f % ROLLBACK_HISTORY] = step[p];
+        }
+
+        game->Step(step, players, replay);
+        game->SaveState(snapshot(f + 1));
+    }
+}
+
+bool RollbackSession::Advance()
+{
+    receive();
+
+    /*no local input added for this frame, keep the last one*/
+    if (confirmed[localPlayer] < frame)
+    {
+        AddLocalInput(inputFor(localPlayer, confirmed[localPlayer]));
+    }
+
+    if (rollbackFrame < frame)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        game->LoadState(snapshot(rollbackFrame));
+        simulate(rollbackFrame, true);
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        stats.rollbacks++;
+        stats.resimulatedFrames += frame - rollbackFrame;
+        stats.maxRollbackFrames = std::max(stats.maxRollbackFrames, frame - rollbackFrame);
+        stats.lastRollbackMs = elapsed.count();
+        stats.maxRollbackMs = std::max(stats.maxRollbackMs, stats.lastRollbackMs);
+    }
+
+    rollbackFrame = INT_MAX;
+
+    /*too far ahead of the inputs of another player*/
+    if (frame - ConfirmedFrame() > ROLLBACK_MAX_FRAMES)
+    {
+        stats.stalls++;
+        send();
+        return false;
+    }
+
+    frame++;
+    simulate(frame - 1, false);
+    stats.frames++;
+
+    /*one frame at a time, so a change of latency is not felt as a jump, and only
+      once a peer was heard of, a round trip of 0 is a measurement then*/
+    if (adaptiveDelay && frame % ROLLBACK_DELAY_INTERVAL == 0 && stats.packetsReceived > 0)
+    {
+        int recommended = RecommendedDelay();
+
+        if (recommended != inputDelay)
+        {
+            SetInputDelay(inputDelay + (recommended > inputDelay ? 1 : -1));
+        }
+    }
+
+    send();
+    return true;
+}
+
+void RollbackSession::Poll()
+{
+    receive();
+    send();
+}
+
+void RollbackSession::receive()
+{
+    int peer;
+
+    for (size_t size; (size = transport->Receive(packet.data(), packet.size(), peer)) > 0;)
+    {
+        Packet h;
+
+        if (size < sizeof(Packet))
+            continue;
+
+        memcpy(&h, packet.data(), sizeof(Packet));
+
+        if (h.match != match || h.player >= players || h.player == localPlayer || peers[h.player] != peer ||
+            size != sizeof(Packet) + h.count * sizeof(NetInput))
+        {
+            continue;
+        }
+
+        stats.packetsReceived++;
+
+        int p = h.player;
+        remoteFrame[p] = std::max(remoteFrame[p], static_cast<int>(h.frame));
+        acked[p] = std::max(acked[p], static_cast<int>(h.ack));
+
+        /*our frame when the peer last heard of us*/
+        if (h.echo >= 0)
+        {
+            roundTrip[p] = frame - h.echo;
+        }
+
+        const NetInput* received = reinterpret_cast<const NetInput*>(packet.data() + sizeof(Packet));
+
+        for (int i = 0; i < h.count; i++)
+        {
+            confirm(p, h.first + i, received[i]);
+        }
+    }
+
+    stats.roundTrip = 0;
+
+    for (int p = 0; p < players; p++)
+    {
+        if (p != localPlayer)
+            stats.roundTrip = std::max(stats.roundTrip, roundTrip[p]);
+    }
+}
+
+void RollbackSession::send()
+{
+    const int capacity = static_cast<int>((NET_MAX_PACKET - sizeof(Packet)) / sizeof(NetInput));
+
+    for (int p = 0; p < players; p++)
+    {
+        if (p == localPlayer)
+            continue;
+
+        /*every input the peer has not acknowledged that is still in the ring*/
+        int first = std::max(acked[p] + 1, confirmed[localPlayer] - ROLLBACK_HISTORY + 1);
+        int count = std::clamp(confirmed[localPlayer] - first + 1, 0, capacity);
+
+        Packet h;
+        h.match = match;
+        h.player = static_cast<uint8_t>(localPlayer);
+        h.count = static_cast<uint16_t>(count);
+        h.frame = frame;
+        h.echo = remoteFrame[p];
+        h.ack = confirmed[p];
+        h.first = first;
+
+        memcpy(packet.data(), &h, sizeof(Packet));
+
+        NetInput* out = reinterpret_cast<NetInput*>(packet.data() + sizeof(Packet));
+
+        for (int i = 0; i < count; i++)
+        {
+            out[i] = inputs[localPlayer][(first + i) % ROLLBACK_HISTORY];
+        }
+
+        transport->Send(peers[p], packet.data(), sizeof(Packet) + count * sizeof(NetInput));
+        stats.packetsSent++;
+    }
+}
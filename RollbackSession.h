@@ -0,0 +1,178 @@
+/* RollbackSession.h
+
+deterministic online play with rollback. every peer simulates all players
+in fixed steps. the input of the local player is scheduled inputDelay
+frames ahead and sent to the other peers, missing remote inputs are
+predicted by repeating their last known input. when an input arrives that
+differs from its prediction the game state is restored from the snapshot
+of that frame and the frames since are simulated again.
+
+the game keeps its simulated state in a plain struct of stateSize bytes,
+snapshots are copied with memcpy into a ring of ROLLBACK_MAX_FRAMES + 2
+entries. a peer that runs more than ROLLBACK_MAX_FRAMES ahead of the
+inputs it knows stalls until they arrive.
+
+every datagram repeats all local inputs the receiver has not acknowledged
+yet, so lost or reordered datagrams only delay inputs. the round trip is
+measured in frames, RecommendedDelay() turns it into an input delay that
+hides most rollbacks. with an adaptive delay the session moves its input
+delay one frame towards it every ROLLBACK_DELAY_INTERVAL frames.
+
+only depends on the standard library and a NetTransport.
+
+    Usage:
+    class Match : public RollbackGame { ... };
+
+    RollbackSession session(&match, sizeof(MatchState), transport, 4, localPlayer, peers);
+    ...
+    while (accumulator >= ROLLBACK_STEP)
+    {
+        session.AddLocalInput(input);
+        if (!session.Advance()) break;
+        accumulator -= ROLLBACK_STEP;
+    }
+
+*/
+
+#pragma once
+
+#include "NetTransport.h"
+#include <cstdint>
+#include <vector>
+
+#define ROLLBACK_STEP (1.f / 60.f)
+#define ROLLBACK_MAX_FRAMES 8
+#define ROLLBACK_MAX_PLAYERS 4
+#define ROLLBACK_INPUT_DELAY 2
+#define ROLLBACK_MAX_DELAY 10
+#define ROLLBACK_DELAY_INTERVAL 30
+
+/*ring of inputs, has to hold the frames a peer may be ahead of another*/
+#define ROLLBACK_HISTORY 64
+
+/*net input buttons*/
+#define NET_BUTTON_DASH_LEFT 0x01
+#define NET_BUTTON_DASH_RIGHT 0x02
+#define NET_BUTTON_JUMP 0x04
+
+/*quantized so every peer simulates the same values*/
+struct NetInput
+{
+    int8_t moveX = 0;
+    uint8_t buttons = 0;
+
+    bool operator==(const NetInput& o) const { return moveX == o.moveX && buttons == o.buttons; }
+    bool operator!=(const NetInput& o) const { return !(*this == o); }
+
+    float Move() const { return moveX / 127.f; }
+};
+
+class RollbackGame
+{
+public:
+    virtual ~RollbackGame() = default;
+
+    virtual void SaveState(void* state) = 0;
+    virtual void LoadState(const void* state) = 0;
+
+    /*one fixed step with the input of every player, replay is set while re-simulating*/
+    virtual void Step(const NetInput* inputs, int players, bool replay) = 0;
+};
+
+struct RollbackStats
+{
+    unsigned long long frames = 0;
+    unsigned long long rollbacks = 0;
+    unsigned long long resimulatedFrames = 0;
+    unsigned long long stalls = 0;
+    unsigned long long packetsSent = 0;
+    unsigned long long packetsReceived = 0;
+    int maxRollbackFrames = 0;
+    double lastRollbackMs = 0.0;
+    double maxRollbackMs = 0.0;
+
+    /*round trip to the slowest peer, in frames*/
+    int roundTrip = 0;
+};
+
+class RollbackSession
+{
+public:
+    /*peers holds the transport peer of every player, the local entry is ignored*/
+    RollbackSession(RollbackGame* game, size_t stateSize, NetTransport* transport, int players, int localPlayer,
+                    const std::vector<int>& peers, int inputDelay = ROLLBACK_INPUT_DELAY, uint8_t match = 0);
+
+    /*input of the local player for the frame inputDelay frames ahead*/
+    void AddLocalInput(const NetInput& input);
+
+    /*receive, roll back if needed and simulate one frame, false while stalled*/
+    bool Advance();
+
+    /*only exchange inputs, lets the other peers confirm their last frames after the local match ended*/
+    void Poll();
+
+    /*a larger delay repeats the last input, a smaller one takes effect once the scheduled inputs are used*/
+    void SetInputDelay(int frames);
+    int InputDelay() const { return inputDelay; }
+    int RecommendedDelay() const;
+
+    /*follow RecommendedDelay() instead of keeping the delay that was set*/
+    void SetAdaptiveDelay(bool adaptive) { adaptiveDelay = adaptive; }
+
+    int Frame() const { return frame; }
+
+    /*last frame with the inputs of all players known*/
+    int ConfirmedFrame() const;
+
+    const RollbackStats& Stats() const { return stats; }
+
+private:
+    struct Packet
+    {
+        uint8_t match;
+        uint8_t player;
+        uint16_t count;
+        int32_t frame;
+        int32_t echo;
+        int32_t ack;
+        int32_t first;
+    };
+
+    void receive();
+    void send();
+    void confirm(int player, int inputFrame, const NetInput& input);
+    NetInput inputFor(int player, int inputFrame) const;
+    void simulate(int fromFrame, bool replay);
+    uint8_t* snapshot(int snapshotFrame);
+
+    RollbackGame* game;
+    NetTransport* transport;
+    size_t stateSize;
+    int players;
+    int localPlayer;
+    int inputDelay;
+    bool adaptiveDelay = false;
+    uint8_t match;
+    std::vector<int> peers;
+
+    int frame = 0;
+
+    /*earliest frame simulated with a wrong prediction*/
+    int rollbackFrame;
+
+    NetInput inputs[ROLLBACK_MAX_PLAYERS][ROLLBACK_HISTORY];
+    NetInput used[ROLLBACK_MAX_PLAYERS][ROLLBACK_HISTORY];
+
+    /*last frame with a known input per player, contiguous from frame 0*/
+    int confirmed[ROLLBACK_MAX_PLAYERS];
+
+    /*per player: our inputs the peer has, and the newest frame of the peer we have seen*/
+    int acked[ROLLBACK_MAX_PLAYERS];
+    int remoteFrame[ROLLBACK_MAX_PLAYERS];
+    int roundTrip[ROLLBACK_MAX_PLAYERS];
+
+    std::vector<uint8_t> snapshots;
+    std::vector<uint8_t> packet;
+
+    RollbackStats stats;
+};
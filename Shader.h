@@ -3,6 +3,7 @@
 #include "util.h"
 #include "d3dx11effect.h"
 #include "Model.h"
+#include "BlurKernel.h"
 
 namespace UShader {
     enum class UsedShader
@@ -157,7 +158,8 @@ public:
     BlurShader(ID3D11Device* device, const std::wstring& filename);
     ~BlurShader();
 
-    void SetWeights(const float _weights[9]) { weights->SetFloatArray(_weights, 0, 9); }
+    /*gWeights of blur.fx, 2 * BLUR_SHADER_RADIUS + 1 values*/
+    void SetWeights(const float* _weights) { weights->SetFloatArray(_weights, 0, 2 * BLUR_SHADER_RADIUS + 1); }
     void SetInput(ID3D11ShaderResourceView* tex) { input->SetResource(tex); }
     void SetOutput(ID3D11UnorderedAccessView* tex) { output->SetUnorderedAccessView(tex); }
 
@@ -0,0 +1,1248 @@
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+/*layout of the varyings, the shadow pass only interpolates the texture coordinates*/
+#define VARYING_POS 0
+#define VARYING_NORMAL 3
+#define VARYING_TANGENT 6
+#define VARYING_TEX 9
+#define VARYING_SHADOW 11
+
+/*clip space outcodes*/
+#define OUT_LEFT 0x01
+#define OUT_RIGHT 0x02
+#define OUT_BOTTOM 0x04
+#define OUT_TOP 0x08
+#define OUT_NEAR 0x10
+#define OUT_FAR 0x20
+
+/*dds header flags*/
+#define DDS_PITCH 0x8
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+
+using Clock = std::chrono::steady_clock;
+
+static double milliseconds(Clock::time_point from, Clock::time_point to)
+{
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+static SoftFloat3 cross(const SoftFloat3& a, const SoftFloat3& b)
+{
+    return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static float dot(const SoftFloat3& a, const SoftFloat3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static SoftFloat3 normalize(const SoftFloat3& v)
+{
+    float l = std::sqrt(dot(v, v));
+
+    if (l <= 0.f)
+        return v;
+
+    return { v.x / l, v.y / l, v.z / l };
+}
+
+SoftMatrix SoftMatrix::Identity()
+{
+    SoftMatrix r = {};
+    r.m[0][0] = r.m[1][1] = r.m[2][2] = r.m[3][3] = 1.f;
+    return r;
+}
+
+SoftMatrix SoftMatrix::Scaling(float x, float y, float z)
+{
+    SoftMatrix r = Identity();
+    r.m[0][0] = x; r.m[1][1] = y; r.m[2][2] = z;
+    return r;
+}
+
+SoftMatrix SoftMatrix::Translation(float x, float y, float z)
+{
+    SoftMatrix r = Identity();
+    r.m[3][0] = x; r.m[3][1] = y; r.m[3][2] = z;
+    return r;
+}
+
+/*roll around z, then pitch around x, then yaw around y*/
+SoftMatrix SoftMatrix::RotationRollPitchYaw(float pitch, float yaw, float roll)
+{
+    float sp = std::sin(pitch), cp = std::cos(pitch);
+    float sy = std::sin(yaw), cy = std::cos(yaw);
+    float sr = std::sin(roll), cr = std::cos(roll);
+
+    SoftMatrix z = Identity(), x = Identity(), y = Identity();
+
+    z.m[0][0] = cr; z.m[0][1] = sr; z.m[1][0] = -sr; z.m[1][1] = cr;
+    x.m[1][1] = cp; x.m[1][2] = sp; x.m[2][1] = -sp; x.m[2][2] = cp;
+    y.m[0][0] = cy; y.m[0][2] = -sy; y.m[2][0] = sy; y.m[2][2] = cy;
+
+    return z * x * y;
+}
+
+SoftMatrix SoftMatrix::LookAtLH(const SoftFloat3& eye, const SoftFloat3& target, const SoftFloat3& up)
+{
+    SoftFloat3 look = normalize({ target.x - eye.x, target.y - eye.y, target.z - eye.z });
+    SoftFloat3 right = normalize(cross(up, look));
+    SoftFloat3 u = cross(look, right);
+
+    SoftMatrix r = Identity();
+    const SoftFloat3* axes[3] = { &right, &u, &look };
+
+    for (int k = 0; k < 3; k++)
+    {
+        r.m[0][k] = axes[k]->x;
+        r.m[1][k] = axes[k]->y;
+        r.m[2][k] = axes[k]->z;
+        r.m[3][k] = -dot(*axes[k], eye);
+    }
+
+    return r;
+}
+
+SoftMatrix SoftMatrix::PerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ)
+{
+    float h = std::cos(0.5f * fovY) / std::sin(0.5f * fovY);
+    float range = farZ / (farZ - nearZ);
+
+    SoftMatrix r = {};
+    r.m[0][0] = h / aspect;
+    r.m[1][1] = h;
+    r.m[2][2] = range;
+    r.m[2][3] = 1.f;
+    r.m[3][2] = -range * nearZ;
+    return r;
+}
+
+SoftMatrix SoftMatrix::OrthographicOffCenterLH(float left, float right, float bottom, float top, float nearZ, float farZ)
+{
+    float w = 1.f / (right - left);
+    float h = 1.f / (top - bottom);
+    float range = 1.f / (farZ - nearZ);
+
+    SoftMatrix r = Identity();
+    r.m[0][0] = 2.f * w;
+    r.m[1][1] = 2.f * h;
+    r.m[2][2] = range;
+    r.m[3][0] = -(left + right) * w;
+    r.m[3][1] = -(top + bottom) * h;
+    r.m[3][2] = -range * nearZ;
+    return r;
+}
+
+SoftMatrix SoftMatrix::operator*(const SoftMatrix& o) const
+{
+    SoftMatrix r;
+
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            r.m[i][j] = m[i][0] * o.m[0][j] + m[i][1] * o.m[1][j] + m[i][2] * o.m[2][j] + m[i][3] * o.m[3][j];
+        }
+    }
+
+    return r;
+}
+
+static SoftFloat4 transformPoint(const SoftFloat3& p, const SoftMatrix& m)
+{
+    SoftFloat4 r;
+    r.x = p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + m.m[3][0];
+    r.y = p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + m.m[3][1];
+    r.z = p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + m.m[3][2];
+    r.w = p.x * m.m[0][3] + p.y * m.m[1][3] + p.z * m.m[2][3] + m.m[3][3];
+    return r;
+}
+
+static SoftFloat3 transformVector(const SoftFloat3& v, const float m[3][3])
+{
+    return { v.x * m[0][0] + v.y * m[1][0] + v.z * m[2][0],
+             v.x * m[0][1] + v.y * m[1][1] + v.z * m[2][1],
+             v.x * m[0][2] + v.y * m[1][2] + v.z * m[2][2] };
+}
+
+static float saturate(float v)
+{
+    return v < 0.f ? 0.f : (v > 1.f ? 1.f : v);
+}
+
+static uint32_t packColor(const SoftFloat4& c)
+{
+    uint32_t r = (uint32_t)(saturate(c.x) * 255.f + 0.5f);
+    uint32_t g = (uint32_t)(saturate(c.y) * 255.f + 0.5f);
+    uint32_t b = (uint32_t)(saturate(c.z) * 255.f + 0.5f);
+
+    return r | (g << 8) | (b << 16) | 0xff000000u;
+}
+
+static SoftFloat4 unpackColor(uint32_t c)
+{
+    const float s = 1.f / 255.f;
+    return { (c & 0xff) * s, ((c >> 8) & 0xff) * s, ((c >> 16) & 0xff) * s, (c >> 24) * s };
+}
+
+/*texture*/
+
+static uint32_t fourCC(const char* s)
+{
+    return (uint32_t)s[0] | ((uint32_t)s[1] << 8) | ((uint32_t)s[2] << 16) | ((uint32_t)s[3] << 24);
+}
+
+static uint32_t expand565(uint16_t c)
+{
+    uint32_t r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16);
+}
+
+/*rgb of the four palette entries of a bc color block, the bc1 three color mode has a transparent black*/
+static void decodeColorBlock(const uint8_t* block, bool bc1, uint32_t out[16])
+{
+    uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+    uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+    uint32_t palette[4];
+
+    palette[0] = expand565(c0) | 0xff000000u;
+    palette[1] = expand565(c1) | 0xff000000u;
+
+    auto mix = [&](int w0, int w1, int d)
+    {
+        uint32_t r = 0;
+
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            uint32_t a = (palette[0] >> shift) & 0xff, b = (palette[1] >> shift) & 0xff;
+            r |= ((a * w0 + b * w1) / d) << shift;
+        }
+
+        return r | 0xff000000u;
+    };
+
+    if (c0 > c1 || !bc1)
+    {
+        palette[2] = mix(2, 1, 3);
+        palette[3] = mix(1, 2, 3);
+    }
+    else
+    {
+        palette[2] = mix(1, 1, 2);
+        palette[3] = 0;
+    }
+
+    uint32_t bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+
+    for (int i = 0; i < 16; i++)
+    {
+        out[i] = palette[(bits >> (2 * i)) & 3];
+    }
+}
+
+static void decodeAlphaBlock(const uint8_t* block, bool bc2, uint32_t out[16])
+{
+    uint8_t alpha[16];
+
+    if (bc2)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            uint8_t a = (block[i / 2] >> ((i & 1) * 4)) & 15;
+            alpha[i] = (uint8_t)(a * 17);
+        }
+    }
+    else
+    {
+        uint32_t a0 = block[0], a1 = block[1];
+        uint8_t palette[8] = { (uint8_t)a0, (uint8_t)a1 };
+
+        if (a0 > a1)
+        {
+            for (int i = 1; i < 7; i++)
+                palette[i + 1] = (uint8_t)(((7 - i) * a0 + i * a1) / 7);
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+                palette[i + 1] = (uint8_t)(((5 - i) * a0 + i * a1) / 5);
+
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t bits = 0;
+
+        for (int i = 0; i < 6; i++)
+        {
+            bits |= (uint64_t)block[2 + i] << (8 * i);
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            alpha[i] = palette[(bits >> (3 * i)) & 7];
+        }
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        out[i] = (out[i] & 0x00ffffffu) | ((uint32_t)alpha[i] << 24);
+    }
+}
+
+static uint32_t maskChannel(uint32_t pixel, uint32_t mask, uint32_t fallback)
+{
+    if (mask == 0)
+        return fallback;
+
+    int shift = 0;
+
+    while (((mask >> shift) & 1) == 0)
+        shift++;
+
+    uint32_t max = mask >> shift;
+    return (((pixel & mask) >> shift) * 255 + max / 2) / max;
+}
+
+bool SoftTexture::LoadDDS(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+
+    if (!in.is_open())
+        return false;
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    auto u32 = [&](size_t offset)
+    {
+        uint32_t v;
+        memcpy(&v, &data[offset], 4);
+        return v;
+    };
+
+    if (data.size() < 128 || memcmp(data.data(), "DDS ", 4) != 0 || u32(4) != 124 || u32(76) != 32)
+        return false;
+
+    uint32_t h = u32(12), w = u32(16);
+    uint32_t formatFlags = u32(80), code = u32(84), bits = u32(88);
+    uint32_t masks[4] = { u32(92), u32(96), u32(100), u32(104) };
+    size_t offset = 128;
+    int bc = 0;
+
+    if (w == 0 || h == 0 || w > 16384 || h > 16384)
+        return false;
+
+    if (formatFlags & DDPF_FOURCC)
+    {
+        if (code == fourCC("DXT1"))
+            bc = 1;
+        else if (code == fourCC("DXT2") || code == fourCC("DXT3"))
+            bc = 2;
+        else if (code == fourCC("DXT4") || code == fourCC("DXT5"))
+            bc = 3;
+        else if (code == fourCC("DX10") && data.size() >= 148)
+        {
+            uint32_t dxgi = u32(128);
+            offset = 148;
+
+            if (dxgi == 71 || dxgi == 72)
+                bc = 1;
+            else if (dxgi == 74 || dxgi == 75)
+                bc = 2;
+            else if (dxgi == 77 || dxgi == 78)
+                bc = 3;
+            else if (dxgi == 28 || dxgi == 29)
+            {
+                bits = 32;
+                masks[0] = 0xff; masks[1] = 0xff00; masks[2] = 0xff0000; masks[3] = 0xff000000;
+            }
+            else if (dxgi == 87 || dxgi == 91)
+            {
+                bits = 32;
+                masks[0] = 0xff0000; masks[1] = 0xff00; masks[2] = 0xff; masks[3] = 0xff000000;
+            }
+            else
+                return false;
+        }
+        else
+            return false;
+    }
+    else if (!(formatFlags & DDPF_RGB) || (bits != 24 && bits != 32))
+    {
+        return false;
+    }
+    else if (!(formatFlags & DDPF_ALPHAPIXELS))
+    {
+        masks[3] = 0;
+    }
+
+    std::vector<uint32_t> out((size_t)w * h);
+
+    if (bc)
+    {
+        size_t blocksX = (w + 3) / 4, blocksY = (h + 3) / 4;
+        size_t blockSize = bc == 1 ? 8 : 16;
+
+        if (data.size() < offset + blocksX * blocksY * blockSize)
+            return false;
+
+        uint32_t texels4x4[16];
+
+        for (size_t by = 0; by < blocksY; by++)
+        {
+            for (size_t bx = 0; bx < blocksX; bx++)
+            {
+                const uint8_t* block = &data[offset + (by * blocksX + bx) * blockSize];
+
+                decodeColorBlock(block + blockSize - 8, bc == 1, texels4x4);
+
+                if (bc > 1)
+                    decodeAlphaBlock(block, bc == 2, texels4x4);
+
+                for (size_t i = 0; i < 16; i++)
+                {
+                    size_t x = bx * 4 + i % 4, y = by * 4 + i / 4;
+
+                    if (x < w && y < h)
+                        out[y * w + x] = texels4x4[i];
+                }
+            }
+        }
+    }
+    else
+    {
+        size_t bytes = bits / 8;
+        size_t pitch = (u32(8) & DDS_PITCH) && u32(20) >= w * bytes ? u32(20) : w * bytes;
+
+        if (data.size() < offset + pitch * (h - 1) + w * bytes)
+            return false;
+
+        for (size_t y = 0; y < h; y++)
+        {
+            for (size_t x = 0; x < w; x++)
+            {
+                uint32_t pixel = 0;
+                memcpy(&pixel, &data[offset + y * pitch + x * bytes], bytes);
+
+                out[y * w + x] = maskChannel(pixel, masks[0], 0) | (maskChannel(pixel, masks[1], 0) << 8) |
+                                 (maskChannel(pixel, masks[2], 0) << 16) | (maskChannel(pixel, masks[3], 255) << 24);
+            }
+        }
+    }
+
+    width = (int)w;
+    height = (int)h;
+    texels = std::move(out);
+
+    return true;
+}
+
+void SoftTexture::Create(int w, int h, const uint32_t* data)
+{
+    width = w;
+    height = h;
+    texels.assign(data, data + (size_t)w * h);
+}
+
+SoftFloat4 SoftTexture::Sample(float u, float v) const
+{
+    if (texels.empty() || !std::isfinite(u) || !std::isfinite(v))
+        return { 1.f, 1.f, 1.f, 1.f };
+
+    /*wrap first, the texel position stays in [-0.5, size - 0.5)*/
+    float x = (u - std::floor(u)) * width - 0.5f;
+    float y = (v - std::floor(v)) * height - 0.5f;
+
+    float fx = std::floor(x), fy = std::floor(y);
+    float wx = x - fx, wy = y - fy;
+
+    int x0 = (int)fx, y0 = (int)fy;
+    int x1 = x0 + 1, y1 = y0 + 1;
+
+    if (x0 < 0) x0 += width;
+    if (y0 < 0) y0 += height;
+    if (x1 >= width) x1 -= width;
+    if (y1 >= height) y1 -= height;
+
+    SoftFloat4 a = unpackColor(texels[(size_t)y0 * width + x0]);
+    SoftFloat4 b = unpackColor(texels[(size_t)y0 * width + x1]);
+    SoftFloat4 c = unpackColor(texels[(size_t)y1 * width + x0]);
+    SoftFloat4 d = unpackColor(texels[(size_t)y1 * width + x1]);
+
+    auto lerp2 = [&](float p, float q, float r, float s)
+    {
+        return (p * (1.f - wx) + q * wx) * (1.f - wy) + (r * (1.f - wx) + s * wx) * wy;
+    };
+
+    return { lerp2(a.x, b.x, c.x, d.x), lerp2(a.y, b.y, c.y, d.y), lerp2(a.z, b.z, c.z, d.z), lerp2(a.w, b.w, c.w, d.w) };
+}
+
+/*rasterizer*/
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, int threads, int shadowSize) : width(width), height(height)
+{
+    this->threads = threads > 0 ? threads : (std::max)(1, (int)std::thread::hardware_concurrency());
+
+    color.assign((size_t)width * height, 0xff000000u);
+
+    screen.width = width;
+    screen.height = height;
+    screen.depth.assign((size_t)width * height, 1.f);
+    screen.color = &color;
+
+    shadow.width = shadowSize;
+    shadow.height = shadowSize;
+    shadow.depth.assign((size_t)shadowSize * shadowSize, 1.f);
+    shadow.color = nullptr;
+}
+
+void SoftwareRasterizer::Clear(const SoftFloat4& c)
+{
+    std::fill(color.begin(), color.end(), packColor(c));
+
+    tileTimings.clear();
+    stats = SoftStats();
+}
+
+void SoftwareRasterizer::parallel(int count, const std::function<void(int)>& work) const
+{
+    std::atomic<int> next(0);
+
+    auto run = [&]()
+    {
+        for (int i = next++; i < count; i = next++)
+        {
+            work(i);
+        }
+    };
+
+    std::vector<std::thread> workers;
+
+    for (int t = 1; t < threads && t < count; t++)
+    {
+        workers.emplace_back(run);
+    }
+
+    run();
+
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+}
+
+void SoftwareRasterizer::Render(const SoftScene& scene)
+{
+    Clock::time_point start = Clock::now();
+
+    SoftViewport viewport = scene.viewport;
+
+    if (viewport.width <= 0 || viewport.height <= 0)
+    {
+        viewport.width = width - viewport.x;
+        viewport.height = height - viewport.y;
+    }
+
+    viewport.x = std::clamp(viewport.x, 0, width);
+    viewport.y = std::clamp(viewport.y, 0, height);
+    viewport.width = std::clamp(viewport.width, 0, width - viewport.x);
+    viewport.height = std::clamp(viewport.height, 0, height - viewport.y);
+
+    if (scene.shadows)
+    {
+        SoftViewport full;
+        full.width = shadow.width;
+        full.height = shadow.height;
+
+        pass(scene, true, shadow, full);
+        stats.shadowMs += milliseconds(start, Clock::now());
+    }
+
+    pass(scene, false, screen, viewport);
+    stats.totalMs += milliseconds(start, Clock::now());
+}
+
+void SoftwareRasterizer::pass(const SoftScene& scene, bool shadowPass, Target& target, const SoftViewport& viewport)
+{
+    Clock::time_point start = Clock::now();
+
+    for (int y = viewport.y; y < viewport.y + viewport.height; y++)
+    {
+        std::fill_n(target.depth.begin() + (size_t)y * target.width + viewport.x, viewport.width, 1.f);
+    }
+
+    /*transform, clip and set up every instance on its own*/
+    size_t count = scene.instances.size();
+
+    if (transformed.size() < count)
+    {
+        transformed.resize(count);
+        triangles.resize(count);
+    }
+
+    parallel((int)count, [&](int i)
+    {
+        setup(scene, scene.instances[i], shadowPass, viewport, transformed[i], triangles[i]);
+    });
+
+    Clock::time_point setupEnd = Clock::now();
+
+    /*bin in draw order, so the depth test resolves ties like the gpu*/
+    tilesX = (viewport.width + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    tilesY = (viewport.height + SOFT_TILE_SIZE - 1) / SOFT_TILE_SIZE;
+    bins.resize((size_t)tilesX * tilesY);
+
+    for (auto& b : bins)
+    {
+        b.clear();
+    }
+
+    size_t triangleCount = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        for (const Triangle& t : triangles[i])
+        {
+            int tx0 = (t.minX - viewport.x) / SOFT_TILE_SIZE, tx1 = (t.maxX - viewport.x) / SOFT_TILE_SIZE;
+            int ty0 = (t.minY - viewport.y) / SOFT_TILE_SIZE, ty1 = (t.maxY - viewport.y) / SOFT_TILE_SIZE;
+
+            for (int ty = ty0; ty <= ty1; ty++)
+            {
+                for (int tx = tx0; tx <= tx1; tx++)
+                {
+                    bins[(size_t)ty * tilesX + tx].push_back(&t);
+                }
+            }
+        }
+
+        triangleCount += triangles[i].size();
+    }
+
+    Clock::time_point binEnd = Clock::now();
+
+    passTimings.resize(bins.size());
+
+    parallel((int)bins.size(), [&](int tile)
+    {
+        rasterTile(scene, tile, shadowPass, target, viewport);
+    });
+
+    if (!shadowPass)
+    {
+        stats.vertexMs += milliseconds(start, setupEnd);
+        stats.binMs += milliseconds(setupEnd, binEnd);
+        stats.rasterMs += milliseconds(binEnd, Clock::now());
+        stats.triangles += triangleCount;
+
+        for (const auto& t : passTimings)
+        {
+            stats.pixels += t.pixels;
+        }
+
+        tileTimings.insert(tileTimings.end(), passTimings.begin(), passTimings.end());
+    }
+}
+
+void SoftwareRasterizer::setup(const SoftScene& scene, const SoftInstance& instance, bool shadowPass,
+                               const SoftViewport& viewport, std::vector<ClipVertex>& vertices,
+                               std::vector<Triangle>& out) const
+{
+    out.clear();
+
+    const SoftMesh* mesh = instance.mesh;
+
+    if (!mesh || (shadowPass && !instance.castsShadow))
+        return;
+
+    SoftMatrix toClip = instance.world * (shadowPass ? scene.lightViewProj : scene.view * scene.proj);
+    SoftMatrix toShadow = instance.world * scene.shadowTransform;
+
+    /*normals use the inverse transpose, tangents the world matrix*/
+    float world3[3][3], normal3[3][3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            world3[i][j] = instance.world.m[i][j];
+        }
+    }
+
+    SoftFloat3 r0 = { world3[0][0], world3[0][1], world3[0][2] };
+    SoftFloat3 r1 = { world3[1][0], world3[1][1], world3[1][2] };
+    SoftFloat3 r2 = { world3[2][0], world3[2][1], world3[2][2] };
+    SoftFloat3 c[3] = { cross(r1, r2), cross(r2, r0), cross(r0, r1) };
+    float det = dot(r0, c[0]);
+    float invDet = det != 0.f ? 1.f / det : 0.f;
+
+    for (int i = 0; i < 3; i++)
+    {
+        normal3[i][0] = c[i].x * invDet;
+        normal3[i][1] = c[i].y * invDet;
+        normal3[i][2] = c[i].z * invDet;
+    }
+
+    vertices.resize(mesh->vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const SoftVertex& in = mesh->vertices[i];
+        ClipVertex& o = vertices[i];
+
+        SoftFloat4 p = transformPoint(in.pos, toClip);
+        o.x = p.x;
+        o.y = p.y;
+        o.z = p.z;
+        o.w = p.w;
+
+        o.outcode = (p.x < -p.w ? OUT_LEFT : 0) | (p.x > p.w ? OUT_RIGHT : 0) | (p.y < -p.w ? OUT_BOTTOM : 0) |
+                    (p.y > p.w ? OUT_TOP : 0) | (p.z < 0.f ? OUT_NEAR : 0) | (p.z > p.w ? OUT_FAR : 0);
+
+        if (shadowPass)
+        {
+            o.v[VARYING_TEX] = in.tex.x;
+            o.v[VARYING_TEX + 1] = in.tex.y;
+            continue;
+        }
+
+        SoftFloat4 posW = transformPoint(in.pos, instance.world);
+        SoftFloat3 n = transformVector(in.normal, normal3);
+        SoftFloat3 t = transformVector(in.tangent, world3);
+        SoftFloat4 s = transformPoint(in.pos, toShadow);
+        const SoftMatrix& tt = instance.texTransform;
+
+        o.v[VARYING_POS] = posW.x;
+        o.v[VARYING_POS + 1] = posW.y;
+        o.v[VARYING_POS + 2] = posW.z;
+        o.v[VARYING_NORMAL] = n.x;
+        o.v[VARYING_NORMAL + 1] = n.y;
+        o.v[VARYING_NORMAL + 2] = n.z;
+        o.v[VARYING_TANGENT] = t.x;
+        o.v[VARYING_TANGENT + 1] = t.y;
+        o.v[VARYING_TANGENT + 2] = t.z;
+        o.v[VARYING_TEX] = in.tex.x * tt.m[0][0] + in.tex.y * tt.m[1][0] + tt.m[3][0];
+        o.v[VARYING_TEX + 1] = in.tex.x * tt.m[0][1] + in.tex.y * tt.m[1][1] + tt.m[3][1];
+        o.v[VARYING_SHADOW] = s.x;
+        o.v[VARYING_SHADOW + 1] = s.y;
+        o.v[VARYING_SHADOW + 2] = s.z;
+        o.v[VARYING_SHADOW + 3] = s.w;
+    }
+
+    const std::vector<uint32_t>& indices = mesh->indices;
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        if (indices[i] >= vertices.size() || indices[i + 1] >= vertices.size() || indices[i + 2] >= vertices.size())
+            continue;
+
+        const ClipVertex& a = vertices[indices[i]];
+        const ClipVertex& b = vertices[indices[i + 1]];
+        const ClipVertex& d = vertices[indices[i + 2]];
+
+        /*all outside of one plane*/
+        if (a.outcode & b.outcode & d.outcode)
+            continue;
+
+        if (!((a.outcode | b.outcode | d.outcode) & OUT_NEAR))
+        {
+            emit(a, b, d, instance, shadowPass, viewport, out);
+            continue;
+        }
+
+        /*clip against z = 0, a triangle becomes up to a quad*/
+        const ClipVertex* in[3] = { &a, &b, &d };
+        ClipVertex poly[4];
+        int n = 0;
+
+        for (int k = 0; k < 3; k++)
+        {
+            const ClipVertex& p = *in[k];
+            const ClipVertex& q = *in[(k + 1) % 3];
+
+            if (p.z >= 0.f)
+                poly[n++] = p;
+
+            if ((p.z >= 0.f) != (q.z >= 0.f))
+            {
+                float f = p.z / (p.z - q.z);
+                ClipVertex& r = poly[n++];
+
+                r.x = p.x + (q.x - p.x) * f;
+                r.y = p.y + (q.y - p.y) * f;
+                r.z = 0.f;
+                r.w = p.w + (q.w - p.w) * f;
+
+                for (int j = 0; j < VARYINGS; j++)
+                {
+                    r.v[j] = p.v[j] + (q.v[j] - p.v[j]) * f;
+                }
+            }
+        }
+
+        for (int k = 1; k + 1 < n; k++)
+        {
+            emit(poly[0], poly[k], poly[k + 1], instance, shadowPass, viewport, out);
+        }
+    }
+}
+
+void SoftwareRasterizer::emit(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, const SoftInstance& instance,
+                              bool shadowPass, const SoftViewport& viewport, std::vector<Triangle>& out) const
+{
+    const ClipVertex* p[3] = { &a, &b, &c };
+    Triangle t;
+
+    for (int k = 0; k < 3; k++)
+    {
+        if (p[k]->w <= 1e-6f)
+            return;
+
+        float invW = 1.f / p[k]->w;
+
+        t.x[k] = viewport.x + (p[k]->x * invW + 1.f) * 0.5f * viewport.width;
+        t.y[k] = viewport.y + (1.f - p[k]->y * invW) * 0.5f * viewport.height;
+        t.z[k] = p[k]->z * invW;
+        t.invW[k] = invW;
+    }
+
+    /*clockwise on screen is front facing, back faces and degenerate triangles are culled*/
+    float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+
+    if (!(area > 0.f))
+        return;
+
+    /*pixels with their center inside the bounds*/
+    float lowX = (std::min)({ t.x[0], t.x[1], t.x[2] }), highX = (std::max)({ t.x[0], t.x[1], t.x[2] });
+    float lowY = (std::min)({ t.y[0], t.y[1], t.y[2] }), highY = (std::max)({ t.y[0], t.y[1], t.y[2] });
+
+    t.minX = (int)std::ceil((std::max)(lowX - 0.5f, (float)viewport.x));
+    t.maxX = (int)std::floor((std::min)(highX - 0.5f, (float)(viewport.x + viewport.width - 1)));
+    t.minY = (int)std::ceil((std::max)(lowY - 0.5f, (float)viewport.y));
+    t.maxY = (int)std::floor((std::min)(highY - 0.5f, (float)(viewport.y + viewport.height - 1)));
+
+    if (t.minX > t.maxX || t.minY > t.maxY)
+        return;
+
+    int first = shadowPass ? VARYING_TEX : 0;
+    int count = shadowPass ? 2 : VARYINGS;
+
+    for (int k = 0; k < 3; k++)
+    {
+        for (int j = first; j < first + count; j++)
+        {
+            t.v[k][j] = p[k]->v[j] * t.invW[k];
+        }
+    }
+
+    t.invArea = 1.f / area;
+    t.bias = 0.f;
+
+    if (shadowPass)
+    {
+        float dzdx = ((t.z[1] - t.z[0]) * (t.y[2] - t.y[0]) - (t.z[2] - t.z[0]) * (t.y[1] - t.y[0])) * t.invArea;
+        float dzdy = ((t.x[1] - t.x[0]) * (t.z[2] - t.z[0]) - (t.x[2] - t.x[0]) * (t.z[1] - t.z[0])) * t.invArea;
+
+        t.bias = SOFT_SHADOW_DEPTH_BIAS + SOFT_SHADOW_SLOPE_BIAS * (std::max)(std::fabs(dzdx), std::fabs(dzdy));
+    }
+
+    t.instance = &instance;
+    out.push_back(t);
+}
+
+void SoftwareRasterizer::rasterTile(const SoftScene& scene, int tile, bool shadowPass, Target& target,
+                                    const SoftViewport& viewport)
+{
+    Clock::time_point start = Clock::now();
+
+    int x0 = viewport.x + (tile % tilesX) * SOFT_TILE_SIZE;
+    int y0 = viewport.y + (tile / tilesX) * SOFT_TILE_SIZE;
+    int x1 = (std::min)(x0 + SOFT_TILE_SIZE, viewport.x + viewport.width) - 1;
+    int y1 = (std::min)(y0 + SOFT_TILE_SIZE, viewport.y + viewport.height) - 1;
+
+    int first = shadowPass ? VARYING_TEX : 0;
+    int count = shadowPass ? 2 : VARYINGS;
+    unsigned int pixels = 0;
+    float v[VARYINGS];
+
+    for (const Triangle* t : bins[tile])
+    {
+        /*edge k is opposite of vertex k, positive inside*/
+        float ea[3], eb[3], ec[3];
+        bool topLeft[3];
+
+        for (int k = 0; k < 3; k++)
+        {
+            int i = (k + 1) % 3, j = (k + 2) % 3;
+
+            ea[k] = -(t->y[j] - t->y[i]);
+            eb[k] = t->x[j] - t->x[i];
+            ec[k] = -(ea[k] * t->x[i] + eb[k] * t->y[i]);
+            topLeft[k] = (t->y[i] == t->y[j] && t->x[j] > t->x[i]) || t->y[j] < t->y[i];
+        }
+
+        int minX = (std::max)(t->minX, x0), maxX = (std::min)(t->maxX, x1);
+        int minY = (std::max)(t->minY, y0), maxY = (std::min)(t->maxY, y1);
+
+        for (int py = minY; py <= maxY; py++)
+        {
+            float fy = py + 0.5f;
+
+            for (int px = minX; px <= maxX; px++)
+            {
+                float fx = px + 0.5f;
+                float e[3];
+                bool inside = true;
+
+                for (int k = 0; k < 3; k++)
+                {
+                    e[k] = ea[k] * fx + eb[k] * fy + ec[k];
+                    inside = inside && (e[k] > 0.f || (e[k] == 0.f && topLeft[k]));
+                }
+
+                if (!inside)
+                    continue;
+
+                float b0 = e[0] * t->invArea, b1 = e[1] * t->invArea, b2 = e[2] * t->invArea;
+                float z = b0 * t->z[0] + b1 * t->z[1] + b2 * t->z[2];
+
+                if (z < 0.f || z > 1.f)
+                    continue;
+
+                z = (std::min)(z + t->bias, 1.f);
+
+                size_t index = (size_t)py * target.width + px;
+
+                if (!(z < target.depth[index]))
+                    continue;
+
+                float w = 1.f / (b0 * t->invW[0] + b1 * t->invW[1] + b2 * t->invW[2]);
+
+                for (int j = first; j < first + count; j++)
+                {
+                    v[j] = (b0 * t->v[0][j] + b1 * t->v[1][j] + b2 * t->v[2][j]) * w;
+                }
+
+                const SoftInstance& instance = *t->instance;
+
+                if (shadowPass)
+                {
+                    if (instance.diffuse && instance.diffuse->Sample(v[VARYING_TEX], v[VARYING_TEX + 1]).w < SOFT_SHADOW_ALPHA_CLIP)
+                        continue;
+                }
+                else
+                {
+                    bool discard = false;
+                    SoftFloat4 c = shade(scene, instance, v, discard);
+
+                    if (discard)
+                        continue;
+
+                    (*target.color)[index] = packColor(c);
+                }
+
+                target.depth[index] = z;
+                pixels++;
+            }
+        }
+    }
+
+    SoftTileTiming& timing = passTimings[tile];
+    timing.x = x0;
+    timing.y = y0;
+    timing.triangles = (unsigned int)bins[tile].size();
+    timing.pixels = pixels;
+    timing.ms = milliseconds(start, Clock::now());
+}
+
+SoftFloat4 SoftwareRasterizer::shade(const SoftScene& scene, const SoftInstance& instance, const float* v, bool& discard) const
+{
+    const SoftMaterial& mat = instance.mesh->material;
+    const SoftLight& light = scene.light;
+
+    SoftFloat3 normal = normalize({ v[VARYING_NORMAL], v[VARYING_NORMAL + 1], v[VARYING_NORMAL + 2] });
+    SoftFloat3 toEye = normalize({ scene.eye.x - v[VARYING_POS], scene.eye.y - v[VARYING_POS + 1], scene.eye.z - v[VARYING_POS + 2] });
+
+    SoftFloat4 tex = { 1.f, 1.f, 1.f, 1.f };
+
+    if (instance.shading != SoftShading::NoTexture && instance.shading != SoftShading::StaticColor)
+    {
+        if (instance.diffuse)
+            tex = instance.diffuse->Sample(v[VARYING_TEX], v[VARYING_TEX + 1]);
+
+        if (tex.w < SOFT_ALPHA_CLIP)
+        {
+            discard = true;
+            return tex;
+        }
+    }
+
+    float shadowLit = scene.shadows ? shadowFactor(v + VARYING_SHADOW) : 1.f;
+
+    if (instance.shading == SoftShading::NoLighting || instance.shading == SoftShading::OnlyShadow)
+    {
+        tex.w = mat.diffuse.w;
+
+        if (instance.shading == SoftShading::OnlyShadow)
+        {
+            tex = { tex.x * shadowLit, tex.y * shadowLit, tex.z * shadowLit, tex.w * shadowLit };
+        }
+
+        return tex;
+    }
+
+    if (instance.shading == SoftShading::StaticColor)
+    {
+        tex = instance.color;
+    }
+
+    if (instance.shading == SoftShading::NormalMap && instance.normalMap)
+    {
+        SoftFloat4 s = instance.normalMap->Sample(v[VARYING_TEX], v[VARYING_TEX + 1]);
+        SoftFloat3 n = { 2.f * s.x - 1.f, 2.f * s.y - 1.f, 2.f * s.z - 1.f };
+
+        SoftFloat3 tangent = { v[VARYING_TANGENT], v[VARYING_TANGENT + 1], v[VARYING_TANGENT + 2] };
+        float d = dot(tangent, normal);
+        SoftFloat3 t = normalize({ tangent.x - d * normal.x, tangent.y - d * normal.y, tangent.z - d * normal.z });
+        SoftFloat3 b = cross(normal, t);
+
+        normal = { n.x * t.x + n.y * b.x + n.z * normal.x,
+                   n.x * t.y + n.y * b.y + n.z * normal.y,
+                   n.x * t.z + n.y * b.z + n.z * normal.z };
+    }
+
+    /*ComputeDirectionalLight*/
+    SoftFloat4 ambient = { mat.ambient.x * light.ambient.x, mat.ambient.y * light.ambient.y,
+                           mat.ambient.z * light.ambient.z, mat.ambient.w * light.ambient.w };
+    SoftFloat4 diffuse = { 0.f, 0.f, 0.f, 0.f };
+    SoftFloat4 spec = { 0.f, 0.f, 0.f, 0.f };
+
+    SoftFloat3 lightVec = { -light.direction.x, -light.direction.y, -light.direction.z };
+    float diffuseFactor = dot(lightVec, normal);
+
+    if (diffuseFactor > 0.f)
+    {
+        float nl = 2.f * dot(light.direction, normal);
+        SoftFloat3 r = { light.direction.x - nl * normal.x, light.direction.y - nl * normal.y, light.direction.z - nl * normal.z };
+        float specFactor = std::pow((std::max)(dot(r, toEye), 0.f), mat.specular.w);
+
+        diffuse = { diffuseFactor * mat.diffuse.x * light.diffuse.x, diffuseFactor * mat.diffuse.y * light.diffuse.y,
+                    diffuseFactor * mat.diffuse.z * light.diffuse.z, diffuseFactor * mat.diffuse.w * light.diffuse.w };
+        spec = { specFactor * mat.specular.x * light.specular.x, specFactor * mat.specular.y * light.specular.y,
+                 specFactor * mat.specular.z * light.specular.z, specFactor * mat.specular.w * light.specular.w };
+    }
+
+    SoftFloat4 lit;
+    lit.x = tex.x * (ambient.x + shadowLit * diffuse.x) + shadowLit * spec.x;
+    lit.y = tex.y * (ambient.y + shadowLit * diffuse.y) + shadowLit * spec.y;
+    lit.z = tex.z * (ambient.z + shadowLit * diffuse.z) + shadowLit * spec.z;
+    lit.w = mat.diffuse.w * tex.w;
+
+    return lit;
+}
+
+float SoftwareRasterizer::shadowFactor(const float* shadowPos) const
+{
+    if (shadowPos[3] <= 0.f)
+        return 1.f;
+
+    float u = shadowPos[0] / shadowPos[3];
+    float v = shadowPos[1] / shadowPos[3];
+    float depth = shadowPos[2] / shadowPos[3];
+
+    int size = shadow.width;
+
+    /*comparison of one texel, outside of the map compares against the black border*/
+    auto texel = [&](int x, int y)
+    {
+        if (x < 0 || y < 0 || x >= size || y >= size)
+            return depth < 0.f ? 1.f : 0.f;
+
+        return depth < shadow.depth[(size_t)y * size + x] ? 1.f : 0.f;
+    };
+
+    float lit = 0.f;
+
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            /*linear comparison filter*/
+            float x = (u + dx * SOFT_SHADOW_TAP) * size - 0.5f;
+            float y = (v + dy * SOFT_SHADOW_TAP) * size - 0.5f;
+
+            if (!std::isfinite(x) || !std::isfinite(y) || std::fabs(x) > 1e6f || std::fabs(y) > 1e6f)
+                continue;
+
+            float fx = std::floor(x), fy = std::floor(y);
+            float wx = x - fx, wy = y - fy;
+            int ix = (int)fx, iy = (int)fy;
+
+            lit += (texel(ix, iy) * (1.f - wx) + texel(ix + 1, iy) * wx) * (1.f - wy) +
+                   (texel(ix, iy + 1) * (1.f - wx) + texel(ix + 1, iy + 1) * wx) * wy;
+        }
+    }
+
+    return lit / 9.f;
+}
+
+/*images*/
+
+static void put16(std::vector<uint8_t>& out, size_t offset, uint16_t v)
+{
+    out[offset] = (uint8_t)v;
+    out[offset + 1] = (uint8_t)(v >> 8);
+}
+
+static void put32(std::vector<uint8_t>& out, size_t offset, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out[offset + i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+bool SoftwareRasterizer::SaveBMP(const std::string& file) const
+{
+    size_t rowSize = ((size_t)width * 3 + 3) & ~(size_t)3;
+    std::vector<uint8_t> out(54 + rowSize * height, 0);
+
+    out[0] = 'B';
+    out[1] = 'M';
+    put32(out, 2, (uint32_t)out.size());
+    put32(out, 10, 54);
+    put32(out, 14, 40);
+    put32(out, 18, (uint32_t)width);
+    put32(out, 22, (uint32_t)height);
+    put16(out, 26, 1);
+    put16(out, 28, 24);
+    put32(out, 34, (uint32_t)(rowSize * height));
+
+    /*bottom up, bgr*/
+    for (int y = 0; y < height; y++)
+    {
+        uint8_t* row = &out[54 + rowSize * (height - 1 - y)];
+
+        for (int x = 0; x < width; x++)
+        {
+            uint32_t c = color[(size_t)y * width + x];
+            row[x * 3] = (uint8_t)(c >> 16);
+            row[x * 3 + 1] = (uint8_t)(c >> 8);
+            row[x * 3 + 2] = (uint8_t)c;
+        }
+    }
+
+    std::ofstream f(file, std::ios::binary);
+
+    if (!f.is_open())
+        return false;
+
+    f.write(reinterpret_cast<const char*>(out.data()), out.size());
+    return f.good();
+}
+
+bool SoftwareRasterizer::LoadBMP(const std::string& file, int& w, int& h, std::vector<uint32_t>& pixels)
+{
+    std::ifstream in(file, std::ios::binary);
+
+    if (!in.is_open())
+        return false;
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    if (data.size() < 54 || data[0] != 'B' || data[1] != 'M')
+        return false;
+
+    auto u32 = [&](size_t offset)
+    {
+        uint32_t v;
+        memcpy(&v, &data[offset], 4);
+        return v;
+    };
+
+    uint32_t offset = u32(10);
+    int32_t bw = (int32_t)u32(18), bh = (int32_t)u32(22);
+    int bits = data[28] | (data[29] << 8);
+    bool topDown = bh < 0;
+
+    bh = topDown ? -bh : bh;
+
+    if (bw <= 0 || bh <= 0 || bw > 32768 || bh > 32768 || (bits != 24 && bits != 32) || u32(30) != 0)
+        return false;
+
+    size_t bytes = bits / 8;
+    size_t rowSize = ((size_t)bw * bytes + 3) & ~(size_t)3;
+
+    if (data.size() < offset + rowSize * bh)
+        return false;
+
+    w = bw;
+    h = bh;
+    pixels.resize((size_t)w * h);
+
+    for (int y = 0; y < h; y++)
+    {
+        const uint8_t* row = &data[offset + rowSize * (topDown ? y : h - 1 - y)];
+
+        for (int x = 0; x < w; x++)
+        {
+            const uint8_t* p = row + x * bytes;
+            pixels[(size_t)y * w + x] = p[2] | (p[1] << 8) | ((uint32_t)p[0] << 16) | 0xff000000u;
+        }
+    }
+
+    return true;
+}
+
+size_t SoftwareRasterizer::Compare(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, int tolerance)
+{
+    if (a.size() != b.size())
+        return (std::max)(a.size(), b.size());
+
+    size_t different = 0;
+
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            int d = (int)((a[i] >> shift) & 0xff) - (int)((b[i] >> shift) & 0xff);
+
+            if (d > tolerance || d < -tolerance)
+            {
+                different++;
+                break;
+            }
+        }
+    }
+
+    return different;
+}
+
+bool SoftwareRasterizer::SaveTileTimings(const std::string& file) const
+{
+    std::ofstream f(file);
+
+    if (!f.is_open())
+        return false;
+
+    f << "# total " << stats.totalMs << " ms, shadow " << stats.shadowMs << " ms, vertex " << stats.vertexMs
+      << " ms, bin " << stats.binMs << " ms, raster " << stats.rasterMs << " ms, " << stats.triangles << " triangles, "
+      << stats.pixels << " pixels, " << threads << " threads\n";
+    f << "x,y,triangles,pixels,ms\n";
+
+    for (const auto& t : tileTimings)
+    {
+        f << t.x << "," << t.y << "," << t.triangles << "," << t.pixels << "," << t.ms << "\n";
+    }
+
+    return f.good();
+}
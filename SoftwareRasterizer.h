@@ -0,0 +1,307 @@
+/* SoftwareRasterizer.h
+
+cpu reference renderer for golden image tests on machines without a gpu.
+it implements the part of the pipeline the game uses: indexed triangle
+lists in the Vertex::Standard layout, back face culling, the depth test,
+the lighting of basictexture.fx and normalmap.fx and the 3x3 pcf shadow
+lookup of LightHelper.fx. the shadow map is drawn by the same rasterizer
+with the depth bias of shadowmap.fx.
+
+triangles are transformed and clipped against the near plane per
+instance, then binned into SOFT_TILE_SIZE square tiles. worker threads
+take whole tiles, so no two threads write the same pixel and the image is
+the same for any thread count. the time spent in every tile is kept for
+performance tracking, from all Render calls since the last Clear.
+
+textures are read from dds files, uncompressed or bc1 - bc3, top mip
+only, and sampled bilinear. images match the gpu closely but not bit
+exact, compare them with a tolerance.
+
+only depends on the standard library.
+
+    Usage:
+    SoftTexture floor;
+    floor.LoadDDS("data/textures/floor.dds");
+
+    SoftInstance instance;
+    instance.mesh = &mesh;
+    instance.diffuse = &floor;
+
+    SoftScene scene;
+    scene.view = ...; scene.proj = ...;
+    scene.instances.push_back(instance);
+
+    SoftwareRasterizer raster(1280, 720);
+    raster.Clear(clearColor);
+    raster.Render(scene);
+    raster.SaveBMP("golden.bmp");
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define SOFT_TILE_SIZE 32
+#define SOFT_SHADOW_SIZE 2048
+
+/*shadowmap.fx depth bias, in units of the 24 bit depth buffer*/
+#define SOFT_SHADOW_DEPTH_BIAS (100000.f / 16777216.f)
+#define SOFT_SHADOW_SLOPE_BIAS 1.f
+
+/*pcf tap distance, LightHelper.fx uses a fixed SMAP_SIZE*/
+#define SOFT_SHADOW_TAP (1.f / 8192.f)
+
+#define SOFT_ALPHA_CLIP 0.1f
+#define SOFT_SHADOW_ALPHA_CLIP 0.15f
+
+struct SoftFloat2
+{
+    float x, y;
+};
+
+struct SoftFloat3
+{
+    float x, y, z;
+};
+
+struct SoftFloat4
+{
+    float x, y, z, w;
+};
+
+/*row major, vectors are multiplied from the left like XMMATRIX*/
+struct SoftMatrix
+{
+    float m[4][4];
+
+    static SoftMatrix Identity();
+
+    /*same matrices as the XMMatrix functions of the same name, angles in radians*/
+    static SoftMatrix Scaling(float x, float y, float z);
+    static SoftMatrix Translation(float x, float y, float z);
+    static SoftMatrix RotationRollPitchYaw(float pitch, float yaw, float roll);
+    static SoftMatrix LookAtLH(const SoftFloat3& eye, const SoftFloat3& target, const SoftFloat3& up);
+    static SoftMatrix PerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ);
+    static SoftMatrix OrthographicOffCenterLH(float left, float right, float bottom, float top, float nearZ, float farZ);
+
+    SoftMatrix operator*(const SoftMatrix& o) const;
+};
+
+/*the members of Vertex::Standard without the tangent handedness*/
+struct SoftVertex
+{
+    SoftFloat3 pos;
+    SoftFloat2 tex;
+    SoftFloat3 normal;
+    SoftFloat3 tangent;
+};
+
+struct SoftMaterial
+{
+    SoftFloat4 ambient = { 1.f, 1.f, 1.f, 1.f };
+    SoftFloat4 diffuse = { 1.f, 1.f, 1.f, 1.f };
+
+    /*w is the specular power*/
+    SoftFloat4 specular = { 0.f, 0.f, 0.f, 1.f };
+};
+
+struct SoftLight
+{
+    SoftFloat4 ambient = { 0.3f, 0.3f, 0.3f, 1.f };
+    SoftFloat4 diffuse = { 0.8f, 0.8f, 0.8f, 1.f };
+    SoftFloat4 specular = { 0.6f, 0.6f, 0.6f, 16.f };
+    SoftFloat3 direction = { -0.57735f, -0.57735f, 0.57735f };
+};
+
+class SoftTexture
+{
+public:
+    /*false for a missing, damaged or unsupported file*/
+    bool LoadDDS(const std::string& file);
+
+    /*rgba8, red in the lowest byte*/
+    void Create(int width, int height, const uint32_t* texels);
+
+    /*bilinear with wrapped addressing*/
+    SoftFloat4 Sample(float u, float v) const;
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+private:
+    int width = 0;
+    int height = 0;
+    std::vector<uint32_t> texels;
+};
+
+/*techniques of basictexture.fx and normalmap.fx*/
+enum class SoftShading
+{
+    Texture, NoTexture, NoLighting, OnlyShadow, StaticColor, NormalMap
+};
+
+struct SoftMesh
+{
+    std::vector<SoftVertex> vertices;
+    std::vector<uint32_t> indices;
+    SoftMaterial material;
+};
+
+struct SoftInstance
+{
+    const SoftMesh* mesh = nullptr;
+    SoftMatrix world = SoftMatrix::Identity();
+    SoftMatrix texTransform = SoftMatrix::Identity();
+
+    /*a missing texture samples white*/
+    const SoftTexture* diffuse = nullptr;
+    const SoftTexture* normalMap = nullptr;
+
+    SoftShading shading = SoftShading::Texture;
+
+    /*lit instead of the texture by StaticColor*/
+    SoftFloat4 color = { 1.f, 1.f, 1.f, 1.f };
+
+    bool castsShadow = true;
+};
+
+struct SoftViewport
+{
+    int x = 0;
+    int y = 0;
+
+    /*0 for the whole target*/
+    int width = 0;
+    int height = 0;
+};
+
+struct SoftScene
+{
+    SoftMatrix view = SoftMatrix::Identity();
+    SoftMatrix proj = SoftMatrix::Identity();
+    SoftFloat3 eye = { 0.f, 0.f, 0.f };
+    SoftLight light;
+
+    /*light view * projection for the shadow pass, shadowTransform maps world to shadow map texture space*/
+    bool shadows = true;
+    SoftMatrix lightViewProj = SoftMatrix::Identity();
+    SoftMatrix shadowTransform = SoftMatrix::Identity();
+
+    std::vector<SoftInstance> instances;
+    SoftViewport viewport;
+};
+
+struct SoftTileTiming
+{
+    int x, y;
+    unsigned int triangles;
+    unsigned int pixels;
+    double ms;
+};
+
+struct SoftStats
+{
+    double shadowMs = 0.0;
+    double vertexMs = 0.0;
+    double binMs = 0.0;
+    double rasterMs = 0.0;
+    double totalMs = 0.0;
+
+    /*of the main passes, after culling and clipping*/
+    size_t triangles = 0;
+    size_t pixels = 0;
+};
+
+class SoftwareRasterizer
+{
+public:
+    /*threads 0 uses every hardware thread*/
+    SoftwareRasterizer(int width, int height, int threads = 0, int shadowSize = SOFT_SHADOW_SIZE);
+
+    /*also starts new tile timings and stats*/
+    void Clear(const SoftFloat4& color);
+
+    /*draws into the viewport of the scene, clears its depth but not its color*/
+    void Render(const SoftScene& scene);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    const std::vector<uint32_t>& Pixels() const { return color; }
+
+    const std::vector<SoftTileTiming>& TileTimings() const { return tileTimings; }
+    const SoftStats& Stats() const { return stats; }
+
+    /*24 bit uncompressed*/
+    bool SaveBMP(const std::string& file) const;
+    bool SaveTileTimings(const std::string& file) const;
+
+    static bool LoadBMP(const std::string& file, int& width, int& height, std::vector<uint32_t>& pixels);
+
+    /*pixels that differ by more than tolerance in a channel, every pixel when the sizes differ*/
+    static size_t Compare(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, int tolerance);
+
+private:
+    static const int VARYINGS = 15;
+
+    /*transformed vertex before the perspective divide*/
+    struct ClipVertex
+    {
+        float x, y, z, w;
+        float v[VARYINGS];
+        int outcode;
+    };
+
+    /*screen space triangle, varyings are divided by w for perspective correct interpolation*/
+    struct Triangle
+    {
+        float x[3], y[3], z[3], invW[3];
+        float v[3][VARYINGS];
+        float invArea;
+        float bias;
+        int minX, minY, maxX, maxY;
+        const SoftInstance* instance;
+    };
+
+    struct Target
+    {
+        int width, height;
+        std::vector<float> depth;
+        std::vector<uint32_t>* color;
+    };
+
+    void pass(const SoftScene& scene, bool shadowPass, Target& target, const SoftViewport& viewport);
+    void setup(const SoftScene& scene, const SoftInstance& instance, bool shadowPass, const SoftViewport& viewport,
+               std::vector<ClipVertex>& vertices, std::vector<Triangle>& out) const;
+    void emit(const ClipVertex& a, const ClipVertex& b, const ClipVertex& c, const SoftInstance& instance,
+              bool shadowPass, const SoftViewport& viewport, std::vector<Triangle>& out) const;
+    void rasterTile(const SoftScene& scene, int tile, bool shadowPass, Target& target, const SoftViewport& viewport);
+
+    SoftFloat4 shade(const SoftScene& scene, const SoftInstance& instance, const float* v, bool& discard) const;
+    float shadowFactor(const float* shadowPos) const;
+
+    /*work for every index, spread over the threads*/
+    void parallel(int count, const std::function<void(int)>& work) const;
+
+    int width, height;
+    int threads;
+
+    std::vector<uint32_t> color;
+    Target screen;
+    Target shadow;
+
+    /*per instance scratch, kept between frames*/
+    std::vector<std::vector<ClipVertex>> transformed;
+    std::vector<std::vector<Triangle>> triangles;
+
+    int tilesX = 0, tilesY = 0;
+    std::vector<std::vector<const Triangle*>> bins;
+    std::vector<SoftTileTiming> passTimings;
+    std::vector<SoftTileTiming> tileTimings;
+
+    SoftStats stats;
+};
@@ -1,5 +1,7 @@
 #include "SoundEngine.h"
+#include "AdpcmCodec.h"
 #include "util.h"
+#include <fstream>
 
 void SoundEngine::Init()
 {
@@ -16,83 +18,184 @@ void SoundEngine::Init()
      //master volume
      masterVoice->SetVolume(0.6f);
 
+     //software mixer for effects
+     mixer = new AudioMixer(MIXER_SAMPLE_RATE, MAX_CHANNELS);
+     mixerOutput = new XAudio2Sink(soundMain, MIXER_SAMPLE_RATE);
+     mixer->StartOutput(mixerOutput);
+
+     stepFrame = SOUND_SCHEDULE_LATENCY * MIXER_SAMPLE_RATE;
+
 }
 
-void SoundEngine::loadFile(const std::wstring& file, std::vector<BYTE>& data, WAVEFORMATEX** formatEx, unsigned int& length)
+void SoundEngine::loadFile(const std::wstring& file, std::vector<BYTE>& data, WAVEFORMATEX& format)
 {
-
     DWORD streamIndex = (DWORD)MF_SOURCE_READER_FIRST_AUDIO_STREAM;
 
-    /*open audio file*/
-    IMFSourceReader* reader;
-     MFCreateSourceReaderFromURL(file.c_str(), srcReaderConfig, &reader);
-     reader->SetStreamSelection(streamIndex, true);
-
-    /*get data type*/
-    IMFMediaType* mediaType;
-     reader->GetNativeMediaType(streamIndex, 0, &mediaType);
+    /*open audio file, compressed formats are decoded to pcm*/
+    IMFSourceReader* reader = AudioStream::OpenReader(file, srcReaderConfig, format);
 
-    /*check compressed or uncompressed*/
-    GUID subType{};
-     mediaType->GetGUID(MF_MT_MAJOR_TYPE, &subType);
-
-    if (subType == MFAudioFormat_Float || subType == MFAudioFormat_PCM)
+    if (reader == nullptr)
     {
-        //uncompressed
+        throw std::exception("Failed to open sound file");
     }
-    else
-    {
-        //compressed
-        IMFMediaType* partType = nullptr;
-         MFCreateMediaType(&partType);
 
-         partType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio);
-         partType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_PCM);
-         reader->SetCurrentMediaType(streamIndex, NULL, partType);
+    /*reserve the decoded size up front*/
+    PROPVARIANT duration;
+    PropVariantInit(&duration);
 
+    if (SUCCEEDED(reader->GetPresentationAttribute((DWORD)MF_SOURCE_READER_MEDIASOURCE, MF_PD_DURATION, &duration)))
+    {
+        data.reserve(static_cast<size_t>(duration.uhVal.QuadPart * format.nAvgBytesPerSec / 10000000ull) + format.nBlockAlign);
     }
-
-     IMFMediaType* uncompressedType = nullptr;
-     reader->GetCurrentMediaType(streamIndex, &uncompressedType);
-     MFCreateWaveFormatExFromMFMediaType(uncompressedType, formatEx, &length);
-     reader->SetStreamSelection(streamIndex, true);
+    PropVariantClear(&duration);
 
     //copy data
-    IMFSample* sample = nullptr;
-    IMFMediaBuffer* buffer = nullptr;
-    BYTE* localAudioData = nullptr;
-    DWORD localAudioDataLength = 0;
-
     while (true)
     {
         DWORD flags = 0;
-         reader->ReadSample(streamIndex, 0, nullptr, &flags, nullptr, &sample);
+        IMFSample* sample = nullptr;
+
+        if (FAILED(reader->ReadSample(streamIndex, 0, nullptr, &flags, nullptr, &sample)))
+            break;
 
         if (flags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED || flags & MF_SOURCE_READERF_ENDOFSTREAM)
+        {
+            DXRelease(sample);
             break;
+        }
 
         if (sample == nullptr)
             continue;
 
-         sample->ConvertToContiguousBuffer(&buffer);
-         buffer->Lock(&localAudioData, nullptr, &localAudioDataLength);
+        IMFMediaBuffer* buffer = nullptr;
+        BYTE* localAudioData = nullptr;
+        DWORD localAudioDataLength = 0;
+
+        sample->ConvertToContiguousBuffer(&buffer);
+        buffer->Lock(&localAudioData, nullptr, &localAudioDataLength);
 
-        for (size_t i = 0; i < localAudioDataLength; i++)
-            data.push_back(localAudioData[i]);
+        data.insert(data.end(), localAudioData, localAudioData + localAudioDataLength);
 
-         buffer->Unlock();
-        localAudioData = nullptr;
+        buffer->Unlock();
+        DXRelease(buffer);
+        DXRelease(sample);
     }
 
-    return;
+    DXRelease(reader);
+}
+
+/*read uncompressed wav files with one bulk read, returns false for anything media foundation has to decode*/
+bool SoundEngine::loadWav(const std::wstring& file, std::vector<BYTE>& data, WAVEFORMATEX& format)
+{
+    std::ifstream fin(file, std::ios::binary);
+
+    if (!fin)
+        return false;
+
+    char riff[4], wave[4], chunkID[4];
+    DWORD riffSize = 0, chunkSize = 0;
+    bool hasFormat = false;
+
+    fin.read(riff, 4);
+    fin.read((char*)&riffSize, 4);
+    fin.read(wave, 4);
+
+    if (!fin || memcmp(riff, "RIFF", 4) != 0 || memcmp(wave, "WAVE", 4) != 0)
+        return false;
+
+    while (fin.read(chunkID, 4) && fin.read((char*)&chunkSize, 4))
+    {
+        /*chunks are padded to an even size*/
+        std::streamoff padded = chunkSize + (chunkSize & 1);
+
+        if (memcmp(chunkID, "fmt ", 4) == 0)
+        {
+            if (chunkSize < 16)
+                return false;
+
+            ZeroMemory(&format, sizeof(WAVEFORMATEX));
+            fin.read((char*)&format, 16);
+
+            if (format.wFormatTag != WAVE_FORMAT_PCM && format.wFormatTag != WAVE_FORMAT_IEEE_FLOAT)
+                return false;
+
+            fin.seekg(padded - 16, std::ios::cur);
+            hasFormat = true;
+        }
+        else if (memcmp(chunkID, "data", 4) == 0 && hasFormat)
+        {
+            data.resize(chunkSize);
+            fin.read((char*)data.data(), chunkSize);
+            data.resize(static_cast<size_t>(fin.gcount()));
+
+            return !data.empty();
+        }
+        else
+        {
+            fin.seekg(padded, std::ios::cur);
+        }
+    }
+
+    return false;
 }
 
 
 void SoundEngine::loadFile(const std::wstring& fileName, SoundType st)
 {
     AudioData* data = new AudioData();
-    WAVEFORMATEX* wfx;
-    loadFile(fileName, data->data, &wfx, data->waveLength);
+    data->fileName = fileName;
+    data->soundType = st;
+
+    if (st == SoundType::Music)
+    {
+        /*music is streamed while playing, only the format is read here*/
+        IMFSourceReader* reader = AudioStream::OpenReader(fileName, srcReaderConfig, data->waveFormat);
+
+        if (reader == nullptr)
+        {
+            delete data;
+            throw std::exception("Failed to open music file");
+        }
+
+        PROPVARIANT duration;
+        PropVariantInit(&duration);
+
+        if (SUCCEEDED(reader->GetPresentationAttribute((DWORD)MF_SOURCE_READER_MEDIASOURCE, MF_PD_DURATION, &duration)))
+        {
+            data->frames = duration.uhVal.QuadPart * data->waveFormat.nSamplesPerSec / 10000000ull;
+        }
+        PropVariantClear(&duration);
+
+        DXRelease(reader);
+    }
+    else
+    {
+        std::vector<BYTE> pcm;
+
+        if (!loadWav(fileName, pcm, data->waveFormat))
+        {
+            pcm.clear();
+            loadFile(fileName, pcm, data->waveFormat);
+        }
+
+        /*the mixer works on float samples*/
+        const WAVEFORMATEX& f = data->waveFormat;
+        bool isFloat = f.wFormatTag == WAVE_FORMAT_IEEE_FLOAT || (f.wFormatTag == WAVE_FORMAT_EXTENSIBLE && f.wBitsPerSample == 32);
+
+        if (!AudioClip::FromPCM(pcm.data(), pcm.size(), f.nChannels, f.nSamplesPerSec, f.wBitsPerSample, isFloat, data->clip))
+        {
+            delete data;
+            throw std::exception("Unsupported sound format");
+        }
+
+        data->frames = pcm.size() / f.nBlockAlign;
+
+#ifdef SOUND_COMPRESSED_RESIDENCY
+        data->clip.Compress();
+#endif
+    }
+
+    data->waveLength = sizeof(WAVEFORMATEX) + data->waveFormat.cbSize;
 
     char id[128];
     char ext[8];
@@ -102,26 +205,78 @@ void SoundEngine::loadFile(const std::wstring& fileName, SoundType st)
     WideCharToMultiByte(CP_UTF8, 0, &fileName[0], (int)fileName.size(), &tStr[0], size_needed, NULL, NULL);
     _splitpath_s(tStr.c_str(), NULL, 0, NULL, 0, id, 128, ext, 8);
 
-    ZeroMemory(&data->audioBuffer, sizeof(XAUDIO2_BUFFER));
-    data->waveFormat = *wfx;
-    data->audioBuffer.AudioBytes = (UINT32)data->data.size();
-    data->audioBuffer.pAudioData = (BYTE* const)& data->data[0];
-    data->audioBuffer.pContext = nullptr;
-    if (st == SoundType::Music)
+    data->length = static_cast<double>(data->frames) / data->waveFormat.nSamplesPerSec;
+
+    soundCollection.insert(std::make_pair(id, data));
+}
+
+int SoundEngine::add(const std::string& id, bool loop, int priority, float offset)
+{
+    VoiceParams params;
+    params.gain = 0.9f;
+
+    return play(id, loop, priority, offset, params);
+}
+
+int SoundEngine::add3D(const std::string& id, const XMFLOAT3& position, const XMFLOAT3& velocity, bool loop, int priority, float offset)
+{
+    if (muted)
+        return -1;
+
+    /*cull sounds nobody can hear before they take a channel*/
+    newEmitter.Clear();
+    newEmitter.Add(position, velocity);
+    spatial.Process(newEmitter);
+
+    if (newEmitter.gain[0] < SOUND_AUDIBLE_THRESHOLD)
     {
-        data->audioBuffer.LoopCount = XAUDIO2_LOOP_INFINITE;
+        culledSounds++;
+        return -1;
     }
-    data->length = static_cast<double>(data->audioBuffer.AudioBytes) / SAMPLE_RATE;
 
-    data->soundType = st;
+    VoiceParams params;
+    params.gain = 0.9f * newEmitter.gain[0];
+    params.pan = newEmitter.pan[0];
+    params.pitch = newEmitter.pitch[0];
 
-    soundCollection.insert(std::make_pair(id, data));
+    int channel = play(id, loop, priority, offset, params);
+
+    if (channel != -1 && channels[channel]->stream == nullptr)
+    {
+        channels[channel]->spatial = true;
+        channels[channel]->position = position;
+        channels[channel]->velocity = velocity;
+    }
+
+    return channel;
+}
+
+void SoundEngine::setEmitter(int channel, const XMFLOAT3& position, const XMFLOAT3& velocity)
+{
+    if (channel < 0 || channel >= MAX_CHANNELS || !channels[channel]->spatial)
+        return;
+
+    channels[channel]->position = position;
+    channels[channel]->velocity = velocity;
+}
+
+void SoundEngine::setListener(int index, const XMFLOAT3& position, const XMFLOAT3& right)
+{
+    spatial.SetListener(index, position, right);
+}
+
+void SoundEngine::setListenerCount(int count)
+{
+    spatial.SetListenerCount(count);
 }
 
-int SoundEngine::add(const std::string& id, bool loop)
+int SoundEngine::play(const std::string& id, bool loop, int priority, float offset, const VoiceParams& effectParams)
 {
     int usedChannel = -1;
 
+    if (muted)
+        return -1;
+
     /*sound in collection ?*/
     if (soundCollection.find(id) == soundCollection.end())
     {
@@ -129,15 +284,15 @@ int SoundEngine::add(const std::string& id, bool loop)
         return -1;
     }
 
-    /*find open voice channel*/
-    for (int i = 0; i < MAX_CHANNELS; i++)
+    /*take an open channel or steal one*/
+    if (!freeChannels.empty())
     {
-        if (channels[i]->available)
-        {
-            usedChannel = i;
-            channels[i]->available = false;
-            break;
-        }
+        usedChannel = freeChannels.back();
+        freeChannels.pop_back();
+    }
+    else
+    {
+        usedChannel = steal(priority);
     }
 
     if (usedChannel == -1)
@@ -146,18 +301,68 @@ int SoundEngine::add(const std::string& id, bool loop)
         return -1;
     }
 
-    /*push data in voice*/
-    channels[usedChannel]->audio = soundCollection[id];
-    channels[usedChannel]->timePlaying = 0.f;
-    HRESULT hr = soundMain->CreateSourceVoice(&channels[usedChannel]->srcVoice, &channels[usedChannel]->audio->waveFormat);
-    if (FAILED(hr))
-        std::cerr << "Failed to create Source Voice\n";
+    SoundChannel* c = channels[usedChannel];
+
+    c->available = false;
+    c->audio = soundCollection[id];
+    c->priority = priority;
+    c->loop = loop;
+
+    /*exact mixer frame of the event, never before what is already mixed*/
+    offset = max(offset, static_cast<float>(-SOUND_SCHEDULE_LATENCY));
+    c->startFrame = static_cast<unsigned long long>(max(stepFrame + offset * mixer->SampleRate(), 0.0));
+
+    /*music voices are fed by a stream, which is also their callback*/
+    if (c->audio->soundType == SoundType::Music)
+    {
+        c->stream = new AudioStream(c->audio->fileName, srcReaderConfig, loop);
+
+        HRESULT hr = soundMain->CreateSourceVoice(&c->srcVoice, &c->audio->waveFormat, 0, XAUDIO2_DEFAULT_FREQ_RATIO, c->stream);
+        if (FAILED(hr))
+        {
+            std::cerr << "Failed to create Source Voice\n";
+            release(c);
+            return -1;
+        }
+    }
+    else
+    {
+        VoiceParams params = effectParams;
+        params.loop = loop;
+
+        c->mixerVoice = mixer->Play(&c->audio->clip, params, c->startFrame);
+
+        /*every mixer voice is busy, give the channel back*/
+        if (c->mixerVoice == 0)
+        {
+            DBOUT("SOUND VOICES FULL!");
+            release(c);
+            return -1;
+        }
+
+        c->isPlaying = true;
+    }
 
     return usedChannel;
 }
 
 void SoundEngine::update(float deltaTime)
 {
+    /*advance the timeline by the game step, so events keep their spacing at any frame rate*/
+    double rate = mixer->SampleRate();
+    double target = mixer->Cursor() + SOUND_SCHEDULE_LATENCY * rate;
+
+    stepFrame += deltaTime * rate;
+
+    /*resync after stalls or drift between game and audio clock*/
+    if (fabs(stepFrame - target) > SOUND_RESYNC_THRESHOLD * rate)
+    {
+        stepFrame = target;
+    }
+
+    spatial.Update(deltaTime);
+    updateSpatial();
+
     /*check queue and play if necessary*/
 
     for (auto& c : channels)
@@ -166,36 +371,22 @@ void SoundEngine::update(float deltaTime)
         if (c->available == false)
         {
 
-            c->timePlaying += deltaTime;
-
+            /*streams start with the next update, effects are scheduled in add*/
             if (c->isPlaying == false)
             {
-                c->srcVoice->SubmitSourceBuffer(&c->audio->audioBuffer);
-
-                /*custom volume per type*/
-                if (c->audio->soundType == SoundType::Music)
-                {
-                    c->srcVoice->SetVolume(0.6f);
-                }
-                else if (c->audio->soundType == SoundType::Effect)
-                {
-                    c->srcVoice->SetVolume(0.9f);
-                }
-
+                c->stream->Start(c->srcVoice);
+                c->srcVoice->SetVolume(0.6f);
                 c->srcVoice->Start();
                 c->isPlaying = true;
             }
-            //check if time is over length
             else
             {
-                /*release voice if sound fully played*/
-                if (c->timePlaying > c->audio->length)
+                /*release voice if sound fully played, looping streams run until stopped*/
+                bool finished = c->stream ? c->stream->Finished() : !mixer->IsPlaying(c->mixerVoice);
+
+                if (finished)
                 {
-                    c->available = true;
-                    c->srcVoice->Stop();
-                    c->audio = nullptr;
-                    c->timePlaying = 0;
-                    c->isPlaying = false;
+                    release(c);
                 }
 
             }
@@ -205,21 +396,131 @@ void SoundEngine::update(float deltaTime)
 }
 
 
+/*attenuation, pan and doppler of all positional voices in one batch*/
+void SoundEngine::updateSpatial()
+{
+    emitters.Clear();
+    spatialChannels.clear();
+    spatialVoices.clear();
+
+    for (auto& c : channels)
+    {
+        if (c->available || !c->spatial)
+            continue;
+
+        emitters.Add(c->position, c->velocity);
+        spatialChannels.push_back(c);
+        spatialVoices.push_back(c->mixerVoice);
+    }
+
+    if (spatialChannels.empty())
+        return;
+
+    spatial.Process(emitters);
+
+    for (size_t i = 0; i < spatialChannels.size(); i++)
+    {
+        spatialChannels[i]->audible = emitters.gain[i] >= SOUND_AUDIBLE_THRESHOLD;
+        emitters.gain[i] = spatialChannels[i]->audible ? 0.9f * emitters.gain[i] : 0.f;
+    }
+
+    mixer->SetVoices(spatialVoices.data(), emitters.gain.data(), emitters.pan.data(), emitters.pitch.data(), spatialVoices.size());
+}
+
 void SoundEngine::forceStop(unsigned char channel)
 {
-    if (channel > MAX_CHANNELS) return;
+    if (channel >= MAX_CHANNELS) return;
 
-    if (channels[channel]->isPlaying)
+    if (channels[channel]->available == false)
     {
-        channels[channel]->available = true;
-        channels[channel]->srcVoice->Stop();
-        channels[channel]->audio = nullptr;
-        channels[channel]->timePlaying = 0;
-        channels[channel]->isPlaying = false;
+        release(channels[channel]);
     }
 
 }
 
+void SoundEngine::release(SoundChannel* c)
+{
+    /*the stream is the voice callback and owns the queued buffers, destroy the voice before it*/
+    if (c->stream)
+    {
+        c->stream->Stop();
+
+        if (c->srcVoice)
+        {
+            c->srcVoice->Stop();
+            c->srcVoice->DestroyVoice();
+        }
+
+        SDelete(c->stream);
+    }
+    else
+    {
+        mixer->Stop(c->mixerVoice);
+    }
+
+    c->srcVoice = nullptr;
+    c->mixerVoice = 0;
+
+    c->available = true;
+    c->audio = nullptr;
+    c->startFrame = 0;
+    c->spatial = false;
+    c->audible = true;
+    c->isPlaying = false;
+    c->loop = false;
+
+    freeChannels.push_back(c->index);
+}
+
+/*stop an inaudible effect, else the oldest effect of the lowest priority not above the new sound, returns its channel*/
+int SoundEngine::steal(int priority)
+{
+    SoundChannel* victim = nullptr;
+
+    for (auto& c : channels)
+    {
+        if (c->available || c->stream || (c->audible && c->priority > priority))
+            continue;
+
+        if (victim == nullptr || (!c->audible && victim->audible) ||
+            (c->audible == victim->audible && (c->priority < victim->priority ||
+            (c->priority == victim->priority && c->startFrame < victim->startFrame))))
+        {
+            victim = c;
+        }
+    }
+
+    if (victim == nullptr)
+        return -1;
+
+    release(victim);
+    freeChannels.pop_back();
+
+    return victim->index;
+}
+
+std::wstring SoundEngine::benchmarkDecode() const
+{
+    std::wostringstream report;
+
+    for (auto& s : soundCollection)
+    {
+        if (s.second->soundType != SoundType::Effect)
+            continue;
+
+        AudioClip clip = s.second->clip;
+        clip.Compress();
+
+        AdpcmBenchmark b = AdpcmCodec::Benchmark(clip.adpcm, clip.channels, clip.Frames(), clip.sampleRate);
+
+        report << s.first.c_str() << L": " << b.pcmBytes / 1024 << L" KB pcm -> " << b.compressedBytes / 1024 << L" KB adpcm ("
+               << static_cast<double>(b.pcmBytes) / b.compressedBytes << L"x), " << b.framesPerSecond / 1000000.0
+               << L" M frames/s, " << b.voiceLoad * 100.0 << L"% of a core per voice\n";
+    }
+
+    return report.str();
+}
+
 SoundEngine::SoundEngine()
 {
     Init();
@@ -227,11 +528,26 @@ SoundEngine::SoundEngine()
     for (int i = 0; i < MAX_CHANNELS; i++)
     {
         channels.push_back(new SoundChannel());
+        channels[i]->index = i;
+        freeChannels.push_back(MAX_CHANNELS - 1 - i);
     }
 }
 
 SoundEngine::~SoundEngine()
 {
+    /*stop decode threads before media foundation shuts down*/
+    for (auto& c : channels)
+    {
+        if (c->available == false)
+        {
+            release(c);
+        }
+    }
+
+    mixer->StopOutput();
+    SDelete(mixerOutput);
+    SDelete(mixer);
+
     for (auto& i : soundCollection)
     {
         SDelete(i.second);
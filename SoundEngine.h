@@ -1,5 +1,9 @@
 #pragma once
 
+#include "AudioMixer.h"
+#include "AudioSink.h"
+#include "AudioStream.h"
+#include "SpatialAudio.h"
 #include "xaudio2.h"
 #include <mfapi.h>
 #include <mfidl.h>
@@ -14,7 +18,18 @@
 #pragma comment(lib, "xaudio2.lib")
 
 #define MAX_CHANNELS 32
-#define SAMPLE_RATE 11025
+
+/*keep effects as ima adpcm and decode them while mixing, remove to keep float samples*/
+#define SOUND_COMPRESSED_RESIDENCY
+
+/*sounds are scheduled this far behind the game so offsets inside a step land in the future*/
+#define SOUND_SCHEDULE_LATENCY 0.04
+#define SOUND_RESYNC_THRESHOLD 0.1
+
+/*a new sound steals the oldest channel of lower or equal priority when all are busy*/
+#define SOUND_PRIORITY_LOW 0
+#define SOUND_PRIORITY_NORMAL 1
+#define SOUND_PRIORITY_HIGH 2
 
 enum class SoundType
 {
@@ -26,10 +41,15 @@ struct AudioData
 {
     WAVEFORMATEX waveFormat;
     unsigned int waveLength = 0;
-    std::vector<BYTE> data;
-    XAUDIO2_BUFFER audioBuffer;
+    AudioClip clip;
+
+    /*length in frames and seconds, derived from block align and sample rate*/
+    unsigned long long frames = 0;
     double length = 0;
     SoundType soundType = SoundType::Effect;
+
+    /*music is streamed from the file instead of kept in clip*/
+    std::wstring fileName;
 };
 
 
@@ -38,9 +58,22 @@ class SoundChannel
 private:
     IXAudio2SourceVoice* srcVoice = nullptr;
     AudioData* audio = nullptr;
-    float timePlaying = 0;
+    unsigned long long startFrame = 0;
     bool available = true;
     bool isPlaying = false;
+    bool loop = false;
+    AudioStream* stream = nullptr;
+    int index = 0;
+    int priority = SOUND_PRIORITY_NORMAL;
+
+    /*effects play on a mixer voice, music on its own streamed source voice*/
+    unsigned int mixerVoice = 0;
+
+    /*positional effects, inaudible ones are stolen first*/
+    bool spatial = false;
+    bool audible = true;
+    DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(0.f, 0.f, 0.f);
+    DirectX::XMFLOAT3 velocity = DirectX::XMFLOAT3(0.f, 0.f, 0.f);
 public:
     SoundChannel() = default;
     friend class SoundEngine;
@@ -53,18 +86,57 @@ public:
     ~SoundEngine();
 
     void loadFile(const std::wstring& fileName, SoundType st);
-    int add(const std::string& id, bool loop = false);
+    /*offset in seconds from the start of the current game step, may be negative down to the schedule latency*/
+    int add(const std::string& id, bool loop = false, int priority = SOUND_PRIORITY_NORMAL, float offset = 0.f);
+
+    /*positional effect, returns -1 without taking a channel when no listener can hear it*/
+    int add3D(const std::string& id, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& velocity,
+              bool loop = false, int priority = SOUND_PRIORITY_NORMAL, float offset = 0.f);
+    void setEmitter(int channel, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& velocity);
+
+    /*one listener per split screen camera*/
+    void setListener(int index, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& right);
+    void setListenerCount(int count);
+    unsigned int getCulledSounds() const { return culledSounds; }
+
+    /*new sounds are ignored while muted, used while a match step is simulated again*/
+    void setMuted(bool m) { muted = m; }
     void update(float deltaTime);
     void forceStop(unsigned char channel);
 
+    /*adpcm size and decode speed of every loaded effect, one line each*/
+    std::wstring benchmarkDecode() const;
+
 private:
 
     void Init();
-    void loadFile(const std::wstring& file, std::vector<BYTE>& data, WAVEFORMATEX** formatEx, unsigned int& length);
+    void loadFile(const std::wstring& file, std::vector<BYTE>& data, WAVEFORMATEX& format);
+    bool loadWav(const std::wstring& file, std::vector<BYTE>& data, WAVEFORMATEX& format);
+    int play(const std::string& id, bool loop, int priority, float offset, const VoiceParams& params);
+    void release(SoundChannel* c);
+    int steal(int priority);
+    void updateSpatial();
 
     /*collection*/
     std::map<std::string, AudioData*> soundCollection;
     std::vector<SoundChannel*> channels;
+    std::vector<int> freeChannels;
+
+    /*effects are mixed in software and played through one voice*/
+    AudioMixer* mixer = nullptr;
+    AudioSink* mixerOutput = nullptr;
+
+    /*mixer frame of the current game step start*/
+    double stepFrame = 0.0;
+
+    /*positional audio, batches are kept to reuse their memory*/
+    SpatialAudio spatial;
+    EmitterBatch emitters;
+    EmitterBatch newEmitter;
+    std::vector<SoundChannel*> spatialChannels;
+    std::vector<unsigned int> spatialVoices;
+    unsigned int culledSounds = 0;
+    bool muted = false;
 
     /*xaudio2*/
     IXAudio2* soundMain;
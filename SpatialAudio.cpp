@@ -0,0 +1,165 @@
+#include "SpatialAudio.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+void EmitterBatch::Clear()
+{
+    x.clear(); y.clear(); z.clear();
+    vx.clear(); vy.clear(); vz.clear();
+    count = 0;
+}
+
+void EmitterBatch::Add(const XMFLOAT3& position, const XMFLOAT3& velocity)
+{
+    x.push_back(position.x);
+    y.push_back(position.y);
+    z.push_back(position.z);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    vz.push_back(velocity.z);
+    count++;
+}
+
+void SpatialAudio::SetListener(int index, const XMFLOAT3& position, const XMFLOAT3& right)
+{
+    if (index < 0 || index >= SOUND_MAX_LISTENERS)
+        return;
+
+    SoundListener& l = listeners[index];
+
+    /*an unused listener or a jump is a new camera, not movement*/
+    XMVECTOR jump = XMVector3LengthSq(XMLoadFloat3(&position) - XMLoadFloat3(&l.position));
+
+    if (index >= listenerCount || XMVectorGetX(jump) > SOUND_TELEPORT_DISTANCE * SOUND_TELEPORT_DISTANCE)
+    {
+        l.moved = false;
+    }
+
+    l.position = position;
+    l.right = right;
+}
+
+void SpatialAudio::SetListenerCount(int count)
+{
+    count = std::clamp(count, 0, SOUND_MAX_LISTENERS);
+
+    /*the split screen layout changed, listeners may belong to other cameras now*/
+    if (count != listenerCount)
+    {
+        for (auto& l : listeners)
+        {
+            l.moved = false;
+        }
+    }
+
+    listenerCount = count;
+}
+
+void SpatialAudio::Update(float deltaTime)
+{
+    for (int i = 0; i < listenerCount; i++)
+    {
+        SoundListener& l = listeners[i];
+
+        /*no velocity on the first update or after a pause*/
+        if (l.moved && deltaTime > 0.f)
+        {
+            XMVECTOR v = (XMLoadFloat3(&l.position) - XMLoadFloat3(&l.previous)) / deltaTime;
+            XMStoreFloat3(&l.velocity, v);
+        }
+        else
+        {
+            l.velocity = XMFLOAT3(0.f, 0.f, 0.f);
+        }
+
+        l.previous = l.position;
+        l.moved = true;
+    }
+}
+
+void SpatialAudio::Process(EmitterBatch& b) const
+{
+    size_t padded = (b.count + 3) & ~size_t(3);
+
+    /*padding lanes are zero and ignored*/
+    for (auto* v : { &b.x, &b.y, &b.z, &b.vx, &b.vy, &b.vz })
+    {
+        v->resize(padded, 0.f);
+    }
+
+    b.gain.resize(padded);
+    b.pan.resize(padded);
+    b.pitch.resize(padded);
+
+    if (listenerCount == 0)
+    {
+        std::fill(b.gain.begin(), b.gain.end(), 1.f);
+        std::fill(b.pan.begin(), b.pan.end(), 0.f);
+        std::fill(b.pitch.begin(), b.pitch.end(), 1.f);
+        return;
+    }
+
+    const XMVECTOR one = XMVectorReplicate(1.f);
+    const XMVECTOR minDistance = XMVectorReplicate(SOUND_MIN_DISTANCE);
+    const XMVECTOR speed = XMVectorReplicate(SOUND_SPEED);
+    const XMVECTOR quarterPi = XMVectorReplicate(XM_PIDIV4);
+    const XMVECTOR epsilon = XMVectorReplicate(1e-6f);
+
+    for (size_t i = 0; i < padded; i += 4)
+    {
+        XMVECTOR px = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&b.x[i]));
+        XMVECTOR py = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&b.y[i]));
+        XMVECTOR pz = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&b.z[i]));
+        XMVECTOR ex = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&b.vx[i]));
+        XMVECTOR ey = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&b.vy[i]));
+        XMVECTOR ez = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&b.vz[i]));
+
+        XMVECTOR left = XMVectorZero();
+        XMVECTOR right = XMVectorZero();
+        XMVECTOR loudest = XMVectorZero();
+        XMVECTOR pitch = one;
+
+        for (int l = 0; l < listenerCount; l++)
+        {
+            const SoundListener& L = listeners[l];
+
+            /*listener to emitter*/
+            XMVECTOR dx = px - XMVectorReplicate(L.position.x);
+            XMVECTOR dy = py - XMVectorReplicate(L.position.y);
+            XMVECTOR dz = pz - XMVectorReplicate(L.position.z);
+
+            XMVECTOR distance = XMVectorSqrt(XMVectorMax(dx * dx + dy * dy + dz * dz, epsilon));
+            XMVECTOR inverse = XMVectorReciprocal(distance);
+            XMVECTOR attenuation = XMVectorMin(one, minDistance * inverse);
+
+            /*cosine between direction and right vector, -1 left to 1 right*/
+            XMVECTOR side = (dx * XMVectorReplicate(L.right.x) + dy * XMVectorReplicate(L.right.y) + dz * XMVectorReplicate(L.right.z)) * inverse;
+            side = XMVectorClamp(side, -one, one);
+
+            XMVECTOR s, c;
+            XMVectorSinCos(&s, &c, (side + one) * quarterPi);
+
+            left = XMVectorMax(left, attenuation * c);
+            right = XMVectorMax(right, attenuation * s);
+
+            /*listener moving towards and emitter moving away along the line between both*/
+            XMVECTOR towards = (dx * XMVectorReplicate(L.velocity.x) + dy * XMVectorReplicate(L.velocity.y) + dz * XMVectorReplicate(L.velocity.z)) * inverse;
+            XMVECTOR away = (dx * ex + dy * ey + dz * ez) * inverse;
+
+            XMVECTOR doppler = (speed + towards) / XMVectorMax(speed + away, epsilon);
+            doppler = XMVectorClamp(doppler, XMVectorReplicate(SOUND_DOPPLER_MIN), XMVectorReplicate(SOUND_DOPPLER_MAX));
+
+            pitch = XMVectorSelect(pitch, doppler, XMVectorGreater(attenuation, loudest));
+            loudest = XMVectorMax(loudest, attenuation);
+        }
+
+        /*back to gain and equal power pan of the mixer*/
+        XMVECTOR gain = XMVectorSqrt(left * left + right * right);
+        XMVECTOR pan = XMVectorATan2(right, left) / quarterPi - one;
+
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&b.gain[i]), gain);
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&b.pan[i]), pan);
+        XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&b.pitch[i]), pitch);
+    }
+}
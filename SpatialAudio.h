@@ -0,0 +1,77 @@
+/* SpatialAudio.h
+
+positional sound for up to SOUND_MAX_LISTENERS listeners (one per split
+screen camera).
+
+emitters are collected in an EmitterBatch (structure of arrays) and
+processed four at a time in XMVECTORs against every listener: inverse
+distance attenuation, equal power panning along the listener right vector
+and doppler from the velocities along the line between both. the loudest
+left and right gain of all listeners is kept, the doppler shift of the
+loudest listener is used. the result is one gain, pan and pitch per emitter
+as used by the AudioMixer. without listeners every emitter plays flat.
+
+    Usage:
+    spatial.SetListener(0, cam->getPosition(), cam->getRight());
+    spatial.SetListenerCount(1);
+    spatial.Update(deltaTime);
+
+    batch.Clear();
+    batch.Add(position, velocity);
+    spatial.Process(batch);
+    float gain = batch.gain[0];
+
+*/
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#define SOUND_MAX_LISTENERS 4
+#define SOUND_MIN_DISTANCE 15.f
+#define SOUND_AUDIBLE_THRESHOLD 0.05f
+#define SOUND_SPEED 1500.f
+#define SOUND_DOPPLER_MIN 0.5f
+#define SOUND_DOPPLER_MAX 2.f
+#define SOUND_TELEPORT_DISTANCE 50.f
+
+struct SoundListener
+{
+    DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(0.f, 0.f, 0.f);
+    DirectX::XMFLOAT3 right = DirectX::XMFLOAT3(1.f, 0.f, 0.f);
+    DirectX::XMFLOAT3 velocity = DirectX::XMFLOAT3(0.f, 0.f, 0.f);
+    DirectX::XMFLOAT3 previous = DirectX::XMFLOAT3(0.f, 0.f, 0.f);
+
+    /*previous is from the last update of the same camera*/
+    bool moved = false;
+};
+
+/*emitters as structure of arrays, Process() pads them to groups of four*/
+struct EmitterBatch
+{
+    std::vector<float> x, y, z;
+    std::vector<float> vx, vy, vz;
+    std::vector<float> gain, pan, pitch;
+    size_t count = 0;
+
+    void Clear();
+    void Add(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& velocity);
+};
+
+class SpatialAudio
+{
+public:
+    void SetListener(int index, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& right);
+    void SetListenerCount(int count);
+    int ListenerCount() const { return listenerCount; }
+
+    /*derive listener velocities from their movement*/
+    void Update(float deltaTime);
+
+    void Process(EmitterBatch& batch) const;
+
+private:
+    SoundListener listeners[SOUND_MAX_LISTENERS];
+    int listenerCount = 0;
+};
@@ -0,0 +1,330 @@
+#include "TangentSpace.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+static void sub(const float* a, const float* b, float* r)
+{
+    r[0] = a[0] - b[0]; r[1] = a[1] - b[1]; r[2] = a[2] - b[2];
+}
+
+static void cross(const float* a, const float* b, float* r)
+{
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static float dot(const float* a, const float* b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/*false for a zero vector*/
+static bool normalize(float* v)
+{
+    float l = sqrtf(dot(v, v));
+
+    if (l <= 0.f)
+    {
+        return false;
+    }
+
+    v[0] /= l; v[1] /= l; v[2] /= l;
+    return true;
+}
+
+/*removes the part of v along the unit vector n*/
+static void project(const float* n, float* v)
+{
+    float d = dot(n, v);
+    v[0] -= n[0] * d; v[1] -= n[1] * d; v[2] -= n[2] * d;
+}
+
+TangentSpaceReport TangentSpace::Process(std::vector<TangentVertex>& vertices, std::vector<unsigned int>& indices)
+{
+    TangentSpaceReport report;
+    report.hasTextureCoordinates = HasTextureCoordinates(vertices);
+
+    if (!ValidNormals(vertices))
+    {
+        GenerateNormals(vertices, indices);
+        report.normalsGenerated = true;
+    }
+
+    /*new normals invalidate the stored tangents*/
+    bool tangentsValid = !report.normalsGenerated && ValidTangents(vertices);
+
+    report.splitVertices = SplitMirroredSeams(vertices, indices);
+
+    /*a split vertex had one tangent for both sides of the seam*/
+    if (!tangentsValid || report.splitVertices > 0)
+    {
+        GenerateTangents(vertices, indices);
+        report.tangentsGenerated = true;
+    }
+
+    return report;
+}
+
+bool TangentSpace::ValidNormals(const std::vector<TangentVertex>& vertices)
+{
+    for (auto& v : vertices)
+    {
+        if (!std::isfinite(v.normal[0]) || !std::isfinite(v.normal[1]) || !std::isfinite(v.normal[2]))
+        {
+            return false;
+        }
+
+        if (fabsf(sqrtf(dot(v.normal, v.normal)) - 1.f) > TANGENT_LENGTH_EPSILON)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TangentSpace::ValidTangents(const std::vector<TangentVertex>& vertices)
+{
+    for (auto& v : vertices)
+    {
+        if (!std::isfinite(v.tangent[0]) || !std::isfinite(v.tangent[1]) || !std::isfinite(v.tangent[2]))
+        {
+            return false;
+        }
+
+        if (fabsf(sqrtf(dot(v.tangent, v.tangent)) - 1.f) > TANGENT_LENGTH_EPSILON)
+        {
+            return false;
+        }
+
+        if (fabsf(dot(v.tangent, v.normal)) > TANGENT_ORTHO_EPSILON)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TangentSpace::HasTextureCoordinates(const std::vector<TangentVertex>& vertices)
+{
+    for (auto& v : vertices)
+    {
+        if (v.uv[0] != 0.f || v.uv[1] != 0.f)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TangentSpace::GenerateNormals(std::vector<TangentVertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    std::vector<float> sum(vertices.size() * 3, 0.f);
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const unsigned int* id = &indices[i];
+        const float* p[3] = { vertices[id[0]].position, vertices[id[1]].position, vertices[id[2]].position };
+
+        /*length of the cross product is twice the face area*/
+        float e1[3], e2[3], n[3];
+        sub(p[1], p[0], e1);
+        sub(p[2], p[0], e2);
+        cross(e1, e2, n);
+
+        for (int k = 0; k < 3; k++)
+        {
+            float w = cornerAngle(p[k], p[(k + 1) % 3], p[(k + 2) % 3]);
+            float* s = &sum[id[k] * 3];
+
+            s[0] += n[0] * w; s[1] += n[1] * w; s[2] += n[2] * w;
+        }
+    }
+
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        float* n = vertices[v].normal;
+
+        n[0] = sum[v * 3 + 0]; n[1] = sum[v * 3 + 1]; n[2] = sum[v * 3 + 2];
+
+        if (!normalize(n))
+        {
+            n[0] = 0.f; n[1] = 1.f; n[2] = 0.f;
+        }
+    }
+}
+
+size_t TangentSpace::SplitMirroredSeams(std::vector<TangentVertex>& vertices, std::vector<unsigned int>& indices)
+{
+    size_t count = vertices.size();
+
+    /*the first face with uv area decides the handedness of a vertex, faces of the other
+      handedness get a copy of it, faces without uv area keep whatever vertex they have*/
+    std::vector<int> side(count, 0);
+    std::vector<unsigned int> copy(count, UINT_MAX);
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        int h = handedness(vertices, &indices[i]);
+
+        if (h == 0)
+        {
+            continue;
+        }
+
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[i + k];
+
+            if (side[v] == 0)
+            {
+                side[v] = h;
+            }
+            else if (side[v] != h)
+            {
+                if (copy[v] == UINT_MAX)
+                {
+                    TangentVertex c = vertices[v];
+                    copy[v] = (unsigned int)vertices.size();
+                    vertices.push_back(c);
+                    side.push_back(h);
+                }
+
+                indices[i + k] = copy[v];
+            }
+        }
+    }
+
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        vertices[v].tangent[3] = side[v] < 0 ? -1.f : 1.f;
+    }
+
+    return vertices.size() - count;
+}
+
+void TangentSpace::GenerateTangents(std::vector<TangentVertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    std::vector<float> sum(vertices.size() * 3, 0.f);
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const unsigned int* id = &indices[i];
+        const TangentVertex* v[3] = { &vertices[id[0]], &vertices[id[1]], &vertices[id[2]] };
+
+        float du1 = v[1]->uv[0] - v[0]->uv[0];
+        float dv1 = v[1]->uv[1] - v[0]->uv[1];
+        float du2 = v[2]->uv[0] - v[0]->uv[0];
+        float dv2 = v[2]->uv[1] - v[0]->uv[1];
+
+        float det = du1 * dv2 - du2 * dv1;
+
+        /*degenerate uv mapping, no direction to contribute*/
+        if (fabsf(det) < 1e-12f)
+        {
+            continue;
+        }
+
+        const float* p[3] = { v[0]->position, v[1]->position, v[2]->position };
+
+        /*direction of increasing u on the face*/
+        float e1[3], e2[3], t[3];
+        sub(p[1], p[0], e1);
+        sub(p[2], p[0], e2);
+
+        for (int c = 0; c < 3; c++)
+        {
+            t[c] = (e1[c] * dv2 - e2[c] * dv1) / det;
+        }
+
+        for (int k = 0; k < 3; k++)
+        {
+            float tk[3] = { t[0], t[1], t[2] };
+            project(v[k]->normal, tk);
+
+            if (!normalize(tk))
+            {
+                continue;
+            }
+
+            float w = cornerAngle(p[k], p[(k + 1) % 3], p[(k + 2) % 3]);
+            float* s = &sum[id[k] * 3];
+
+            s[0] += tk[0] * w; s[1] += tk[1] * w; s[2] += tk[2] * w;
+        }
+    }
+
+    for (size_t v = 0; v < vertices.size(); v++)
+    {
+        const float* n = vertices[v].normal;
+        float* t = vertices[v].tangent;
+
+        t[0] = sum[v * 3 + 0]; t[1] = sum[v * 3 + 1]; t[2] = sum[v * 3 + 2];
+
+        /*gram schmidt*/
+        project(n, t);
+
+        if (dot(t, t) < 1e-12f)
+        {
+            orthogonalTangent(n, t);
+        }
+
+        normalize(t);
+
+        if (t[3] != -1.f)
+        {
+            t[3] = 1.f;
+        }
+    }
+}
+
+/*sign of the uv area, mirrored uvs are negative*/
+int TangentSpace::handedness(const std::vector<TangentVertex>& vertices, const unsigned int* face)
+{
+    const float* a = vertices[face[0]].uv;
+    const float* b = vertices[face[1]].uv;
+    const float* c = vertices[face[2]].uv;
+
+    float det = (b[0] - a[0]) * (c[1] - a[1]) - (c[0] - a[0]) * (b[1] - a[1]);
+
+    if (fabsf(det) < 1e-12f)
+    {
+        return 0;
+    }
+
+    return det > 0.f ? 1 : -1;
+}
+
+/*angle at p between the edges to a and b*/
+float TangentSpace::cornerAngle(const float* p, const float* a, const float* b)
+{
+    float e1[3], e2[3];
+    sub(a, p, e1);
+    sub(b, p, e2);
+
+    float l = sqrtf(dot(e1, e1)) * sqrtf(dot(e2, e2));
+
+    if (l <= 0.f)
+    {
+        return 0.f;
+    }
+
+    return acosf((std::min)(1.f, (std::max)(-1.f, dot(e1, e2) / l)));
+}
+
+void TangentSpace::orthogonalTangent(const float* n, float* t)
+{
+    float axis[3] = { 0.f, 1.f, 0.f };
+
+    if (fabsf(n[1]) >= 0.99f)
+    {
+        axis[0] = 1.f; axis[1] = 0.f;
+    }
+
+    cross(axis, n, t);
+    normalize(t);
+}
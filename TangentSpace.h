@@ -0,0 +1,75 @@
+/* TangentSpace.h
+
+validates and regenerates the per vertex normals and tangents of meshes.
+
+normals are the sum of the adjacent face normals weighted by face area and
+corner angle. tangents use the mikktspace weighting: the uv tangent of every
+face is projected into the tangent plane of the corner normal, weighted by
+the corner angle, accumulated and orthonormalized at the end. meshes without
+texture coordinates get an arbitrary tangent perpendicular to the normal.
+
+the w of a tangent is the handedness of the uv mapping, the bitangent is
+w * cross(normal, tangent). like mikktspace a vertex shared by faces with
+mirrored and unmirrored uvs is split, so both sides of a mirror seam get
+their own tangent and sign. (mikktspace also splits vertices where faces
+of the same handedness only touch at the vertex, this does not.)
+
+only depends on the standard library, Model::GenerateTangentSpace runs it
+on the meshes of a model.
+
+    Usage:
+    TangentSpaceReport r = TangentSpace::Process(vertices, indices);
+
+    bitangent = tangent.w * cross(normal, tangent.xyz)
+
+*/
+
+#pragma once
+
+#include "constants.h"
+#include <cstddef>
+#include <vector>
+
+/*same layout as Vertex::Standard*/
+struct TangentVertex
+{
+    float position[3];
+    float uv[2];
+    float normal[3];
+    float tangent[4];
+};
+
+struct TangentSpaceReport
+{
+    bool hasTextureCoordinates = false;
+    bool normalsGenerated = false;
+    bool tangentsGenerated = false;
+
+    /*vertices added at mirrored uv seams*/
+    size_t splitVertices = 0;
+};
+
+class TangentSpace
+{
+public:
+    /*check and repair, may add vertices and change indices*/
+    static TangentSpaceReport Process(std::vector<TangentVertex>& vertices, std::vector<unsigned int>& indices);
+
+    static bool ValidNormals(const std::vector<TangentVertex>& vertices);
+    static bool ValidTangents(const std::vector<TangentVertex>& vertices);
+    static bool HasTextureCoordinates(const std::vector<TangentVertex>& vertices);
+
+    static void GenerateNormals(std::vector<TangentVertex>& vertices, const std::vector<unsigned int>& indices);
+
+    /*stores the handedness of every vertex in tangent[3], returns the number of vertices added*/
+    static size_t SplitMirroredSeams(std::vector<TangentVertex>& vertices, std::vector<unsigned int>& indices);
+
+    /*keeps the handedness in tangent[3], vertices without one get 1*/
+    static void GenerateTangents(std::vector<TangentVertex>& vertices, const std::vector<unsigned int>& indices);
+
+private:
+    /*+1, -1 or 0 for a face without uv area*/
+    static int handedness(const std::vector<TangentVertex>& vertices, const unsigned int* face);
+    static float cornerAngle(const float* p, const float* a, const float* b);
+    static void orthogonalTangent(const float* n, float* t);
+};
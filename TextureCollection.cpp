@@ -1,8 +1,9 @@
 #include "TextureCollection.h"
 #include "DDSTextureLoader.h"
+#include <fstream>
 
 /*keep device for texture loading*/
-TextureCollection::TextureCollection(ID3D11Device* dev)
+TextureCollection::TextureCollection(ID3D11Device* dev) : streamer(dev)
 {
     device = dev;
     defaultID = DEFAULT_NONE;
@@ -22,12 +23,9 @@ TextureCollection::~TextureCollection()
     collection.clear();
 }
 
-/*load texture in file and add it to collection*/
+/*register texture in file, it is loaded when first used*/
 bool TextureCollection::Add(std::string file)
 {
-
-    ID3D11ShaderResourceView* srv = 0;
-
     char id[128];
     char ext[8];
     _splitpath_s(file.c_str(), NULL, 0, NULL, 0, id, 128, ext, 8);
@@ -40,22 +38,22 @@ bool TextureCollection::Add(std::string file)
         return true;
     }
 
-    if (collection.find(id) != collection.end())
+    if (residency.Find(id))
     {
         DBOUT("skipping " << id << ext << " because it is already in the collection"<<endl);
         return true;
     }
 
-    /*load*/
-    HRESULT hr = DirectX::CreateDDSTextureFromFile(device, std::wstring(file.begin(), file.end()).c_str(), nullptr, &srv);
+    /*size for the budget from the header*/
+    uint64_t bytes = 0;
 
-    if (FAILED(hr))
+    if (!TextureResidency::DdsBytes(file, bytes))
     {
-        throw std::exception("failed to create srv from file");
+        throw std::exception("failed to read dds header");
         return false;
     }
 
-    collection.insert(std::make_pair(id, srv));
+    residency.Register(id, file, bytes);
     return true;
 }
 
@@ -63,7 +61,7 @@ bool TextureCollection::Add(std::string file)
 ID3D11ShaderResourceView* TextureCollection::Get(std::string id)
 {
 
-    if (collection.find(id) == collection.end())
+    if (!residency.Find(id))
     {
         if (defaultID == DEFAULT_NONE)
         {
@@ -72,22 +70,123 @@ ID3D11ShaderResourceView* TextureCollection::Get(std::string id)
         }
         else
         {
-            return collection[defaultID];
+            id = defaultID;
+        }
+    }
+
+    if (residency.Use(id))
+    {
+        return collection[id];
+    }
+
+    /*placeholder until Update loaded it, without one it is loaded now*/
+    if (defaultID == DEFAULT_NONE)
+    {
+        if (!load(id))
+        {
+            throw std::exception("failed to create srv from file");
+            return nullptr;
         }
+
+        return collection[id];
     }
 
-    return collection[id];
+    return collection[defaultID];
 
 }
 
 bool TextureCollection::SetDefaultTexture(std::string id)
 {
-    if (collection.find(id) == collection.end())
+    if (!residency.Find(id) || (!residency.Find(id)->resident && !load(id)))
     {
         throw std::exception("can't set default texture");
         return false;
     }
 
+    residency.Pin(id);
     defaultID = id;
     return true;
 }
+
+void TextureCollection::Update(ID3D11DeviceContext* context)
+{
+    for (auto& id : residency.TakeLoads(TEXTURE_LOADS_PER_FRAME))
+    {
+        streamer.Request(id, residency.Find(id)->file);
+    }
+
+    std::vector<TextureStreamer::Ready> ready;
+    std::vector<std::string> failed;
+    streamer.Update(context, ready, failed);
+
+    for (auto& r : ready)
+    {
+        collection[r.id] = r.srv;
+        residency.Loaded(r.id, true, r.bytes);
+    }
+
+    /*formats the streamer can't create*/
+    for (auto& id : failed)
+    {
+        load(id);
+    }
+
+    for (auto& id : residency.Evict())
+    {
+        streamer.Cancel(id);
+        DXRelease(collection[id]);
+        collection.erase(id);
+    }
+
+    residency.NextFrame();
+}
+
+void TextureCollection::SetBudget(uint64_t bytes)
+{
+    residency.SetBudget(bytes);
+}
+
+const TextureResidency& TextureCollection::getResidency()
+{
+    return residency;
+}
+
+bool TextureCollection::WriteReport(const std::string& file)
+{
+    std::wofstream out(file, std::ios::trunc);
+
+    if (!out.is_open())
+        return false;
+
+    out << residency.Report();
+    return true;
+}
+
+bool TextureCollection::load(const std::string& id)
+{
+    const TextureEntry* e = residency.Find(id);
+
+    if (!e)
+        return false;
+
+    /*loaded out of the queue already*/
+    if (e->resident)
+    {
+        residency.Loaded(id, true);
+        return true;
+    }
+
+    ID3D11ShaderResourceView* srv = 0;
+    HRESULT hr = DirectX::CreateDDSTextureFromFile(device, std::wstring(e->file.begin(), e->file.end()).c_str(), nullptr, &srv);
+
+    if (FAILED(hr))
+    {
+        DBOUT("failed to load texture " << e->file.c_str() << endl);
+        residency.Loaded(id, false);
+        return false;
+    }
+
+    collection[id] = srv;
+    residency.Loaded(id, true);
+    return true;
+}
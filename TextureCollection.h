@@ -1,7 +1,17 @@
 #pragma once
 
 #include "util.h"
+#include "TextureResidency.h"
+#include "TextureStreamer.h"
 
+/*seconds between two reports of -texturetelemetry*/
+#define TEXTURE_TELEMETRY_INTERVAL 1.f
+
+/*textures are registered with Add and loaded when first used, until then
+  and for textures that fail to load Get returns the default texture.
+  Update streams the requested textures in, smallest mip first, and evicts
+  the least recently used ones over the budget, see TextureResidency.h and
+  TextureStreamer.h*/
 class TextureCollection
 {
 public:
@@ -12,8 +22,21 @@ public:
     ID3D11ShaderResourceView* Get(std::string id);
     bool SetDefaultTexture(std::string id);
 
+    /*once per frame*/
+    void Update(ID3D11DeviceContext* context);
+
+    void SetBudget(uint64_t bytes);
+    const TextureResidency& getResidency();
+
+    /*resident textures and their bytes, for -texturetelemetry*/
+    bool WriteReport(const std::string& file);
+
 private:
+    bool load(const std::string& id);
+
     std::map<std::string, ID3D11ShaderResourceView*> collection;
+    TextureResidency residency;
+    TextureStreamer streamer;
     ID3D11Device* device;
     std::string defaultID;
-};
\ No newline at end of file
+};
@@ -0,0 +1,591 @@
+#include "TexturePacker.h"
+#include "json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDPF_FOURCC 0x4
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+#define DDS_DIMENSION_TEXTURE2D 3
+
+/*free space of a page, maxrects with the best short side fit*/
+class MaxRects
+{
+public:
+    MaxRects(uint32_t width, uint32_t height)
+    {
+        AtlasRect all;
+        all.width = width;
+        all.height = height;
+        free.push_back(all);
+    }
+
+    bool Insert(uint32_t width, uint32_t height, AtlasRect& placed)
+    {
+        size_t best = free.size();
+        uint32_t bestShort = UINT_MAX, bestLong = UINT_MAX;
+
+        for (size_t i = 0; i < free.size(); i++)
+        {
+            const AtlasRect& f = free[i];
+
+            if (f.width < width || f.height < height)
+                continue;
+
+            uint32_t dw = f.width - width, dh = f.height - height;
+            uint32_t s = (std::min)(dw, dh), l = (std::max)(dw, dh);
+
+            if (s < bestShort || (s == bestShort && l < bestLong))
+            {
+                best = i;
+                bestShort = s;
+                bestLong = l;
+            }
+        }
+
+        if (best == free.size())
+            return false;
+
+        placed.x = free[best].x;
+        placed.y = free[best].y;
+        placed.width = width;
+        placed.height = height;
+
+        split(placed);
+        prune();
+        return true;
+    }
+
+private:
+    /*free rectangles overlapping r are replaced by the up to four maximal ones around it*/
+    void split(const AtlasRect& r)
+    {
+        std::vector<AtlasRect> next;
+
+        for (const AtlasRect& f : free)
+        {
+            if (r.x >= f.x + f.width || r.x + r.width <= f.x || r.y >= f.y + f.height || r.y + r.height <= f.y)
+            {
+                next.push_back(f);
+                continue;
+            }
+
+            if (r.x > f.x)
+                next.push_back({ f.x, f.y, r.x - f.x, f.height });
+
+            if (r.x + r.width < f.x + f.width)
+                next.push_back({ r.x + r.width, f.y, f.x + f.width - r.x - r.width, f.height });
+
+            if (r.y > f.y)
+                next.push_back({ f.x, f.y, f.width, r.y - f.y });
+
+            if (r.y + r.height < f.y + f.height)
+                next.push_back({ f.x, r.y + r.height, f.width, f.y + f.height - r.y - r.height });
+        }
+
+        free.swap(next);
+    }
+
+    static bool contains(const AtlasRect& a, const AtlasRect& b)
+    {
+        return b.x >= a.x && b.y >= a.y && b.x + b.width <= a.x + a.width && b.y + b.height <= a.y + a.height;
+    }
+
+    /*drop rectangles inside others, of two equal ones the first stays*/
+    void prune()
+    {
+        std::vector<AtlasRect> next;
+
+        for (size_t i = 0; i < free.size(); i++)
+        {
+            bool inside = false;
+
+            for (size_t j = 0; j < free.size() && !inside; j++)
+            {
+                inside = j != i && contains(free[j], free[i]) && (j < i || !contains(free[i], free[j]));
+            }
+
+            if (!inside)
+                next.push_back(free[i]);
+        }
+
+        free.swap(next);
+    }
+
+    std::vector<AtlasRect> free;
+};
+
+/*why a texture can't go on a page, nullptr if it can*/
+static const char* unsupported(const DdsLayout& l)
+{
+    if (l.format == 0)
+        return "no dxgi format";
+
+    if (l.cube || l.volume || l.arraySize != 1)
+        return "not a single 2d texture";
+
+    if (l.width > TEXTURE_ATLAS_MAX_TEXTURE || l.height > TEXTURE_ATLAS_MAX_TEXTURE)
+        return "too large for the atlas";
+
+    if (l.width % 4 != 0 || l.height % 4 != 0)
+        return "size is not a multiple of 4";
+
+    return nullptr;
+}
+
+static bool writeDds(const std::string& file, const AtlasPage& page, uint32_t format, const std::vector<uint8_t>& data)
+{
+    /*header and dx10 header as 32 bit words*/
+    uint32_t header[(DDS_HEADER_BYTES + DDS_DX10_BYTES) / 4] = {};
+
+    header[0] = DDS_HEADER_BYTES;
+    header[1] = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT;
+    header[2] = page.height;
+    header[3] = page.width;
+    header[6] = page.mips;
+    header[18] = 32;
+    header[19] = DDPF_FOURCC;
+    memcpy(&header[20], "DX10", 4);
+    header[26] = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+    header[31] = format;
+    header[32] = DDS_DIMENSION_TEXTURE2D;
+    header[34] = 1;
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+
+    if (!out.is_open())
+        return false;
+
+    out.write("DDS ", DDS_MAGIC_BYTES);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+    return out.good();
+}
+
+void TexturePacker::Add(const std::string& id, const std::string& file)
+{
+    Source s;
+    s.id = id;
+    s.file = file;
+    s.valid = ReadDdsLayout(file, s.layout);
+
+    sources.push_back(s);
+}
+
+bool TexturePacker::Pack()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    pages.clear();
+    normals.clear();
+    skipped.clear();
+
+    const std::string suffix = TEXTURE_ATLAS_NORMAL_SUFFIX;
+
+    std::map<std::string, size_t> index;
+
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        index[sources[i].id] = i;
+    }
+
+    /*pages are shared by textures of the same format, normal map format and mips*/
+    std::map<std::vector<uint32_t>, std::vector<size_t>> groups;
+    std::map<size_t, size_t> normalSource;
+
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        const Source& s = sources[i];
+        const DdsLayout& l = s.layout;
+
+        /*normal maps go with their texture*/
+        if (s.id.size() > suffix.size() && s.id.compare(s.id.size() - suffix.size(), suffix.size(), suffix) == 0 &&
+            index.count(s.id.substr(0, s.id.size() - suffix.size())))
+            continue;
+
+        const char* reason = s.valid ? unsupported(l) : "not a readable dds file";
+
+        if (reason)
+        {
+            skip(s.id, reason);
+            continue;
+        }
+
+        uint32_t mips = (std::min)(l.mips, (uint32_t)TEXTURE_ATLAS_MAX_MIPS);
+        uint32_t normalFormat = 0;
+
+        auto n = index.find(s.id + suffix);
+
+        if (n != index.end())
+        {
+            const Source& ns = sources[n->second];
+            reason = ns.valid ? unsupported(ns.layout) : "not a readable dds file";
+
+            if (!reason && (ns.layout.width != l.width || ns.layout.height != l.height))
+                reason = "size differs from its texture";
+
+            if (reason)
+            {
+                skip(ns.id, reason);
+            }
+            else
+            {
+                normalSource[i] = n->second;
+                normalFormat = ns.layout.format;
+                mips = (std::min)(mips, ns.layout.mips);
+            }
+        }
+
+        /*every mip of the texture has to cover whole blocks*/
+        while (mips > 1 && (l.width % (4u << (mips - 1)) != 0 || l.height % (4u << (mips - 1)) != 0))
+        {
+            mips--;
+        }
+
+        groups[{ l.format, normalFormat, mips }].push_back(i);
+    }
+
+    for (auto& g : groups)
+    {
+        uint32_t mips = g.first[2];
+        uint32_t cell = 4u << (mips - 1);
+        std::vector<size_t>& members = g.second;
+
+        /*largest first*/
+        std::stable_sort(members.begin(), members.end(), [&](size_t a, size_t b)
+        {
+            const DdsLayout& la = sources[a].layout;
+            const DdsLayout& lb = sources[b].layout;
+            uint32_t sa = (std::max)(la.width, la.height), sb = (std::max)(lb.width, lb.height);
+
+            return sa != sb ? sa > sb : la.width * la.height > lb.width * lb.height;
+        });
+
+        std::vector<MaxRects> bins;
+        size_t first = pages.size();
+
+        for (size_t i : members)
+        {
+            const Source& s = sources[i];
+
+            /*in cells, with one cell of gutter on every side*/
+            uint32_t w = s.layout.width / cell + 2, h = s.layout.height / cell + 2;
+            AtlasRect placed;
+            size_t b = 0;
+
+            while (b < bins.size() && !bins[b].Insert(w, h, placed))
+            {
+                b++;
+            }
+
+            if (b == bins.size())
+            {
+                bins.emplace_back(TEXTURE_ATLAS_SIZE / cell, TEXTURE_ATLAS_SIZE / cell);
+                bins.back().Insert(w, h, placed);
+
+                AtlasPage page;
+                page.id = "atlas" + std::to_string(pages.size());
+                page.normalId = g.first[1] ? page.id + suffix : "";
+                page.mips = mips;
+                page.format = g.first[0];
+                page.normalFormat = g.first[1];
+                pages.push_back(page);
+            }
+
+            AtlasPage& page = pages[first + b];
+
+            AtlasRect r;
+            r.x = (placed.x + 1) * cell;
+            r.y = (placed.y + 1) * cell;
+            r.width = s.layout.width;
+            r.height = s.layout.height;
+
+            /*pages end at their last texture*/
+            page.width = (std::max)(page.width, (placed.x + w) * cell);
+            page.height = (std::max)(page.height, (placed.y + h) * cell);
+            page.textures.push_back(s.id);
+            page.rects.push_back(r);
+
+            if (normalSource.count(i))
+                normals[s.id] = sources[normalSource[i]].id;
+        }
+    }
+
+    packMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return !pages.empty();
+}
+
+bool TexturePacker::Write(const std::string& dir)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    nlohmann::json manifest;
+    manifest["pages"] = nlohmann::json::array();
+    manifest["textures"] = nlohmann::json::object();
+
+    std::vector<uint8_t> data;
+
+    for (size_t p = 0; p < pages.size(); p++)
+    {
+        const AtlasPage& page = pages[p];
+
+        if (!copy(page, false, data) || !writeDds(dir + "/" + page.id + ".dds", page, page.format, data))
+            return false;
+
+        if (!page.normalId.empty() &&
+            (!copy(page, true, data) || !writeDds(dir + "/" + page.normalId + ".dds", page, page.normalFormat, data)))
+            return false;
+
+        manifest["pages"].push_back({ { "id", page.id }, { "normal", page.normalId }, { "width", page.width },
+                                      { "height", page.height }, { "mips", page.mips }, { "format", page.format },
+                                      { "normalFormat", page.normalFormat } });
+
+        for (size_t t = 0; t < page.textures.size(); t++)
+        {
+            const AtlasRect& r = page.rects[t];
+            auto n = normals.find(page.textures[t]);
+
+            manifest["textures"][page.textures[t]] = { { "page", p }, { "normal", n == normals.end() ? "" : n->second },
+                                                       { "rect", { r.x, r.y, r.width, r.height } } };
+        }
+    }
+
+    std::ofstream out(dir + "/" + TEXTURE_ATLAS_MANIFEST, std::ios::trunc);
+
+    if (!out.is_open())
+        return false;
+
+    out << manifest.dump(4);
+
+    writeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return out.good();
+}
+
+std::wstring TexturePacker::Report() const
+{
+    uint64_t used = 0, total = 0;
+    size_t packed = 0;
+
+    std::wostringstream s;
+
+    for (const AtlasPage& page : pages)
+    {
+        uint64_t area = 0;
+
+        for (const AtlasRect& r : page.rects)
+        {
+            area += (uint64_t)r.width * r.height;
+        }
+
+        used += area;
+        total += (uint64_t)page.width * page.height;
+        packed += page.textures.size() + (page.normalId.empty() ? 0 : page.textures.size());
+
+        s << L"  " << std::wstring(page.id.begin(), page.id.end());
+
+        if (!page.normalId.empty())
+            s << L" + " << std::wstring(page.normalId.begin(), page.normalId.end());
+
+        s << L": " << page.width << L" x " << page.height << L", format " << page.format << L", " << page.mips << L" mips, "
+          << page.textures.size() << L" textures, " << area * 100 / ((uint64_t)page.width * page.height) << L"% occupied\n";
+    }
+
+    for (const std::string& r : skipped)
+    {
+        s << L"  skipped " << std::wstring(r.begin(), r.end()) << L"\n";
+    }
+
+    std::wostringstream head;
+    head << L"Texture atlas: " << packed << L" of " << sources.size() << L" textures on " << pages.size() << L" pages, "
+         << (total ? used * 100 / total : 0) << L"% occupied, packed in " << packMs << L" ms, written in " << writeMs << L" ms\n";
+
+    return head.str() + s.str();
+}
+
+/*the pixels of all mips of a page, the textures with their gutters*/
+bool TexturePacker::copy(const AtlasPage& page, bool normalMaps, std::vector<uint8_t>& data)
+{
+    const uint32_t cell = 4u << (page.mips - 1);
+    std::vector<uint64_t> mipOffset;
+    uint32_t elementBytes = 0, element = 1;
+
+    data.clear();
+
+    for (size_t t = 0; t < page.textures.size(); t++)
+    {
+        std::string id = normalMaps ? normals.at(page.textures[t]) : page.textures[t];
+        const Source* s = nullptr;
+
+        for (const Source& i : sources)
+        {
+            if (i.id == id)
+                s = &i;
+        }
+
+        if (!s)
+            return false;
+
+        std::ifstream in(s->file, std::ios::binary);
+        std::vector<uint8_t> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        /*the file has to be what was packed*/
+        DdsLayout l;
+
+        if (!ParseDds(file.data(), file.size(), file.size(), l) || l.width != s->layout.width ||
+            l.height != s->layout.height || l.format != s->layout.format || l.mips < page.mips)
+            return false;
+
+        if (t == 0)
+        {
+            /*a block or a texel*/
+            element = l.blockCompressed ? 4 : 1;
+            elementBytes = l.blockCompressed ? l.bitsPerTexel * 2 : l.bitsPerTexel / 8;
+
+            uint64_t size = 0;
+
+            for (uint32_t m = 0; m < page.mips; m++)
+            {
+                mipOffset.push_back(size);
+                size += (uint64_t)((page.width >> m) / element) * ((page.height >> m) / element) * elementBytes;
+            }
+
+            data.assign(static_cast<size_t>(size), 0);
+        }
+
+        const AtlasRect& r = page.rects[t];
+
+        for (uint32_t m = 0; m < page.mips; m++)
+        {
+            const DdsSubresource& src = l.Subresource(m, 0);
+
+            size_t pitch = (size_t)((page.width >> m) / element) * elementBytes;
+            int cols = (int)((r.width >> m) / element), rows = (int)((r.height >> m) / element);
+            int gutter = (int)((cell >> m) / element);
+            size_t x = (r.x >> m) / element, y = (r.y >> m) / element;
+
+            for (int ry = -gutter; ry < rows + gutter; ry++)
+            {
+                int sy = (std::min)((std::max)(ry, 0), rows - 1);
+
+                const uint8_t* from = file.data() + src.offset + (size_t)sy * src.rowPitch;
+                uint8_t* to = data.data() + mipOffset[m] + (y + ry) * pitch + x * elementBytes;
+
+                memcpy(to, from, (size_t)cols * elementBytes);
+
+                /*edges repeated into the gutter*/
+                for (int k = 1; k <= gutter; k++)
+                {
+                    memcpy(to - (size_t)k * elementBytes, from, elementBytes);
+                    memcpy(to + (size_t)(cols - 1 + k) * elementBytes, from + (size_t)(cols - 1) * elementBytes, elementBytes);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void TexturePacker::skip(const std::string& id, const std::string& reason)
+{
+    skipped.push_back(id + ": " + reason);
+}
+
+bool TextureAtlas::Read(const std::string& file)
+{
+    pages.clear();
+    entries.clear();
+
+    std::ifstream in(file);
+
+    if (!in.is_open())
+        return false;
+
+    try
+    {
+        nlohmann::json j = nlohmann::json::parse(in);
+
+        for (auto& p : j["pages"])
+        {
+            AtlasPage page;
+            page.id = p["id"].get<std::string>();
+            page.normalId = p["normal"].get<std::string>();
+            page.width = p["width"];
+            page.height = p["height"];
+            page.mips = p["mips"];
+            page.format = p["format"];
+            page.normalFormat = p["normalFormat"];
+
+            if (page.width == 0 || page.height == 0)
+                throw std::invalid_argument("empty atlas page");
+
+            pages.push_back(page);
+        }
+
+        for (auto it = j["textures"].begin(); it != j["textures"].end(); it++)
+        {
+            Entry e;
+            e.page = it.value()["page"];
+            e.normal = it.value()["normal"].get<std::string>();
+            e.rect.x = it.value()["rect"][0];
+            e.rect.y = it.value()["rect"][1];
+            e.rect.width = it.value()["rect"][2];
+            e.rect.height = it.value()["rect"][3];
+
+            if (e.page >= pages.size() || (uint64_t)e.rect.x + e.rect.width > pages[e.page].width ||
+                (uint64_t)e.rect.y + e.rect.height > pages[e.page].height)
+                throw std::invalid_argument("atlas rect outside of its page");
+
+            entries[it.key()] = e;
+        }
+    }
+    catch (std::exception&)
+    {
+        pages.clear();
+        entries.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool TextureAtlas::Find(const std::string& diffuse, const std::string& normal, AtlasPlacement& placement) const
+{
+    auto it = entries.find(diffuse);
+
+    if (it == entries.end())
+        return false;
+
+    const Entry& e = it->second;
+    const AtlasPage& page = pages[e.page];
+
+    if (!normal.empty() && (normal != e.normal || page.normalId.empty()))
+        return false;
+
+    placement.page = page.id;
+    placement.normalPage = normal.empty() ? "" : page.normalId;
+    placement.scale[0] = (float)e.rect.width / page.width;
+    placement.scale[1] = (float)e.rect.height / page.height;
+    placement.offset[0] = (float)e.rect.x / page.width;
+    placement.offset[1] = (float)e.rect.y / page.height;
+
+    return true;
+}
@@ -0,0 +1,136 @@
+/* TexturePacker.h
+
+packs small dds textures into atlas pages at build time, so meshes with
+different textures can be drawn without binding another texture. textures
+of the same format and mip count share pages, they are placed with
+maxrects and the best short side fit. a normal map named <id>_nmap of the
+same size as <id> is placed at the same spot of a second page.
+
+every texture is surrounded by a gutter of its repeated edge blocks.
+positions, sizes and gutters are multiples of 4 << (mips - 1) texels, so
+every mip of a page has whole blocks and a gutter of at least one block.
+pages have at most TEXTURE_ATLAS_MAX_MIPS mips to keep the gutters small.
+
+Write stores the pages as dds files next to a manifest, TextureAtlas reads
+the manifest at run time and gives the uv transform of a texture.
+
+only depends on the standard library.
+
+    Usage:
+    TexturePacker packer;
+    packer.Add("bricks", "data/textures/bricks.dds");
+    packer.Add("bricks_nmap", "data/textures/bricks_nmap.dds");
+    packer.Pack();
+    packer.Write("data/textures/atlas");
+    DBOUT(packer.Report());
+
+    TextureAtlas atlas;
+    atlas.Read("data/textures/atlas/atlas.json");
+
+    AtlasPlacement p;
+    if (atlas.Find("bricks", "bricks_nmap", p))
+        uv = p.offset + uv * p.scale, drawn with p.page and p.normalPage
+
+*/
+
+#pragma once
+
+#include "DdsParser.h"
+#include <map>
+#include <string>
+#include <vector>
+
+#define TEXTURE_ATLAS_SIZE 4096
+#define TEXTURE_ATLAS_MAX_TEXTURE 1024
+#define TEXTURE_ATLAS_MAX_MIPS 4
+#define TEXTURE_ATLAS_NORMAL_SUFFIX "_nmap"
+#define TEXTURE_ATLAS_MANIFEST "atlas.json"
+
+/*a texture on a page in texels of mip 0, without its gutter*/
+struct AtlasRect
+{
+    uint32_t x = 0, y = 0;
+    uint32_t width = 0, height = 0;
+};
+
+struct AtlasPage
+{
+    std::string id;
+
+    /*empty if the textures of the page have no normal maps*/
+    std::string normalId;
+
+    uint32_t width = 0, height = 0, mips = 1;
+    uint32_t format = 0, normalFormat = 0;
+
+    std::vector<std::string> textures;
+    std::vector<AtlasRect> rects;
+};
+
+/*uv = offset + uv * scale*/
+struct AtlasPlacement
+{
+    std::string page, normalPage;
+    float scale[2];
+    float offset[2];
+};
+
+class TexturePacker
+{
+public:
+    void Add(const std::string& id, const std::string& file);
+
+    /*places the textures on pages, false if none could be placed*/
+    bool Pack();
+
+    /*pages as <page id>.dds and the manifest into dir*/
+    bool Write(const std::string& dir);
+
+    const std::vector<AtlasPage>& Pages() const { return pages; }
+
+    /*pages, their occupancy, skipped textures and run time*/
+    std::wstring Report() const;
+
+private:
+    struct Source
+    {
+        std::string id, file;
+        DdsLayout layout;
+        bool valid = false;
+    };
+
+    bool copy(const AtlasPage& page, bool normals, std::vector<uint8_t>& data);
+    void skip(const std::string& id, const std::string& reason);
+
+    std::vector<Source> sources;
+    std::vector<AtlasPage> pages;
+
+    /*id of a packed texture to the id of its normal map*/
+    std::map<std::string, std::string> normals;
+    std::vector<std::string> skipped;
+
+    double packMs = 0.0, writeMs = 0.0;
+};
+
+/*the manifest written by TexturePacker*/
+class TextureAtlas
+{
+public:
+    bool Read(const std::string& file);
+
+    /*false if diffuse is not in the atlas or normal is not its normal map, normal may be empty*/
+    bool Find(const std::string& diffuse, const std::string& normal, AtlasPlacement& placement) const;
+
+    size_t Size() const { return entries.size(); }
+
+private:
+    struct Entry
+    {
+        size_t page;
+        std::string normal;
+        AtlasRect rect;
+    };
+
+    std::vector<AtlasPage> pages;
+    std::map<std::string, Entry> entries;
+};
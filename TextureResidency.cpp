@@ -0,0 +1,168 @@
+#include "TextureResidency.h"
+#include "DdsParser.h"
+#include <algorithm>
+#include <sstream>
+
+TextureResidency::TextureResidency(uint64_t budget) : budget(budget)
+{
+}
+
+void TextureResidency::SetBudget(uint64_t bytes)
+{
+    budget = bytes;
+}
+
+bool TextureResidency::Register(const std::string& id, const std::string& file, uint64_t bytes)
+{
+    if (entries.find(id) != entries.end())
+        return false;
+
+    TextureEntry e;
+    e.file = file;
+    e.bytes = bytes;
+    entries.insert(std::make_pair(id, e));
+
+    return true;
+}
+
+const TextureEntry* TextureResidency::Find(const std::string& id) const
+{
+    auto it = entries.find(id);
+    return it == entries.end() ? nullptr : &it->second;
+}
+
+bool TextureResidency::Use(const std::string& id)
+{
+    auto it = entries.find(id);
+
+    if (it == entries.end())
+        return false;
+
+    TextureEntry& e = it->second;
+    e.lastUse = frame;
+
+    if (e.resident)
+    {
+        /*most recently used to the back*/
+        lru.splice(lru.end(), lru, lruPos[id]);
+        return true;
+    }
+
+    if (!e.queued && !e.failed)
+    {
+        e.queued = true;
+        queue.push_back(id);
+    }
+
+    return false;
+}
+
+void TextureResidency::Pin(const std::string& id, bool pinned)
+{
+    auto it = entries.find(id);
+
+    if (it != entries.end())
+        it->second.pinned = pinned;
+}
+
+std::vector<std::string> TextureResidency::TakeLoads(size_t max)
+{
+    size_t count = (std::min)(max, queue.size());
+    std::vector<std::string> taken(queue.begin(), queue.begin() + count);
+
+    queue.erase(queue.begin(), queue.begin() + count);
+
+    return taken;
+}
+
+void TextureResidency::Loaded(const std::string& id, bool ok, uint64_t bytes)
+{
+    auto it = entries.find(id);
+
+    if (it == entries.end())
+        return;
+
+    TextureEntry& e = it->second;
+    e.queued = false;
+
+    if (!ok)
+    {
+        e.failed = true;
+        return;
+    }
+
+    if (e.resident)
+        return;
+
+    if (bytes)
+        e.bytes = bytes;
+
+    e.resident = true;
+    residentBytes += e.bytes;
+    lruPos[id] = lru.insert(lru.end(), id);
+    loads++;
+}
+
+std::vector<std::string> TextureResidency::Evict()
+{
+    std::vector<std::string> evicted;
+
+    for (auto it = lru.begin(); it != lru.end() && residentBytes > budget;)
+    {
+        TextureEntry& e = entries[*it];
+
+        if (e.pinned || e.lastUse + TEXTURE_KEEP_FRAMES > frame)
+        {
+            it++;
+            continue;
+        }
+
+        evicted.push_back(*it);
+        e.resident = false;
+        residentBytes -= e.bytes;
+        evictions++;
+
+        lruPos.erase(*it);
+        it = lru.erase(it);
+    }
+
+    return evicted;
+}
+
+std::wstring TextureResidency::Report() const
+{
+    std::vector<std::pair<uint64_t, std::string>> resident;
+
+    for (auto& id : lru)
+    {
+        resident.push_back(std::make_pair(entries.at(id).bytes, id));
+    }
+
+    std::sort(resident.rbegin(), resident.rend());
+
+    std::wostringstream s;
+    s << L"Textures: " << resident.size() << L" of " << entries.size() << L" resident, "
+      << residentBytes / 1024 << L" KB of " << budget / 1024 << L" KB budget, "
+      << loads << L" loads, " << evictions << L" evictions\n";
+
+    for (auto& r : resident)
+    {
+        const TextureEntry& e = entries.at(r.second);
+
+        s << L"  " << std::wstring(r.second.begin(), r.second.end()) << L": " << r.first / 1024 << L" KB, used in frame "
+          << e.lastUse << (e.pinned ? L", pinned" : L"") << L"\n";
+    }
+
+    return s.str();
+}
+
+bool TextureResidency::DdsBytes(const std::string& file, uint64_t& bytes)
+{
+    DdsLayout layout;
+
+    if (!ReadDdsLayout(file, layout))
+        return false;
+
+    bytes = layout.dataBytes;
+    return true;
+}
@@ -0,0 +1,110 @@
+/* TextureResidency.h
+
+decides which textures are resident. textures are registered with their
+size from the dds header, the first use of a texture that isn't resident
+queues its load and the caller draws with a placeholder until it is
+loaded. when the resident textures are over the budget the least recently
+used ones are evicted, but never pinned ones or those used in the last
+TEXTURE_KEEP_FRAMES frames, the budget is exceeded instead.
+
+only bookkeeping, the TextureCollection does the loading, so the policy
+runs without a device.
+
+    Usage:
+    TextureResidency residency(64 * 1024 * 1024);
+
+    uint64_t bytes;
+    if (TextureResidency::DdsBytes(file, bytes))
+        residency.Register("bricks", file, bytes);
+
+    if (!residency.Use("bricks"))
+        draw with the placeholder
+
+    for (auto& id : residency.TakeLoads(TEXTURE_LOADS_PER_FRAME))
+        residency.Loaded(id, load(id));
+
+    for (auto& id : residency.Evict())
+        release(id);
+
+    residency.NextFrame();
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#define TEXTURE_BUDGET_DEFAULT (256ull * 1024 * 1024)
+#define TEXTURE_KEEP_FRAMES 2
+#define TEXTURE_LOADS_PER_FRAME 4
+
+struct TextureEntry
+{
+    std::string file;
+    uint64_t bytes = 0;
+    uint64_t lastUse = 0;
+    bool resident = false;
+    bool queued = false;
+    bool failed = false;
+    bool pinned = false;
+};
+
+class TextureResidency
+{
+public:
+    TextureResidency(uint64_t budget = TEXTURE_BUDGET_DEFAULT);
+
+    void SetBudget(uint64_t bytes);
+    uint64_t Budget() const { return budget; }
+
+    /*false if the id is registered already*/
+    bool Register(const std::string& id, const std::string& file, uint64_t bytes);
+    const TextureEntry* Find(const std::string& id) const;
+
+    /*marks a use in this frame, true if resident. the first use of a texture that isn't queues its load*/
+    bool Use(const std::string& id);
+
+    /*pinned textures are loaded right away by the caller and never evicted*/
+    void Pin(const std::string& id, bool pinned = true);
+
+    /*up to max queued textures to load now, in the order of their first use*/
+    std::vector<std::string> TakeLoads(size_t max);
+
+    /*result of a load, bytes replaces the size of the header if not 0. failed textures stay on the placeholder*/
+    void Loaded(const std::string& id, bool ok, uint64_t bytes = 0);
+
+    /*textures to release to fit the budget, least recently used first. they are not resident anymore*/
+    std::vector<std::string> Evict();
+
+    void NextFrame() { frame++; }
+    uint64_t Frame() const { return frame; }
+
+    uint64_t ResidentBytes() const { return residentBytes; }
+    size_t ResidentCount() const { return lru.size(); }
+    uint64_t LoadCount() const { return loads; }
+    uint64_t EvictionCount() const { return evictions; }
+
+    /*resident textures with their bytes, largest first*/
+    std::wstring Report() const;
+
+    /*bytes of all mips, faces and slices of a dds file from its header, false if it is no dds file*/
+    static bool DdsBytes(const std::string& file, uint64_t& bytes);
+
+private:
+    std::map<std::string, TextureEntry> entries;
+
+    /*resident textures, least recently used first*/
+    std::list<std::string> lru;
+    std::map<std::string, std::list<std::string>::iterator> lruPos;
+    std::vector<std::string> queue;
+
+    uint64_t budget;
+    uint64_t residentBytes = 0;
+    uint64_t frame = 1;
+    uint64_t loads = 0;
+    uint64_t evictions = 0;
+};
@@ -0,0 +1,326 @@
+#include "TextureStreamer.h"
+#include <fstream>
+
+TextureStreamer::TextureStreamer(ID3D11Device* device) : device(device)
+{
+    worker = std::thread(&TextureStreamer::work, this);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+
+    wake.notify_all();
+    drained.notify_all();
+
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+
+    for (auto& s : streams)
+    {
+        release(s.second);
+    }
+}
+
+void TextureStreamer::Request(const std::string& id, const std::string& file)
+{
+    uint64_t serial = nextSerial++;
+
+    streams[serial].id = id;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({ serial, file });
+    }
+
+    wake.notify_one();
+}
+
+void TextureStreamer::Cancel(const std::string& id)
+{
+    for (auto it = streams.begin(); it != streams.end(); it++)
+    {
+        if (it->second.id != id)
+            continue;
+
+        uint64_t serial = it->first;
+
+        release(it->second);
+        streams.erase(it);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for (auto j = jobs.begin(); j != jobs.end(); j++)
+            {
+                if (j->serial == serial)
+                {
+                    jobs.erase(j);
+                    break;
+                }
+            }
+
+            if (working == serial)
+                abort = true;
+        }
+
+        drained.notify_all();
+        return;
+    }
+}
+
+void TextureStreamer::Update(ID3D11DeviceContext* context, std::vector<Ready>& ready, std::vector<std::string>& failed)
+{
+    size_t uploaded = 0;
+
+    while (uploaded < TEXTURE_STREAM_BYTES_PER_FRAME)
+    {
+        Chunk c;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (chunks.empty())
+                break;
+
+            c = std::move(chunks.front());
+            chunks.pop_front();
+            queuedBytes -= c.data.size();
+        }
+
+        drained.notify_all();
+
+        /*chunks of cancelled textures*/
+        auto it = streams.find(c.serial);
+
+        if (it == streams.end())
+            continue;
+
+        Stream& s = it->second;
+
+        if (c.failed || (c.mip < 0 && (s.layout = std::move(c.layout), !create(s))))
+        {
+            /*a texture with some mips stays at that quality, the others are loaded another way*/
+            if (!s.ready)
+                failed.push_back(s.id);
+
+            release(s);
+            streams.erase(it);
+            continue;
+        }
+
+        if (c.mip < 0)
+            continue;
+
+        upload(context, s, c);
+        uploaded += c.data.size();
+
+        if (!s.ready)
+        {
+            s.ready = true;
+            s.srv->AddRef();
+            ready.push_back({ s.id, s.srv, s.layout.dataBytes });
+        }
+
+        /*complete, the view of the caller keeps the texture*/
+        if (c.mip == 0)
+        {
+            release(s);
+            streams.erase(it);
+        }
+    }
+}
+
+void TextureStreamer::work()
+{
+    for (;;)
+    {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return quit || !jobs.empty(); });
+
+            if (quit)
+                return;
+
+            job = jobs.front();
+            jobs.pop_front();
+            working = job.serial;
+            abort = false;
+        }
+
+        read(job);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            working = 0;
+            abort = false;
+        }
+    }
+}
+
+void TextureStreamer::read(const Job& job)
+{
+    Chunk header;
+    header.serial = job.serial;
+    header.mip = -1;
+    header.failed = true;
+
+    std::ifstream in(job.file, std::ios::binary | std::ios::ate);
+
+    if (!in.is_open())
+    {
+        push(std::move(header));
+        return;
+    }
+
+    uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    uint8_t bytes[DDS_MAX_HEADER_BYTES];
+
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+
+    DdsLayout& layout = header.layout;
+
+    /*only 2d textures with a dxgi format are streamed*/
+    if (!ParseDds(bytes, static_cast<size_t>(in.gcount()), fileSize, layout) || layout.format == 0 ||
+        layout.volume || layout.texture1D)
+    {
+        push(std::move(header));
+        return;
+    }
+
+    header.failed = false;
+    push(Chunk(header));
+    in.clear();
+
+    for (int m = static_cast<int>(layout.mips) - 1; m >= 0; m--)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            drained.wait(lock, [&] { return quit || abort || queuedBytes < TEXTURE_STREAM_QUEUE_BYTES; });
+
+            if (quit || abort)
+                return;
+        }
+
+        Chunk c;
+        c.serial = job.serial;
+        c.mip = m;
+        c.failed = false;
+        c.data.resize(static_cast<size_t>(layout.MipBytes(m)));
+
+        size_t offset = 0;
+
+        for (uint32_t slice = 0; slice < layout.arraySize; slice++)
+        {
+            const DdsSubresource& r = layout.Subresource(m, slice);
+
+            in.seekg(static_cast<std::streamoff>(r.offset));
+            in.read(reinterpret_cast<char*>(c.data.data() + offset), static_cast<std::streamsize>(r.bytes));
+
+            if (static_cast<uint64_t>(in.gcount()) != r.bytes)
+            {
+                c.failed = true;
+                c.data.clear();
+                break;
+            }
+
+            offset += static_cast<size_t>(r.bytes);
+        }
+
+        bool failed = c.failed;
+        push(std::move(c));
+
+        if (failed)
+            return;
+    }
+}
+
+void TextureStreamer::push(Chunk&& chunk)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    queuedBytes += chunk.data.size();
+    chunks.push_back(std::move(chunk));
+}
+
+bool TextureStreamer::create(Stream& s)
+{
+    const DdsLayout& l = s.layout;
+
+    D3D11_TEXTURE2D_DESC desc;
+    desc.Width = l.width;
+    desc.Height = l.height;
+    desc.MipLevels = l.mips;
+    desc.ArraySize = l.arraySize;
+    desc.Format = static_cast<DXGI_FORMAT>(l.format);
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = l.cube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+    if (FAILED(device->CreateTexture2D(&desc, nullptr, &s.texture)))
+        return false;
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+    viewDesc.Format = desc.Format;
+
+    if (l.cube && l.arraySize > 6)
+    {
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+        viewDesc.TextureCubeArray.MipLevels = l.mips;
+        viewDesc.TextureCubeArray.NumCubes = l.arraySize / 6;
+    }
+    else if (l.cube)
+    {
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+        viewDesc.TextureCube.MipLevels = l.mips;
+    }
+    else if (l.arraySize > 1)
+    {
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        viewDesc.Texture2DArray.MipLevels = l.mips;
+        viewDesc.Texture2DArray.ArraySize = l.arraySize;
+    }
+    else
+    {
+        viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        viewDesc.Texture2D.MipLevels = l.mips;
+    }
+
+    return SUCCEEDED(device->CreateShaderResourceView(s.texture, &viewDesc, &s.srv));
+}
+
+void TextureStreamer::upload(ID3D11DeviceContext* context, Stream& s, const Chunk& c)
+{
+    const DdsLayout& l = s.layout;
+    size_t offset = 0;
+
+    for (uint32_t slice = 0; slice < l.arraySize; slice++)
+    {
+        const DdsSubresource& r = l.Subresource(c.mip, slice);
+
+        context->UpdateSubresource(s.texture, D3D11CalcSubresource(c.mip, slice, l.mips), nullptr,
+                                   c.data.data() + offset, r.rowPitch, r.slicePitch);
+
+        offset += static_cast<size_t>(r.bytes);
+    }
+
+    /*sample only the mips that are there*/
+    context->SetResourceMinLOD(s.texture, static_cast<float>(c.mip));
+}
+
+void TextureStreamer::release(Stream& s)
+{
+    DXRelease(s.srv);
+    DXRelease(s.texture);
+}
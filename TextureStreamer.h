@@ -0,0 +1,115 @@
+/* TextureStreamer.h
+
+loads dds textures without stalling the frame. a worker thread parses the
+header with ParseDds and reads the mips of a texture from the smallest to
+the largest. Update creates the texture from the header and uploads the
+mips that have been read, at most TEXTURE_STREAM_BYTES_PER_FRAME per
+frame. the min lod of the texture follows the uploaded mips, so it can be
+used as soon as its smallest mip is there and gets sharper while the rest
+arrives. the worker reads at most TEXTURE_STREAM_QUEUE_BYTES ahead of the
+uploads.
+
+files the streamer can't create a texture for, volume and 1d textures or
+pixel formats without a dxgi format, are returned as failed, they are
+loaded by the DDSTextureLoader instead.
+
+    Usage:
+    TextureStreamer streamer(device);
+    streamer.Request("bricks", "data/textures/bricks.dds");
+
+    std::vector<TextureStreamer::Ready> ready;
+    std::vector<std::string> failed;
+    streamer.Update(context, ready, failed);
+
+    streamer.Cancel("bricks");
+
+*/
+
+#pragma once
+
+#include "util.h"
+#include "DdsParser.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#define TEXTURE_STREAM_BYTES_PER_FRAME (8 * 1024 * 1024)
+#define TEXTURE_STREAM_QUEUE_BYTES (32 * 1024 * 1024)
+
+class TextureStreamer
+{
+public:
+    /*a texture whose smallest mip is uploaded, the view is referenced for the caller*/
+    struct Ready
+    {
+        std::string id;
+        ID3D11ShaderResourceView* srv;
+        uint64_t bytes;
+    };
+
+    TextureStreamer(ID3D11Device* device);
+    ~TextureStreamer();
+
+    void Request(const std::string& id, const std::string& file);
+
+    /*stops raising the mips of id, the caller releases its view*/
+    void Cancel(const std::string& id);
+
+    void Update(ID3D11DeviceContext* context, std::vector<Ready>& ready, std::vector<std::string>& failed);
+
+    /*textures requested and not complete*/
+    size_t Pending() const { return streams.size(); }
+
+private:
+    struct Job
+    {
+        uint64_t serial;
+        std::string file;
+    };
+
+    /*the header or one mip of all slices, smallest first*/
+    struct Chunk
+    {
+        uint64_t serial;
+        int mip;
+        bool failed;
+        DdsLayout layout;
+        std::vector<uint8_t> data;
+    };
+
+    struct Stream
+    {
+        std::string id;
+        ID3D11Texture2D* texture = 0;
+        ID3D11ShaderResourceView* srv = 0;
+        DdsLayout layout;
+        bool ready = false;
+    };
+
+    void work();
+    void read(const Job& job);
+    void push(Chunk&& chunk);
+
+    bool create(Stream& s);
+    void upload(ID3D11DeviceContext* context, Stream& s, const Chunk& c);
+    void release(Stream& s);
+
+    ID3D11Device* device;
+
+    /*main thread only*/
+    std::map<uint64_t, Stream> streams;
+    uint64_t nextSerial = 1;
+
+    /*shared with the worker*/
+    std::mutex mutex;
+    std::condition_variable wake, drained;
+    std::deque<Job> jobs;
+    std::deque<Chunk> chunks;
+    size_t queuedBytes = 0;
+    uint64_t working = 0;
+    bool abort = false;
+    bool quit = false;
+
+    std::thread worker;
+};
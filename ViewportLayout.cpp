@@ -0,0 +1,84 @@
+#include "ViewportLayout.h"
+#include <algorithm>
+
+void ViewportLayout::Build(int windowWidth, int windowHeight, int columns, int rows, int gutter)
+{
+    columns = std::max(columns, 1);
+    rows = std::max(rows, 1);
+    gutter = std::max(gutter, 0);
+
+    screen.resize(columns * rows);
+    slots.resize(columns * rows);
+    scales.resize(columns * rows, 1.f);
+
+    /*odd sizes give the extra pixel to the later views*/
+    for (int r = 0; r < rows; r++)
+    {
+        for (int c = 0; c < columns; c++)
+        {
+            ViewportRect& s = screen[r * columns + c];
+            s.x = c * windowWidth / columns;
+            s.y = r * windowHeight / rows;
+            s.width = (c + 1) * windowWidth / columns - s.x;
+            s.height = (r + 1) * windowHeight / rows - s.y;
+
+            ViewportRect& a = slots[r * columns + c];
+            a.x = s.x + (c + 1) * gutter;
+            a.y = s.y + (r + 1) * gutter;
+            a.width = s.width;
+            a.height = s.height;
+        }
+    }
+
+    atlasWidth = windowWidth + (columns + 1) * gutter;
+    atlasHeight = windowHeight + (rows + 1) * gutter;
+}
+
+ViewportRect ViewportLayout::Target(int view) const
+{
+    ViewportRect r = slots[view];
+
+    r.width = std::max(1, static_cast<int>(r.width * scales[view] + 0.5f));
+    r.height = std::max(1, static_cast<int>(r.height * scales[view] + 0.5f));
+
+    return r;
+}
+
+ViewportUV ViewportLayout::UV(int view) const
+{
+    ViewportRect r = Target(view);
+    const ViewportRect& s = screen[view];
+
+    /*a smaller target is magnified, move the edges in so the outermost
+      screen pixels sample the centers of the outermost texels: the center
+      of the first of s pixels lands on inset + (r - 2 inset) / 2s = 0.5*/
+    float insetX = s.width > 1 ? 0.5f * (s.width - r.width) / (s.width - 1) : 0.f;
+    float insetY = s.height > 1 ? 0.5f * (s.height - r.height) / (s.height - 1) : 0.f;
+
+    ViewportUV uv;
+    uv.u0 = (r.x + insetX) / atlasWidth;
+    uv.v0 = (r.y + insetY) / atlasHeight;
+    uv.u1 = (r.x + r.width - insetX) / atlasWidth;
+    uv.v1 = (r.y + r.height - insetY) / atlasHeight;
+
+    return uv;
+}
+
+ViewportRect ViewportLayout::Used() const
+{
+    ViewportRect used;
+
+    for (int i = 0; i < Views(); i++)
+    {
+        ViewportRect r = Target(i);
+        used.width = std::max(used.width, r.x + r.width);
+        used.height = std::max(used.height, r.y + r.height);
+    }
+
+    return used;
+}
+
+void ViewportLayout::SetScale(int view, float s)
+{
+    scales[view] = std::clamp(s, VIEWPORT_MIN_SCALE, 1.f);
+}
@@ -0,0 +1,82 @@
+/* ViewportLayout.h
+
+places the split screen views in one shared atlas render target. every
+view gets a slot of the size of its part of the window, the slots are
+separated by a gutter so filters over the atlas don't bleed between views.
+the views are rendered to the top left part of their slot, scaled by the
+dynamic resolution scale, and stretched over their part of the window when
+the atlas is composed to the back buffer.
+
+every view has its own scale, picked by the FrameTimeGovernor. the atlas
+is sized for scale 1, so a new scale never reallocates it.
+
+only depends on the standard library.
+
+    Usage:
+    layout.Build(wndWidth, wndHeight, 2, 2);
+    CreateAtlas(layout.AtlasWidth(), layout.AtlasHeight());
+
+    layout.SetScale(view, governor.Scale(view));
+
+    RenderView(view, layout.Target(view));
+    DrawQuad(layout.Screen(view), layout.UV(view));
+
+*/
+
+#pragma once
+
+#include <vector>
+
+#define VIEWPORT_GUTTER 8
+#define VIEWPORT_MIN_SCALE 0.25f
+
+struct ViewportRect
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+struct ViewportUV
+{
+    float u0, v0, u1, v1;
+};
+
+class ViewportLayout
+{
+public:
+    /*columns x rows views covering the window, row by row*/
+    void Build(int windowWidth, int windowHeight, int columns, int rows, int gutter = VIEWPORT_GUTTER);
+
+    int Views() const { return static_cast<int>(screen.size()); }
+    int AtlasWidth() const { return atlasWidth; }
+    int AtlasHeight() const { return atlasHeight; }
+
+    /*part of the window a view covers*/
+    const ViewportRect& Screen(int view) const { return screen[view]; }
+
+    /*part of the atlas a view is rendered to at the current scale*/
+    ViewportRect Target(int view) const;
+
+    /*texture coordinates of the target, the edge texels are not filtered with the gutter*/
+    ViewportUV UV(int view) const;
+
+    /*top left part of the atlas covering all targets*/
+    ViewportRect Used() const;
+
+    /*clamped to VIEWPORT_MIN_SCALE - 1*/
+    void SetScale(int view, float s);
+    float Scale(int view) const { return scales[view]; }
+
+private:
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+
+    std::vector<ViewportRect> screen;
+
+    /*full scale area of every view in the atlas*/
+    std::vector<ViewportRect> slots;
+
+    std::vector<float> scales;
+};
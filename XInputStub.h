@@ -0,0 +1,171 @@
+/* XInputStub.h
+
+stand in for XInput.h outside of windows, used by ControllerInput.h when
+_WIN32 is not defined. the four slots are driven through the XInputStub
+namespace, every call is counted and queries of empty slots can be made
+as slow as on real hardware. capability and battery queries made on
+pollThread are counted apart, they would block the game loop.
+
+    Usage:
+    XInputStub::connected[1] = true;
+    XInputStub::state[1].Gamepad.wButtons = XINPUT_GAMEPAD_A;
+    XInputStub::disconnectedDelayUs = 500;
+    ...
+    controllers->Update(deltaTime);
+    unsigned int calls = XInputStub::getStateCalls;
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+typedef uint32_t DWORD;
+typedef uint16_t WORD;
+typedef uint8_t BYTE;
+typedef int16_t SHORT;
+typedef int BOOL;
+
+#define ERROR_SUCCESS 0L
+#define ERROR_DEVICE_NOT_CONNECTED 1167L
+
+#define XUSER_MAX_COUNT 4
+
+#define XINPUT_GAMEPAD_DPAD_UP 0x0001
+#define XINPUT_GAMEPAD_DPAD_DOWN 0x0002
+#define XINPUT_GAMEPAD_DPAD_LEFT 0x0004
+#define XINPUT_GAMEPAD_DPAD_RIGHT 0x0008
+#define XINPUT_GAMEPAD_START 0x0010
+#define XINPUT_GAMEPAD_BACK 0x0020
+#define XINPUT_GAMEPAD_LEFT_THUMB 0x0040
+#define XINPUT_GAMEPAD_RIGHT_THUMB 0x0080
+#define XINPUT_GAMEPAD_LEFT_SHOULDER 0x0100
+#define XINPUT_GAMEPAD_RIGHT_SHOULDER 0x0200
+#define XINPUT_GAMEPAD_A 0x1000
+#define XINPUT_GAMEPAD_B 0x2000
+#define XINPUT_GAMEPAD_X 0x4000
+#define XINPUT_GAMEPAD_Y 0x8000
+
+#define XINPUT_FLAG_GAMEPAD 0x00000001
+#define XINPUT_CAPS_WIRELESS 0x0002
+
+#define BATTERY_DEVTYPE_GAMEPAD 0x00
+#define BATTERY_LEVEL_EMPTY 0x00
+#define BATTERY_LEVEL_LOW 0x01
+#define BATTERY_LEVEL_MEDIUM 0x02
+#define BATTERY_LEVEL_FULL 0x03
+
+struct XINPUT_GAMEPAD
+{
+    WORD wButtons;
+    BYTE bLeftTrigger;
+    BYTE bRightTrigger;
+    SHORT sThumbLX;
+    SHORT sThumbLY;
+    SHORT sThumbRX;
+    SHORT sThumbRY;
+};
+
+struct XINPUT_STATE
+{
+    DWORD dwPacketNumber;
+    XINPUT_GAMEPAD Gamepad;
+};
+
+struct XINPUT_VIBRATION
+{
+    WORD wLeftMotorSpeed;
+    WORD wRightMotorSpeed;
+};
+
+struct XINPUT_CAPABILITIES
+{
+    BYTE Type;
+    BYTE SubType;
+    WORD Flags;
+    XINPUT_GAMEPAD Gamepad;
+    XINPUT_VIBRATION Vibration;
+};
+
+struct XINPUT_BATTERY_INFORMATION
+{
+    BYTE BatteryType;
+    BYTE BatteryLevel;
+};
+
+namespace XInputStub
+{
+    inline bool connected[XUSER_MAX_COUNT];
+    inline bool wireless[XUSER_MAX_COUNT];
+    inline XINPUT_STATE state[XUSER_MAX_COUNT];
+    inline BYTE batteryLevel[XUSER_MAX_COUNT];
+
+    /*simulated cost of querying an empty slot*/
+    inline std::atomic<int> disconnectedDelayUs{ 0 };
+
+    inline std::atomic<unsigned int> getStateCalls{ 0 };
+    inline std::atomic<unsigned int> slotStateCalls[XUSER_MAX_COUNT];
+    inline std::atomic<unsigned int> disconnectedCalls{ 0 };
+    inline std::atomic<unsigned int> capabilitiesCalls{ 0 };
+    inline std::atomic<unsigned int> batteryCalls{ 0 };
+
+    /*the thread that calls XInputGetState*/
+    inline std::atomic<std::thread::id> pollThread;
+    inline std::atomic<unsigned int> statusCallsOnPollThread{ 0 };
+}
+
+inline DWORD XInputGetState(DWORD index, XINPUT_STATE* state)
+{
+    XInputStub::getStateCalls++;
+
+    if (index < XUSER_MAX_COUNT)
+        XInputStub::slotStateCalls[index]++;
+
+    if (index >= XUSER_MAX_COUNT || !XInputStub::connected[index])
+    {
+        XInputStub::disconnectedCalls++;
+        std::this_thread::sleep_for(std::chrono::microseconds(XInputStub::disconnectedDelayUs.load()));
+        return ERROR_DEVICE_NOT_CONNECTED;
+    }
+
+    *state = XInputStub::state[index];
+    return ERROR_SUCCESS;
+}
+
+inline DWORD XInputGetCapabilities(DWORD index, DWORD /*flags*/, XINPUT_CAPABILITIES* capabilities)
+{
+    XInputStub::capabilitiesCalls++;
+
+    if (std::this_thread::get_id() == XInputStub::pollThread.load())
+        XInputStub::statusCallsOnPollThread++;
+
+    if (index >= XUSER_MAX_COUNT || !XInputStub::connected[index])
+        return ERROR_DEVICE_NOT_CONNECTED;
+
+    *capabilities = XINPUT_CAPABILITIES();
+    capabilities->Type = 1;
+    capabilities->Flags = XInputStub::wireless[index] ? XINPUT_CAPS_WIRELESS : 0;
+    return ERROR_SUCCESS;
+}
+
+inline DWORD XInputGetBatteryInformation(DWORD index, BYTE /*devType*/, XINPUT_BATTERY_INFORMATION* battery)
+{
+    XInputStub::batteryCalls++;
+
+    if (std::this_thread::get_id() == XInputStub::pollThread.load())
+        XInputStub::statusCallsOnPollThread++;
+
+    if (index >= XUSER_MAX_COUNT || !XInputStub::connected[index])
+        return ERROR_DEVICE_NOT_CONNECTED;
+
+    battery->BatteryType = 2;
+    battery->BatteryLevel = XInputStub::batteryLevel[index];
+    return ERROR_SUCCESS;
+}
+
+inline void XInputEnable(BOOL /*enable*/)
+{
+}
@@ -1,12 +1,21 @@
 #pragma once
 
 
+/*allocator.h*/
+#define LINEAR_BLOCK_SIZE 65536
+#define POOL_CHUNK_SIZE 32
+
+#ifdef _DEBUG
+#define TRACK_ALLOCATIONS
+#endif
+
 /*camera.h*/
 #define CAMERA_RESTRICTION_ANGLE 10.f
 
 /*directxbase.h*/
 #define MODEL_PATH "data/models"
 #define TEXTURE_PATH "data/textures"
+#define TEXTURE_ATLAS_PATH "data/textures/atlas"
 #define SOUND_PATH_MUSIC "data/sound/mu"
 #define SOUND_PATH_EFFECTS "data/sound/fx"
 #define BITMAP_PATH "data/sprites"
@@ -22,8 +31,11 @@
 
 #define PAUSE_FADE_TIME 0.2f
 #define TRANSITION_TIME 0.9f
+/*blur of the screen behind the menu, in texels, about the old fixed kernel of blur.fx*/
+#define BLUR_SCREEN_SIGMA 2.6f
 #define POST_PROCESS
 #define END_TIME_V 9.f
+#define SPLITSCREEN_VIEWS 4
 
 /*ball.h*/
 #define BALL_BORDER (PLAYER_DISTANCE + 3)
@@ -35,16 +47,32 @@
 /*level.h*/
 #define LEVEL_PATH "data/levels/"
 
+/*model.h*/
+#define LOD_MAX_ERROR 0.02f
+#define LOD_MIN_TRIANGLES 1024
+#define CLUSTER_MAX_VERTICES 64
+#define CLUSTER_MAX_TRIANGLES 124
+#define CLUSTER_MIN_TRIANGLES 4096
+
+/*tangentspace.h*/
+#define TANGENT_LENGTH_EPSILON 0.01f
+#define TANGENT_ORTHO_EPSILON 0.1f
+
 /*modelcollection.h*/
 #define DEFAULT_NONE "!none!"
+#define ATLAS_UV_EPSILON 0.001f
 
 /*modelinstancestatic.h*/
 #define DEFAULT_PLANE "defaultPlane"
 #define DEFAULT_SPHERE "defaultSphere"
 #define DEFAULT_CUBE "defaultCube"
+#define TEXTURE_TILE_SIZE 4.f
+#define PRIMITIVE_TILING_STEP 0.25f
 
 /*playablechar.h*/
 #define PLAYER_HEIGHT 1.01f
+#define CAMERA_DIST_UP 6.0f
+#define CAMERA_DIST_BACK 40.0f
 
 /*player.h*/
 #ifdef _DEBUG
@@ -54,6 +82,12 @@
 #endif
 #define HP_LIMIT 6
 
+/*goldenscene.h*/
+#define GOLDEN_WIDTH 1920
+#define GOLDEN_HEIGHT 1080
+#define GOLDEN_TOLERANCE 2
+#define GOLDEN_MAX_DIFFERENT 0.001f
+
 /*shadowmap.h*/
 #define SHADOW_HIGH 4096
 
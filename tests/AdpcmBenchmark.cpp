@@ -0,0 +1,37 @@
+/*the adpcm part of the -benchmark report of the game: compression and
+  decode throughput of every sound effect.
+
+    AdpcmBenchmark [directory of wav files]
+
+  without an argument the effects of the game in data/sound/fx*/
+
+#include "AdpcmCodec.h"
+#include "WavReader.h"
+#include <cstdio>
+#include <filesystem>
+
+int main(int argc, char** argv)
+{
+    std::string directory = argc > 1 ? argv[1] : REPO_DIR "/data/sound/fx";
+
+    for (auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        WavData wav;
+
+        if (entry.path().extension() != ".wav" || !ReadWav(entry.path().string(), wav))
+            continue;
+
+        std::vector<uint8_t> blocks;
+
+        if (!AdpcmCodec::Encode(wav.samples.data(), wav.Frames(), wav.channels, blocks))
+            continue;
+
+        AdpcmBenchmark b = AdpcmCodec::Benchmark(blocks, wav.channels, wav.Frames(), wav.sampleRate);
+
+        printf("%s: %zu KB pcm -> %zu KB adpcm (%gx), %g M frames/s, %g%% of a core per voice\n",
+               entry.path().stem().string().c_str(), b.pcmBytes / 1024, b.compressedBytes / 1024,
+               static_cast<double>(b.pcmBytes) / b.compressedBytes, b.framesPerSecond / 1000000.0, b.voiceLoad * 100.0);
+    }
+
+    return 0;
+}
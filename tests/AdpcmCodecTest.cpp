@@ -0,0 +1,204 @@
+/*encodes and decodes tones, noise and the sound effects of the game: the
+  error stays within a bound relative to the signal, block starts and
+  silence are exact, channels don't leak into each other and channel counts
+  the codec has no room for are rejected*/
+
+#include "AdpcmCodec.h"
+#include "WavReader.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <random>
+
+#define TEST_EFFECTS REPO_DIR "/data/sound/fx"
+#define TEST_SETTLE_FRAMES 32
+
+struct RoundTrip
+{
+    /*signal to noise ratio in db and the largest error of one sample in full scale, once the
+      step that starts at its smallest caught up with the signal after TEST_SETTLE_FRAMES*/
+    double snr = 0.0;
+    double maxError = 0.0;
+    size_t bytes = 0;
+    size_t exactStarts = 0;
+};
+
+static RoundTrip roundTrip(const std::vector<int16_t>& pcm, int channels, std::vector<float>* decoded = nullptr)
+{
+    RoundTrip r;
+    size_t frames = pcm.size() / channels;
+
+    std::vector<uint8_t> blocks;
+    CHECK(AdpcmCodec::Encode(pcm.data(), frames, channels, blocks));
+    CHECK(blocks.size() == AdpcmCodec::BlockCount(frames) * AdpcmCodec::BlockBytes(channels));
+    r.bytes = blocks.size();
+
+    std::vector<float> out(frames * channels);
+    std::vector<float> first(channels);
+
+    for (size_t b = 0; b < AdpcmCodec::BlockCount(frames); b++)
+    {
+        size_t start = b * ADPCM_BLOCK_FRAMES;
+        size_t count = (std::min)((size_t)ADPCM_BLOCK_FRAMES, frames - start);
+        const uint8_t* block = &blocks[b * AdpcmCodec::BlockBytes(channels)];
+
+        CHECK(AdpcmCodec::DecodeBlock(block, channels, count, &out[start * channels]));
+        AdpcmCodec::FirstFrame(block, channels, first.data());
+
+        bool exact = true;
+
+        for (int c = 0; c < channels; c++)
+        {
+            exact = exact && first[c] == out[start * channels + c] && first[c] == pcm[start * channels + c] / 32768.f;
+        }
+
+        r.exactStarts += exact;
+    }
+
+    double signal = 0.0, noise = 0.0;
+
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        double s = pcm[i] / 32768.0;
+        double e = out[i] - s;
+
+        signal += s * s;
+        noise += e * e;
+
+        if (i >= (size_t)TEST_SETTLE_FRAMES * channels)
+            r.maxError = (std::max)(r.maxError, std::fabs(e));
+    }
+
+    r.snr = noise > 0.0 ? 10.0 * std::log10(signal / noise) : 1000.0;
+
+    if (decoded)
+        decoded->swap(out);
+
+    return r;
+}
+
+static std::vector<int16_t> tone(size_t frames, int channels, double frequency, double amplitude, int sampleRate)
+{
+    std::vector<int16_t> pcm(frames * channels);
+
+    for (size_t i = 0; i < frames; i++)
+    {
+        for (int c = 0; c < channels; c++)
+        {
+            /*the right channel an octave higher*/
+            double w = 2.0 * 3.14159265358979 * frequency * (c + 1) * i / sampleRate;
+            pcm[i * channels + c] = static_cast<int16_t>(std::lround(amplitude * 32767.0 * std::sin(w)));
+        }
+    }
+
+    return pcm;
+}
+
+static void TestTones()
+{
+    /*a partial last block and both channel counts*/
+    const size_t frames = ADPCM_BLOCK_FRAMES * 10 + 321;
+
+    for (int channels = 1; channels <= ADPCM_MAX_CHANNELS; channels++)
+    {
+        RoundTrip r = roundTrip(tone(frames, channels, 440.0, 0.5, 44100), channels);
+
+        printf("tone %d: %.1f db, max error %.4f\n", channels, r.snr, r.maxError);
+        CHECK(r.snr > 30.0);
+        CHECK(r.maxError < 0.02);
+        CHECK(r.exactStarts == AdpcmCodec::BlockCount(frames));
+
+        /*4 bits per sample plus the block headers and the padding of the last block*/
+        double ratio = static_cast<double>(frames * channels * sizeof(int16_t)) / r.bytes;
+        CHECK(ratio > 3.5 && ratio < 4.0);
+    }
+
+    /*white noise at full scale is the worst case for the step adaption, it still follows*/
+    std::mt19937 rng(7);
+    std::vector<int16_t> noise(ADPCM_BLOCK_FRAMES * 4);
+
+    for (int16_t& s : noise)
+    {
+        s = static_cast<int16_t>(static_cast<int>(rng() % 65536) - 32768);
+    }
+
+    RoundTrip r = roundTrip(noise, 1);
+    CHECK(r.snr > 5.0);
+}
+
+static void TestSilence()
+{
+    /*left a tone, right silent: the right channel decodes to exact zeros*/
+    std::vector<int16_t> pcm = tone(ADPCM_BLOCK_FRAMES * 3, 2, 1000.0, 0.9, 48000);
+
+    for (size_t i = 1; i < pcm.size(); i += 2)
+    {
+        pcm[i] = 0;
+    }
+
+    std::vector<float> out;
+    roundTrip(pcm, 2, &out);
+
+    bool silent = true;
+
+    for (size_t i = 1; i < out.size(); i += 2)
+    {
+        silent = silent && out[i] == 0.f;
+    }
+
+    CHECK(silent);
+}
+
+static void TestEffects()
+{
+    int files = 0;
+
+    for (auto& entry : std::filesystem::directory_iterator(TEST_EFFECTS))
+    {
+        WavData wav;
+
+        if (entry.path().extension() != ".wav" || !ReadWav(entry.path().string(), wav))
+            continue;
+
+        RoundTrip r = roundTrip(wav.samples, wav.channels);
+        printf("%s: %.1f db, max error %.4f\n", entry.path().filename().string().c_str(), r.snr, r.maxError);
+
+        /*the 11khz effects have most of their energy near nyquist, where 4 bits do worst*/
+        CHECK(r.snr > 15.0);
+        CHECK(r.maxError < 0.35);
+        CHECK(r.exactStarts == AdpcmCodec::BlockCount(wav.Frames()));
+        files++;
+    }
+
+    CHECK(files > 0);
+}
+
+static void TestChannels()
+{
+    std::vector<int16_t> pcm(ADPCM_BLOCK_FRAMES * 3);
+    std::vector<uint8_t> blocks(5, 0xab);
+
+    CHECK(!AdpcmCodec::Encode(pcm.data(), ADPCM_BLOCK_FRAMES, 0, blocks));
+    CHECK(!AdpcmCodec::Encode(pcm.data(), ADPCM_BLOCK_FRAMES, 3, blocks));
+    CHECK(blocks.size() == 5);
+
+    /*blocks are appended*/
+    CHECK(AdpcmCodec::Encode(pcm.data(), ADPCM_BLOCK_FRAMES, 1, blocks));
+    CHECK(blocks.size() == 5 + AdpcmCodec::BlockBytes(1) && blocks[4] == 0xab);
+
+    std::vector<float> out(ADPCM_BLOCK_FRAMES * 3, 2.f);
+    CHECK(!AdpcmCodec::DecodeBlock(&blocks[5], 3, ADPCM_BLOCK_FRAMES, out.data()));
+    CHECK(!AdpcmCodec::DecodeBlock(&blocks[5], 1, ADPCM_BLOCK_FRAMES + 1, out.data()));
+    CHECK(out[0] == 2.f);
+}
+
+int main()
+{
+    TestTones();
+    TestSilence();
+    TestEffects();
+    TestChannels();
+
+    return Result();
+}
@@ -0,0 +1,21 @@
+/*the audio mixer part of the -benchmark report of the game: how many resampled
+  voices the mixer mixes per block within the budget.
+
+    AudioMixerBenchmark [budget ms]
+
+  without an argument the budget is MIXER_BENCHMARK_BUDGET*/
+
+#include "AudioMixer.h"
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+    double budget = argc > 1 ? atof(argv[1]) : MIXER_BENCHMARK_BUDGET;
+
+    MixerBenchmark mix = AudioMixer::Benchmark(budget);
+    printf("Audio mixer: %zu voices in %g ms per %d frame block (budget %g ms)\n",
+           mix.voices, mix.msPerBlock, MIXER_BLOCK_FRAMES, budget);
+
+    return 0;
+}
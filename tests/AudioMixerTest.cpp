@@ -0,0 +1,379 @@
+/*mixes known clips and checks the output sample by sample: gain, pan and
+  pitch, voices that start on their frame, ids that stay invalid after their
+  slot is taken by another sound and the limiter ceiling. a mix written by
+  the output thread into a wav file has to read back as the same mix*/
+
+#include "AudioMixer.h"
+#include "AudioSink.h"
+#include "Check.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+/*one 16 bit step of the wav file*/
+#define TEST_PCM_EPSILON (1.0 / 32767.0 + 1e-6)
+
+static AudioClip constant(float value, size_t frames, int channels = 1)
+{
+    AudioClip clip;
+    clip.channels = channels;
+    clip.samples.assign(frames * channels, value);
+    return clip;
+}
+
+/*rises 1e-5 per frame, the value tells which frame of the clip was played*/
+static AudioClip ramp(size_t frames, int sampleRate = MIXER_SAMPLE_RATE)
+{
+    AudioClip clip;
+    clip.sampleRate = sampleRate;
+    clip.samples.resize(frames);
+
+    for (size_t i = 0; i < frames; i++)
+    {
+        clip.samples[i] = i * 1e-5f;
+    }
+
+    return clip;
+}
+
+static VoiceParams left(float gain = 1.f)
+{
+    VoiceParams p;
+    p.gain = gain;
+    p.pan = -1.f;
+    return p;
+}
+
+static std::vector<float> mix(AudioMixer& mixer, size_t frames)
+{
+    std::vector<float> out(frames * 2);
+    mixer.Mix(out.data(), frames);
+    return out;
+}
+
+static void TestFromPCM()
+{
+    /*24 bit samples with the top bit set are negative*/
+    const unsigned char pcm24[] = { 0x00, 0x00, 0x80, 0xff, 0xff, 0x7f, 0x00, 0x00, 0xc0 };
+
+    AudioClip clip;
+    CHECK(AudioClip::FromPCM(pcm24, sizeof(pcm24), 1, 44100, 24, false, clip));
+    CHECK(clip.Frames() == 3);
+    CHECK_NEAR(clip.samples[0], -1.0, 1e-6);
+    CHECK_NEAR(clip.samples[1], 1.0, 1e-6);
+    CHECK_NEAR(clip.samples[2], -0.5, 1e-6);
+
+    const unsigned char pcm8[] = { 0, 128, 192 };
+    CHECK(AudioClip::FromPCM(pcm8, sizeof(pcm8), 1, 22050, 8, false, clip));
+    CHECK_NEAR(clip.samples[0], -1.0, 1e-6);
+    CHECK_NEAR(clip.samples[2], 0.5, 1e-6);
+
+    CHECK(!AudioClip::FromPCM(pcm8, sizeof(pcm8), 3, 22050, 8, false, clip));
+    CHECK(!AudioClip::FromPCM(pcm8, sizeof(pcm8), 1, 22050, 16, true, clip));
+}
+
+static void TestGainPanPitch()
+{
+    AudioClip half = constant(0.5f, 4800);
+
+    /*hard left and right take the whole voice, the center splits it with equal power*/
+    const float pans[] = { -1.f, 0.f, 1.f };
+
+    for (float pan : pans)
+    {
+        AudioMixer mixer;
+
+        VoiceParams p;
+        p.gain = 0.5f;
+        p.pan = pan;
+        mixer.Play(&half, p);
+
+        std::vector<float> out = mix(mixer, 100);
+        float angle = (pan + 1.f) * 0.785398163f;
+
+        CHECK_NEAR(out[50 * 2], 0.25 * std::cos(angle), 1e-6);
+        CHECK_NEAR(out[50 * 2 + 1], 0.25 * std::sin(angle), 1e-6);
+    }
+
+    /*stereo clips keep full gain at the center*/
+    {
+        AudioClip stereo = constant(0.5f, 4800, 2);
+        AudioMixer mixer;
+        mixer.Play(&stereo, VoiceParams());
+
+        std::vector<float> out = mix(mixer, 100);
+        CHECK_NEAR(out[10 * 2], 0.5, 1e-6);
+        CHECK_NEAR(out[10 * 2 + 1], 0.5, 1e-6);
+    }
+
+    /*frame i of the mix plays frame i * step of the clip*/
+    AudioClip r = ramp(48000);
+    const float pitches[] = { 1.f, 2.f, 0.5f, 0.75f };
+
+    for (float pitch : pitches)
+    {
+        AudioMixer mixer;
+
+        VoiceParams p = left();
+        p.pitch = pitch;
+        unsigned int voice = mixer.Play(&r, p);
+
+        std::vector<float> out = mix(mixer, 1000);
+
+        for (size_t i = 0; i < 1000; i += 37)
+        {
+            CHECK_NEAR(out[i * 2], i * pitch * 1e-5, 1e-6);
+        }
+
+        CHECK_NEAR(mixer.Position(voice), 1000.0 * pitch, 1e-6);
+    }
+
+    /*a clip at half the rate of the mixer plays every frame twice as long*/
+    {
+        AudioClip slow = ramp(24000, MIXER_SAMPLE_RATE / 2);
+        AudioMixer mixer;
+        mixer.Play(&slow, left());
+
+        std::vector<float> out = mix(mixer, 1000);
+        CHECK_NEAR(out[501 * 2], 250.5 * 1e-5, 1e-6);
+    }
+
+    /*changes apply to the next block*/
+    {
+        AudioMixer mixer;
+        unsigned int voice = mixer.Play(&half, left());
+
+        mix(mixer, 100);
+        mixer.SetGain(voice, 0.2f);
+        mixer.SetPan(voice, 5.f);
+        std::vector<float> out = mix(mixer, 100);
+
+        CHECK_NEAR(out[0], 0.0, 1e-6);
+        CHECK_NEAR(out[1], 0.1, 1e-6);
+    }
+}
+
+static void TestStartFrame()
+{
+    AudioClip half = constant(0.5f, 4800);
+    AudioMixer mixer;
+
+    /*inside the third block of the mix*/
+    const uint64_t start = MIXER_BLOCK_FRAMES * 2 + 123;
+    unsigned int voice = mixer.Play(&half, left(), start);
+
+    CHECK(mixer.IsPlaying(voice));
+
+    std::vector<float> out = mix(mixer, MIXER_BLOCK_FRAMES * 2);
+    CHECK_NEAR(mixer.Position(voice), 0.0, 0.0);
+
+    std::vector<float> next = mix(mixer, MIXER_BLOCK_FRAMES * 2);
+    out.insert(out.end(), next.begin(), next.end());
+
+    for (size_t i = 0; i < out.size() / 2; i++)
+    {
+        if (out[i * 2] != (i < start ? 0.f : 0.5f))
+        {
+            CHECK(out[i * 2] == (i < start ? 0.f : 0.5f));
+            printf("frame %zu\n", i);
+            break;
+        }
+    }
+
+    CHECK(mixer.Cursor() == MIXER_BLOCK_FRAMES * 4);
+
+    /*a start frame in the past plays at once*/
+    AudioMixer late;
+    mix(late, 1000);
+    late.Play(&half, left(), 10);
+    out = mix(late, 10);
+    CHECK(out[0] == 0.5f);
+}
+
+static void TestVoiceIds()
+{
+    AudioClip half = constant(0.5f, 4800);
+    AudioMixer mixer(MIXER_SAMPLE_RATE, 2);
+
+    unsigned int a = mixer.Play(&half, left());
+    unsigned int b = mixer.Play(&half, left());
+    CHECK(a != 0 && b != 0 && a != b);
+    CHECK(mixer.Play(&half, left()) == 0);
+    CHECK(mixer.ActiveVoices() == 2);
+
+    /*the sound engine steals a channel by stopping its voice and playing into the free slot*/
+    mixer.Stop(a);
+    unsigned int c = mixer.Play(&half, left(0.5f));
+
+    CHECK(c != 0 && c != a);
+    CHECK((c & 0xFFFF) == (a & 0xFFFF));
+    CHECK(!mixer.IsPlaying(a) && mixer.IsPlaying(c));
+
+    /*the old id reaches nothing*/
+    mixer.SetGain(a, 0.f);
+    mixer.Stop(a);
+    CHECK(mixer.IsPlaying(c));
+    CHECK(mixer.ActiveVoices() == 2);
+
+    std::vector<float> out = mix(mixer, 10);
+    CHECK_NEAR(out[0], 0.75, 1e-6);
+
+    /*a voice that ends frees its slot and its id*/
+    AudioClip shortClip = constant(0.5f, 100);
+    AudioMixer ending(MIXER_SAMPLE_RATE, 1);
+    unsigned int d = ending.Play(&shortClip, left());
+    mix(ending, 200);
+
+    CHECK(!ending.IsPlaying(d));
+    unsigned int e = ending.Play(&shortClip, left());
+    CHECK(e != 0 && e != d);
+}
+
+static void TestLimiter()
+{
+    AudioClip loud = constant(0.9f, 48000);
+    AudioClip quiet = constant(0.3f, 48000);
+
+    AudioMixer mixer;
+    mixer.SetMasterGain(2.f);
+
+    unsigned int voices[4];
+
+    for (unsigned int& v : voices)
+    {
+        v = mixer.Play(&loud, left());
+    }
+
+    std::vector<float> out = mix(mixer, 4800);
+    float peak = 0.f;
+
+    for (float s : out)
+    {
+        peak = std::max(peak, std::fabs(s));
+    }
+
+    /*attack is instant, not one sample goes over the ceiling*/
+    CHECK(peak <= MIXER_LIMITER_THRESHOLD + 1e-6f);
+    CHECK_NEAR(peak, MIXER_LIMITER_THRESHOLD, 1e-6);
+
+    for (unsigned int v : voices)
+    {
+        mixer.Stop(v);
+    }
+
+    /*the gain recovers within a few release times, a quiet voice then plays at full master gain*/
+    mixer.Play(&quiet, left());
+    mix(mixer, static_cast<size_t>(MIXER_SAMPLE_RATE * MIXER_LIMITER_RELEASE * 10));
+    out = mix(mixer, 10);
+    CHECK_NEAR(out[0], 0.6, 1e-4);
+}
+
+/*the output thread writes whole blocks, the file has to hold exactly what an offline mix of the same frames gives*/
+static void TestSinks()
+{
+    AudioClip r = ramp(48000);
+    AudioClip half = constant(0.5f, 4800, 2);
+
+    auto start = [&](AudioMixer& mixer)
+    {
+        VoiceParams p;
+        p.pitch = 0.75f;
+        p.pan = 0.25f;
+        p.loop = true;
+        mixer.Play(&r, p);
+        mixer.Play(&half, VoiceParams(), 1000);
+    };
+
+    {
+        AudioMixer mixer;
+        NullSink sink(mixer.SampleRate());
+
+        start(mixer);
+        mixer.StartOutput(&sink);
+
+        while (mixer.Cursor() < MIXER_SAMPLE_RATE)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        mixer.StopOutput();
+
+        CHECK(sink.FramesSubmitted() == mixer.Cursor());
+        CHECK(sink.FramesSubmitted() % MIXER_BLOCK_FRAMES == 0);
+    }
+
+    std::filesystem::path file = std::filesystem::temp_directory_path() / "AudioMixerTest.wav";
+    uint64_t frames = 0;
+
+    {
+        AudioMixer mixer;
+        WavFileSink sink(file.string(), mixer.SampleRate());
+
+        start(mixer);
+        mixer.StartOutput(&sink);
+
+        while (mixer.Cursor() < MIXER_SAMPLE_RATE / 2)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        mixer.StopOutput();
+        frames = mixer.Cursor();
+    }
+
+    std::ifstream in(file, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    CHECK(bytes.size() == 44 + frames * 4);
+
+    if (bytes.size() != 44 + frames * 4)
+        return;
+
+    uint32_t riff, rate, data;
+    uint16_t channels, bits;
+    memcpy(&riff, &bytes[4], 4);
+    memcpy(&channels, &bytes[22], 2);
+    memcpy(&rate, &bytes[24], 4);
+    memcpy(&bits, &bytes[34], 2);
+    memcpy(&data, &bytes[40], 4);
+
+    CHECK(memcmp(&bytes[0], "RIFF", 4) == 0 && memcmp(&bytes[8], "WAVE", 4) == 0);
+    CHECK(riff == bytes.size() - 8 && data == frames * 4);
+    CHECK(channels == 2 && bits == 16 && rate == MIXER_SAMPLE_RATE);
+
+    AudioMixer offline;
+    start(offline);
+    std::vector<float> expected = mix(offline, static_cast<size_t>(frames));
+
+    size_t different = 0;
+
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        int16_t s;
+        memcpy(&s, &bytes[44 + i * 2], 2);
+
+        if (std::fabs(s / 32767.0 - expected[i]) > TEST_PCM_EPSILON)
+            different++;
+    }
+
+    CHECK(different == 0);
+
+    in.close();
+    std::filesystem::remove(file);
+}
+
+int main()
+{
+    TestFromPCM();
+    TestGainPanPitch();
+    TestStartFrame();
+    TestVoiceIds();
+    TestLimiter();
+    TestSinks();
+
+    return Result();
+}
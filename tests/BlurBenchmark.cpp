@@ -0,0 +1,20 @@
+/*the cpu blur part of the -benchmark report of the game: cost of the taps,
+  the folded linear taps and the mip chain against sigma.
+
+    BlurBenchmark [width height]
+
+  without arguments a 1280 x 720 image like the game*/
+
+#include "BlurKernel.h"
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    int width = argc > 2 ? atoi(argv[1]) : 1280;
+    int height = argc > 2 ? atoi(argv[2]) : 720;
+
+    std::wcout << CpuBlur::Report(CpuBlur::Benchmark(width, height, { 1.f, 2.f, 4.f, 8.f, 16.f, 32.f }));
+
+    return 0;
+}
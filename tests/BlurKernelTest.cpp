@@ -0,0 +1,280 @@
+/*checks the gaussian kernels and the cpu blur that the gpu blur is compared
+  with: weights sum to 1 and are symmetric, folded linear taps blur like
+  the taps they come from, the simd passes match a plain scalar blur with
+  clamped edges and the mip chain stays close to the full blur*/
+
+#include "BlurKernel.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+/*odd sizes, so rows end in the scalar tail of every instruction set*/
+#define TEST_WIDTH 67
+#define TEST_HEIGHT 41
+
+static BlurImage noise(int width, int height, unsigned int seed)
+{
+    BlurImage image;
+    image.Resize(width, height);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> value(0.f, 1.f);
+
+    for (float& v : image.rgba)
+    {
+        v = value(rng);
+    }
+
+    return image;
+}
+
+/*soft shapes and a hard edge, the content a menu screen has*/
+static BlurImage picture(int width, int height)
+{
+    BlurImage image;
+    image.Resize(width, height);
+
+    for (int y = 0; y < height; y++)
+    {
+        float* row = image.Row(y);
+
+        for (int x = 0; x < width; x++)
+        {
+            float u = static_cast<float>(x) / width, v = static_cast<float>(y) / height;
+
+            row[x * 4 + 0] = 0.5f + 0.5f * std::sin(u * 9.f) * std::cos(v * 7.f);
+            row[x * 4 + 1] = u < 0.5f ? 0.2f : 0.9f;
+            row[x * 4 + 2] = (u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f) < 0.05f ? 1.f : 0.f;
+            row[x * 4 + 3] = 1.f;
+        }
+    }
+
+    return image;
+}
+
+static float maxDifference(const BlurImage& a, const BlurImage& b)
+{
+    float d = 0.f;
+
+    for (size_t i = 0; i < a.rgba.size(); i++)
+    {
+        d = std::max(d, std::fabs(a.rgba[i] - b.rgba[i]));
+    }
+
+    return d;
+}
+
+/*one texel at a time, every read clamped to the image like blur.fx*/
+static BlurImage scalarBlur(const BlurImage& image, const BlurKernel& k)
+{
+    BlurImage temp, out;
+    temp.Resize(image.width, image.height);
+    out.Resize(image.width, image.height);
+
+    const std::vector<float>& w = k.Weights();
+    const int r = k.Radius();
+
+    for (int y = 0; y < image.height; y++)
+    {
+        for (int x = 0; x < image.width; x++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                double sum = 0.0;
+
+                for (int i = -r; i <= r; i++)
+                {
+                    sum += w[i + r] * image.Row(y)[std::clamp(x + i, 0, image.width - 1) * 4 + c];
+                }
+
+                temp.Row(y)[x * 4 + c] = static_cast<float>(sum);
+            }
+        }
+    }
+
+    for (int y = 0; y < image.height; y++)
+    {
+        for (int x = 0; x < image.width; x++)
+        {
+            for (int c = 0; c < 4; c++)
+            {
+                double sum = 0.0;
+
+                for (int i = -r; i <= r; i++)
+                {
+                    sum += w[i + r] * temp.Row(std::clamp(y + i, 0, image.height - 1))[x * 4 + c];
+                }
+
+                out.Row(y)[x * 4 + c] = static_cast<float>(sum);
+            }
+        }
+    }
+
+    return out;
+}
+
+static void TestWeights()
+{
+    const float sigmas[] = { 0.3f, 1.f, 2.6f, 5.f, 12.f, 32.f };
+
+    for (float sigma : sigmas)
+    {
+        BlurKernel k = BlurKernel::Gaussian(sigma);
+        const std::vector<float>& w = k.Weights();
+
+        CHECK(k.Radius() == std::max(1, (int)std::ceil(BLUR_SIGMA_RADIUS * sigma)));
+        CHECK(w.size() == (size_t)(2 * k.Radius() + 1));
+
+        double sum = 0.0;
+
+        for (size_t i = 0; i < w.size(); i++)
+        {
+            sum += w[i];
+            CHECK(w[i] == w[w.size() - 1 - i]);
+            CHECK(w[i] > 0.f);
+        }
+
+        CHECK_NEAR(sum, 1.0, 1e-6);
+
+        /*falling off from the center*/
+        for (int i = k.Radius(); i + 1 < (int)w.size(); i++)
+        {
+            CHECK(w[i + 1] <= w[i]);
+        }
+
+        /*linear taps keep the sum, the center and the symmetry*/
+        std::vector<BlurTap> taps = k.LinearTaps();
+        CHECK(taps[0].offset == 0.f && taps[0].weight == w[k.Radius()]);
+        CHECK(taps.size() == 1 + 2 * (size_t)((k.Radius() + 1) / 2));
+
+        sum = 0.0;
+
+        for (size_t i = 0; i < taps.size(); i++)
+        {
+            sum += taps[i].weight;
+
+            if (i > 0 && i % 2 == 1)
+                CHECK(taps[i].offset == -taps[i + 1].offset && taps[i].weight == taps[i + 1].weight);
+        }
+
+        CHECK_NEAR(sum, 1.0, 1e-6);
+    }
+
+    /*the kernel of the shader has a fixed radius*/
+    BlurKernel shader = BlurKernel::Gaussian(BLUR_SHADER_RADIUS, BLUR_SHADER_RADIUS);
+    CHECK(shader.Radius() == BLUR_SHADER_RADIUS);
+
+    /*the sigma of the smallest mip fits into the radius*/
+    const float wide[] = { 1.f, 2.6f, 4.f, 10.f, 40.f };
+
+    for (float sigma : wide)
+    {
+        int mips = BlurKernel::Mips(sigma);
+        CHECK(mips >= 0 && mips <= BLUR_MAX_MIPS);
+        CHECK(mips == BLUR_MAX_MIPS || std::ceil(BLUR_SIGMA_RADIUS * sigma / (1 << mips)) <= BLUR_MIP_RADIUS);
+        CHECK(mips == 0 || std::ceil(BLUR_SIGMA_RADIUS * sigma / (1 << (mips - 1))) > BLUR_MIP_RADIUS);
+    }
+}
+
+static void TestLinearTaps()
+{
+    const float sigmas[] = { 0.8f, 2.6f, 7.f };
+
+    for (float sigma : sigmas)
+    {
+        BlurKernel k = BlurKernel::Gaussian(sigma);
+
+        BlurImage taps = noise(TEST_WIDTH, TEST_HEIGHT, 1);
+        BlurImage linear = taps;
+
+        CpuBlur::Blur(taps, k.Taps());
+        CpuBlur::Blur(linear, k.LinearTaps());
+
+        CHECK(maxDifference(taps, linear) < 1e-5f);
+    }
+}
+
+static void TestSimd()
+{
+    printf("simd: %s\n", CpuBlur::Simd());
+
+    const float sigmas[] = { 0.5f, 2.6f, 9.f };
+
+    for (float sigma : sigmas)
+    {
+        BlurKernel k = BlurKernel::Gaussian(sigma);
+
+        /*a kernel wider than the image reads the clamped edges many times*/
+        BlurImage image = noise(TEST_WIDTH, sigma > 5.f ? 9 : TEST_HEIGHT, 2);
+        BlurImage reference = scalarBlur(image, k);
+
+        CpuBlur::Blur(image, k);
+        CHECK(maxDifference(image, reference) < 1e-5f);
+    }
+
+    /*a constant image stays constant up to the edges*/
+    BlurImage flat;
+    flat.Resize(TEST_WIDTH, TEST_HEIGHT);
+    std::fill(flat.rgba.begin(), flat.rgba.end(), 0.75f);
+
+    CpuBlur::Blur(flat, BlurKernel::Gaussian(4.f));
+    CHECK(std::all_of(flat.rgba.begin(), flat.rgba.end(), [](float v) { return std::fabs(v - 0.75f) < 1e-5f; }));
+
+    /*one texel wide or high*/
+    BlurImage line = noise(TEST_WIDTH, 1, 3);
+    BlurImage lineReference = scalarBlur(line, BlurKernel::Gaussian(3.f));
+    CpuBlur::Blur(line, BlurKernel::Gaussian(3.f));
+    CHECK(maxDifference(line, lineReference) < 1e-5f);
+}
+
+/*the chain is a cheaper approximation: on picture content it is a fraction of a percent off
+  on average, hard edges blurred from the smallest mip stay within a tenth*/
+static void TestMips()
+{
+    const float sigmas[] = { 4.f, 8.f, 16.f, 32.f };
+
+    for (float sigma : sigmas)
+    {
+        int mips = BlurKernel::Mips(sigma);
+        CHECK(mips > 0);
+
+        BlurImage full = picture(640, 360);
+        BlurImage chain = full;
+
+        CpuBlur::Blur(full, BlurKernel::Gaussian(sigma));
+        CpuBlur::BlurMips(chain, sigma, mips);
+
+        double mean = 0.0;
+
+        for (size_t i = 0; i < full.rgba.size(); i++)
+        {
+            mean += std::fabs(full.rgba[i] - chain.rgba[i]);
+        }
+
+        mean /= full.rgba.size();
+
+        float error = maxDifference(full, chain);
+        printf("sigma %g, %d mips: error %g, mean %g\n", sigma, mips, error, mean);
+        CHECK(error < 0.1f);
+        CHECK(mean < 0.01);
+    }
+
+    /*without mips it is the full blur*/
+    BlurImage full = picture(64, 48);
+    BlurImage chain = full;
+
+    CpuBlur::Blur(full, BlurKernel::Gaussian(2.f));
+    CpuBlur::BlurMips(chain, 2.f, 0);
+    CHECK(maxDifference(full, chain) == 0.f);
+}
+
+int main()
+{
+    TestWeights();
+    TestLinearTaps();
+    TestSimd();
+    TestMips();
+
+    return Result();
+}
@@ -0,0 +1,37 @@
+/* Check.h
+
+minimal checks for the linux tests. a failed check prints the file, line
+and expression and the test keeps running, Result gives the exit code.
+
+    Usage:
+    CHECK(lods.size() == 3);
+    CHECK_NEAR(error, 0.f, 1e-6f);
+    return Result();
+
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+static int checkFailures = 0;
+
+#define CHECK(c) \
+    do { if (!(c)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #c); checkFailures++; } } while (0)
+
+#define CHECK_NEAR(a, b, eps) \
+    do { double _a = (a), _b = (b); if (!(std::fabs(_a - _b) <= (eps))) { \
+        printf("%s:%d: check failed: %s = %g, %s = %g\n", __FILE__, __LINE__, #a, _a, #b, _b); checkFailures++; } } while (0)
+
+inline int Result()
+{
+    if (checkFailures)
+    {
+        printf("%d checks failed\n", checkFailures);
+        return 1;
+    }
+
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*drives XInputStub through a connect and disconnect sequence: empty slots
+  are probed with a backoff that doubles up to CONTROLLER_BACKOFF_MAX,
+  probing starts over after a controller was connected, capabilities and
+  battery are only queried on the status worker and the counters add up to
+  the calls the stub saw*/
+
+#include "ControllerInput.h"
+#include "Check.h"
+#include <vector>
+
+/*exact in binary, so the timer of the test and of the controllers agree*/
+#define TEST_DT (1.0f / 64.0f)
+
+/*how long to wait for the status worker*/
+#define TEST_WORKER_TIMEOUT_MS 2000
+
+struct Clock
+{
+    ControllerInput& controllers;
+    double time = 0.0;
+    unsigned int updates = 0;
+
+    /*one update, returns the slots that were queried as bits*/
+    unsigned int Step()
+    {
+        unsigned int before[MAX_CONTROLLERS];
+
+        for (int i = 0; i < MAX_CONTROLLERS; i++)
+        {
+            before[i] = XInputStub::slotStateCalls[i];
+        }
+
+        controllers.Update(TEST_DT);
+        time += TEST_DT;
+        updates++;
+
+        unsigned int queried = 0;
+
+        for (int i = 0; i < MAX_CONTROLLERS; i++)
+        {
+            if (XInputStub::slotStateCalls[i] != before[i])
+                queried |= 1u << i;
+        }
+
+        return queried;
+    }
+
+    /*times the slot was queried within seconds*/
+    std::vector<double> Probes(int slot, double seconds)
+    {
+        std::vector<double> probes;
+        double end = time + seconds;
+
+        while (time < end)
+        {
+            if (Step() & (1u << slot))
+                probes.push_back(time);
+        }
+
+        return probes;
+    }
+};
+
+/*every interval between probes is the expected backoff, rounded up to the next update*/
+static void checkIntervals(const std::vector<double>& probes, double since, const std::vector<double>& expected)
+{
+    CHECK(probes.size() >= expected.size());
+
+    double last = since;
+
+    for (size_t i = 0; i < expected.size() && i < probes.size(); i++)
+    {
+        double interval = probes[i] - last;
+
+        if (interval < expected[i] - 1e-6 || interval >= expected[i] + TEST_DT)
+        {
+            CHECK(interval >= expected[i] - 1e-6 && interval < expected[i] + TEST_DT);
+            printf("probe %zu after %g s, expected %g s\n", i, interval, expected[i]);
+        }
+
+        last = probes[i];
+    }
+}
+
+static bool waitForStatus(ControllerInput& controllers, unsigned long long queries)
+{
+    for (int ms = 0; ms < TEST_WORKER_TIMEOUT_MS; ms++)
+    {
+        if (controllers.getCounters().statusQueries >= queries)
+            return true;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return false;
+}
+
+int main()
+{
+    XInputStub::pollThread = std::this_thread::get_id();
+
+    ControllerInput controllers;
+    Clock clock{ controllers };
+
+    /*the first update queries every slot*/
+    CHECK(clock.Step() == 0xF);
+
+    /*empty slots: the first probe after 0.2 s, doubling up to the maximum*/
+    std::vector<double> probes = clock.Probes(0, 6.0);
+    checkIntervals(probes, TEST_DT, { 0.2, 0.4, 0.8, 1.0, 1.0, 1.0 });
+
+    /*a controller connects and is found at the next probe of its slot*/
+    XInputStub::connected[1] = true;
+    XInputStub::wireless[1] = true;
+    XInputStub::batteryLevel[1] = BATTERY_LEVEL_MEDIUM;
+
+    double connectTime = clock.time;
+    probes = clock.Probes(1, CONTROLLER_BACKOFF_MAX + TEST_DT);
+    CHECK(!probes.empty() && controllers.isConnected(1));
+
+    if (!probes.empty())
+        CHECK(probes[0] - connectTime <= CONTROLLER_BACKOFF_MAX + TEST_DT);
+
+    /*then it is read every update*/
+    for (int i = 0; i < 10; i++)
+    {
+        CHECK(clock.Step() & 2);
+    }
+
+    /*the worker queries capabilities and battery once, the next update hands them out*/
+    CHECK(waitForStatus(controllers, 1));
+    clock.Step();
+
+    CHECK(controllers.getState(1)->capabilities.Flags & XINPUT_CAPS_WIRELESS);
+    CHECK(controllers.getState(1)->batteryInfo.BatteryLevel == BATTERY_LEVEL_MEDIUM);
+    CHECK(XInputStub::capabilitiesCalls == 1 && XInputStub::batteryCalls == 1);
+
+    /*and again every CAP_BATTERY_POLL_TIME*/
+    XInputStub::batteryLevel[1] = BATTERY_LEVEL_LOW;
+    clock.Probes(1, CAP_BATTERY_POLL_TIME);
+    CHECK(waitForStatus(controllers, 2));
+    clock.Step();
+
+    CHECK(controllers.getState(1)->batteryInfo.BatteryLevel == BATTERY_LEVEL_LOW);
+    CHECK(controllers.getCounters().statusQueries == 2);
+
+    /*a disconnect clears the slot and probing starts over at the minimum*/
+    XInputStub::connected[1] = false;
+    CHECK(clock.Step() & 2);
+    CHECK(!controllers.isConnected(1));
+    CHECK(controllers.getState(1)->batteryInfo.BatteryLevel == 0);
+
+    double disconnectTime = clock.time;
+    probes = clock.Probes(1, 4.0);
+    checkIntervals(probes, disconnectTime, { 0.1, 0.2, 0.4, 0.8, 1.0 });
+
+    /*a reconnect is found, a second disconnect starts over again*/
+    XInputStub::connected[1] = true;
+    clock.Probes(1, CONTROLLER_BACKOFF_MAX + TEST_DT);
+    CHECK(controllers.isConnected(1));
+
+    XInputStub::connected[1] = false;
+    clock.Step();
+    disconnectTime = clock.time;
+    probes = clock.Probes(1, 1.0);
+    checkIntervals(probes, disconnectTime, { 0.1, 0.2, 0.4 });
+
+    /*the reconnect queried the status again*/
+    CHECK(waitForStatus(controllers, 3));
+
+    /*nothing on the polling thread waited for a status query*/
+    CHECK(XInputStub::statusCallsOnPollThread == 0);
+
+    ControllerCounters c = controllers.getCounters();
+
+    CHECK(c.polls == clock.updates);
+    CHECK(c.stateQueries == XInputStub::getStateCalls);
+    CHECK(c.stateQueries + c.skippedQueries == (unsigned long long)clock.updates * MAX_CONTROLLERS);
+    CHECK(c.statusQueries == XInputStub::capabilitiesCalls);
+    CHECK(c.maxPollMs >= c.lastPollMs);
+
+    /*most empty slot queries are skipped*/
+    CHECK(c.skippedQueries > c.stateQueries);
+
+    return Result();
+}
@@ -0,0 +1,316 @@
+/*checks the cpu particles: the simd integration matches the scalar formula
+  on odd ranges, emitting doesn't depend on the frame rate, old particles
+  are culled, Advance lands where stepping at 60 frames per second does
+  under constant acceleration and the updater gives the same pools on one
+  thread and on many*/
+
+#include "CpuParticles.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+
+#define TEST_DT (1.f / 60.f)
+
+static const float gravity[3] = { -1.f, -9.8f, 0.5f };
+
+static CpuParticleEmitter fire(size_t capacity, float rate = 0.f, float lifetime = 1e6f)
+{
+    ParticleEmitterDesc desc = ParticleEmitterDesc::Fire();
+    desc.rate = rate;
+    desc.lifetime = lifetime;
+    desc.spread[0] = desc.spread[1] = desc.spread[2] = 3.f;
+
+    CpuParticleEmitter e(desc, capacity);
+    e.SetEmitPosition(1.f, 2.f, 3.f);
+    e.SetAcceleration(gravity[0], gravity[1], gravity[2]);
+    return e;
+}
+
+static bool samePools(const ParticlePool& a, const ParticlePool& b)
+{
+    if (a.count != b.count)
+        return false;
+
+    auto same = [&](const auto& x, const auto& y) { return std::equal(x.begin(), x.begin() + a.count, y.begin()); };
+
+    return same(a.posX, b.posX) && same(a.posY, b.posY) && same(a.posZ, b.posZ) &&
+           same(a.velX, b.velX) && same(a.velY, b.velY) && same(a.velZ, b.velZ) &&
+           same(a.sizeX, b.sizeX) && same(a.sizeY, b.sizeY) && same(a.age, b.age) && same(a.type, b.type);
+}
+
+static void TestIntegrate()
+{
+    /*a count and ranges that end in the scalar tail*/
+    CpuParticleEmitter e = fire(1003);
+    e.Emit(1003);
+    CHECK(e.Count() == 1003);
+
+    ParticlePool before = e.Pool();
+
+    e.Integrate(0, 5, TEST_DT);
+    e.Integrate(5, 618, TEST_DT);
+    e.Integrate(618, 5000, TEST_DT);
+
+    const ParticlePool& p = e.Pool();
+    float worst = 0.f;
+
+    for (size_t i = 0; i < p.count; i++)
+    {
+        const float* pos[3] = { &before.posX[i], &before.posY[i], &before.posZ[i] };
+        const float* vel[3] = { &before.velX[i], &before.velY[i], &before.velZ[i] };
+        const float now[6] = { p.posX[i], p.posY[i], p.posZ[i], p.velX[i], p.velY[i], p.velZ[i] };
+
+        for (int c = 0; c < 3; c++)
+        {
+            float x = *pos[c] + (*vel[c] + 0.5f * gravity[c] * TEST_DT) * TEST_DT;
+            float v = *vel[c] + gravity[c] * TEST_DT;
+
+            worst = std::max(worst, std::fabs(now[c] - x));
+            worst = std::max(worst, std::fabs(now[3 + c] - v));
+        }
+
+        CHECK(p.age[i] == before.age[i] + TEST_DT);
+    }
+
+    CHECK(worst < 1e-5f);
+
+    /*the vertices of the draw shaders place a particle where it is*/
+    std::vector<ParticleVertex> vertices(e.Count());
+    CHECK(e.Export(vertices.data(), vertices.size()) == e.Count());
+    CHECK(e.Export(vertices.data(), 10) == 10);
+
+    worst = 0.f;
+
+    for (size_t i = 0; i < p.count; i++)
+    {
+        const ParticleVertex& v = vertices[i];
+        const float pos[3] = { p.posX[i], p.posY[i], p.posZ[i] };
+
+        for (int c = 0; c < 3; c++)
+        {
+            float x = 0.5f * gravity[c] * v.age * v.age + v.initialVel[c] * v.age + v.initialPos[c];
+            worst = std::max(worst, std::fabs(x - pos[c]));
+        }
+    }
+
+    CHECK(worst < 1e-4f);
+}
+
+/*the same second at different frame rates emits the same particles*/
+static void TestRate()
+{
+    const float rates[] = { 300.f, 60.f, 7.5f };
+    const float dts[] = { 1.f / 30.f, 1.f / 60.f, 1.f / 144.f, 0.013f };
+
+    for (float rate : rates)
+    {
+        for (float dt : dts)
+        {
+            CpuParticleEmitter e = fire(10000, rate);
+            int frames = static_cast<int>(std::lround(2.f / dt));
+
+            for (int f = 0; f < frames; f++)
+            {
+                e.Update(dt);
+            }
+
+            double expected = rate * frames * dt;
+
+            if (std::fabs(e.Count() - expected) > 1.0)
+            {
+                CHECK(std::fabs(e.Count() - expected) <= 1.0);
+                printf("rate %g at %g s: %zu particles, expected %g\n", rate, dt, e.Count(), expected);
+            }
+        }
+    }
+
+    /*the pool limits the particles, nothing is written past it*/
+    CpuParticleEmitter full = fire(100, 6000.f);
+    full.Update(1.f);
+    CHECK(full.Count() == 100);
+}
+
+static void TestCull()
+{
+    const float lifetime = 1.f;
+    CpuParticleEmitter e = fire(10000, 120.f, lifetime);
+
+    for (int f = 0; f < 60 * 3; f++)
+    {
+        e.Update(TEST_DT);
+    }
+
+    const ParticlePool& p = e.Pool();
+    float oldest = 0.f;
+
+    for (size_t i = 0; i < p.count; i++)
+    {
+        CHECK(p.age[i] <= lifetime);
+        oldest = std::max(oldest, p.age[i]);
+    }
+
+    /*a lifetime of particles, the oldest just younger than the lifetime*/
+    CHECK(std::fabs(static_cast<double>(e.Count()) - 120.0 * lifetime) <= 3.0);
+    CHECK(oldest > lifetime - 2.f * TEST_DT);
+
+    e.Reset();
+    CHECK(e.Count() == 0);
+}
+
+/*sleeping for half a second and catching up lands where 30 frames at 60 fps do*/
+static void TestAdvance()
+{
+    const int frames = 30;
+    const float seconds = frames * TEST_DT;
+
+    /*particles alive before the sleep*/
+    {
+        CpuParticleEmitter stepped = fire(2000);
+        stepped.Emit(2000);
+        CpuParticleEmitter advanced = stepped;
+
+        for (int f = 0; f < frames; f++)
+        {
+            stepped.Update(TEST_DT);
+        }
+
+        advanced.Advance(seconds);
+
+        const ParticlePool& a = stepped.Pool();
+        const ParticlePool& b = advanced.Pool();
+        CHECK(a.count == b.count);
+
+        float worst = 0.f;
+
+        for (size_t i = 0; i < a.count && i < b.count; i++)
+        {
+            worst = std::max({ worst, std::fabs(a.posX[i] - b.posX[i]), std::fabs(a.posY[i] - b.posY[i]), std::fabs(a.posZ[i] - b.posZ[i]) });
+            worst = std::max({ worst, std::fabs(a.velX[i] - b.velX[i]), std::fabs(a.velY[i] - b.velY[i]), std::fabs(a.velZ[i] - b.velZ[i]) });
+            worst = std::max(worst, std::fabs(a.age[i] - b.age[i]));
+        }
+
+        CHECK(worst < 1e-4f);
+    }
+
+    /*particles emitted during the sleep, every one where its age puts it*/
+    {
+        ParticleEmitterDesc desc;
+        desc.rate = 120.f;
+        desc.lifetime = 10.f;
+
+        CpuParticleEmitter stepped(desc, 1000);
+        stepped.SetAcceleration(gravity[0], gravity[1], gravity[2]);
+        CpuParticleEmitter advanced = stepped;
+
+        for (int f = 0; f < frames; f++)
+        {
+            stepped.Update(TEST_DT);
+        }
+
+        advanced.Advance(seconds);
+
+        const ParticlePool& a = stepped.Pool();
+        const ParticlePool& b = advanced.Pool();
+
+        CHECK(std::abs(static_cast<int>(a.count) - static_cast<int>(b.count)) <= 1);
+
+        for (const ParticlePool* p : { &a, &b })
+        {
+            float worst = 0.f;
+
+            for (size_t i = 0; i < p->count; i++)
+            {
+                float t = p->age[i];
+                worst = std::max({ worst, std::fabs(p->posX[i] - 0.5f * gravity[0] * t * t),
+                                   std::fabs(p->posY[i] - 0.5f * gravity[1] * t * t), std::fabs(p->velY[i] - gravity[1] * t) });
+            }
+
+            CHECK(worst < 1e-4f);
+        }
+
+        /*frames emit at their end, the catch up spreads the particles evenly: no more than a frame apart*/
+        std::vector<float> ages(a.age.begin(), a.age.begin() + a.count);
+        std::vector<float> caughtUp(b.age.begin(), b.age.begin() + b.count);
+        std::sort(ages.begin(), ages.end());
+        std::sort(caughtUp.begin(), caughtUp.end());
+
+        for (size_t i = 0; i < ages.size() && i < caughtUp.size(); i++)
+        {
+            CHECK(std::fabs(ages[i] - caughtUp[i]) <= TEST_DT);
+        }
+    }
+
+    /*a sleep longer than the lifetime leaves one lifetime of particles*/
+    {
+        CpuParticleEmitter e = fire(10000, 60.f, 2.f);
+        e.Emit(500);
+        e.Advance(100.f);
+
+        CHECK(std::fabs(static_cast<double>(e.Count()) - 120.0) <= 1.0);
+
+        for (size_t i = 0; i < e.Count(); i++)
+        {
+            CHECK(e.Pool().age[i] <= 2.f);
+        }
+    }
+}
+
+/*chunks of PARTICLE_JOB_SIZE on any number of threads give the same particles as one thread*/
+static void TestUpdater()
+{
+    std::vector<CpuParticleEmitter> one, many;
+
+    for (size_t capacity : { (size_t)PARTICLE_JOB_SIZE * 3 + 17, (size_t)100, (size_t)5000 })
+    {
+        CpuParticleEmitter e = fire(capacity, 600.f, 2.f);
+        e.Emit(capacity / 2);
+
+        one.push_back(e);
+        many.push_back(e);
+    }
+
+    std::vector<CpuParticleEmitter*> a, b;
+
+    for (size_t i = 0; i < one.size(); i++)
+    {
+        a.push_back(&one[i]);
+        b.push_back(&many[i]);
+    }
+
+    ParticleUpdater single(1);
+    ParticleUpdater threads(4);
+    CHECK(single.Threads() == 1 && threads.Threads() == 4);
+
+    for (int f = 0; f < 90; f++)
+    {
+        single.Update(a, TEST_DT);
+        threads.Update(b, TEST_DT);
+    }
+
+    for (size_t i = 0; i < one.size(); i++)
+    {
+        CHECK(samePools(one[i].Pool(), many[i].Pool()));
+    }
+
+    /*and the same as updating the emitter itself*/
+    CpuParticleEmitter direct = fire(5000, 600.f, 2.f);
+    direct.Emit(2500);
+
+    for (int f = 0; f < 90; f++)
+    {
+        direct.Update(TEST_DT);
+    }
+
+    CHECK(samePools(direct.Pool(), many[2].Pool()));
+}
+
+int main()
+{
+    TestIntegrate();
+    TestRate();
+    TestCull();
+    TestAdvance();
+    TestUpdater();
+
+    return Result();
+}
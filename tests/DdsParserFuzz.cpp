@@ -0,0 +1,159 @@
+/*mutates the headers of the textures of the game and a dx10 cube array
+  and parses them with random file sizes. the parser must not read past
+  the bytes it gets, which a build with TEST_SANITIZERS checks, and every
+  layout it accepts has to lie in the file.
+
+    DdsParserFuzz [rounds]
+
+  ctest runs DDS_FUZZ_ROUNDS, a longer run takes the rounds as argument*/
+
+#include "DdsParser.h"
+#include "Check.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#define TEST_TEXTURES REPO_DIR "/data/textures"
+
+#define DDS_FUZZ_ROUNDS 20000
+
+/*bytes of a seed that are mutated, the headers and a bit of data*/
+#define DDS_FUZZ_BYTES 200
+#define DDS_FUZZ_MUTATIONS 8
+
+static std::vector<uint8_t> readFile(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+/*dx10 header of a bc7 cube array of two cubes with 7 mips*/
+static std::vector<uint8_t> cubeArray()
+{
+    std::vector<uint8_t> h(DDS_MAX_HEADER_BYTES, 0);
+    auto set = [&](size_t offset, uint32_t v) { memcpy(&h[offset], &v, 4); };
+
+    memcpy(h.data(), "DDS ", 4);
+    set(4, DDS_HEADER_BYTES);
+    set(12, 64);
+    set(16, 64);
+    set(28, 7);
+    set(76, 32);
+    set(80, 0x4);
+    memcpy(&h[84], "DX10", 4);
+    set(128, 98);
+    set(132, 3);
+    set(136, 0x4);
+    set(140, 2);
+
+    return h;
+}
+
+/*an accepted layout: every subresource follows the last and all end inside the file*/
+static bool valid(const DdsLayout& l, uint64_t fileSize)
+{
+    if (l.subresources.size() != (size_t)l.arraySize * l.mips)
+        return false;
+
+    uint64_t end = l.dataOffset;
+
+    for (auto& s : l.subresources)
+    {
+        if (s.offset != end || s.bytes == 0)
+            return false;
+
+        end += s.bytes;
+    }
+
+    return end <= fileSize && end == l.dataOffset + l.dataBytes;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::vector<uint8_t>> seeds;
+
+    for (auto& entry : std::filesystem::directory_iterator(TEST_TEXTURES))
+    {
+        if (entry.path().extension() != ".dds")
+            continue;
+
+        seeds.push_back(readFile(entry.path().string()));
+
+        /*the seeds themselves are fine*/
+        const std::vector<uint8_t>& s = seeds.back();
+        DdsLayout l;
+        CHECK(ParseDds(s.data(), (std::min)(s.size(), (size_t)DDS_MAX_HEADER_BYTES), s.size(), l));
+    }
+
+    seeds.push_back(cubeArray());
+
+    size_t rounds = argc > 1 ? strtoul(argv[1], nullptr, 10) : DDS_FUZZ_ROUNDS;
+    size_t accepted = 0;
+
+    std::mt19937 rng(1);
+
+    for (size_t r = 0; r < rounds; r++)
+    {
+        const std::vector<uint8_t>& seed = seeds[rng() % seeds.size()];
+        std::vector<uint8_t> b(seed.begin(), seed.begin() + (std::min)(seed.size(), (size_t)DDS_FUZZ_BYTES));
+
+        int mutations = 1 + rng() % DDS_FUZZ_MUTATIONS;
+
+        for (int m = 0; m < mutations; m++)
+        {
+            size_t p = rng() % (std::min)(b.size(), (size_t)DDS_MAX_HEADER_BYTES);
+
+            switch (rng() % 4)
+            {
+            case 0:
+                b[p] = (uint8_t)rng();
+                break;
+            case 1:
+                b[p] ^= (uint8_t)(1 << (rng() % 8));
+                break;
+            case 2:
+            {
+                /*sizes and counts at their limits*/
+                uint32_t v = (rng() % 2) ? 0xffffffffu : ((rng() % 3) ? rng() % 70000 : 0);
+
+                if (p + 4 <= b.size())
+                    memcpy(&b[p], &v, 4);
+
+                break;
+            }
+            case 3:
+                b.resize(rng() % b.size() + 1);
+                break;
+            }
+        }
+
+        /*exactly the bytes given on the heap, so a sanitizer sees any read past them*/
+        size_t size = (std::min)(b.size(), (size_t)DDS_MAX_HEADER_BYTES);
+        std::vector<uint8_t> header(b.begin(), b.begin() + size);
+
+        uint64_t fileSize = (rng() % 2) ? seed.size() : (uint64_t)rng() * rng();
+        fileSize = (std::max)(fileSize, (uint64_t)size);
+
+        DdsLayout l;
+
+        if (ParseDds(header.data(), header.size(), fileSize, l))
+        {
+            accepted++;
+
+            if (!valid(l, fileSize))
+            {
+                CHECK(valid(l, fileSize));
+                printf("round %zu\n", r);
+            }
+        }
+    }
+
+    printf("%zu of %zu mutations accepted\n", accepted, rounds);
+
+    /*the mutations have to reach the layout code, not only the magic checks*/
+    CHECK(accepted > 0);
+
+    return Result();
+}
@@ -0,0 +1,277 @@
+/*layouts of the textures of the game and of built headers for the cases
+  the game has no file of: arrays, cubes, 1d and volume textures, formats
+  without a dxgi format and headers that have to be rejected*/
+
+#include "DdsParser.h"
+#include "Check.h"
+#include <cstring>
+#include <filesystem>
+
+#define TEST_TEXTURES REPO_DIR "/data/textures"
+
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDSD_DEPTH 0x800000
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_CUBEMAP_ALLFACES 0xFC00
+#define DDSCAPS2_VOLUME 0x200000
+
+#define FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define FORMAT_R8G8B8A8 28
+#define FORMAT_BC1 71
+
+struct Header
+{
+    std::vector<uint8_t> bytes;
+
+    void Set(size_t offset, uint32_t v) { memcpy(&bytes[offset], &v, 4); }
+
+    /*the header with fileSize - its size bytes of data*/
+    bool Parse(uint64_t fileSize, DdsLayout& layout) const { return ParseDds(bytes.data(), bytes.size(), fileSize, layout); }
+};
+
+static Header legacy(uint32_t width, uint32_t height, uint32_t mips, uint32_t formatFlags, uint32_t code, uint32_t bits = 0)
+{
+    Header h;
+    h.bytes.assign(DDS_MAGIC_BYTES + DDS_HEADER_BYTES, 0);
+    memcpy(h.bytes.data(), "DDS ", 4);
+
+    h.Set(4, DDS_HEADER_BYTES);
+    h.Set(12, height);
+    h.Set(16, width);
+    h.Set(28, mips);
+    h.Set(76, 32);
+    h.Set(80, formatFlags);
+    h.Set(84, code);
+    h.Set(88, bits);
+
+    return h;
+}
+
+static Header dx10(uint32_t width, uint32_t height, uint32_t mips, uint32_t format, uint32_t dimension,
+                   uint32_t arraySize, uint32_t misc = 0)
+{
+    Header h = legacy(width, height, mips, DDPF_FOURCC, FOURCC('D', 'X', '1', '0'));
+    h.bytes.resize(DDS_MAX_HEADER_BYTES, 0);
+
+    h.Set(128, format);
+    h.Set(132, dimension);
+    h.Set(136, misc);
+    h.Set(140, arraySize);
+
+    return h;
+}
+
+/*subresources follow each other from the data offset in D3D11CalcSubresource order*/
+static bool contiguous(const DdsLayout& l)
+{
+    if (l.subresources.size() != (size_t)l.arraySize * l.mips)
+        return false;
+
+    uint64_t end = l.dataOffset;
+
+    for (auto& s : l.subresources)
+    {
+        if (s.offset != end)
+            return false;
+
+        end += s.bytes;
+    }
+
+    return end == l.dataOffset + l.dataBytes;
+}
+
+int main()
+{
+    /*the textures of the game, every byte after the header is a subresource*/
+    int textures = 0;
+
+    for (auto& entry : std::filesystem::directory_iterator(TEST_TEXTURES))
+    {
+        if (entry.path().extension() != ".dds")
+            continue;
+
+        DdsLayout l;
+        bool ok = ReadDdsLayout(entry.path().string(), l);
+        CHECK(ok);
+
+        if (!ok)
+        {
+            printf("%s\n", entry.path().string().c_str());
+            continue;
+        }
+
+        CHECK(l.format != 0);
+        CHECK(!l.cube && !l.volume && !l.texture1D);
+        CHECK(contiguous(l));
+        CHECK(l.dataOffset + l.dataBytes == entry.file_size());
+        textures++;
+    }
+
+    CHECK(textures > 0);
+
+    /*bc1 mip chain, blocks of 4 x 4 texels in 8 bytes*/
+    {
+        Header h = legacy(256, 128, 9, DDPF_FOURCC, FOURCC('D', 'X', 'T', '1'));
+
+        DdsLayout l;
+        CHECK(h.Parse(1 << 20, l));
+        CHECK(l.format == FORMAT_BC1 && l.blockCompressed && l.mips == 9);
+        CHECK(contiguous(l));
+        CHECK(l.Subresource(0, 0).rowPitch == 64 * 8);
+        CHECK(l.Subresource(0, 0).bytes == 64 * 32 * 8);
+        CHECK(l.Subresource(8, 0).width == 1 && l.Subresource(8, 0).height == 1);
+        CHECK(l.Subresource(8, 0).bytes == 8);
+
+        /*the data has to be in the file*/
+        CHECK(h.Parse(l.dataOffset + l.dataBytes, l));
+        CHECK(!h.Parse(l.dataOffset + l.dataBytes - 1, l));
+
+        /*a 256 x 128 chain has 9 mips, 0 means 1*/
+        h.Set(28, 10);
+        CHECK(!h.Parse(1 << 20, l));
+        h.Set(28, 0);
+        CHECK(h.Parse(1 << 20, l) && l.mips == 1);
+    }
+
+    /*array slices each with their mips*/
+    {
+        Header h = dx10(16, 16, 2, FORMAT_R8G8B8A8, 3, 4);
+
+        DdsLayout l;
+        CHECK(h.Parse(1 << 20, l));
+        CHECK(l.arraySize == 4 && l.mips == 2);
+        CHECK(contiguous(l));
+        CHECK(l.Subresource(0, 3).offset == DDS_MAX_HEADER_BYTES + 3 * (1024 + 256));
+        CHECK(l.Subresource(1, 3).bytes == 256);
+        CHECK(l.MipBytes(0) == 4 * 1024);
+    }
+
+    /*cubes are six slices and square*/
+    {
+        DdsLayout l;
+        CHECK(dx10(32, 32, 1, FORMAT_R8G8B8A8, 3, 2, 0x4).Parse(1 << 20, l));
+        CHECK(l.cube && l.arraySize == 12);
+        CHECK(!dx10(32, 16, 1, FORMAT_R8G8B8A8, 3, 1, 0x4).Parse(1 << 20, l));
+
+        Header h = legacy(32, 32, 1, DDPF_FOURCC, FOURCC('D', 'X', 'T', '5'));
+        h.Set(112, DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_ALLFACES);
+        CHECK(h.Parse(1 << 20, l) && l.cube && l.arraySize == 6);
+
+        /*partial cubes*/
+        h.Set(112, DDSCAPS2_CUBEMAP | 0x400);
+        CHECK(!h.Parse(1 << 20, l));
+    }
+
+    /*1d textures are one texel high and marked, the streamer leaves them to the DDSTextureLoader*/
+    {
+        DdsLayout l;
+        CHECK(dx10(64, 1, 7, FORMAT_R8G8B8A8, 2, 1).Parse(1 << 20, l));
+        CHECK(l.texture1D && !l.volume && l.height == 1);
+        CHECK(contiguous(l));
+        CHECK(!dx10(64, 2, 1, FORMAT_R8G8B8A8, 2, 1).Parse(1 << 20, l));
+        CHECK(!dx10(64, 1, 1, FORMAT_R8G8B8A8, 2, 1, 0x4).Parse(1 << 20, l));
+    }
+
+    /*volumes have a depth that is halved with the mips*/
+    {
+        Header h = dx10(8, 8, 4, FORMAT_R8G8B8A8, 4, 1);
+        h.Set(24, 8);
+
+        DdsLayout l;
+        CHECK(h.Parse(1 << 20, l));
+        CHECK(l.volume && !l.texture1D && l.depth == 8);
+        CHECK(l.Subresource(0, 0).bytes == 8 * 8 * 8 * 4);
+        CHECK(l.Subresource(3, 0).depth == 1 && l.Subresource(3, 0).bytes == 4);
+
+        /*volume arrays don't exist*/
+        h.Set(140, 2);
+        CHECK(!h.Parse(1 << 20, l));
+
+        Header old = legacy(8, 8, 1, DDPF_FOURCC, FOURCC('D', 'X', 'T', '1'));
+        old.Set(24, 4);
+        old.Set(112, DDSCAPS2_VOLUME);
+        CHECK(old.Parse(1 << 20, l) && !l.volume && l.depth == 1);
+        old.Set(8, DDSD_DEPTH);
+        CHECK(old.Parse(1 << 20, l) && l.volume && l.depth == 4);
+    }
+
+    /*pixel formats without a dxgi format still have a size*/
+    {
+        DdsLayout l;
+        CHECK(legacy(16, 16, 1, DDPF_RGB, 0, 24).Parse(1 << 20, l));
+        CHECK(l.format == 0 && l.bitsPerTexel == 24);
+        CHECK(l.Subresource(0, 0).rowPitch == 48);
+
+        CHECK(!legacy(16, 16, 1, DDPF_RGB, 0, 12).Parse(1 << 20, l));
+        CHECK(!legacy(16, 16, 1, DDPF_FOURCC, FOURCC('A', 'B', 'C', 'D')).Parse(1 << 20, l));
+    }
+
+    /*broken headers*/
+    {
+        Header good = dx10(16, 16, 1, FORMAT_R8G8B8A8, 3, 1);
+        DdsLayout l;
+        CHECK(good.Parse(1 << 20, l));
+
+        Header h = good;
+        h.bytes[0] = 'X';
+        CHECK(!h.Parse(1 << 20, l));
+
+        h = good;
+        h.Set(4, 120);
+        CHECK(!h.Parse(1 << 20, l));
+
+        h = good;
+        h.Set(76, 24);
+        CHECK(!h.Parse(1 << 20, l));
+
+        /*the dx10 header is cut off*/
+        CHECK(!ParseDds(good.bytes.data(), DDS_MAGIC_BYTES + DDS_HEADER_BYTES, 1 << 20, l));
+        CHECK(!ParseDds(good.bytes.data(), DDS_MAGIC_BYTES + DDS_HEADER_BYTES - 1, 1 << 20, l));
+        CHECK(!ParseDds(nullptr, 0, 0, l));
+
+        /*more bytes than the file has*/
+        CHECK(!good.Parse(DDS_MAX_HEADER_BYTES - 1, l));
+
+        h = good;
+        h.Set(128, 0);
+        CHECK(!h.Parse(1 << 20, l));
+
+        h = good;
+        h.Set(140, 0);
+        CHECK(!h.Parse(1 << 20, l));
+
+        h = good;
+        h.Set(132, 5);
+        CHECK(!h.Parse(1 << 20, l));
+
+        h = good;
+        h.Set(16, 0);
+        CHECK(!h.Parse(1 << 20, l));
+
+        h = good;
+        h.Set(16, DDS_MAX_DIMENSION + 1);
+        CHECK(!h.Parse(1ull << 40, l));
+
+        /*a rejected header leaves an empty layout*/
+        CHECK(l.subresources.empty() && l.width == 0);
+    }
+
+    /*the largest sizes don't overflow, they just don't fit in the file*/
+    {
+        Header h = dx10(DDS_MAX_DIMENSION, DDS_MAX_DIMENSION, DDS_MAX_MIPS, 2, 3, DDS_MAX_ARRAY);
+
+        DdsLayout l;
+        CHECK(!h.Parse(~0ull >> 8, l));
+
+        h.Set(16, 0xffffffff);
+        h.Set(140, 0xffffffff);
+        CHECK(!h.Parse(~0ull, l));
+    }
+
+    DdsLayout missing;
+    CHECK(!ReadDdsLayout(TEST_TEXTURES "/missing.dds", missing));
+
+    return Result();
+}
@@ -0,0 +1,111 @@
+/*replays a frame trace through the governor in a closed loop: scales stay
+  within their bounds, settle where the frame fits the budget and come back
+  to full resolution when the load goes away*/
+
+#include "FrameTimeGovernor.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+
+#define TEST_TRACE TEST_DATA_DIR "/frametrace_match.txt"
+#define TEST_VIEWS 4
+
+/*the last frames of a phase of the trace have to be settled*/
+#define TEST_SETTLE_FRAMES 60
+
+/*phases of the trace by their first frame after them, see the comments in the trace*/
+struct Phase
+{
+    int end;
+    const char* name;
+};
+
+static const Phase phases[] =
+{
+    { 300, "light" }, { 900, "heavy" }, { 1200, "one heavy view" }, { 1500, "overload" }, { 1800, "light again" }
+};
+
+int main()
+{
+    std::vector<FrameTiming> trace;
+    CHECK(FrameTimeGovernor::LoadTrace(TEST_TRACE, trace));
+    CHECK(trace.size() == 1800);
+
+    if (trace.size() != 1800)
+        return Result();
+
+    GovernorConfig config;
+    std::vector<float> scales = FrameTimeGovernor::Replay(trace, TEST_VIEWS, config);
+    CHECK(scales.size() == trace.size() * TEST_VIEWS);
+
+    /*same timings, same scales*/
+    CHECK(FrameTimeGovernor::Replay(trace, TEST_VIEWS, config) == scales);
+
+    for (float s : scales)
+    {
+        CHECK(s >= config.minScale && s <= config.maxScale);
+    }
+
+    auto scale = [&](int frame, int view) { return scales[frame * TEST_VIEWS + view]; };
+
+    for (const Phase& phase : phases)
+    {
+        for (int v = 0; v < TEST_VIEWS; v++)
+        {
+            float lo = config.maxScale, hi = config.minScale, worst = 0.f;
+
+            for (int f = phase.end - TEST_SETTLE_FRAMES; f < phase.end; f++)
+            {
+                lo = std::min(lo, scale(f, v));
+                hi = std::max(hi, scale(f, v));
+
+                /*the frame as the governor saw it, drawn with the scales of the frame before*/
+                std::vector<float> previous(scales.begin() + (f - 1) * TEST_VIEWS, scales.begin() + f * TEST_VIEWS);
+                FrameTiming t = FrameTimeGovernor::Simulate(trace[f], previous);
+
+                float shared = t.gpuMs;
+
+                for (int i = 0; i < TEST_VIEWS; i++)
+                {
+                    shared -= t.viewMs[i];
+                }
+
+                float budget = (config.targetMs - shared) / TEST_VIEWS;
+                worst = std::max(worst, std::fabs(t.viewMs[v] - budget) / budget);
+            }
+
+            bool atBound = hi - lo < 1e-3f && (std::fabs(lo - config.minScale) < 1e-3f || std::fabs(hi - config.maxScale) < 1e-3f);
+
+            printf("%-15s view %d: scale %.3f - %.3f, %.1f%% off its budget\n", phase.name, v, lo, hi, worst * 100.f);
+
+            /*no oscillation*/
+            CHECK(hi - lo < 0.05f);
+
+            /*settled on the budget or held at a bound, only a view with headroom stays at full resolution*/
+            CHECK(atBound || worst < 0.12f);
+        }
+    }
+
+    /*nothing to save while the load is light*/
+    CHECK(scale(299, 0) == config.maxScale && scale(1799, 0) > config.maxScale - 1e-3f);
+
+    /*all views heavy, all go down together*/
+    CHECK(scale(899, 0) < 0.9f && std::fabs(scale(899, 0) - scale(899, 3)) < 0.05f);
+
+    /*only the heavy view pays*/
+    CHECK(scale(1199, 0) < 0.75f && scale(1199, 1) > config.maxScale - 1e-3f);
+
+    /*more than the smallest scale saves*/
+    CHECK(scale(1499, 2) < config.minScale + 1e-3f);
+
+    /*a saved trace loads back to the same frames*/
+    std::string copy = "frametrace_copy.txt";
+    std::vector<FrameTiming> loaded;
+
+    CHECK(FrameTimeGovernor::SaveTrace(copy, trace));
+    CHECK(FrameTimeGovernor::LoadTrace(copy, loaded));
+    CHECK(loaded.size() == trace.size());
+    CHECK(FrameTimeGovernor::Replay(loaded, TEST_VIEWS, config) == scales);
+
+    return Result();
+}
@@ -0,0 +1,55 @@
+/*renders the golden image of game.lvl without a gpu and compares it to the
+  committed reference, run with --update to write a new reference after an
+  intended change of the renderer or the data*/
+
+#include "GoldenScene.h"
+#include "Check.h"
+#include <cstring>
+#include <filesystem>
+
+#define TEST_WIDTH 640
+#define TEST_HEIGHT 360
+#define GOLDEN_REFERENCE TEST_DATA_DIR "/golden_match_start.bmp"
+
+int main(int argc, char** argv)
+{
+    /*the data paths are relative to the repository like for the game*/
+    std::filesystem::current_path(REPO_DIR);
+
+    SoftwareRasterizer raster(TEST_WIDTH, TEST_HEIGHT);
+    CHECK(GoldenScene::RenderMatchStart(raster, "game.lvl"));
+
+    const SoftStats& stats = raster.Stats();
+    printf("golden image in %.1f ms, %zu triangles, %zu pixels\n", stats.totalMs, stats.triangles, stats.pixels);
+
+    CHECK(stats.triangles > 0);
+
+    if (argc > 1 && strcmp(argv[1], "--update") == 0)
+    {
+        CHECK(raster.SaveBMP(GOLDEN_REFERENCE));
+        return Result();
+    }
+
+    /*tiles are independent, one thread draws the same image*/
+    SoftwareRasterizer single(TEST_WIDTH, TEST_HEIGHT, 1);
+    CHECK(GoldenScene::RenderMatchStart(single, "game.lvl"));
+    CHECK(SoftwareRasterizer::Compare(raster.Pixels(), single.Pixels(), 0) == 0);
+
+    int width = 0, height = 0;
+    std::vector<uint32_t> reference;
+
+    CHECK(SoftwareRasterizer::LoadBMP(GOLDEN_REFERENCE, width, height, reference));
+    CHECK(width == TEST_WIDTH && height == TEST_HEIGHT);
+
+    size_t different = SoftwareRasterizer::Compare(raster.Pixels(), reference, GOLDEN_TOLERANCE);
+    printf("%zu of %zu pixels differ from the reference\n", different, raster.Pixels().size());
+
+    if (different > raster.Pixels().size() * GOLDEN_MAX_DIFFERENT)
+    {
+        /*next to the test binary to look at*/
+        raster.SaveBMP((std::filesystem::path(argv[0]).parent_path() / "golden_match_start.bmp").string());
+        CHECK(false);
+    }
+
+    return Result();
+}
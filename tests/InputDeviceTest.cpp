@@ -0,0 +1,132 @@
+/*checks the LoopbackDevice wire format: buttons travel as a bitmask, broken
+  packets are dropped and do not stop the datagrams behind them*/
+
+#include "InputDevice.h"
+#include "NetSocket.h"
+#include "Check.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#define TEST_PORT 27115
+
+static InputData Pad(uint32_t mask, float lx)
+{
+    InputData d = {};
+    d.type = 1;
+    d.isConnected = true;
+
+    for (int b = 0; b < BUTTON_COUNT; b++)
+    {
+        d.buttons[b] = (mask >> b & 1u) != 0;
+    }
+
+    d.trigger[0] = lx;
+    return d;
+}
+
+static bool Same(const InputData& a, const InputData& b)
+{
+    if (a.type != b.type || a.isConnected != b.isConnected)
+        return false;
+
+    for (int i = 0; i < BUTTON_COUNT; i++)
+    {
+        if (a.buttons[i] != b.buttons[i])
+            return false;
+    }
+
+    for (int i = 0; i < TRIGGER_COUNT; i++)
+    {
+        if (a.trigger[i] != b.trigger[i])
+            return false;
+    }
+
+    return true;
+}
+
+static void SendRaw(const void* data, size_t size)
+{
+    intptr_t s = OpenUdpSocket(0, true);
+    CHECK(s != NET_INVALID_SOCKET);
+    CHECK(SendUdp(s, NET_LOOPBACK_ADDRESS, TEST_PORT, data, size));
+    CloseUdpSocket(s);
+}
+
+static void TestEncode()
+{
+    InputData in = Pad(0x2A5Bu, -0.25f);
+    InputPacket p = LoopbackDevice::Encode(3, in);
+
+    CHECK(p.slot == 3);
+    CHECK(p.buttons == 0x2A5Bu);
+    CHECK(p.connected == 1);
+
+    InputData out;
+    CHECK(LoopbackDevice::Decode(p, out));
+    CHECK(Same(in, out));
+
+    /*values a bool can not hold*/
+    InputPacket bad = p;
+    bad.connected = 0x40;
+    CHECK(!LoopbackDevice::Decode(bad, out));
+
+    bad = p;
+    bad.buttons |= 1u << BUTTON_COUNT;
+    CHECK(!LoopbackDevice::Decode(bad, out));
+
+    bad = p;
+    bad.trigger[2] = NAN;
+    CHECK(!LoopbackDevice::Decode(bad, out));
+
+    /*triggers are clamped*/
+    bad = p;
+    bad.trigger[1] = 7.f;
+    CHECK(LoopbackDevice::Decode(bad, out));
+    CHECK(out.trigger[1] == 1.f);
+}
+
+static void TestLoopback()
+{
+    LoopbackDevice device(2, TEST_PORT);
+    std::vector<InputData> out(2);
+
+    CHECK(LoopbackDevice::Send(0, Pad(0x1u, 0.5f), TEST_PORT));
+    CHECK(LoopbackDevice::Send(1, Pad(0x3001u, -1.f), TEST_PORT));
+
+    device.Read(out.data(), 0.016f);
+
+    CHECK(Same(out[0], Pad(0x1u, 0.5f)));
+    CHECK(Same(out[1], Pad(0x3001u, -1.f)));
+
+    /*broken datagrams in front of a good one*/
+    InputPacket garbage = LoopbackDevice::Encode(0, Pad(0x2u, 0.f));
+    garbage.connected = 0xFF;
+
+    char large[sizeof(InputPacket) + 16] = {};
+    InputPacket outOfRange = LoopbackDevice::Encode(5, Pad(0x4u, 0.f));
+
+    SendRaw(&garbage, sizeof(garbage));
+    SendRaw(large, sizeof(large));
+    SendRaw(large, 0);
+    SendRaw(large, 7);
+    SendRaw(&outOfRange, sizeof(outOfRange));
+    CHECK(LoopbackDevice::Send(0, Pad(0x8u, 0.125f), TEST_PORT));
+
+    device.Read(out.data(), 0.016f);
+
+    CHECK(Same(out[0], Pad(0x8u, 0.125f)));
+    CHECK(Same(out[1], Pad(0x3001u, -1.f)));
+
+    /*nothing new keeps the last state*/
+    device.Read(out.data(), 0.016f);
+    CHECK(Same(out[0], Pad(0x8u, 0.125f)));
+}
+
+int main()
+{
+    TestEncode();
+    TestLoopback();
+
+    return Result();
+}
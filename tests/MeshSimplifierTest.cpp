@@ -0,0 +1,351 @@
+/*checks the simplifier on a flat grid and a sphere: index counts, triangle
+  targets and the reported error bound of every level. a thin torus has to
+  stay a closed manifold*/
+
+#include "MeshSimplifier.h"
+#include "Check.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <utility>
+
+struct TestMesh
+{
+    std::vector<float> positions;
+    std::vector<unsigned int> indices;
+
+    size_t VertexCount() const { return positions.size() / 3; }
+};
+
+/*n x n quads in the xz plane, border vertices are locked by the simplifier*/
+static TestMesh Grid(unsigned int n)
+{
+    TestMesh m;
+
+    for (unsigned int z = 0; z <= n; z++)
+    {
+        for (unsigned int x = 0; x <= n; x++)
+        {
+            m.positions.insert(m.positions.end(), { (float)x, 0.f, (float)z });
+        }
+    }
+
+    for (unsigned int z = 0; z < n; z++)
+    {
+        for (unsigned int x = 0; x < n; x++)
+        {
+            unsigned int i = z * (n + 1) + x;
+            m.indices.insert(m.indices.end(), { i, i + n + 1, i + 1, i + 1, i + n + 1, i + n + 2 });
+        }
+    }
+
+    return m;
+}
+
+/*closed unit sphere, an icosahedron subdivided levels times*/
+static TestMesh Sphere(int levels)
+{
+    const float t = (1.f + sqrtf(5.f)) / 2.f;
+
+    TestMesh m;
+    m.positions = { -1, t, 0, 1, t, 0, -1, -t, 0, 1, -t, 0,
+                    0, -1, t, 0, 1, t, 0, -1, -t, 0, 1, -t,
+                    t, 0, -1, t, 0, 1, -t, 0, -1, -t, 0, 1 };
+    m.indices = { 0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+                  1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+                  3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+                  4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1 };
+
+    auto normalize = [&](unsigned int v)
+    {
+        float* p = &m.positions[v * 3];
+        float l = sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        p[0] /= l; p[1] /= l; p[2] /= l;
+    };
+
+    for (unsigned int v = 0; v < m.VertexCount(); v++)
+    {
+        normalize(v);
+    }
+
+    for (int l = 0; l < levels; l++)
+    {
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> middles;
+        std::vector<unsigned int> next;
+
+        auto middle = [&](unsigned int a, unsigned int b)
+        {
+            auto key = std::make_pair(std::min(a, b), std::max(a, b));
+            auto it = middles.find(key);
+
+            if (it != middles.end())
+                return it->second;
+
+            unsigned int v = (unsigned int)m.VertexCount();
+
+            for (int k = 0; k < 3; k++)
+            {
+                m.positions.push_back((m.positions[a * 3 + k] + m.positions[b * 3 + k]) * 0.5f);
+            }
+
+            normalize(v);
+            middles[key] = v;
+            return v;
+        };
+
+        for (size_t i = 0; i < m.indices.size(); i += 3)
+        {
+            unsigned int a = m.indices[i], b = m.indices[i + 1], c = m.indices[i + 2];
+            unsigned int ab = middle(a, b), bc = middle(b, c), ca = middle(c, a);
+
+            next.insert(next.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+        }
+
+        m.indices = next;
+    }
+
+    return m;
+}
+
+/*closed torus with a thin tube of three sides, every ring of the tube is a loop of three
+  edges without a face in it, collapsing one of them would pinch the tube*/
+static TestMesh ThinTorus(unsigned int segments, float radius, float tube)
+{
+    TestMesh m;
+
+    for (unsigned int s = 0; s < segments; s++)
+    {
+        float a = 2.f * 3.14159265f * s / segments;
+
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            float b = 2.f * 3.14159265f * k / 3;
+            float r = radius + tube * cosf(b);
+
+            m.positions.insert(m.positions.end(), { r * cosf(a), tube * sinf(b), r * sinf(a) });
+        }
+    }
+
+    for (unsigned int s = 0; s < segments; s++)
+    {
+        unsigned int n = (s + 1) % segments;
+
+        for (unsigned int k = 0; k < 3; k++)
+        {
+            unsigned int l = (k + 1) % 3;
+            unsigned int i0 = s * 3 + k, i1 = s * 3 + l, i2 = n * 3 + k, i3 = n * 3 + l;
+
+            m.indices.insert(m.indices.end(), { i0, i2, i1, i1, i2, i3 });
+        }
+    }
+
+    return m;
+}
+
+/*y of the normal, the grid faces up*/
+static double NormalY(const TestMesh& m, const unsigned int* c)
+{
+    const float* p0 = &m.positions[c[0] * 3];
+    const float* p1 = &m.positions[c[1] * 3];
+    const float* p2 = &m.positions[c[2] * 3];
+
+    double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+    return e1[2] * e2[0] - e1[0] * e2[2];
+}
+
+/*the index list is whole triangles of existing, distinct vertices*/
+static void CheckIndices(const TestMesh& m, const SimplifyResult& r)
+{
+    CHECK(r.indices.size() == r.triangleCount * 3);
+
+    for (size_t i = 0; i + 2 < r.indices.size(); i += 3)
+    {
+        const unsigned int* c = &r.indices[i];
+
+        CHECK(c[0] < m.VertexCount() && c[1] < m.VertexCount() && c[2] < m.VertexCount());
+        CHECK(c[0] != c[1] && c[1] != c[2] && c[0] != c[2]);
+    }
+}
+
+static void TestGrid()
+{
+    TestMesh m = Grid(16);
+    size_t triangles = m.indices.size() / 3;
+
+    MeshSimplifier simplifier(m.positions.data(), sizeof(float) * 3, m.VertexCount(), m.indices);
+    std::vector<SimplifyResult> chain = simplifier.SimplifyChain({ 0.5f, 0.25f, 0.15f }, 0.01f);
+
+    CHECK(chain.size() == 3);
+
+    for (size_t i = 0; i < chain.size(); i++)
+    {
+        CheckIndices(m, chain[i]);
+
+        /*collapses inside a plane cost nothing*/
+        CHECK_NEAR(chain[i].error, 0.0, 1e-6);
+
+        /*only the 64 border vertices are locked, they need 62 triangles*/
+        CHECK(chain[i].triangleCount <= (size_t)((i == 0 ? 0.5f : i == 1 ? 0.25f : 0.15f) * triangles));
+
+        /*no triangle was flipped and the grid is still covered*/
+        double area = 0.0;
+
+        for (size_t t = 0; t < chain[i].indices.size(); t += 3)
+        {
+            double y = NormalY(m, &chain[i].indices[t]);
+            CHECK(y > 0.0);
+            area += y * 0.5;
+        }
+
+        CHECK_NEAR(area, 16.0 * 16.0, 1e-3);
+    }
+}
+
+static void TestSphere()
+{
+    TestMesh m = Sphere(3);
+    size_t triangles = m.indices.size() / 3;
+    const float ratios[] = { 0.5f, 0.25f, 0.1f };
+    const float maxError = 0.05f;
+
+    CHECK(triangles == 1280);
+
+    MeshSimplifier simplifier(m.positions.data(), sizeof(float) * 3, m.VertexCount(), m.indices);
+    std::vector<SimplifyResult> chain = simplifier.SimplifyChain({ ratios[0], ratios[1], ratios[2] }, maxError);
+
+    CHECK(chain.size() == 3);
+
+    float lastError = 0.f;
+    size_t lastCount = triangles;
+
+    for (size_t i = 0; i < chain.size(); i++)
+    {
+        CheckIndices(m, chain[i]);
+
+        /*every level is within the bound and no better than the level before*/
+        CHECK(chain[i].error <= maxError);
+        CHECK(chain[i].error >= lastError);
+        CHECK(chain[i].triangleCount <= lastCount);
+
+        printf("sphere lod %zu: %zu of %zu triangles, error %g\n", i + 1, chain[i].triangleCount, triangles, chain[i].error);
+
+        lastError = chain[i].error;
+        lastCount = chain[i].triangleCount;
+    }
+
+    /*half of the sphere is within 5% of its size, the bound stops the chain before a quarter*/
+    CHECK(chain[0].triangleCount <= (size_t)(ratios[0] * triangles));
+    CHECK(chain[0].error > 0.f);
+    CHECK(chain[1].triangleCount > (size_t)(ratios[1] * triangles));
+    CHECK(chain[2].triangleCount == chain[1].triangleCount);
+    CHECK(chain[2].indices == chain[1].indices);
+
+    /*a single level stops at the same point as the chain*/
+    MeshSimplifier single(m.positions.data(), sizeof(float) * 3, m.VertexCount(), m.indices);
+    SimplifyResult r = single.Simplify(ratios[1], maxError);
+
+    CHECK(r.triangleCount == chain[1].triangleCount);
+    CHECK(r.indices == chain[1].indices);
+    CHECK(r.error == chain[1].error);
+}
+
+static void TestErrorBound()
+{
+    TestMesh m = Sphere(3);
+    size_t triangles = m.indices.size() / 3;
+
+    /*every collapse on the curved surface costs more than this, nothing may be removed*/
+    MeshSimplifier simplifier(m.positions.data(), sizeof(float) * 3, m.VertexCount(), m.indices);
+    std::vector<SimplifyResult> chain = simplifier.SimplifyChain({ 0.5f, 0.25f }, 1e-5f);
+
+    for (const SimplifyResult& r : chain)
+    {
+        CheckIndices(m, r);
+        CHECK(r.triangleCount == triangles);
+        CHECK(r.error <= 1e-5f);
+    }
+
+    /*a loose bound lets the chain get close to the target*/
+    MeshSimplifier loose(m.positions.data(), sizeof(float) * 3, m.VertexCount(), m.indices);
+    SimplifyResult r = loose.Simplify(0.1f, 1.f);
+
+    CheckIndices(m, r);
+    CHECK(r.triangleCount <= (size_t)(0.1f * triangles));
+    CHECK(r.error <= 1.f);
+}
+
+/*every edge has two triangles and no triangle is there twice*/
+static bool Manifold(const SimplifyResult& r)
+{
+    std::map<std::pair<unsigned int, unsigned int>, int> edges;
+    std::set<std::vector<unsigned int>> faces;
+
+    for (size_t i = 0; i + 2 < r.indices.size(); i += 3)
+    {
+        std::vector<unsigned int> f(r.indices.begin() + i, r.indices.begin() + i + 3);
+        std::sort(f.begin(), f.end());
+
+        if (!faces.insert(f).second)
+            return false;
+
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int a = r.indices[i + k], b = r.indices[i + (k + 1) % 3];
+            edges[std::make_pair(std::min(a, b), std::max(a, b))]++;
+        }
+    }
+
+    for (auto& e : edges)
+    {
+        if (e.second != 2)
+            return false;
+    }
+
+    return true;
+}
+
+static void TestPinch()
+{
+    TestMesh m = ThinTorus(24, 4.f, 0.05f);
+    size_t triangles = m.indices.size() / 3;
+
+    MeshSimplifier simplifier(m.positions.data(), sizeof(float) * 3, m.VertexCount(), m.indices);
+    std::vector<SimplifyResult> chain = simplifier.SimplifyChain({ 0.5f, 0.1f }, 1.f);
+
+    for (const SimplifyResult& r : chain)
+    {
+        CheckIndices(m, r);
+        CHECK(Manifold(r));
+        CHECK(r.triangleCount < triangles);
+
+        /*still a closed torus, euler characteristic 0 makes twice as many triangles as vertices*/
+        std::set<unsigned int> used(r.indices.begin(), r.indices.end());
+        CHECK(r.triangleCount == used.size() * 2);
+    }
+}
+
+static void TestEmpty()
+{
+    float p[9] = { 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+
+    MeshSimplifier simplifier(p, sizeof(float) * 3, 3, std::vector<unsigned int>());
+    std::vector<SimplifyResult> chain = simplifier.SimplifyChain({ 0.5f }, 0.01f);
+
+    CHECK(chain.size() == 1);
+    CHECK(chain[0].triangleCount == 0);
+    CHECK(chain[0].indices.empty());
+}
+
+int main()
+{
+    TestGrid();
+    TestSphere();
+    TestErrorBound();
+    TestPinch();
+    TestEmpty();
+
+    return Result();
+}
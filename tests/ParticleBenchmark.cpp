@@ -0,0 +1,27 @@
+/*the cpu particle part of the -benchmark report of the game: particles per
+  millisecond per core with one thread and with all of them.
+
+    ParticleBenchmark [particles...]
+
+  without arguments 10k, 100k and 1M particles like the game*/
+
+#include "CpuParticles.h"
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> counts;
+
+    for (int i = 1; i < argc; i++)
+    {
+        counts.push_back(strtoul(argv[i], nullptr, 10));
+    }
+
+    if (counts.empty())
+        counts = { 10000, 100000, 1000000 };
+
+    std::wcout << ParticleUpdater::Report(ParticleUpdater::Benchmark(counts));
+
+    return 0;
+}
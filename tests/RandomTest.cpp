@@ -0,0 +1,237 @@
+/*checks the random numbers gameplay repeats from: philox against the known
+  answers of Random123, the sse Fill against the scalar blocks for counts
+  that end in the tail, pcg32 against the output of the reference
+  implementation, Below() without bias and streams that repeat with the
+  match seed*/
+
+#include "Random.h"
+#include "Check.h"
+#include <cmath>
+#include <vector>
+
+struct PhiloxVector
+{
+    uint32_t counter[4];
+    uint64_t key;
+    uint32_t expected[4];
+};
+
+/*kat_vectors of Random123, philox4x32 with 10 rounds. the key words are k0 low, k1 high*/
+static const PhiloxVector philoxVectors[] =
+{
+    { { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }, 0x0000000000000000ull,
+      { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+    { { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, 0xffffffffffffffffull,
+      { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+    { { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, 0x299f31d0a4093822ull,
+      { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+};
+
+static void TestPhilox()
+{
+    for (const PhiloxVector& v : philoxVectors)
+    {
+        uint32_t out[4];
+        Random::Philox128(v.key, v.counter, out);
+
+        for (int i = 0; i < 4; i++)
+        {
+            if (out[i] != v.expected[i])
+            {
+                CHECK(out[i] == v.expected[i]);
+                printf("philox word %d: %08x, expected %08x\n", i, out[i], v.expected[i]);
+            }
+        }
+    }
+
+    /*the 64 bit counter is the low half of the 128 bit one*/
+    const uint64_t counter = 0x123456789abcdef0ull;
+    const uint32_t full[4] = { 0x9abcdef0, 0x12345678, 0, 0 };
+
+    uint32_t a[4], b[4];
+    Random::Philox(RANDOM_TEXTURE_KEY, counter, a);
+    Random::Philox128(RANDOM_TEXTURE_KEY, full, b);
+    CHECK(a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3]);
+}
+
+/*what Fill has to write: 4 floats per block from the scalar philox*/
+static float expectedFill(uint64_t key, uint64_t counter, size_t i, float a, float b)
+{
+    uint32_t block[4];
+    Random::Philox(key, counter + i / 4, block);
+    return (block[i % 4] >> 8) * ((b - a) * (1.f / 16777216.f)) + a;
+}
+
+static void TestFill()
+{
+    printf("simd: %s\n", Random::Simd());
+
+    const size_t counts[] = { 1, 3, 4, 15, 16, 17, 31, 33, 47, 64, 1001 };
+
+    /*a counter where the low word carries into the high one inside an sse batch*/
+    const uint64_t counters[] = { 0, 5, 0xfffffffeull };
+
+    for (uint64_t counter : counters)
+    {
+        for (size_t count : counts)
+        {
+            std::vector<float> out(count + 1, 42.f);
+            Random::Fill(out.data(), count, RANDOM_TEXTURE_KEY, counter, -1.f, 1.f);
+
+            size_t different = 0;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                if (std::fabs(out[i] - expectedFill(RANDOM_TEXTURE_KEY, counter, i, -1.f, 1.f)) > 1e-6f)
+                    different++;
+
+                if (out[i] < -1.f || out[i] >= 1.f)
+                    different++;
+            }
+
+            if (different)
+            {
+                CHECK(different == 0);
+                printf("fill of %zu at counter %llu: %zu values differ\n", count, (unsigned long long)counter, different);
+            }
+
+            /*nothing written past count*/
+            CHECK(out[count] == 42.f);
+        }
+    }
+
+    /*counter based, a later part of the buffer is the fill from its block*/
+    std::vector<float> whole(100), part(60);
+    Random::Fill(whole.data(), whole.size(), 7, 3);
+    Random::Fill(part.data(), part.size(), 7, 3 + 10);
+
+    bool same = true;
+
+    for (size_t i = 0; i < part.size(); i++)
+    {
+        same = same && whole[40 + i] == part[i];
+    }
+
+    CHECK(same);
+}
+
+static void TestPcg32()
+{
+    /*pcg32-demo of pcg-c-basic, pcg32_srandom_r(&rng, 42u, 54u)*/
+    const uint32_t expected[] = { 0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e };
+
+    Pcg32 r(42, 54);
+
+    for (uint32_t e : expected)
+    {
+        uint32_t v = r.Next();
+
+        if (v != e)
+        {
+            CHECK(v == e);
+            printf("pcg32: %08x, expected %08x\n", v, e);
+        }
+    }
+
+    /*a copy is a snapshot*/
+    Pcg32 copy = r;
+    CHECK(copy.Next() == r.Next());
+
+    for (int i = 0; i < 1000; i++)
+    {
+        float f = r.Float();
+        CHECK(f >= 0.f && f < 1.f);
+    }
+}
+
+static void TestBelow()
+{
+    Pcg32 r(7, 1);
+
+    CHECK(r.Below(0) == 0 && r.Below(1) == 0);
+
+    /*chi squared over six faces, 20.5 is the 0.1 % bound of 5 degrees of freedom*/
+    const int draws = 600000;
+    int faces[6] = {};
+
+    for (int i = 0; i < draws; i++)
+    {
+        uint32_t v = r.Below(6);
+        CHECK(v < 6);
+
+        if (v < 6)
+            faces[v]++;
+    }
+
+    double chi = 0.0;
+
+    for (int f : faces)
+    {
+        chi += (f - draws / 6.0) * (f - draws / 6.0) / (draws / 6.0);
+    }
+
+    CHECK(chi < 20.5);
+
+    /*3 * 2^30: a plain modulo would make the lowest third twice as likely*/
+    const uint32_t n = 0xC0000000u;
+    int low = 0;
+
+    for (int i = 0; i < 300000; i++)
+    {
+        uint32_t v = r.Below(n);
+        CHECK(v < n);
+        low += v < 0x40000000u;
+    }
+
+    CHECK_NEAR(low / 300000.0, 1.0 / 3.0, 0.01);
+}
+
+static void TestStreams()
+{
+    auto draw = [](RandomStream stream, uint64_t index)
+    {
+        Pcg32 r = Random::Stream(stream, index);
+        std::vector<uint32_t> v(64);
+
+        for (uint32_t& x : v)
+        {
+            x = r.Next();
+        }
+
+        return v;
+    };
+
+    Random::Seed(0x5eed);
+    CHECK(Random::MatchSeed() == 0x5eed);
+
+    std::vector<uint32_t> ball = draw(RandomStream::Ball, 0);
+    std::vector<uint32_t> particles = draw(RandomStream::Particles, 0);
+    std::vector<uint32_t> second = draw(RandomStream::Particles, 1);
+    uint32_t shared = Random::Shared().Next();
+
+    /*other systems taking numbers in between change nothing*/
+    Random::Shared().Next();
+
+    Random::Seed(0x5eed);
+    CHECK(draw(RandomStream::Ball, 0) == ball);
+    CHECK(draw(RandomStream::Particles, 0) == particles);
+    CHECK(draw(RandomStream::Particles, 1) == second);
+    CHECK(Random::Shared().Next() == shared);
+
+    /*streams, indices and seeds are apart*/
+    CHECK(ball != particles && particles != second);
+
+    Random::Seed(0x5eee);
+    CHECK(draw(RandomStream::Ball, 0) != ball);
+}
+
+int main()
+{
+    TestPhilox();
+    TestFill();
+    TestPcg32();
+    TestBelow();
+    TestStreams();
+
+    return Result();
+}
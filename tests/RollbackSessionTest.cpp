@@ -0,0 +1,214 @@
+/*runs rollback sessions over a LoopbackNetwork with latency, jitter and
+  loss: every peer has to end up with the same state for every confirmed
+  frame, rollbacks stay short and the adaptive delay follows the latency*/
+
+#include "RollbackSession.h"
+#include "Check.h"
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+#define TEST_FRAMES 900
+
+struct TestState
+{
+    int32_t frame;
+    int32_t position[ROLLBACK_MAX_PLAYERS];
+    uint32_t hash;
+};
+
+/*a little physics per player, and a hash of every frame to compare the peers*/
+class TestGame : public RollbackGame
+{
+public:
+    TestGame() : hashes(TEST_FRAMES * 2, 0) { memset(&state, 0, sizeof(state)); }
+
+    void SaveState(void* s) override { memcpy(s, &state, sizeof(state)); }
+    void LoadState(const void* s) override { memcpy(&state, s, sizeof(state)); }
+
+    void Step(const NetInput* inputs, int players, bool replay) override
+    {
+        for (int p = 0; p < players; p++)
+        {
+            state.position[p] += inputs[p].moveX;
+
+            if (inputs[p].buttons & NET_BUTTON_JUMP)
+                state.position[p] = -state.position[p];
+
+            state.hash = state.hash * 31u + static_cast<uint32_t>(state.position[p]);
+        }
+
+        /*some work, so a rollback takes measurable time*/
+        volatile uint32_t work = state.hash;
+        for (int i = 0; i < 2000; i++)
+            work = work * 1664525u + 1013904223u;
+
+        state.frame++;
+        hashes[state.frame] = state.hash;
+        replayed += replay ? 1 : 0;
+    }
+
+    TestState state;
+
+    /*hash after every frame, replays overwrite mispredicted ones*/
+    std::vector<uint32_t> hashes;
+    int replayed = 0;
+};
+
+/*input of a player changes every few frames, so predictions fail*/
+static NetInput ScriptedInput(int player, int frame)
+{
+    uint32_t x = static_cast<uint32_t>(frame / (3 + player)) * 2654435761u + player * 40503u;
+    x ^= x >> 13;
+
+    NetInput in;
+    in.moveX = static_cast<int8_t>(static_cast<int>(x % 255) - 127);
+    in.buttons = (x >> 8) % 7 == 0 ? NET_BUTTON_JUMP : 0;
+    return in;
+}
+
+struct Run
+{
+    std::vector<std::unique_ptr<TestGame>> games;
+    std::vector<std::unique_ptr<RollbackSession>> sessions;
+    int confirmed = 0;
+};
+
+static Run Play(int players, const LoopbackSettings& settings, bool adaptive, int delay)
+{
+    LoopbackNetwork network(players, settings);
+    Run run;
+
+    std::vector<int> peers;
+    for (int p = 0; p < players; p++)
+        peers.push_back(p);
+
+    for (int p = 0; p < players; p++)
+    {
+        run.games.push_back(std::make_unique<TestGame>());
+        run.sessions.push_back(std::make_unique<RollbackSession>(run.games[p].get(), sizeof(TestState), network.Endpoint(p),
+                                                                 players, p, peers, delay));
+        run.sessions[p]->SetAdaptiveDelay(adaptive);
+    }
+
+    /*all peers step at 60 hz, a stalled peer just waits for the next tick*/
+    for (int tick = 0; tick < TEST_FRAMES; tick++)
+    {
+        for (int p = 0; p < players; p++)
+        {
+            RollbackSession& s = *run.sessions[p];
+            s.AddLocalInput(ScriptedInput(p, s.Frame() + s.InputDelay()));
+            s.Advance();
+        }
+
+        network.Advance(1000.0 / 60.0);
+    }
+
+    run.confirmed = run.sessions[0]->ConfirmedFrame();
+
+    for (auto& s : run.sessions)
+        run.confirmed = std::min(run.confirmed, s->ConfirmedFrame());
+
+    return run;
+}
+
+/*a frame whose inputs every peer knows hashes the same on every peer*/
+static void CheckConverged(const Run& run)
+{
+    CHECK(run.confirmed > TEST_FRAMES / 2);
+
+    int mismatches = 0;
+
+    for (int f = 1; f <= run.confirmed; f++)
+    {
+        for (size_t p = 1; p < run.games.size(); p++)
+        {
+            if (run.games[p]->hashes[f] != run.games[0]->hashes[f])
+                mismatches++;
+        }
+    }
+
+    CHECK(mismatches == 0);
+}
+
+static void CheckRollbacks(const Run& run, const char* name)
+{
+    for (size_t p = 0; p < run.sessions.size(); p++)
+    {
+        const RollbackStats& st = run.sessions[p]->Stats();
+
+        printf("%s peer %zu: %llu frames, %llu rollbacks, %llu resimulated, max %d frames / %.3f ms, %llu stalls, delay %d (recommended %d)\n",
+               name, p, st.frames, st.rollbacks, st.resimulatedFrames, st.maxRollbackFrames, st.maxRollbackMs, st.stalls,
+               run.sessions[p]->InputDelay(), run.sessions[p]->RecommendedDelay());
+
+        CHECK(st.maxRollbackFrames <= ROLLBACK_MAX_FRAMES);
+
+        /*at most ROLLBACK_MAX_FRAMES cheap steps, far below one frame of the game*/
+        CHECK(st.maxRollbackMs < 1000.0 * ROLLBACK_STEP);
+        CHECK(st.resimulatedFrames == static_cast<unsigned long long>(run.games[p]->replayed));
+    }
+}
+
+static void TestLossyNetwork()
+{
+    LoopbackSettings settings;
+    settings.latencyMs = 50.0;
+    settings.jitterMs = 15.0;
+    settings.loss = 0.1;
+    settings.seed = 7;
+
+    Run fixed = Play(3, settings, false, 0);
+    CheckConverged(fixed);
+    CheckRollbacks(fixed, "lossy fixed");
+
+    Run adaptive = Play(3, settings, true, 0);
+    CheckConverged(adaptive);
+    CheckRollbacks(adaptive, "lossy adaptive");
+
+    unsigned long long fixedRollbacks = 0, adaptiveRollbacks = 0;
+
+    for (int p = 0; p < 3; p++)
+    {
+        fixedRollbacks += fixed.sessions[p]->Stats().resimulatedFrames;
+        adaptiveRollbacks += adaptive.sessions[p]->Stats().resimulatedFrames;
+
+        /*no delay for 50 ms one way has to roll back*/
+        CHECK(fixed.sessions[p]->Stats().rollbacks > 0);
+        CHECK(fixed.sessions[p]->InputDelay() == 0);
+
+        /*the delay grew to the latency*/
+        int delay = adaptive.sessions[p]->InputDelay();
+        int recommended = adaptive.sessions[p]->RecommendedDelay();
+
+        CHECK(delay >= ROLLBACK_INPUT_DELAY);
+        CHECK(delay >= recommended - 1 && delay <= recommended + 1);
+    }
+
+    /*a delay that hides the latency leaves less to simulate again*/
+    CHECK(adaptiveRollbacks < fixedRollbacks);
+}
+
+static void TestFastNetwork()
+{
+    LoopbackSettings settings;
+    settings.seed = 3;
+
+    /*nothing to hide, the adaptive delay shrinks from the default*/
+    Run run = Play(2, settings, true, ROLLBACK_INPUT_DELAY + 2);
+    CheckConverged(run);
+    CheckRollbacks(run, "fast adaptive");
+
+    for (auto& s : run.sessions)
+    {
+        CHECK(s->InputDelay() <= ROLLBACK_INPUT_DELAY);
+        CHECK(s->Stats().stalls == 0);
+    }
+}
+
+int main()
+{
+    TestLossyNetwork();
+    TestFastNetwork();
+
+    return Result();
+}
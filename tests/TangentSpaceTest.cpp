@@ -0,0 +1,293 @@
+/*checks generated tangents against the mikktspace result of flat and
+  cylindrical uv mappings: the tangent follows the u direction of the faces
+  and w * cross(normal, tangent) the v direction, also across mirror seams*/
+
+#include "TangentSpace.h"
+#include "Check.h"
+#include <cmath>
+
+struct Vec
+{
+    float x, y, z;
+};
+
+static Vec Sub(const float* a, const float* b) { return { a[0] - b[0], a[1] - b[1], a[2] - b[2] }; }
+static float Dot(Vec a, Vec b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static Vec Cross(Vec a, Vec b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+static Vec Scale(Vec a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+
+static Vec Normalize(Vec a)
+{
+    float l = sqrtf(Dot(a, a));
+    return l > 0.f ? Scale(a, 1.f / l) : a;
+}
+
+static TangentVertex MakeVertex(float x, float y, float z, float u, float v)
+{
+    TangentVertex t = {};
+    t.position[0] = x; t.position[1] = y; t.position[2] = z;
+    t.uv[0] = u; t.uv[1] = v;
+    return t;
+}
+
+/*every corner of a face with uv area has a unit tangent perpendicular to
+  its normal, close to the u direction of the face, and a bitangent close
+  to the v direction, minDot is the cosine of the allowed angle*/
+static void CheckFrames(const std::vector<TangentVertex>& vertices, const std::vector<unsigned int>& indices, float minDot)
+{
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const TangentVertex& a = vertices[indices[i]];
+        const TangentVertex& b = vertices[indices[i + 1]];
+        const TangentVertex& c = vertices[indices[i + 2]];
+
+        Vec e1 = Sub(b.position, a.position);
+        Vec e2 = Sub(c.position, a.position);
+
+        float du1 = b.uv[0] - a.uv[0], dv1 = b.uv[1] - a.uv[1];
+        float du2 = c.uv[0] - a.uv[0], dv2 = c.uv[1] - a.uv[1];
+        float det = du1 * dv2 - du2 * dv1;
+
+        if (fabsf(det) < 1e-12f)
+            continue;
+
+        Vec dpdu = Normalize(Scale({ e1.x * dv2 - e2.x * dv1, e1.y * dv2 - e2.y * dv1, e1.z * dv2 - e2.z * dv1 }, 1.f / det));
+        Vec dpdv = Normalize(Scale({ e2.x * du1 - e1.x * du2, e2.y * du1 - e1.y * du2, e2.z * du1 - e1.z * du2 }, 1.f / det));
+
+        for (int k = 0; k < 3; k++)
+        {
+            const TangentVertex& v = vertices[indices[i + k]];
+
+            Vec n = { v.normal[0], v.normal[1], v.normal[2] };
+            Vec t = { v.tangent[0], v.tangent[1], v.tangent[2] };
+            Vec bitangent = Scale(Cross(n, t), v.tangent[3]);
+
+            CHECK_NEAR(Dot(t, t), 1.0, 1e-4);
+            CHECK_NEAR(Dot(t, n), 0.0, 1e-4);
+            CHECK(v.tangent[3] == 1.f || v.tangent[3] == -1.f);
+            CHECK(Dot(t, dpdu) > minDot);
+            CHECK(Dot(bitangent, dpdv) > minDot);
+        }
+    }
+}
+
+/*quad in the xz plane from x0 to x1, u runs from u0 to u1 along x and v along z*/
+static void AddQuad(std::vector<TangentVertex>& vertices, std::vector<unsigned int>& indices, float x0, float x1, float u0, float u1)
+{
+    unsigned int first = (unsigned int)vertices.size();
+
+    vertices.push_back(MakeVertex(x0, 0.f, 0.f, u0, 0.f));
+    vertices.push_back(MakeVertex(x0, 0.f, 1.f, u0, 1.f));
+    vertices.push_back(MakeVertex(x1, 0.f, 1.f, u1, 1.f));
+    vertices.push_back(MakeVertex(x1, 0.f, 0.f, u1, 0.f));
+
+    indices.insert(indices.end(), { first, first + 1, first + 3, first + 3, first + 1, first + 2 });
+}
+
+static void TestQuad()
+{
+    std::vector<TangentVertex> vertices;
+    std::vector<unsigned int> indices;
+    AddQuad(vertices, indices, 0.f, 1.f, 0.f, 1.f);
+
+    TangentSpaceReport r = TangentSpace::Process(vertices, indices);
+
+    CHECK(r.hasTextureCoordinates);
+    CHECK(r.normalsGenerated);
+    CHECK(r.tangentsGenerated);
+    CHECK(r.splitVertices == 0);
+    CHECK(vertices.size() == 4);
+
+    /*faces up, u along x and v along z: a left handed frame*/
+    for (auto& v : vertices)
+    {
+        CHECK_NEAR(v.normal[1], 1.0, 1e-6);
+        CHECK_NEAR(v.tangent[0], 1.0, 1e-6);
+        CHECK(v.tangent[3] == -1.f);
+    }
+
+    CheckFrames(vertices, indices, 0.9999f);
+}
+
+/*two quads sharing an edge, the second one has its u mirrored at the edge*/
+static void TestMirroredQuads()
+{
+    std::vector<TangentVertex> vertices;
+    std::vector<unsigned int> indices;
+    AddQuad(vertices, indices, 0.f, 1.f, 0.f, 1.f);
+    AddQuad(vertices, indices, 1.f, 2.f, 1.f, 0.f);
+
+    /*weld the shared edge like an exporter does for identical vertices*/
+    for (auto& i : indices)
+    {
+        if (i == 4) i = 3;
+        if (i == 5) i = 2;
+    }
+
+    TangentSpaceReport r = TangentSpace::Process(vertices, indices);
+
+    /*both vertices of the seam exist once for each side*/
+    CHECK(r.splitVertices == 2);
+    CHECK(vertices.size() == 10);
+
+    for (size_t i = 0; i < 6; i++)
+    {
+        CHECK(indices[i] != 8 && indices[i] != 9);
+    }
+
+    for (size_t i = 6; i < 12; i++)
+    {
+        CHECK(indices[i] != 2 && indices[i] != 3);
+    }
+
+    for (size_t i = 8; i < 10; i++)
+    {
+        CHECK(vertices[i].position[0] == 1.f);
+        CHECK(vertices[i].uv[0] == 1.f);
+    }
+
+    /*the mirrored side points its tangent back and flips the sign, the bitangent stays*/
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        const TangentVertex& v = vertices[indices[i]];
+        bool mirrored = i >= 6;
+
+        CHECK_NEAR(v.tangent[0], mirrored ? -1.0 : 1.0, 1e-6);
+        CHECK(v.tangent[3] == (mirrored ? 1.f : -1.f));
+    }
+
+    CheckFrames(vertices, indices, 0.9999f);
+}
+
+/*closed ring of quads around y, u goes around and back so there are mirror seams at both ends*/
+static void TestMirroredCylinder()
+{
+    const int segments = 8;
+    const float pi = 3.14159265f;
+
+    std::vector<TangentVertex> vertices;
+    std::vector<unsigned int> indices;
+
+    for (int j = 0; j < segments; j++)
+    {
+        float a = 2.f * pi * j / segments;
+        float u = (float)(j <= segments / 2 ? j : segments - j) / (segments / 2);
+
+        vertices.push_back(MakeVertex(cosf(a), 0.f, sinf(a), u, 1.f));
+        vertices.push_back(MakeVertex(cosf(a), 1.f, sinf(a), u, 0.f));
+    }
+
+    for (unsigned int j = 0; j < (unsigned int)segments; j++)
+    {
+        unsigned int a = j * 2, b = ((j + 1) % segments) * 2;
+        indices.insert(indices.end(), { a, a + 1, b, b, a + 1, b + 1 });
+    }
+
+    TangentSpaceReport r = TangentSpace::Process(vertices, indices);
+
+    /*the columns at u = 0 and u = 1 are split*/
+    CHECK(r.splitVertices == 4);
+    CHECK(vertices.size() == segments * 2 + 4);
+
+    /*seam vertices only see the faces of their side, 22.5 degrees off the circle*/
+    CheckFrames(vertices, indices, cosf(pi / segments) - 1e-3f);
+
+    /*smooth vertices lie exactly on the circle tangent*/
+    for (int j = 1; j < segments / 2; j++)
+    {
+        float a = 2.f * pi * j / segments;
+        Vec circle = { -sinf(a), 0.f, cosf(a) };
+        Vec t = { vertices[j * 2].tangent[0], vertices[j * 2].tangent[1], vertices[j * 2].tangent[2] };
+
+        CHECK(Dot(t, circle) > 0.9999f);
+    }
+
+    /*generating again keeps everything*/
+    std::vector<TangentVertex> again = vertices;
+    std::vector<unsigned int> againIndices = indices;
+    TangentSpaceReport r2 = TangentSpace::Process(again, againIndices);
+
+    CHECK(!r2.normalsGenerated);
+    CHECK(!r2.tangentsGenerated);
+    CHECK(r2.splitVertices == 0);
+    CHECK(againIndices == indices);
+
+    for (size_t i = 0; i < again.size(); i++)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            CHECK(again[i].tangent[k] == vertices[i].tangent[k]);
+        }
+    }
+}
+
+/*valid stored tangents are kept, they only get the handedness*/
+static void TestStoredTangents()
+{
+    std::vector<TangentVertex> vertices;
+    std::vector<unsigned int> indices;
+    AddQuad(vertices, indices, 0.f, 1.f, 0.f, 1.f);
+
+    for (auto& v : vertices)
+    {
+        v.normal[1] = 1.f;
+        v.tangent[0] = 0.8f; v.tangent[2] = 0.6f;
+    }
+
+    TangentSpaceReport r = TangentSpace::Process(vertices, indices);
+
+    CHECK(!r.normalsGenerated);
+    CHECK(!r.tangentsGenerated);
+
+    for (auto& v : vertices)
+    {
+        CHECK(v.tangent[0] == 0.8f && v.tangent[2] == 0.6f);
+        CHECK(v.tangent[3] == -1.f);
+    }
+
+    /*a broken normal regenerates both*/
+    vertices[0].normal[1] = NAN;
+    r = TangentSpace::Process(vertices, indices);
+
+    CHECK(r.normalsGenerated);
+    CHECK(r.tangentsGenerated);
+    CheckFrames(vertices, indices, 0.9999f);
+}
+
+static void TestWithoutTextureCoordinates()
+{
+    std::vector<TangentVertex> vertices;
+    std::vector<unsigned int> indices;
+    AddQuad(vertices, indices, 0.f, 1.f, 0.f, 0.f);
+
+    for (auto& v : vertices)
+    {
+        v.uv[1] = 0.f;
+    }
+
+    TangentSpaceReport r = TangentSpace::Process(vertices, indices);
+
+    CHECK(!r.hasTextureCoordinates);
+    CHECK(r.splitVertices == 0);
+
+    for (auto& v : vertices)
+    {
+        Vec n = { v.normal[0], v.normal[1], v.normal[2] };
+        Vec t = { v.tangent[0], v.tangent[1], v.tangent[2] };
+
+        CHECK_NEAR(Dot(t, t), 1.0, 1e-6);
+        CHECK_NEAR(Dot(t, n), 0.0, 1e-6);
+        CHECK(v.tangent[3] == 1.f);
+    }
+}
+
+int main()
+{
+    TestQuad();
+    TestMirroredQuads();
+    TestMirroredCylinder();
+    TestStoredTangents();
+    TestWithoutTextureCoordinates();
+
+    return Result();
+}
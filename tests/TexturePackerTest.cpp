@@ -0,0 +1,165 @@
+/*packs the textures of the game into a temporary directory and compares
+  every texel of every mip of the written pages, gutters included, with
+  the texture it came from. the manifest has to find every texture on its
+  page, rects must not overlap and an empty packer writes nothing*/
+
+#include "TexturePacker.h"
+#include "Check.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#define TEST_TEXTURES REPO_DIR "/data/textures"
+
+static std::vector<uint8_t> readFile(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static bool overlap(const AtlasRect& a, const AtlasRect& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+/*texels that differ between the rect of a page and its source, gutters are the repeated edge blocks*/
+static int compare(const std::vector<uint8_t>& page, const DdsLayout& pageLayout, const AtlasRect& r,
+                   const std::vector<uint8_t>& source, const DdsLayout& sourceLayout)
+{
+    /*blocks of compressed formats, texels otherwise*/
+    uint32_t unit = sourceLayout.blockCompressed ? 4 : 1;
+    uint32_t bytes = sourceLayout.blockCompressed ? sourceLayout.bitsPerTexel * 2 : sourceLayout.bitsPerTexel / 8;
+    uint32_t cell = 4 << (pageLayout.mips - 1);
+
+    int different = 0;
+
+    for (uint32_t m = 0; m < pageLayout.mips; m++)
+    {
+        const DdsSubresource& s = sourceLayout.Subresource(m, 0);
+        const DdsSubresource& d = pageLayout.Subresource(m, 0);
+
+        int cols = (r.width >> m) / unit, rows = (r.height >> m) / unit;
+        int gutter = (cell >> m) / unit;
+        size_t x = (r.x >> m) / unit, y = (r.y >> m) / unit;
+
+        for (int ry = -gutter; ry < rows + gutter; ry++)
+        {
+            for (int rx = -gutter; rx < cols + gutter; rx++)
+            {
+                int sy = std::clamp(ry, 0, rows - 1), sx = std::clamp(rx, 0, cols - 1);
+
+                const uint8_t* a = page.data() + d.offset + (y + ry) * d.rowPitch + (x + rx) * bytes;
+                const uint8_t* b = source.data() + s.offset + sy * s.rowPitch + sx * bytes;
+
+                if (memcmp(a, b, bytes) != 0)
+                    different++;
+            }
+        }
+    }
+
+    return different;
+}
+
+int main()
+{
+    std::filesystem::path out = std::filesystem::temp_directory_path() / "TexturePackerTest";
+    std::filesystem::remove_all(out);
+
+    TexturePacker packer;
+
+    for (auto& entry : std::filesystem::directory_iterator(TEST_TEXTURES))
+    {
+        if (entry.path().extension() == ".dds")
+            packer.Add(entry.path().stem().string(), entry.path().string());
+    }
+
+    CHECK(packer.Pack());
+    CHECK(!packer.Pages().empty());
+    CHECK(packer.Write(out.string()));
+
+    TextureAtlas atlas;
+    CHECK(atlas.Read((out / TEXTURE_ATLAS_MANIFEST).string()));
+
+    size_t textures = 0;
+
+    for (const AtlasPage& page : packer.Pages())
+    {
+        CHECK(page.textures.size() == page.rects.size());
+
+        for (int normal = 0; normal < 2; normal++)
+        {
+            if (normal && page.normalId.empty())
+                continue;
+
+            std::vector<uint8_t> file = readFile((out / ((normal ? page.normalId : page.id) + ".dds")).string());
+
+            DdsLayout l;
+            bool ok = ParseDds(file.data(), file.size(), file.size(), l);
+            CHECK(ok);
+
+            if (!ok)
+                continue;
+
+            CHECK(l.width == page.width && l.height == page.height && l.mips == page.mips);
+            CHECK(l.format == (normal ? page.normalFormat : page.format));
+            CHECK(l.dataOffset + l.dataBytes == file.size());
+
+            for (size_t t = 0; t < page.textures.size(); t++)
+            {
+                const AtlasRect& r = page.rects[t];
+                std::string id = page.textures[t];
+                std::string normalId = page.normalId.empty() ? "" : id + TEXTURE_ATLAS_NORMAL_SUFFIX;
+
+                if (!normal)
+                {
+                    for (size_t u = t + 1; u < page.textures.size(); u++)
+                    {
+                        CHECK(!overlap(r, page.rects[u]));
+                    }
+
+                    AtlasPlacement p;
+                    CHECK(atlas.Find(id, normalId, p) && p.page == page.id && p.normalPage == page.normalId);
+                    CHECK_NEAR(p.offset[0], (double)r.x / page.width, 1e-6);
+                    CHECK_NEAR(p.scale[1], (double)r.height / page.height, 1e-6);
+                    textures++;
+                }
+
+                std::string sourceId = normal ? normalId : id;
+                std::vector<uint8_t> source = readFile(TEST_TEXTURES "/" + sourceId + ".dds");
+
+                DdsLayout sl;
+                CHECK(ParseDds(source.data(), source.size(), source.size(), sl));
+                CHECK(sl.format == l.format && sl.mips >= l.mips);
+
+                int different = compare(file, l, r, source, sl);
+
+                if (different)
+                {
+                    printf("%s: %d texels differ\n", sourceId.c_str(), different);
+                    CHECK(different == 0);
+                }
+            }
+        }
+    }
+
+    CHECK(textures == atlas.Size());
+
+    /*a normal map only goes with its own texture*/
+    for (const AtlasPage& page : packer.Pages())
+    {
+        for (const std::string& id : page.textures)
+        {
+            AtlasPlacement p;
+            CHECK(!atlas.Find(id, id + "_other" TEXTURE_ATLAS_NORMAL_SUFFIX, p));
+        }
+    }
+
+    /*nothing to pack*/
+    TexturePacker empty;
+    CHECK(!empty.Pack());
+
+    std::filesystem::remove_all(out);
+
+    return Result();
+}
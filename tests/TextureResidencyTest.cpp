@@ -0,0 +1,312 @@
+/*runs the residency policy without a device: the first use queues a load,
+  TakeLoads hands them out in the order of first use up to its limit, the
+  least recently used textures are evicted first, pinned ones and those used
+  in the last TEXTURE_KEEP_FRAMES frames stay over the budget, failed loads
+  are never queued again and the resident bytes and the report add up*/
+
+#include "TextureResidency.h"
+#include "DdsParser.h"
+#include "Check.h"
+#include <random>
+
+#define TEST_TEXTURES REPO_DIR "/data/textures"
+
+/*use, load and mark as loaded, like a frame of TextureCollection*/
+static void load(TextureResidency& r, const std::string& id)
+{
+    r.Use(id);
+
+    for (auto& loaded : r.TakeLoads(TEXTURE_LOADS_PER_FRAME))
+    {
+        r.Loaded(loaded, true);
+    }
+}
+
+static bool resident(const TextureResidency& r, const std::string& id)
+{
+    const TextureEntry* e = r.Find(id);
+    return e && e->resident;
+}
+
+static void TestLoads()
+{
+    TextureResidency r(1024);
+
+    CHECK(r.Register("a", "a.dds", 100));
+    CHECK(r.Register("b", "b.dds", 100));
+    CHECK(r.Register("c", "c.dds", 100));
+    CHECK(r.Register("d", "d.dds", 100));
+    CHECK(r.Register("e", "e.dds", 100));
+    CHECK(r.Register("f", "f.dds", 100));
+    CHECK(!r.Register("a", "other.dds", 5));
+    CHECK(r.Find("a")->file == "a.dds" && r.Find("a")->bytes == 100);
+    CHECK(!r.Find("missing"));
+
+    /*not resident, the first use queues the load*/
+    CHECK(!r.Use("c"));
+    CHECK(!r.Use("a"));
+    CHECK(!r.Use("e"));
+    CHECK(!r.Use("c"));
+    CHECK(!r.Use("b"));
+    CHECK(!r.Use("f"));
+    CHECK(!r.Use("missing"));
+    CHECK(r.Find("c")->queued && !r.Find("d")->queued);
+
+    /*in the order of the first use, each once, up to the limit*/
+    CHECK(r.TakeLoads(2) == std::vector<std::string>({ "c", "a" }));
+    CHECK(r.TakeLoads(TEXTURE_LOADS_PER_FRAME) == std::vector<std::string>({ "e", "b", "f" }));
+    CHECK(r.TakeLoads(TEXTURE_LOADS_PER_FRAME).empty());
+    CHECK(r.TakeLoads(0).empty());
+
+    /*taken but not loaded yet isn't queued twice*/
+    CHECK(!r.Use("c"));
+    CHECK(r.TakeLoads(TEXTURE_LOADS_PER_FRAME).empty());
+
+    /*the size of the loaded texture replaces the one of the header*/
+    r.Loaded("c", true, 150);
+    CHECK(r.Use("c"));
+    CHECK(!r.Find("c")->queued);
+    CHECK(r.ResidentBytes() == 150 && r.ResidentCount() == 1 && r.LoadCount() == 1);
+
+    /*loaded twice counts once*/
+    r.Loaded("c", true);
+    CHECK(r.ResidentBytes() == 150 && r.ResidentCount() == 1 && r.LoadCount() == 1);
+
+    r.Loaded("missing", true);
+    CHECK(r.ResidentCount() == 1);
+
+    CHECK(r.Frame() == 1);
+    r.NextFrame();
+    CHECK(r.Frame() == 2);
+    CHECK(r.Use("c") && r.Find("c")->lastUse == 2);
+}
+
+static void TestEviction()
+{
+    TextureResidency r(300);
+    const std::vector<std::string> ids = { "t0", "t1", "t2", "t3", "t4" };
+
+    for (auto& id : ids)
+    {
+        r.Register(id, id + ".dds", 100);
+        load(r, id);
+    }
+
+    CHECK(r.ResidentBytes() == 500 && r.ResidentCount() == 5);
+
+    /*all used in this frame*/
+    CHECK(r.Evict().empty());
+
+    r.NextFrame();
+    CHECK(r.Use("t0"));
+    CHECK(r.Use("t2"));
+    CHECK(r.Evict().empty());
+
+    /*t1, t3 and t4 are old enough, t0 and t2 were used last*/
+    r.NextFrame();
+    r.NextFrame();
+    CHECK(r.Use("t3"));
+    r.NextFrame();
+
+    CHECK(r.Evict() == std::vector<std::string>({ "t1", "t4" }));
+    CHECK(r.ResidentBytes() == 300 && r.ResidentCount() == 3 && r.EvictionCount() == 2);
+    CHECK(!resident(r, "t1") && !resident(r, "t4") && resident(r, "t0") && resident(r, "t2") && resident(r, "t3"));
+
+    /*within the budget nothing goes*/
+    CHECK(r.Evict().empty());
+
+    /*a smaller budget takes the least recently used first*/
+    r.SetBudget(100);
+    CHECK(r.Budget() == 100);
+    CHECK(r.Evict() == std::vector<std::string>({ "t0", "t2" }));
+    CHECK(r.ResidentBytes() == 100 && resident(r, "t3"));
+
+    /*an evicted texture is loaded again at its next use*/
+    CHECK(!r.Use("t1"));
+    CHECK(r.TakeLoads(TEXTURE_LOADS_PER_FRAME) == std::vector<std::string>({ "t1" }));
+    r.Loaded("t1", true);
+    CHECK(r.Use("t1") && r.LoadCount() == 6);
+}
+
+static void TestKeep()
+{
+    TextureResidency r(100);
+    r.Register("pinned", "pinned.dds", 200);
+    r.Register("used", "used.dds", 200);
+    r.Register("old", "old.dds", 50);
+
+    r.Pin("pinned");
+    CHECK(r.Find("pinned")->pinned);
+    r.Pin("missing");
+
+    load(r, "old");
+    load(r, "pinned");
+    load(r, "used");
+
+    /*the budget is exceeded instead: pinned never goes, used is used every frame, only old goes*/
+    std::vector<std::string> evicted;
+
+    for (int f = 0; f < 10; f++)
+    {
+        r.NextFrame();
+        CHECK(r.Use("used"));
+
+        for (auto& id : r.Evict())
+        {
+            evicted.push_back(id);
+        }
+    }
+
+    CHECK(evicted == std::vector<std::string>({ "old" }));
+    CHECK(r.ResidentBytes() == 400 && r.ResidentBytes() > r.Budget());
+
+    /*used stays for TEXTURE_KEEP_FRAMES frames after its last use*/
+    uint64_t lastUse = r.Frame();
+
+    while (r.Frame() < lastUse + TEXTURE_KEEP_FRAMES)
+    {
+        r.NextFrame();
+
+        if (r.Frame() < lastUse + TEXTURE_KEEP_FRAMES)
+            CHECK(r.Evict().empty());
+    }
+
+    CHECK(r.Evict() == std::vector<std::string>({ "used" }));
+    CHECK(r.ResidentBytes() == 200 && resident(r, "pinned"));
+
+    /*unpinned it is like any other*/
+    r.Pin("pinned", false);
+    CHECK(r.Evict() == std::vector<std::string>({ "pinned" }));
+    CHECK(r.ResidentBytes() == 0 && r.ResidentCount() == 0);
+}
+
+static void TestFailed()
+{
+    TextureResidency r;
+    r.Register("broken", "broken.dds", 100);
+    r.Register("fine", "fine.dds", 100);
+
+    CHECK(!r.Use("broken"));
+    CHECK(!r.Use("fine"));
+
+    for (auto& id : r.TakeLoads(TEXTURE_LOADS_PER_FRAME))
+    {
+        r.Loaded(id, id != "broken");
+    }
+
+    CHECK(r.Find("broken")->failed && !r.Find("broken")->queued && !resident(r, "broken"));
+    CHECK(r.ResidentBytes() == 100 && r.LoadCount() == 1);
+
+    /*the placeholder stays, the load isn't tried again*/
+    for (int f = 0; f < 10; f++)
+    {
+        r.NextFrame();
+        CHECK(!r.Use("broken"));
+        CHECK(r.Use("fine"));
+        CHECK(r.TakeLoads(TEXTURE_LOADS_PER_FRAME).empty());
+    }
+
+    CHECK(r.ResidentBytes() == 100 && r.ResidentCount() == 1 && r.LoadCount() == 1);
+}
+
+/*resident bytes are the sum over the resident entries after every step of random frames*/
+static void TestAccounting()
+{
+    TextureResidency r(2000);
+    std::vector<std::string> ids;
+
+    for (int i = 0; i < 20; i++)
+    {
+        ids.push_back("t" + std::to_string(i));
+        r.Register(ids.back(), ids.back() + ".dds", 100 + 37 * i);
+    }
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<size_t> pick(0, ids.size() - 1);
+    uint64_t loads = 0, evictions = 0;
+    bool consistent = true;
+
+    for (int f = 0; f < 500; f++)
+    {
+        for (int u = 0; u < 6; u++)
+        {
+            r.Use(ids[pick(rng)]);
+        }
+
+        if (f == 100)
+            r.Pin(ids[3]);
+
+        for (auto& id : r.TakeLoads(TEXTURE_LOADS_PER_FRAME))
+        {
+            /*sometimes the texture is larger than its header said*/
+            r.Loaded(id, true, rng() % 4 == 0 ? r.Find(id)->bytes + 10 : 0);
+            loads++;
+        }
+
+        evictions += r.Evict().size();
+        r.NextFrame();
+
+        uint64_t bytes = 0;
+        size_t count = 0;
+
+        for (auto& id : ids)
+        {
+            if (resident(r, id))
+            {
+                bytes += r.Find(id)->bytes;
+                count++;
+            }
+        }
+
+        consistent = consistent && bytes == r.ResidentBytes() && count == r.ResidentCount();
+    }
+
+    CHECK(consistent);
+    CHECK(r.LoadCount() == loads && r.EvictionCount() == evictions);
+    CHECK(evictions > 0);
+}
+
+static void TestReport()
+{
+    TextureResidency r(1024 * 1024);
+    r.Register("small", "small.dds", 2048);
+    r.Register("large", "large.dds", 10240);
+    r.Register("unused", "unused.dds", 4096);
+
+    load(r, "small");
+    r.Pin("large");
+    load(r, "large");
+    r.NextFrame();
+    r.Use("small");
+
+    /*largest first*/
+    std::wstring expected =
+        L"Textures: 2 of 3 resident, 12 KB of 1024 KB budget, 2 loads, 0 evictions\n"
+        L"  large: 10 KB, used in frame 1, pinned\n"
+        L"  small: 2 KB, used in frame 2\n";
+
+    std::wstring report = r.Report();
+    CHECK(report == expected);
+
+    if (report != expected)
+        printf("%ls", report.c_str());
+
+    /*the size of a game texture from its header*/
+    uint64_t bytes = 0;
+    DdsLayout layout;
+    CHECK(TextureResidency::DdsBytes(TEST_TEXTURES "/bricks.dds", bytes));
+    CHECK(ReadDdsLayout(TEST_TEXTURES "/bricks.dds", layout) && bytes == layout.dataBytes && bytes > 0);
+    CHECK(!TextureResidency::DdsBytes(TEST_TEXTURES "/missing.dds", bytes));
+}
+
+int main()
+{
+    TestLoads();
+    TestEviction();
+    TestKeep();
+    TestFailed();
+    TestAccounting();
+    TestReport();
+
+    return Result();
+}
@@ -0,0 +1,189 @@
+/*lays out split screens in odd window sizes: the views tile the window
+  pixel by pixel, their slots in the atlas keep the gutter to each other and
+  to the edges, targets round and clamp with the scale, the uv inset puts
+  the outer screen pixels on the outer texel centers and Used() is the
+  bounding box of the targets*/
+
+#include "ViewportLayout.h"
+#include "Check.h"
+#include <algorithm>
+#include <vector>
+
+struct Split
+{
+    int width, height, columns, rows;
+};
+
+static const Split splits[] =
+{
+    { 641, 479, 1, 1 }, { 641, 479, 2, 1 }, { 641, 479, 1, 2 }, { 1279, 721, 2, 2 }, { 1001, 997, 3, 3 }, { 7, 5, 3, 2 }
+};
+
+/*gap between two rects along x or y, negative when they overlap in both*/
+static int gap(const ViewportRect& a, const ViewportRect& b)
+{
+    int gx = std::max(b.x - (a.x + a.width), a.x - (b.x + b.width));
+    int gy = std::max(b.y - (a.y + a.height), a.y - (b.y + b.height));
+    return std::max(gx, gy);
+}
+
+static void TestTiling()
+{
+    for (const Split& split : splits)
+    {
+        ViewportLayout layout;
+        layout.Build(split.width, split.height, split.columns, split.rows);
+        CHECK(layout.Views() == split.columns * split.rows);
+
+        /*every pixel of the window belongs to exactly one view*/
+        std::vector<int> covered(split.width * split.height, 0);
+
+        for (int v = 0; v < layout.Views(); v++)
+        {
+            const ViewportRect& s = layout.Screen(v);
+
+            for (int y = s.y; y < s.y + s.height; y++)
+            {
+                for (int x = s.x; x < s.x + s.width; x++)
+                {
+                    if (x >= 0 && y >= 0 && x < split.width && y < split.height)
+                        covered[y * split.width + x]++;
+                }
+            }
+
+            /*views of a row and of a column differ by one pixel at most*/
+            CHECK(std::abs(s.width - split.width / split.columns) <= 1);
+            CHECK(std::abs(s.height - split.height / split.rows) <= 1);
+        }
+
+        CHECK(std::all_of(covered.begin(), covered.end(), [](int c) { return c == 1; }));
+
+        /*slots at full scale keep the gutter to each other and to the atlas edges*/
+        CHECK(layout.AtlasWidth() == split.width + (split.columns + 1) * VIEWPORT_GUTTER);
+        CHECK(layout.AtlasHeight() == split.height + (split.rows + 1) * VIEWPORT_GUTTER);
+
+        for (int v = 0; v < layout.Views(); v++)
+        {
+            ViewportRect a = layout.Target(v);
+            const ViewportRect& s = layout.Screen(v);
+
+            CHECK(a.width == s.width && a.height == s.height);
+            CHECK(a.x >= VIEWPORT_GUTTER && a.y >= VIEWPORT_GUTTER);
+            CHECK(a.x + a.width + VIEWPORT_GUTTER <= layout.AtlasWidth());
+            CHECK(a.y + a.height + VIEWPORT_GUTTER <= layout.AtlasHeight());
+
+            for (int w = v + 1; w < layout.Views(); w++)
+            {
+                CHECK(gap(a, layout.Target(w)) >= VIEWPORT_GUTTER);
+            }
+        }
+    }
+}
+
+static void TestScale()
+{
+    ViewportLayout layout;
+    layout.Build(641, 479, 2, 1);
+
+    /*the left view is 320 x 479, the right one 321 x 479*/
+    CHECK(layout.Screen(0).width == 320 && layout.Screen(1).width == 321);
+
+    /*round half up*/
+    layout.SetScale(1, 0.5f);
+    CHECK(layout.Target(1).width == 161 && layout.Target(1).height == 240);
+    CHECK(layout.Target(1).x == layout.Screen(1).x + 2 * VIEWPORT_GUTTER);
+
+    layout.SetScale(0, 0.7f);
+    CHECK(layout.Target(0).width == 224 && layout.Target(0).height == 335);
+
+    /*clamped to VIEWPORT_MIN_SCALE - 1*/
+    layout.SetScale(0, 0.01f);
+    CHECK(layout.Scale(0) == VIEWPORT_MIN_SCALE);
+    CHECK(layout.Target(0).width == 80 && layout.Target(0).height == 120);
+
+    layout.SetScale(0, 3.f);
+    CHECK(layout.Scale(0) == 1.f);
+    CHECK(layout.Target(0).width == 320);
+
+    /*a tiny window still renders a texel*/
+    ViewportLayout tiny;
+    tiny.Build(3, 3, 1, 1);
+    tiny.SetScale(0, VIEWPORT_MIN_SCALE);
+    CHECK(tiny.Target(0).width == 1 && tiny.Target(0).height == 1);
+}
+
+/*the centers of the first and last screen pixels, mapped through the uv, land on the outer texel centers*/
+static void TestUV()
+{
+    const float scales[] = { 1.f, 0.9f, 0.5f, 0.37f, VIEWPORT_MIN_SCALE };
+
+    for (float scale : scales)
+    {
+        ViewportLayout layout;
+        layout.Build(1279, 721, 2, 2);
+
+        for (int v = 0; v < layout.Views(); v++)
+        {
+            layout.SetScale(v, scale);
+
+            ViewportRect t = layout.Target(v);
+            const ViewportRect& s = layout.Screen(v);
+            ViewportUV uv = layout.UV(v);
+
+            /*atlas texels along the quad at the center of screen pixel i*/
+            auto texelX = [&](int i) { return (uv.u0 + (uv.u1 - uv.u0) * (i + 0.5) / s.width) * layout.AtlasWidth(); };
+            auto texelY = [&](int i) { return (uv.v0 + (uv.v1 - uv.v0) * (i + 0.5) / s.height) * layout.AtlasHeight(); };
+
+            CHECK_NEAR(texelX(0), t.x + 0.5, 1e-3);
+            CHECK_NEAR(texelX(s.width - 1), t.x + t.width - 0.5, 1e-3);
+            CHECK_NEAR(texelY(0), t.y + 0.5, 1e-3);
+            CHECK_NEAR(texelY(s.height - 1), t.y + t.height - 0.5, 1e-3);
+
+            /*inside the target, nothing of the gutter is sampled*/
+            CHECK(uv.u0 * layout.AtlasWidth() > t.x - 1e-3 && uv.u1 * layout.AtlasWidth() < t.x + t.width + 1e-3);
+            CHECK(uv.v0 * layout.AtlasHeight() > t.y - 1e-3 && uv.v1 * layout.AtlasHeight() < t.y + t.height + 1e-3);
+        }
+    }
+}
+
+static void TestUsed()
+{
+    ViewportLayout layout;
+    layout.Build(1001, 997, 3, 3);
+
+    ViewportRect used = layout.Used();
+    CHECK(used.x == 0 && used.y == 0);
+    CHECK(used.width == layout.AtlasWidth() - VIEWPORT_GUTTER);
+    CHECK(used.height == layout.AtlasHeight() - VIEWPORT_GUTTER);
+
+    /*scaled views shrink the used part to the box around the targets*/
+    const float scales[] = { 1.f, 0.5f, 0.25f, 0.8f, 0.3f, 0.6f, 0.9f, 0.25f, 0.4f };
+
+    for (int v = 0; v < layout.Views(); v++)
+    {
+        layout.SetScale(v, scales[v]);
+    }
+
+    int right = 0, bottom = 0;
+
+    for (int v = 0; v < layout.Views(); v++)
+    {
+        ViewportRect t = layout.Target(v);
+        right = std::max(right, t.x + t.width);
+        bottom = std::max(bottom, t.y + t.height);
+    }
+
+    used = layout.Used();
+    CHECK(used.width == right && used.height == bottom);
+    CHECK(used.width < layout.AtlasWidth() - VIEWPORT_GUTTER);
+}
+
+int main()
+{
+    TestTiling();
+    TestScale();
+    TestUV();
+    TestUsed();
+
+    return Result();
+}
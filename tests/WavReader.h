@@ -0,0 +1,76 @@
+/* WavReader.h
+
+reads the 16 bit pcm wav files of the game for the linux tests and
+benchmarks, the chunks other than fmt and data are skipped.
+
+    Usage:
+    WavData wav;
+    CHECK(ReadWav(REPO_DIR "/data/sound/fx/boing.wav", wav));
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+struct WavData
+{
+    std::vector<int16_t> samples;
+    int channels = 0;
+    int sampleRate = 0;
+
+    size_t Frames() const { return channels ? samples.size() / channels : 0; }
+};
+
+inline bool ReadWav(const std::string& file, WavData& wav)
+{
+    std::ifstream in(file, std::ios::binary);
+    std::vector<char> b((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    if (b.size() < 12 || memcmp(&b[0], "RIFF", 4) != 0 || memcmp(&b[8], "WAVE", 4) != 0)
+        return false;
+
+    uint16_t format = 0, bits = 0;
+
+    for (size_t i = 12; i + 8 <= b.size();)
+    {
+        uint32_t size;
+        memcpy(&size, &b[i + 4], 4);
+
+        if (size > b.size() - i - 8)
+            return false;
+
+        if (memcmp(&b[i], "fmt ", 4) == 0 && size >= 16)
+        {
+            uint16_t channels;
+            uint32_t rate;
+            memcpy(&format, &b[i + 8], 2);
+            memcpy(&channels, &b[i + 10], 2);
+            memcpy(&rate, &b[i + 12], 4);
+            memcpy(&bits, &b[i + 22], 2);
+
+            wav.channels = channels;
+            wav.sampleRate = rate;
+        }
+        else if (memcmp(&b[i], "data", 4) == 0)
+        {
+            if (format != 1 || bits != 16 || wav.channels == 0)
+                return false;
+
+            size_t count = size / sizeof(int16_t);
+            count -= count % wav.channels;
+
+            wav.samples.resize(count);
+            memcpy(wav.samples.data(), &b[i + 8], count * sizeof(int16_t));
+            return true;
+        }
+
+        i += 8 + size + (size & 1);
+    }
+
+    return false;
+}
@@ -25,6 +25,7 @@
 #include <iostream>
 #include "constants.h"
 #include "DDSTextureLoader.h"
+#include "Random.h"
 
 
 using namespace DirectX;
@@ -111,7 +112,7 @@ public:
     // Returns random float in [0, 1).
     static float RandF()
     {
-        return (float)(rand()) / (float)RAND_MAX;
+        return Random::Shared().Float();
     }
 
     // Returns random float in [a, b).
@@ -122,6 +123,7 @@ public:
 
 };
 
+/*shared through ResourceManager::getRandomTexture*/
 static ID3D11ShaderResourceView* CreateRandomTexture1DSRV(ID3D11Device* device)
 {
     // 
@@ -129,13 +131,8 @@ static ID3D11ShaderResourceView* CreateRandomTexture1DSRV(ID3D11Device* device)
     //
     XMFLOAT4 randomValues[1024];
 
-    for (int i = 0; i < 1024; ++i)
-    {
-        randomValues[i].x = DXMath::RandF(-1.0f, 1.0f);
-        randomValues[i].y = DXMath::RandF(-1.0f, 1.0f);
-        randomValues[i].z = DXMath::RandF(-1.0f, 1.0f);
-        randomValues[i].w = DXMath::RandF(-1.0f, 1.0f);
-    }
+    /*counter based, the same values every time*/
+    Random::Fill(&randomValues[0].x, 1024 * 4, RANDOM_TEXTURE_KEY, 0, -1.0f, 1.0f);
 
     D3D11_SUBRESOURCE_DATA initData;
     initData.pSysMem = randomValues;